@@ -0,0 +1,110 @@
+// Screen grab latency: X11 MIT-SHM vs XGetImage at 1080p and 4K.
+// Needs an X display at least 3840x2160 for the 4K rows (make bench-capture
+// starts one under Xvfb when $DISPLAY is unset).
+// Usage: capture_bench [iterations]
+
+#include "screen_handler/capture_source.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+
+namespace {
+
+struct GrabTimes {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+};
+
+bool timeGrabs(CaptureSource& source, int width, int height, int iterations, GrabTimes& times) {
+    const Recordify::Utils::Rectangle area(0, 0, width, height);
+    const size_t stride = static_cast<size_t>(width) * source.bitsPerPixel() / 8;
+    std::vector<uint8_t> frame(stride * height);
+
+    // Warm-up grab resizes the source's image and faults in the frame
+    if (!source.grab(area, frame.data(), stride)) {
+        return false;
+    }
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (!source.grab(area, frame.data(), stride)) {
+            return false;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+    }
+    times.mean = total / iterations;
+    times.p50 = samples[samples.size() / 2];
+    times.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc >= 2 ? std::atoi(argv[1]) : 100;
+    if (iterations <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<CaptureSource> probe = createX11CaptureSource();
+    if (!probe) {
+        std::cerr << "Built without X11 support" << std::endl;
+        return 1;
+    }
+    if (!probe->open()) {
+        std::cerr << "No X display (set DISPLAY or run under xvfb-run)" << std::endl;
+        return 1;
+    }
+    const Recordify::Utils::Rectangle screen = probe->bounds();
+    probe->close();
+
+    std::cout << "=== Capture benchmark: " << screen.width << "x" << screen.height << " screen, "
+              << iterations << " grabs ===" << std::endl;
+
+    bool ok = true;
+    for (bool useShm : {true, false}) {
+        std::unique_ptr<CaptureSource> source = createX11CaptureSource("", useShm);
+        if (!source->open()) {
+            ok = false;
+            continue;
+        }
+
+        for (const auto& size : {std::make_pair(1920, 1080), std::make_pair(3840, 2160)}) {
+            std::cout << std::left << std::setw(9) << source->name() << std::setw(11)
+                      << (std::to_string(size.first) + "x" + std::to_string(size.second));
+            if (size.first > screen.width || size.second > screen.height) {
+                std::cout << "larger than the screen" << std::endl;
+                continue;
+            }
+
+            GrabTimes times;
+            if (!timeGrabs(*source, size.first, size.second, iterations, times)) {
+                std::cout << "grab failed" << std::endl;
+                ok = false;
+                continue;
+            }
+            const double megabytes = static_cast<double>(size.first) * size.second * 4 / 1e6;
+            std::cout << std::fixed << std::setprecision(3)
+                      << "mean " << std::setw(8) << times.mean << "ms  p50 " << std::setw(8) << times.p50
+                      << "ms  p99 " << std::setw(8) << times.p99 << "ms  "
+                      << std::setprecision(0) << megabytes * 1000.0 / times.mean << " MB/s" << std::endl;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Color statistics microbenchmark: scalar vs SSE2 vs AVX2 sums on a single
+// thread, over noise (every pixel its own run) and desktop-like content
+// (long runs of flat color), every pixel and every other row and column.
+// Scalar folds every run of identical pixels once, so it is at its best on
+// the desktop content; with SIMD, chunks of short runs have every pixel
+// summed by the kernel and only the histogram and palette scatter per run.
+// Usage: color_stats_bench [width height iterations]
+
+#include "utils/color_stats.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Recordify::Utils;
+using namespace Recordify::Utils::ColorStatsKernels;
+
+namespace {
+
+struct BenchResult {
+    double millisecondsPerFrame = 0.0;
+    ColorStatsResult stats;
+};
+
+BenchResult runKernel(Isa isa, const std::vector<uint8_t>& pixels, int width, int height, int step,
+                      int iterations) {
+    ColorStatsOptions options;
+    options.rowStep = step;
+    options.columnStep = step;
+    const size_t stride = static_cast<size_t>(width) * 4;
+    setActiveIsa(isa);
+
+    BenchResult result;
+    result.stats = computeColorStats(pixels.data(), width, height, stride, 4, options); // warm-up
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        computeColorStats(pixels.data(), width, height, stride, 4, options);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    result.millisecondsPerFrame = elapsed.count() / iterations;
+    return result;
+}
+
+bool sameStats(const ColorStatsResult& a, const ColorStatsResult& b) {
+    return a.sampleCount == b.sampleCount && a.meanRed == b.meanRed && a.meanGreen == b.meanGreen &&
+           a.meanBlue == b.meanBlue && a.luminanceStdDev == b.luminanceStdDev &&
+           a.meanSaturation == b.meanSaturation && a.luminanceHistogram == b.luminanceHistogram;
+}
+
+// Flat panels with rows of glyph-sized strokes, like an editor or a terminal
+std::vector<uint8_t> makeDesktop(int width, int height) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            const bool sidebar = x < width / 6;
+            const bool glyph = !sidebar && y % 20 < 12 && x % 9 < 5 && (x * 7 + y * 3) % 11 < 6;
+            const uint8_t value = glyph ? 30 : (sidebar ? 60 : 240);
+            pixel[0] = value;
+            pixel[1] = value;
+            pixel[2] = sidebar ? 90 : value;
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int width = 1920;
+    int height = 1080;
+    int iterations = 30;
+    if (argc >= 4) {
+        width = std::atoi(argv[1]);
+        height = std::atoi(argv[2]);
+        iterations = std::atoi(argv[3]);
+    }
+    if (width <= 0 || height <= 0 || iterations <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [width height iterations]" << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> noise(static_cast<size_t>(width) * height * 4);
+    std::mt19937 rng(12345);
+    for (auto& byte : noise) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    const std::vector<uint8_t> desktop = makeDesktop(width, height);
+
+    std::cout << "=== Color statistics benchmark: " << width << "x" << height << " BGRA, "
+              << iterations << " iterations, 1 thread ===" << std::endl;
+    std::cout << "CPU supports: " << isaName(detectIsa()) << std::endl;
+    bool allMatch = true;
+
+    const struct {
+        const char* name;
+        const std::vector<uint8_t>& pixels;
+    } contents[] = {{"noise", noise}, {"desktop", desktop}};
+    for (const auto& content : contents) {
+        for (int step : {1, 2}) {
+            BenchResult scalar = runKernel(Isa::SCALAR, content.pixels, width, height, step, iterations);
+            for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2}) {
+                std::cout << std::left << std::setw(9) << content.name << "step " << step << "  "
+                          << std::setw(8) << isaName(isa);
+                if (isa > detectIsa()) {
+                    std::cout << "unsupported" << std::endl;
+                    continue;
+                }
+
+                BenchResult result = isa == Isa::SCALAR
+                                         ? scalar
+                                         : runKernel(isa, content.pixels, width, height, step, iterations);
+                bool matches = sameStats(result.stats, scalar.stats);
+                allMatch = allMatch && matches;
+
+                std::cout << std::fixed << std::setprecision(3) << std::setw(10) << result.millisecondsPerFrame
+                          << "ms/frame  " << std::setprecision(2) << "x"
+                          << scalar.millisecondsPerFrame / result.millisecondsPerFrame
+                          << (matches ? "" : "  MISMATCH") << std::endl;
+            }
+        }
+    }
+
+    setActiveIsa(detectIsa());
+    return allMatch ? 0 : 1;
+}
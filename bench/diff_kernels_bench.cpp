@@ -0,0 +1,114 @@
+// Frame differencing microbenchmark: scalar vs SSE2 vs AVX2.
+// Usage: diff_kernels_bench [width height iterations]
+
+#include "utils/diff_kernels.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Recordify::Utils::DiffKernels;
+
+namespace {
+
+struct BenchResult {
+    double millisecondsPerFrame = 0.0;
+    FrameDiff diff;
+};
+
+BenchResult runKernel(Isa isa, const std::vector<uint8_t>& current, const std::vector<uint8_t>& previous,
+                      int width, int height, int iterations) {
+    const int bytesPerPixel = 4;
+    BenchResult result;
+    setActiveIsa(isa);
+
+    // One warm-up pass so the first timed iteration isn't paying for page faults
+    diffFrames(current.data(), previous.data(), width, height,
+               static_cast<size_t>(width) * bytesPerPixel, bytesPerPixel, 64, 10, result.diff);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        diffFrames(current.data(), previous.data(), width, height,
+                   static_cast<size_t>(width) * bytesPerPixel, bytesPerPixel, 64, 10, result.diff);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    result.millisecondsPerFrame = elapsed.count() / iterations;
+    return result;
+}
+
+bool sameResult(const FrameDiff& a, const FrameDiff& b) {
+    if (a.tiles.size() != b.tiles.size()) return false;
+    for (size_t i = 0; i < a.tiles.size(); ++i) {
+        if (a.tiles[i].changedBytes != b.tiles[i].changedBytes ||
+            a.tiles[i].changedPixels != b.tiles[i].changedPixels ||
+            a.tiles[i].sad != b.tiles[i].sad ||
+            a.tiles[i].maxDelta != b.tiles[i].maxDelta) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int width = 3840;
+    int height = 2160;
+    int iterations = 50;
+    if (argc >= 4) {
+        width = std::atoi(argv[1]);
+        height = std::atoi(argv[2]);
+        iterations = std::atoi(argv[3]);
+    }
+    if (width <= 0 || height <= 0 || iterations <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [width height iterations]" << std::endl;
+        return 1;
+    }
+
+    // Random frame plus a copy with sparse small changes and a moving block
+    const size_t frameBytes = static_cast<size_t>(width) * height * 4;
+    std::vector<uint8_t> previous(frameBytes);
+    std::mt19937 rng(12345);
+    for (auto& byte : previous) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> current = previous;
+    for (size_t i = 0; i < frameBytes; i += 97) {
+        current[i] = static_cast<uint8_t>(current[i] + (rng() % 32));
+    }
+
+    const double gigabytesPerFrame = 2.0 * frameBytes / 1e9; // both frames are read
+    std::cout << "=== Frame diff benchmark: " << width << "x" << height << " BGRA, "
+              << iterations << " iterations ===" << std::endl;
+    std::cout << "CPU supports: " << isaName(detectIsa()) << std::endl;
+
+    BenchResult scalar = runKernel(Isa::SCALAR, current, previous, width, height, iterations);
+    bool allMatch = true;
+
+    for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2}) {
+        if (isa > detectIsa()) {
+            std::cout << std::left << std::setw(8) << isaName(isa) << "unsupported" << std::endl;
+            continue;
+        }
+
+        BenchResult result = isa == Isa::SCALAR ? scalar
+                                                : runKernel(isa, current, previous, width, height, iterations);
+        bool matches = sameResult(result.diff, scalar.diff);
+        allMatch = allMatch && matches;
+
+        std::cout << std::left << std::setw(8) << isaName(isa)
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(10) << result.millisecondsPerFrame << "ms/frame  "
+                  << std::setprecision(2) << std::setw(8) << gigabytesPerFrame * 1000.0 / result.millisecondsPerFrame
+                  << "GB/s  x" << scalar.millisecondsPerFrame / result.millisecondsPerFrame
+                  << (matches ? "" : "  MISMATCH") << std::endl;
+    }
+
+    setActiveIsa(detectIsa());
+    std::cout << "Changed bytes: " << scalar.diff.total.changedBytes
+              << ", pixels: " << scalar.diff.total.changedPixels
+              << ", max delta: " << static_cast<int>(scalar.diff.total.maxDelta) << std::endl;
+    return allMatch ? 0 : 1;
+}
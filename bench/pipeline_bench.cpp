@@ -0,0 +1,454 @@
+// End-to-end pipeline benchmark over a synthetic workload. Every frame goes
+// through capture, diff, color analysis, compositing, YUV conversion, MJPEG
+// encoding and file write; each stage is timed on its own. The frames are
+// measured in several runs and the median of the per-run medians is what gets
+// compared, so one noisy stretch can't fail or pass a check on its own.
+// Results are written as JSON and can be checked against a baseline from an
+// earlier run.
+// Usage: pipeline_bench [--width N] [--height N] [--frames N] [--runs N]
+//                       [--workload NAME] [--seed N] [--fraction F] [--out FILE]
+//                       [--baseline FILE] [--threshold PERCENT]
+
+#include "file_manager/file_writer.h"
+#include "screen_handler/layer_compositor.h"
+#include "screen_handler/screen_reader.h"
+#include "screen_handler/synthetic_source.h"
+#include "utils/color_convert.h"
+#include "utils/diff_kernels.h"
+#include "utils/logger.h"
+#include "video_handler/mjpeg_backend.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Recordify;
+
+// Heap allocations made by the timed code, per thread so the logger and
+// I/O threads don't count against the stage that happens to be running
+namespace {
+thread_local uint64_t t_allocations = 0;
+}
+
+void* operator new(size_t size) {
+    ++t_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    ++t_allocations;
+    const size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+    void* p = _aligned_malloc(size ? size : 1, align);
+#else
+    void* p = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+#endif
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+#ifdef _WIN32
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+namespace {
+
+struct Options {
+    int width = 1920;
+    int height = 1080;
+    int frames = 300; // per run
+    int runs = 5;
+    ScreenHandler::SyntheticWorkload workload = ScreenHandler::SyntheticWorkload::SCROLLING_TERMINAL;
+    uint32_t seed = 1;
+    float fraction = -1.0f;
+    std::string out;
+    std::string baseline;
+    double threshold = 15.0; // percent slower median than the baseline that counts as a regression
+};
+
+struct StageResult {
+    std::string name;
+    double bytesPerFrame = 0.0;
+    std::vector<double> samples; // ns per frame, all runs
+    std::vector<double> runMedians;
+    size_t runStart = 0;
+    uint64_t allocations = 0;
+
+    double mean() const {
+        double total = 0.0;
+        for (double sample : samples) total += sample;
+        return samples.empty() ? 0.0 : total / samples.size();
+    }
+    double percentile(double p) const {
+        if (samples.empty()) return 0.0;
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    }
+    // Closes the current run, keeping its median
+    void endRun() {
+        if (samples.size() > runStart) {
+            std::vector<double> run(samples.begin() + runStart, samples.end());
+            std::nth_element(run.begin(), run.begin() + run.size() / 2, run.end());
+            runMedians.push_back(run[run.size() / 2]);
+        }
+        runStart = samples.size();
+    }
+    double medianOfRuns() const {
+        if (runMedians.empty()) return percentile(0.50);
+        std::vector<double> sorted = runMedians;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[sorted.size() / 2];
+    }
+    double megabytesPerSecond() const { return mean() > 0.0 ? bytesPerFrame / mean() * 1e3 : 0.0; }
+    double allocationsPerFrame() const { return samples.empty() ? 0.0 : static_cast<double>(allocations) / samples.size(); }
+};
+
+// Times one call of fn into stage
+template <typename Fn>
+void measure(StageResult& stage, Fn&& fn) {
+    const uint64_t allocationsBefore = t_allocations;
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    stage.allocations += t_allocations - allocationsBefore;
+    stage.samples.push_back(elapsed.count());
+}
+
+bool parseWorkload(const std::string& name, ScreenHandler::SyntheticWorkload& workload) {
+    static const std::map<std::string, ScreenHandler::SyntheticWorkload> names = {
+        {"static", ScreenHandler::SyntheticWorkload::STATIC_DESKTOP},
+        {"terminal", ScreenHandler::SyntheticWorkload::SCROLLING_TERMINAL},
+        {"video", ScreenHandler::SyntheticWorkload::VIDEO_REGION},
+        {"window", ScreenHandler::SyntheticWorkload::MOVING_WINDOW},
+        {"cursor", ScreenHandler::SyntheticWorkload::BLINKING_CURSOR},
+    };
+    auto it = names.find(name);
+    if (it == names.end()) {
+        return false;
+    }
+    workload = it->second;
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--width") options.width = std::atoi(value.c_str());
+        else if (arg == "--height") options.height = std::atoi(value.c_str());
+        else if (arg == "--frames") options.frames = std::atoi(value.c_str());
+        else if (arg == "--runs") options.runs = std::atoi(value.c_str());
+        else if (arg == "--seed") options.seed = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (arg == "--fraction") options.fraction = std::strtof(value.c_str(), nullptr);
+        else if (arg == "--out") options.out = value;
+        else if (arg == "--baseline") options.baseline = value;
+        else if (arg == "--threshold") options.threshold = std::strtod(value.c_str(), nullptr);
+        else if (arg == "--workload") {
+            if (!parseWorkload(value, options.workload)) return false;
+        } else {
+            return false;
+        }
+    }
+    return options.width >= 64 && options.height >= 64 && options.frames > 0 && options.runs > 0;
+}
+
+// Annotation overlay: a highlight box, a pointer ring and a caption
+void drawAnnotations(ScreenHandler::TiledSurface& layer) {
+    ScreenHandler::Rasterizer rasterizer(layer);
+    ScreenHandler::RasterPath path;
+    path.addRoundedRect(layer.width() * 0.1f, layer.height() * 0.1f, layer.width() * 0.3f, layer.height() * 0.2f, 12.0f);
+    rasterizer.fill(path, ScreenHandler::PremultipliedColor::fromStraight(255, 200, 0, 96));
+    path.clear();
+    path.addEllipse(layer.width() * 0.6f, layer.height() * 0.5f, 24.0f, 24.0f);
+    rasterizer.fill(path, ScreenHandler::PremultipliedColor::fromStraight(255, 0, 0, 160));
+    path.clear();
+    path.addText("Recordify benchmark", layer.width() * 0.1f, layer.height() * 0.85f, 28.0f, true);
+    rasterizer.fill(path, ScreenHandler::PremultipliedColor::fromStraight(255, 255, 255, 255));
+}
+
+std::string toJson(const Options& options, const std::vector<StageResult>& stages) {
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(1);
+    json << "{\n  \"context\": {\n"
+         << "    \"width\": " << options.width << ",\n"
+         << "    \"height\": " << options.height << ",\n"
+         << "    \"frames\": " << options.frames << ",\n"
+         << "    \"runs\": " << options.runs << ",\n"
+         << "    \"workload\": \"" << ScreenHandler::SyntheticSource::workloadName(options.workload) << "\",\n"
+         << "    \"seed\": " << options.seed << ",\n"
+         << "    \"diff_isa\": \"" << Utils::DiffKernels::isaName(Utils::DiffKernels::activeIsa()) << "\",\n"
+         << "    \"convert_isa\": \"" << Utils::ColorConvert::isaName(Utils::ColorConvert::activeIsa()) << "\"\n"
+         << "  },\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const StageResult& stage = stages[i];
+        json << "    {\"name\": \"" << stage.name << "\", \"iterations\": " << stage.samples.size()
+             << ", \"ns_per_frame\": " << stage.mean() << ", \"mb_per_s\": " << stage.megabytesPerSecond()
+             << ", \"allocs_per_frame\": " << std::setprecision(2) << stage.allocationsPerFrame()
+             << std::setprecision(1) << ", \"p50_ns\": " << stage.percentile(0.50)
+             << ", \"run_p50_ns\": " << stage.medianOfRuns()
+             << ", \"p99_ns\": " << stage.percentile(0.99) << "}" << (i + 1 < stages.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+// Reads `"key": value` out of one flat JSON object
+bool jsonNumber(const std::string& object, const std::string& key, double& value) {
+    const size_t at = object.find("\"" + key + "\"");
+    if (at == std::string::npos) return false;
+    const size_t colon = object.find(':', at);
+    if (colon == std::string::npos) return false;
+    value = std::strtod(object.c_str() + colon + 1, nullptr);
+    return true;
+}
+
+// name -> benchmark object, plus the context object, from a file this tool wrote
+bool loadBaseline(const std::string& path, std::string& context, std::map<std::string, std::string>& benchmarks) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+
+    const size_t contextStart = text.find("\"context\"");
+    const size_t contextEnd = text.find('}', contextStart);
+    if (contextStart == std::string::npos || contextEnd == std::string::npos) return false;
+    context = text.substr(contextStart, contextEnd - contextStart);
+
+    for (size_t at = text.find("{\"name\"", contextEnd); at != std::string::npos; at = text.find("{\"name\"", at + 1)) {
+        const std::string object = text.substr(at, text.find('}', at) - at);
+        const size_t nameStart = object.find('"', object.find(':')) + 1;
+        benchmarks[object.substr(nameStart, object.find('"', nameStart) - nameStart)] = object;
+    }
+    return !benchmarks.empty();
+}
+
+// A slower median of the per-run medians beyond the threshold, or more
+// allocations, is a regression. Mean and p99 are reported too but move with
+// scheduler noise.
+int compareWithBaseline(const Options& options, const std::vector<StageResult>& stages) {
+    std::string context;
+    std::map<std::string, std::string> baseline;
+    if (!loadBaseline(options.baseline, context, baseline)) {
+        std::cerr << "Cannot read baseline " << options.baseline << std::endl;
+        return 2;
+    }
+    double width = 0, height = 0;
+    if (!jsonNumber(context, "width", width) || !jsonNumber(context, "height", height) ||
+        static_cast<int>(width) != options.width || static_cast<int>(height) != options.height) {
+        std::cerr << "Baseline " << options.baseline << " was recorded at another resolution" << std::endl;
+        return 2;
+    }
+    if (context.find(ScreenHandler::SyntheticSource::workloadName(options.workload)) == std::string::npos) {
+        std::cerr << "Baseline " << options.baseline << " was recorded with another workload" << std::endl;
+        return 2;
+    }
+
+    int regressions = 0;
+    std::cerr << "\n=== Against baseline " << options.baseline << " (threshold " << options.threshold << "%) ===\n";
+    for (const StageResult& stage : stages) {
+        auto it = baseline.find(stage.name);
+        double mean = 0, p50 = 0, p99 = 0, allocations = 0;
+        if (it == baseline.end() || !jsonNumber(it->second, "ns_per_frame", mean) ||
+            !jsonNumber(it->second, "run_p50_ns", p50) || !jsonNumber(it->second, "p99_ns", p99) ||
+            !jsonNumber(it->second, "allocs_per_frame", allocations)) {
+            std::cerr << std::left << std::setw(12) << stage.name << "not in baseline" << std::endl;
+            continue;
+        }
+
+        auto change = [](double now, double before) { return before > 0 ? (now / before - 1.0) * 100.0 : 0.0; };
+        const bool slower = change(stage.medianOfRuns(), p50) > options.threshold;
+        const bool allocates = stage.allocationsPerFrame() > allocations + 0.5;
+        regressions += slower || allocates;
+        std::cerr << std::left << std::setw(12) << stage.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(7) << change(stage.medianOfRuns(), p50) << "% p50  " << std::setw(7)
+                  << change(stage.mean(), mean) << "% mean  " << std::setw(7) << change(stage.percentile(0.99), p99)
+                  << "% p99  "
+                  << std::setprecision(2) << allocations << " -> " << stage.allocationsPerFrame() << " allocs"
+                  << (slower ? "  SLOWER" : "") << (allocates ? "  MORE ALLOCATIONS" : "") << std::endl;
+    }
+    if (regressions > 0) {
+        std::cerr << regressions << " stage(s) regressed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--width N] [--height N] [--frames N] [--runs N]\n"
+                     "       [--workload static|terminal|video|window|cursor] [--seed N] [--fraction F]\n"
+                     "       [--out FILE] [--baseline FILE] [--threshold PERCENT]"
+                  << std::endl;
+        return 1;
+    }
+    Utils::Logger::instance().setLevel(Utils::LogLevel::LEVEL_WARNING);
+
+    ScreenHandler::SyntheticConfig config;
+    config.workload = options.workload;
+    config.width = options.width;
+    config.height = options.height;
+    config.seed = options.seed;
+    config.changedFraction = options.fraction;
+
+    ScreenHandler::ScreenReader reader;
+    if (!reader.setCaptureSource(std::make_unique<ScreenHandler::SyntheticSource>(config)) || !reader.initialize()) {
+        return 1;
+    }
+
+    const int width = options.width;
+    const int height = options.height;
+    const size_t stride = static_cast<size_t>(width) * 4;
+    const double frameBytes = static_cast<double>(stride) * height;
+
+    ScreenHandler::TiledSurface annotations(width, height);
+    drawAnnotations(annotations);
+    ScreenHandler::LayerCompositor compositor;
+    compositor.resize(width, height);
+    compositor.update({{&annotations, 1.0f, true}});
+
+    VideoHandler::EncoderSettings settings;
+    settings.width = width;
+    settings.height = height;
+    VideoHandler::MjpegBackend encoder;
+    const std::string outputPath = "pipeline_bench.tmp";
+    FileManager::FileWriter writer;
+    if (!encoder.open(settings) || !writer.open(outputPath)) {
+        std::cerr << "Cannot set up the encoder or " << outputPath << std::endl;
+        return 1;
+    }
+
+    // Buffers every stage reuses, as the recording pipeline does
+    ScreenHandler::ScreenCapture current, previous;
+    Utils::DiffKernels::FrameDiff diff;
+    std::vector<uint8_t> composited(stride * height);
+    std::vector<uint8_t> yuv(static_cast<size_t>(width) * height +
+                             static_cast<size_t>(Utils::ColorConvert::chromaWidth(width)) * 2 *
+                                 Utils::ColorConvert::chromaHeight(height));
+    std::vector<uint8_t> packet;
+
+    std::vector<StageResult> stages(7);
+    const char* names[] = {"capture", "diff", "color", "composite", "convert", "encode", "write"};
+    for (size_t i = 0; i < stages.size(); ++i) {
+        stages[i].name = names[i];
+        stages[i].samples.reserve(static_cast<size_t>(options.frames) * options.runs);
+        stages[i].bytesPerFrame = frameBytes;
+    }
+    double packetBytes = 0.0;
+
+    // Frame 0 primes every buffer and is not measured. The output file is
+    // started over for each run so it doesn't grow without bound.
+    const int totalFrames = options.frames * options.runs;
+    for (int frame = -1; frame < totalFrames; ++frame) {
+        if (frame > 0 && frame % options.frames == 0) {
+            for (StageResult& result : stages) {
+                result.endRun();
+            }
+            writer.close();
+            if (!writer.open(outputPath)) {
+                std::cerr << "Cannot reopen " << outputPath << std::endl;
+                return 1;
+            }
+        }
+        std::swap(current, previous);
+        StageResult scratch;
+        auto stage = [&](int index) -> StageResult& { return frame < 0 ? scratch : stages[index]; };
+
+        measure(stage(0), [&] { reader.captureScreen(current); });
+        if (!current.hasPixels()) {
+            std::cerr << "Capture failed" << std::endl;
+            return 1;
+        }
+        const uint8_t* pixels = current.pixels();
+        if (previous.hasPixels()) {
+            measure(stage(1), [&] {
+                Utils::DiffKernels::diffFrames(pixels, previous.pixels(), width, height, stride, 4, 64, 10, diff);
+            });
+        }
+        measure(stage(2), [&] { current.analyzeColors(); });
+
+        std::memcpy(composited.data(), pixels, composited.size());
+        measure(stage(3), [&] { compositor.compositeOnto(composited.data(), width, height, stride, 4); });
+
+        uint8_t* y = yuv.data();
+        uint8_t* uv = y + static_cast<size_t>(width) * height;
+        measure(stage(4), [&] {
+            Utils::ColorConvert::convertToNV12(composited.data(), width, height, stride,
+                                               Utils::ColorConvert::PixelFormat::BGRA32, y, width, uv,
+                                               static_cast<size_t>(Utils::ColorConvert::chromaWidth(width)) * 2);
+        });
+
+        VideoHandler::VideoFrame video;
+        video.pixels = composited.data();
+        video.width = width;
+        video.height = height;
+        video.stride = stride;
+        video.bytesPerPixel = 4;
+        bool keyFrame = false;
+        packet.clear(); // encode() appends
+        measure(stage(5), [&] { encoder.encode(video, packet, keyFrame); });
+
+        measure(stage(6), [&] { writer.write(packet.data(), packet.size()); });
+        if (frame >= 0) {
+            packetBytes += packet.size();
+        }
+    }
+    for (StageResult& result : stages) {
+        result.endRun();
+    }
+    writer.close();
+    std::remove(outputPath.c_str());
+    stages[6].bytesPerFrame = packetBytes / totalFrames;
+
+    std::cerr << "=== Pipeline benchmark: " << width << "x" << height << " "
+              << ScreenHandler::SyntheticSource::workloadName(options.workload) << ", " << options.runs << " x "
+              << options.frames << " frames ===" << std::endl;
+    for (const StageResult& stage : stages) {
+        std::cerr << std::left << std::setw(12) << stage.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(9) << stage.mean() / 1e6 << " ms/frame  p50 " << std::setw(8)
+                  << stage.medianOfRuns() / 1e6 << "  p99 " << std::setw(8) << stage.percentile(0.99) / 1e6
+                  << std::setprecision(0) << std::setw(8) << stage.megabytesPerSecond() << " MB/s  "
+                  << std::setprecision(2) << stage.allocationsPerFrame() << " allocs/frame" << std::endl;
+    }
+
+    const std::string json = toJson(options, stages);
+    if (options.out.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream file(options.out);
+        if (!(file << json)) {
+            std::cerr << "Cannot write " << options.out << std::endl;
+            return 1;
+        }
+        std::cerr << "Results written to " << options.out << std::endl;
+    }
+    return options.baseline.empty() ? 0 : compareWithBaseline(options, stages);
+}
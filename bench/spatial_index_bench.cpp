@@ -0,0 +1,124 @@
+// Hit-testing microbenchmark: SpatialGrid vs a linear scan over N rectangles.
+// Rectangles are annotation/window sized and spread over a 4K desktop.
+// Usage: spatial_index_bench [queries]
+
+#include "utils/spatial_index.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Recordify::Utils;
+
+namespace {
+
+struct Timing {
+    double pointNs = 0.0;
+    double rectNs = 0.0;
+    size_t hits = 0; // keeps the work observable and lets both sides be compared
+};
+
+std::vector<Rectangle> makeRectangles(size_t count, std::mt19937& rng) {
+    std::vector<Rectangle> rects;
+    rects.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        // Mostly small marks, some window-sized
+        bool large = rng() % 10 == 0;
+        int width = large ? 200 + rng() % 800 : 8 + rng() % 120;
+        int height = large ? 150 + rng() % 600 : 8 + rng() % 80;
+        rects.emplace_back(rng() % 3840, rng() % 2160, width, height);
+    }
+    return rects;
+}
+
+template <typename PointFn, typename RectFn>
+Timing measure(const std::vector<Point>& points, const std::vector<Rectangle>& areas,
+               PointFn&& pointQuery, RectFn&& rectQuery) {
+    Timing timing;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& point : points) {
+        timing.hits += pointQuery(point);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (const auto& area : areas) {
+        timing.hits += rectQuery(area);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    timing.pointNs = std::chrono::duration<double, std::nano>(middle - start).count() / points.size();
+    timing.rectNs = std::chrono::duration<double, std::nano>(end - middle).count() / areas.size();
+    return timing;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int queries = 20000;
+    if (argc >= 2) {
+        queries = std::atoi(argv[1]);
+    }
+    if (queries <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [queries]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(4242);
+    std::vector<Point> points;
+    std::vector<Rectangle> areas;
+    for (int i = 0; i < queries; ++i) {
+        points.emplace_back(rng() % 3840, rng() % 2160);
+        areas.emplace_back(rng() % 3840, rng() % 2160, 64, 64); // one compositor tile
+    }
+
+    std::cout << "=== Spatial index benchmark: " << queries << " point and 64x64 rect queries ===" << std::endl;
+    std::cout << std::left << std::setw(8) << "items" << std::setw(14) << "linear pt" << std::setw(14) << "grid pt"
+              << std::setw(14) << "linear rect" << std::setw(14) << "grid rect" << "point speedup" << std::endl;
+
+    bool allMatch = true;
+    for (size_t count : {100u, 1000u, 4000u, 16000u}) {
+        std::vector<Rectangle> rects = makeRectangles(count, rng);
+
+        std::vector<std::pair<size_t, Rectangle>> items;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            items.push_back({i, rects[i]});
+        }
+        SpatialGrid<size_t> grid;
+        grid.build(items);
+
+        Timing linear = measure(points, areas,
+            [&rects](const Point& point) {
+                size_t hits = 0;
+                for (const auto& rect : rects) hits += rect.contains(point);
+                return hits;
+            },
+            [&rects](const Rectangle& area) {
+                size_t hits = 0;
+                for (const auto& rect : rects) hits += rect.intersects(area);
+                return hits;
+            });
+        Timing indexed = measure(points, areas,
+            [&grid](const Point& point) {
+                size_t hits = 0;
+                grid.queryPoint(point, [&hits](size_t, const Rectangle&) { ++hits; });
+                return hits;
+            },
+            [&grid](const Rectangle& area) {
+                size_t hits = 0;
+                grid.queryRect(area, [&hits](size_t, const Rectangle&) { ++hits; });
+                return hits;
+            });
+
+        bool matches = linear.hits == indexed.hits;
+        allMatch = allMatch && matches;
+        std::cout << std::left << std::fixed << std::setprecision(1)
+                  << std::setw(8) << count
+                  << std::setw(14) << linear.pointNs << std::setw(14) << indexed.pointNs
+                  << std::setw(14) << linear.rectNs << std::setw(14) << indexed.rectNs
+                  << "x" << linear.pointNs / indexed.pointNs
+                  << (matches ? "" : "  MISMATCH") << std::endl;
+    }
+    std::cout << "(times in ns per query)" << std::endl;
+    return allMatch ? 0 : 1;
+}
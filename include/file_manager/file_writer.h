@@ -0,0 +1,92 @@
+#ifndef RECORDIFY_FILE_WRITER_H
+#define RECORDIFY_FILE_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Recordify {
+namespace FileManager {
+
+enum class IoBackend {
+    AUTO,     // io_uring where the kernel allows it, pwrite otherwise
+    IO_URING, // Linux only; falls back to PWRITE if setup fails
+    PWRITE    // positional writes (WriteFile on Windows)
+};
+
+enum class SyncPolicy {
+    NEVER,    // leave it to the OS
+    ON_CLOSE, // one fdatasync when the file is finished
+    INTERVAL, // at most every syncIntervalMs, after the batches written so far
+    ALWAYS    // after every batch
+};
+
+struct WriterOptions {
+    size_t batchSize = 4 << 20; // bytes per write handed to the kernel
+    int queueDepth = 4;         // batches queued or in flight before write() waits
+    bool directIo = false;      // O_DIRECT / FILE_FLAG_NO_BUFFERING, buffered if refused
+    IoBackend backend = IoBackend::AUTO;
+    SyncPolicy sync = SyncPolicy::ON_CLOSE;
+    uint32_t syncIntervalMs = 1000;
+};
+
+// Sequential file writer with a dedicated I/O thread. write() copies into
+// page-aligned batches and hands full ones to the I/O thread, so callers
+// only wait on disk when all queueDepth batches are still in flight.
+// Direct I/O pads the last block and trims the file when it's closed.
+//
+// writeAt() rewrites bytes already written (headers patched at the end of
+// a recording); it is applied in order with the batches around it.
+class FileWriter {
+public:
+    struct Stats {
+        uint64_t bytesQueued = 0;  // accepted by write()
+        uint64_t bytesWritten = 0; // completed by the I/O thread
+        uint64_t batchesWritten = 0;
+        uint64_t syncs = 0;
+        uint64_t stalls = 0;       // write() calls that waited for a free batch
+        float stallTime = 0.0f;    // ms, total
+        float maxWriteTime = 0.0f; // ms, slowest batch from queueing to completion
+    };
+
+    FileWriter();
+    ~FileWriter();
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    // Creates or truncates the file
+    bool open(const std::string& path, const WriterOptions& options = WriterOptions());
+    // Writes everything queued, syncs per the policy and closes
+    bool close();
+    bool isOpen() const;
+
+    bool write(const void* data, size_t size);
+    bool writeAt(uint64_t offset, const void* data, size_t size);
+    // Blocks until everything accepted so far has reached the kernel
+    bool flush();
+    // flush() plus fdatasync, regardless of the policy
+    bool sync();
+    // Runs `callback` once every byte accepted so far has been written: on
+    // the I/O thread, or right away if that already happened. Bytes still in
+    // the batch being filled wait for it to fill or be flushed; flush()
+    // returns after their callbacks. Dropped if the writer fails first.
+    bool whenWritten(std::function<void()> callback);
+
+    uint64_t getPosition() const; // bytes accepted, i.e. the file size after close()
+    bool isDirect() const;        // false if direct I/O was requested but refused
+    IoBackend getBackend() const; // the one actually in use
+    Stats getStats() const;
+    const std::string& getPath() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+const char* backendName(IoBackend backend);
+
+}} // namespace Recordify::FileManager
+
+#endif // RECORDIFY_FILE_WRITER_H
@@ -0,0 +1,83 @@
+#ifndef RECORDIFY_FRAME_SPOOL_H
+#define RECORDIFY_FRAME_SPOOL_H
+
+#include "utils/geometry.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Recordify {
+
+namespace ScreenHandler {
+class ScreenHandler;
+struct ScreenCapture;
+struct PipelineFrame;
+}
+
+namespace FileManager {
+
+struct SpoolFrameInfo {
+    Utils::Rectangle area;
+    int width = 0, height = 0;
+    int bitsPerPixel = 0;
+    size_t stride = 0; // bytes per row
+    size_t size = 0;   // bytes of pixel data
+    std::chrono::steady_clock::time_point timestamp;
+};
+
+// Lossless raw-frame recording into a preallocated memory-mapped file: a
+// header, a fixed-size frame index, then the pixel data. Appending is one
+// memcpy into the mapping plus an index entry, so it keeps up with capture
+// where encoding can't; an offline pass encodes the spool afterwards (see
+// tools/spool_replay.cpp).
+//
+// Disk space is reserved up front, so a full disk can't fault the mapping
+// mid-recording; a full spool rejects further frames instead. Frames are
+// readable as soon as they are counted in the header, so a spool left by a
+// crashed process replays up to its last frame. One writer at a time.
+class FrameSpool {
+public:
+    FrameSpool();
+    ~FrameSpool();
+    FrameSpool(const FrameSpool&) = delete;
+    FrameSpool& operator=(const FrameSpool&) = delete;
+
+    // Writer: room for maxFrames frames and dataBytes of pixels
+    bool create(const std::string& path, uint32_t maxFrames, uint64_t dataBytes);
+    // Reader: maps an existing spool read-only
+    bool open(const std::string& path);
+    // Writer: marks the spool complete and trims the unused space
+    bool close();
+    bool isOpen() const;
+
+    bool append(const ScreenHandler::ScreenCapture& capture);
+    bool append(const SpoolFrameInfo& info, const uint8_t* pixels);
+
+    // Zero-copy: pixels point into the mapping until close()
+    bool getFrame(uint32_t index, SpoolFrameInfo& info, const uint8_t*& pixels) const;
+
+    uint32_t getFrameCount() const;
+    uint32_t getCapacity() const;
+    uint64_t getDataUsed() const;
+    uint64_t getDataCapacity() const;
+    uint64_t getDroppedFrames() const; // rejected because the spool was full
+    bool isComplete() const;           // closed by its writer
+
+    // Pipeline hooks: the writer stage appends every frame, rebuilding
+    // DIRTY_TILES frames into full ones. Install before startCapture().
+    void attach(ScreenHandler::ScreenHandler& handler);
+    void detach(ScreenHandler::ScreenHandler& handler);
+    bool writeFrame(const ScreenHandler::PipelineFrame& frame);
+
+    const std::string& getPath() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}} // namespace Recordify::FileManager
+
+#endif // RECORDIFY_FRAME_SPOOL_H
@@ -0,0 +1,66 @@
+#ifndef RECORDIFY_SEGMENT_MANIFEST_H
+#define RECORDIFY_SEGMENT_MANIFEST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Recordify {
+namespace FileManager {
+
+struct StreamInfo {
+    std::string codec; // fourcc text, e.g. "MJPG"
+    int width = 0, height = 0;
+    float fps = 0.0f;
+};
+
+struct SegmentInfo {
+    std::string file;      // name only, next to the manifest
+    uint32_t frames = 0;
+    double duration = 0.0; // seconds
+    uint64_t bytes = 0;
+};
+
+// Index of a recording split into rolling segments. Only finished segments
+// are listed, and the manifest is rewritten atomically (temp file, sync,
+// rename) after each one, so after a crash it still names every segment
+// that is complete on disk. finish() marks a recording that ended cleanly.
+//
+// For an output path "dir/name.avi" the manifest is "dir/name.manifest"
+// and the segments are "dir/name_00000.avi", "dir/name_00001.avi", ...
+class SegmentManifest {
+public:
+    SegmentManifest() = default;
+    explicit SegmentManifest(const std::string& outputPath);
+
+    // Reads a manifest; its segments resolve relative to its directory
+    bool load(const std::string& manifestPath);
+    bool save() const;
+
+    void setStream(const StreamInfo& stream) { m_stream = stream; }
+    bool add(const SegmentInfo& segment); // appends and saves
+    bool finish();                        // marks complete and saves
+
+    const std::string& getPath() const { return m_path; }
+    std::string segmentName(size_t index) const;
+    std::string resolve(const SegmentInfo& segment) const; // full path
+
+    const StreamInfo& getStream() const { return m_stream; }
+    const std::vector<SegmentInfo>& getSegments() const { return m_segments; }
+    bool isComplete() const { return m_complete; }
+    uint64_t getTotalFrames() const;
+    double getTotalDuration() const;
+
+private:
+    std::string m_path;
+    std::string m_directory; // with trailing separator, or empty
+    std::string m_base;      // segment name prefix
+    std::string m_extension;
+    StreamInfo m_stream;
+    std::vector<SegmentInfo> m_segments;
+    bool m_complete = false;
+};
+
+}} // namespace Recordify::FileManager
+
+#endif // RECORDIFY_SEGMENT_MANIFEST_H
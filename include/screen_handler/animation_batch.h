@@ -0,0 +1,73 @@
+#ifndef RECORDIFY_ANIMATION_BATCH_H
+#define RECORDIFY_ANIMATION_BATCH_H
+
+#include "screen_handler/screen_writer.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+// Every running animation, stored as structure-of-arrays so one advance()
+// steps them all. Keyframes of all animations are flattened into shared
+// per-channel arrays. A first pass moves each animation's segment cursor
+// forward (amortised O(1), playback only goes one way) and eases the local
+// time; a second, branch-free pass then interpolates one channel at a time.
+class AnimationBatch {
+public:
+    // Replaces any animation already running for objectId
+    void add(int objectId, const Animation& animation);
+    bool remove(int objectId);
+    void clear();
+
+    size_t size() const { return m_ids.size(); }
+    bool empty() const { return m_ids.empty(); }
+    bool contains(int objectId) const { return indexOf(objectId) >= 0; }
+
+    // Moves every animation forward by deltaTime seconds and re-evaluates it.
+    // Ids that reached their end are appended to `finished` and dropped; their
+    // final state is still readable until the next advance().
+    void advance(float deltaTime, std::vector<int>& finished);
+
+    // State from the last advance(); false if objectId wasn't evaluated.
+    // Linear in the batch size, iterate getObjectIds() to read everything.
+    bool getState(int objectId, AnimationKeyframe& state) const;
+
+    // Results of the last advance(), parallel to getObjectIds()
+    const std::vector<int>& getObjectIds() const { return m_evaluatedIds; }
+    AnimationKeyframe getStateAt(size_t index) const;
+
+private:
+    enum Channel { X, Y, OPACITY, SCALE, ROTATION, CHANNELS };
+
+    int indexOf(int objectId) const;
+    void removeAt(size_t index);
+
+    // Per animation
+    std::unordered_map<int, size_t> m_rows;
+    std::vector<int> m_ids;
+    std::vector<float> m_elapsed;
+    std::vector<float> m_inverseDuration;
+    std::vector<uint32_t> m_firstKey; // into the keyframe arrays
+    std::vector<uint32_t> m_keyCount;
+    std::vector<uint32_t> m_segment;  // cursor, relative to m_firstKey
+
+    // Flattened keyframes
+    std::vector<float> m_keyTime;
+    std::vector<Easing> m_keyEasing;
+    std::vector<float> m_keyValue[CHANNELS];
+
+    // Scratch and results of the last advance()
+    std::vector<uint32_t> m_from; // absolute keyframe index
+    std::vector<uint32_t> m_to;
+    std::vector<float> m_weight;
+    std::vector<float> m_result[CHANNELS];
+    std::vector<int> m_evaluatedIds;
+    std::vector<float> m_evaluatedTime;
+};
+
+}} // namespace Recordify::ScreenHandler
+
+#endif // RECORDIFY_ANIMATION_BATCH_H
@@ -0,0 +1,56 @@
+#ifndef RECORDIFY_CAPTURE_SOURCE_H
+#define RECORDIFY_CAPTURE_SOURCE_H
+
+#include "screen_handler/frame_pool.h"
+#include "utils/geometry.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+// Where ScreenReader's captured pixels come from. The reader owns the frame
+// buffers; a source only fills the requested area of them. Calls are
+// serialized by the reader, so sources need no locking of their own.
+class CaptureSource {
+public:
+    virtual ~CaptureSource() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool open() = 0;
+    virtual void close() {}
+
+    // Screen area the source can grab; empty if it takes any area
+    virtual Utils::Rectangle bounds() const = 0;
+    virtual int bitsPerPixel() const = 0; // 24 (BGR) or 32 (BGRA)
+
+    // Copies `area` (screen coordinates, inside bounds()) into `pixels`,
+    // rows `stride` bytes apart
+    virtual bool grab(const Utils::Rectangle& area, uint8_t* pixels, size_t stride) = 0;
+
+    // Memory grab() fills without going through a buffer of its own; the
+    // reader's frame pool takes its slabs from here when the source has one
+    virtual FramePool::SlabAllocator slabAllocator() { return FramePool::SlabAllocator(); }
+
+    // Pointer position in screen coordinates, if the source knows it
+    virtual bool pointer(Utils::Point&) { return false; }
+};
+
+// Synthetic 1920x1080 static desktop (see SyntheticSource); the fallback
+// when no display is reachable
+std::unique_ptr<CaptureSource> createSimulatedCaptureSource();
+
+// X11 root window grabs through MIT-SHM, or XGetSubImage into a reused
+// image when shared memory is unavailable (remote display) or useShm is
+// off. Returns null when built without X11 support. displayName empty
+// means $DISPLAY.
+std::unique_ptr<CaptureSource> createX11CaptureSource(const std::string& displayName = "", bool useShm = true);
+
+// Best source for this platform, already opened
+std::unique_ptr<CaptureSource> createDefaultCaptureSource();
+
+}} // namespace Recordify::ScreenHandler
+
+#endif // RECORDIFY_CAPTURE_SOURCE_H
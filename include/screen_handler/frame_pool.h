@@ -0,0 +1,127 @@
+#ifndef RECORDIFY_FRAME_POOL_H
+#define RECORDIFY_FRAME_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+class FramePool;
+
+// Ref-counted handle to a pixel buffer borrowed from a FramePool.
+// Copies share the same memory; the buffer returns to its pool when the
+// last handle is released.
+class FrameBuffer {
+public:
+    FrameBuffer() = default;
+    FrameBuffer(const FrameBuffer& other);
+    FrameBuffer(FrameBuffer&& other) noexcept;
+    FrameBuffer& operator=(const FrameBuffer& other);
+    FrameBuffer& operator=(FrameBuffer&& other) noexcept;
+    ~FrameBuffer();
+
+    // Standalone heap buffer, not owned by any pool
+    static FrameBuffer allocate(size_t bytes);
+
+    uint8_t* data() { return m_block ? m_block->data : nullptr; }
+    const uint8_t* data() const { return m_block ? m_block->data : nullptr; }
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_block ? m_block->capacity : 0; }
+    bool empty() const { return m_size == 0; }
+
+    uint8_t& operator[](size_t index) { return m_block->data[index]; }
+    const uint8_t& operator[](size_t index) const { return m_block->data[index]; }
+
+    uint8_t* begin() { return data(); }
+    uint8_t* end() { return data() + m_size; }
+    const uint8_t* begin() const { return data(); }
+    const uint8_t* end() const { return data() + m_size; }
+
+    // Shrink or grow within the existing capacity; never reallocates
+    bool resize(size_t bytes);
+
+    bool unique() const { return m_block && m_block->refs.load(std::memory_order_acquire) == 1; }
+    int useCount() const { return m_block ? m_block->refs.load(std::memory_order_acquire) : 0; }
+    bool isPooled() const { return m_block && m_block->pooled; }
+    void reset();
+
+private:
+    friend class FramePool;
+
+    struct Block {
+        std::atomic<int> refs{0};
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+        bool pooled = false;
+        std::shared_ptr<void> owner; // keeps the pool state alive while borrowed
+        void (*recycle)(Block*) = nullptr;
+    };
+
+    FrameBuffer(Block* block, size_t size);
+    void release();
+
+    Block* m_block = nullptr;
+    size_t m_size = 0;
+};
+
+// Fixed set of page-aligned slabs handed out as FrameBuffers.
+// Once configured, acquiring a frame that fits a slab does no heap
+// allocation; oversized requests or an exhausted pool fall back to the
+// heap and are counted as misses.
+class FramePool {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        int slabCount = 0;
+        int slabsInUse = 0;
+        size_t slabBytes = 0;
+    };
+
+    // Page-aligned slab memory from somewhere other than the heap, such as
+    // shared memory a capture source grabs into. `owner` frees it once the
+    // slab set and every buffer borrowed from it are gone.
+    struct SlabMemory {
+        uint8_t* data = nullptr;
+        std::shared_ptr<void> owner;
+    };
+    using SlabAllocator = std::function<SlabMemory(size_t bytes)>;
+
+    FramePool();
+    FramePool(int slabCount, size_t slabBytes);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Reallocates the slab set, from `allocator` if given (falling back to
+    // the heap when it fails); outstanding buffers stay valid and are freed
+    // when released. Safe to call while other threads acquire.
+    bool configure(int slabCount, size_t slabBytes, const SlabAllocator& allocator = SlabAllocator());
+    bool isConfigured() const;
+
+    FrameBuffer acquire(size_t bytes);
+
+    Stats getStats() const;
+    void resetStats();
+
+    static size_t pageSize();
+
+private:
+    struct State;
+    std::shared_ptr<State> currentState() const;
+
+    // configure() swaps the slab set while acquire() may be reading it;
+    // callers take a reference under the mutex and work on that
+    mutable std::mutex m_mutex;
+    std::shared_ptr<State> m_state;
+};
+
+}} // namespace Recordify::ScreenHandler
+
+#endif // RECORDIFY_FRAME_POOL_H
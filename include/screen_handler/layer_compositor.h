@@ -0,0 +1,121 @@
+#ifndef RECORDIFY_LAYER_COMPOSITOR_H
+#define RECORDIFY_LAYER_COMPOSITOR_H
+
+#include "screen_handler/rasterizer.h"
+#include "utils/geometry.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+// Sparse premultiplied RGBA surface split into TILE_SIZE x TILE_SIZE tiles.
+// Tiles are allocated on first draw, and every tile written since the last
+// clearDirty() is flagged so consumers only revisit what changed.
+class TiledSurface {
+public:
+    static constexpr int TILE_SIZE = 64;
+    static constexpr size_t TILE_STRIDE = TILE_SIZE * 4;
+
+    TiledSurface() = default;
+    TiledSurface(int width, int height);
+    TiledSurface(TiledSurface&&) noexcept = default;
+    TiledSurface& operator=(TiledSurface&&) noexcept = default;
+
+    bool resize(int width, int height); // keeps content that still fits
+    void clear();                       // frees tiles, flagging them dirty
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int tileColumns() const { return m_columns; }
+    int tileRows() const { return m_rows; }
+    int tileCount() const { return m_columns * m_rows; }
+    Utils::Rectangle bounds() const { return Utils::Rectangle(0, 0, m_width, m_height); }
+    Utils::Rectangle tileRect(int tile) const; // clipped to the surface
+
+    bool hasTile(int tile) const { return m_tiles[tile] != nullptr; }
+    const uint8_t* tileData(int tile) const { return m_tiles[tile] ? m_tiles[tile]->pixels : nullptr; }
+    uint8_t* tileData(int tile) { return m_tiles[tile] ? m_tiles[tile]->pixels : nullptr; }
+    uint8_t* acquireTile(int tile); // allocates a transparent tile if needed
+    void releaseTile(int tile);
+    int occupiedTiles() const { return m_occupied; }
+    size_t memoryUsage() const { return static_cast<size_t>(m_occupied) * sizeof(Tile); }
+
+    bool isDirty(int tile) const { return m_dirty[tile] != 0; }
+    bool hasDirtyTiles() const { return m_anyDirty; }
+    void markDirty(int tile) { m_dirty[tile] = 1; m_anyDirty = true; }
+    void markOccupiedDirty(); // e.g. after an opacity or visibility change
+    void clearDirty();
+
+    // Rasterizer entry point: blends one row of coverage starting at (x, y)
+    void blendSpan(int x, int y, const uint8_t* coverage, int count, PremultipliedColor color);
+    // Source-over of a premultiplied image placed at (x, y), limited to `clip`.
+    // Tiles stay unallocated where the image is fully transparent.
+    void blendSurface(const RasterSurface& image, int x, int y, const Utils::Rectangle& clip);
+
+    PremultipliedColor pixel(int x, int y) const;
+
+private:
+    struct Tile {
+        alignas(16) uint8_t pixels[TILE_SIZE * TILE_STRIDE];
+    };
+
+    std::vector<std::unique_ptr<Tile>> m_tiles;
+    std::vector<uint8_t> m_dirty;
+    int m_width = 0;
+    int m_height = 0;
+    int m_columns = 0;
+    int m_rows = 0;
+    int m_occupied = 0;
+    bool m_anyDirty = false;
+};
+
+// Flattens layers into a cached overlay and blends that overlay onto frames.
+// update() rebuilds only tiles whose layers changed; compositing a frame then
+// touches only occupied overlay tiles, so static annotations cost one tile
+// blend each regardless of how many layers they came from.
+class LayerCompositor {
+public:
+    struct LayerRef {
+        TiledSurface* surface;
+        float opacity;
+        bool visible;
+    };
+
+    struct Stats {
+        uint64_t tilesRebuilt = 0;
+        uint64_t tilesComposited = 0;
+        uint64_t framesComposited = 0;
+    };
+
+    bool resize(int width, int height);
+    void invalidate(); // next update() rebuilds every tile
+
+    // Layers bottom to top; clears their dirty flags
+    void update(const std::vector<LayerRef>& layers);
+
+    // Source-over blend onto a packed BGR24 (3) or BGRA32 (4) frame whose top-left
+    // pixel lines up with the overlay's. Returns the number of tiles blended.
+    int compositeOnto(uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel);
+    // Same, onto just `area` (overlay coordinates) of such a frame, e.g. one
+    // tile of an incremental frame; `pixels` is the area's top-left pixel
+    int compositeOnto(uint8_t* pixels, const Utils::Rectangle& area, size_t stride, int bytesPerPixel);
+    // Same, onto a premultiplied RGBA surface
+    int compositeOnto(RasterSurface& surface);
+
+    const TiledSurface& overlay() const { return m_overlay; }
+    bool isEmpty() const { return m_overlay.occupiedTiles() == 0; }
+    Stats getStats() const { return m_stats; }
+
+private:
+    TiledSurface m_overlay;
+    std::vector<int> m_occupiedList; // overlay tiles with content
+    bool m_invalidated = true;
+    Stats m_stats;
+};
+
+}} // namespace Recordify::ScreenHandler
+
+#endif // RECORDIFY_LAYER_COMPOSITOR_H
@@ -0,0 +1,118 @@
+#ifndef RECORDIFY_QUALITY_CONTROLLER_H
+#define RECORDIFY_QUALITY_CONTROLLER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+enum class ChromaSubsampling {
+    YUV444,         // full chroma
+    YUV420          // chroma halved both ways
+};
+
+enum class EncoderPreset {
+    QUALITY,        // slowest, best compression
+    BALANCED,
+    FAST            // cheapest per frame
+};
+
+// Encoding effort the pipeline asks of the encode stage. The pipeline applies
+// the frame rate itself; the rest is a request to the frame encoder, stamped
+// on every PipelineFrame, and only varies along the encoder's EncoderKnobs.
+struct QualityLevel {
+    int step = 0;                  // 0 = full quality, each step is cheaper
+    float resolutionScale = 1.0f;  // per axis, of the captured size
+    ChromaSubsampling chroma = ChromaSubsampling::YUV444;
+    EncoderPreset preset = EncoderPreset::QUALITY;
+    float fpsScale = 1.0f;         // of RecordingConfig::fps
+
+    // e.g. "scale 0.75, 4:2:0, fast preset, 22.5 fps"
+    std::string describe(float fps) const;
+};
+
+// What a frame encoder does with PipelineFrame::quality; declared with
+// ScreenHandler::setFrameEncoder. Knobs it ignores stay out of the ladder.
+struct EncoderKnobs {
+    bool resolution = false;
+    bool chroma = false;
+    bool preset = false;
+};
+
+struct AdaptiveQualityOptions {
+    // Knobs the controller may turn, stepped down in this order. All but the
+    // frame rate also need the encoder's support (EncoderKnobs).
+    bool scaleResolution = true;   // 1 -> 0.75 -> 0.5
+    bool subsampleChroma = true;   // 4:4:4 -> 4:2:0
+    bool lowerPreset = true;       // quality -> balanced -> fast
+    bool lowerFrameRate = true;    // 1 -> 0.75 -> 0.5 of the configured fps
+
+    float stepDownLoad = 0.95f;    // share of the frame budget counted as overloaded
+    float stepUpLoad = 0.7f;       // predicted share at the level above must stay below this
+    int stepDownSamples = 2;       // consecutive overloaded evaluations before stepping down
+    int stepUpSamples = 8;         // consecutive evaluations with headroom before stepping up
+    std::chrono::milliseconds interval{250};     // between evaluations
+    std::chrono::milliseconds settleTime{1000};  // after a change, before the next one
+};
+
+// What the pipeline measured since the previous evaluation
+struct PipelineLoad {
+    float captureMs = 0.0f;        // per frame
+    float encodeMs = 0.0f;         // per frame, on one worker
+    int encoders = 1;
+    int backlog = 0;               // frames queued in front of process and encode
+    int backlogLimit = 0;          // backlog at or above this counts as overloaded
+    int newDrops = 0;
+};
+
+// Closed-loop quality ladder: steps down while capture + encode overruns the
+// frame budget, and back up once the level above is predicted to fit with
+// room to spare. The prediction uses the encode cost ratio measured across
+// each step on the way down, and relativeCost() for steps not yet measured.
+// The up threshold, the longer up streak and the settle time after every
+// change keep it from oscillating between two levels.
+class QualityController {
+public:
+    enum class Decision { HOLD, STEP_DOWN, STEP_UP };
+
+    explicit QualityController(const AdaptiveQualityOptions& options = AdaptiveQualityOptions());
+
+    // Rebuilds the ladder from the options and knobs and returns to full quality
+    void reset(float fps);
+    void setOptions(const AdaptiveQualityOptions& options);
+    const AdaptiveQualityOptions& getOptions() const { return m_options; }
+    void setEncoderKnobs(const EncoderKnobs& knobs);
+
+    Decision evaluate(const PipelineLoad& load, std::chrono::steady_clock::time_point now);
+
+    const QualityLevel& getLevel() const { return m_ladder[m_step]; }
+    const QualityLevel& getLevel(int step) const { return m_ladder[step]; }
+    int getStepCount() const { return static_cast<int>(m_ladder.size()); }
+    float getFrameBudget(int step) const; // ms
+    // Capture + encode per frame over the budget, as of the last evaluation
+    float getLoad() const { return m_load; }
+
+    // Encode work per frame relative to full quality, from the sample count
+    // alone; presets have no fixed ratio and count as equal
+    static float relativeCost(const QualityLevel& level);
+
+private:
+    AdaptiveQualityOptions m_options;
+    EncoderKnobs m_knobs;
+    std::vector<QualityLevel> m_ladder;
+    std::vector<float> m_stepCost;   // measured encode cost over the step above, 0 = not yet
+    float m_encodeBeforeStep = 0.0f; // ms per frame just before the last step down
+    bool m_measureStep = false;      // next settled evaluation measures m_stepCost
+    int m_step = 0;
+    float m_fps = 30.0f;
+    float m_load = 0.0f;
+    int m_overloadedStreak = 0;
+    int m_headroomStreak = 0;
+    std::chrono::steady_clock::time_point m_lastChange;
+};
+
+}} // namespace Recordify::ScreenHandler
+
+#endif // RECORDIFY_QUALITY_CONTROLLER_H
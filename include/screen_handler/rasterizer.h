@@ -0,0 +1,188 @@
+#ifndef RECORDIFY_RASTERIZER_H
+#define RECORDIFY_RASTERIZER_H
+
+#include "utils/geometry.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+class TiledSurface;
+
+struct PointF {
+    float x = 0.0f;
+    float y = 0.0f;
+
+    PointF() = default;
+    PointF(float x, float y) : x(x), y(y) {}
+};
+
+// Premultiplied RGBA, same byte order as RasterSurface pixels
+struct PremultipliedColor {
+    uint8_t r = 0, g = 0, b = 0, a = 0;
+
+    static PremultipliedColor fromStraight(uint8_t r, uint8_t g, uint8_t b, uint8_t a,
+                                           float opacity = 1.0f);
+    bool isTransparent() const { return a == 0; }
+};
+
+// CPU-side RGBA8 canvas holding premultiplied pixels, rows 16-byte aligned
+class RasterSurface {
+public:
+    RasterSurface() = default;
+    RasterSurface(int width, int height);
+    RasterSurface(const RasterSurface& other);
+    RasterSurface(RasterSurface&& other) noexcept = default;
+    RasterSurface& operator=(const RasterSurface& other);
+    RasterSurface& operator=(RasterSurface&& other) noexcept = default;
+
+    bool resize(int width, int height); // contents are cleared
+    void release();
+    void clear(PremultipliedColor color = PremultipliedColor());
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    size_t stride() const { return m_stride; }
+    bool isEmpty() const { return m_width <= 0 || m_height <= 0; }
+    Utils::Rectangle bounds() const { return Utils::Rectangle(0, 0, m_width, m_height); }
+
+    uint8_t* row(int y) { return m_pixels.data() + m_offset + m_stride * y; }
+    const uint8_t* row(int y) const { return m_pixels.data() + m_offset + m_stride * y; }
+    PremultipliedColor pixel(int x, int y) const;
+
+    // FNV-1a over the visible pixels, used for golden-image comparisons
+    uint64_t hash() const;
+
+private:
+    std::vector<uint8_t> m_pixels;
+    size_t m_offset = 0; // to the first 16-byte aligned byte
+    size_t m_stride = 0;
+    int m_width = 0;
+    int m_height = 0;
+};
+
+enum class LineCap {
+    BUTT,
+    ROUND,
+    SQUARE
+};
+
+struct StrokeStyle {
+    float width = 1.0f;
+    LineCap cap = LineCap::BUTT;
+    std::vector<float> dashPattern; // on/off lengths, empty for solid
+    float dashOffset = 0.0f;
+};
+
+// Flattened outline made of straight contours. Curves are subdivided as they
+// are added, to within `tolerance` pixels.
+class RasterPath {
+public:
+    struct Contour {
+        size_t begin;
+        size_t end; // one past the last point
+        bool closed;
+    };
+
+    void moveTo(float x, float y);
+    void lineTo(float x, float y);
+    void cubicTo(const PointF& control1, const PointF& control2, const PointF& end,
+                 float tolerance = 0.25f);
+    void close();
+    void clear();
+
+    void addPolygon(const std::vector<PointF>& points, bool closed);
+    void addRect(float x, float y, float width, float height);
+    void addRoundedRect(float x, float y, float width, float height, float radius,
+                        float tolerance = 0.25f);
+    void addEllipse(float cx, float cy, float rx, float ry, float tolerance = 0.25f);
+
+    // Built-in 5x8 bitmap font, scaled so a line is `size` pixels tall.
+    // (x, y) is the top-left corner of the first glyph cell.
+    void addText(const std::string& text, float x, float y, float size,
+                 bool bold = false, bool italic = false, float letterSpacing = 0.0f);
+    static float measureText(const std::string& text, float size, bool bold = false,
+                             float letterSpacing = 0.0f);
+
+    // Outline of this path stroked with `style`; fill it to draw the stroke
+    RasterPath stroked(const StrokeStyle& style) const;
+    // Open contours covering the "on" intervals of a dash pattern
+    RasterPath dashed(const std::vector<float>& pattern, float offset) const;
+
+    template <typename Fn>
+    void transform(Fn&& fn) {
+        for (auto& point : m_points) {
+            point = fn(point);
+        }
+    }
+
+    void translate(float dx, float dy);
+
+    const std::vector<PointF>& points() const { return m_points; }
+    const std::vector<Contour>& contours() const { return m_contours; }
+    bool isEmpty() const { return m_contours.empty(); }
+
+private:
+    std::vector<PointF> m_points;
+    std::vector<Contour> m_contours;
+    bool m_open = false;
+};
+
+// Scanline rasterizer with exact-area anti-aliasing. Fills use the non-zero
+// rule; each row's coverage is accumulated from the edges crossing it and
+// blended into the target one span at a time (SSE2 when available).
+class Rasterizer {
+public:
+    explicit Rasterizer(RasterSurface& surface);
+    explicit Rasterizer(TiledSurface& surface);
+
+    // Retargeting resets the clip
+    void setTarget(RasterSurface& surface);
+    void setTarget(TiledSurface& surface);
+
+    void setClip(const Utils::Rectangle& clip); // empty clears it
+    void setAntiAliasing(bool enabled) { m_antiAliasing = enabled; }
+    bool antiAliasing() const { return m_antiAliasing; }
+
+    // Both return the device-space bounds that were touched
+    Utils::Rectangle fill(const RasterPath& path, PremultipliedColor color);
+    Utils::Rectangle stroke(const RasterPath& path, const StrokeStyle& style,
+                            PremultipliedColor color);
+
+    // Source-over blend of a solid color through an 8-bit coverage mask.
+    // Public so the SIMD and scalar paths can be checked against each other.
+    static void blendSpan(uint8_t* pixels, const uint8_t* coverage, int count,
+                          PremultipliedColor color, bool allowSimd = true);
+
+private:
+    struct Edge {
+        float yTop;
+        float yBottom;
+        float xTop;   // x at yTop
+        float dxdy;
+        float direction;
+    };
+
+    void accumulateRow(const Edge& edge, int y);
+    Utils::Rectangle targetBounds() const;
+
+    RasterSurface* m_surface = nullptr; // exactly one target is set
+    TiledSurface* m_tiles = nullptr;
+    Utils::Rectangle m_clip;
+    bool m_antiAliasing = true;
+
+    // Scratch reused between calls
+    std::vector<Edge> m_edges;
+    std::vector<const Edge*> m_active;
+    std::vector<float> m_accumulation;
+    std::vector<uint8_t> m_coverage;
+    int m_touchedBegin = 0;
+    int m_touchedEnd = 0;
+};
+
+}} // namespace Recordify::ScreenHandler
+
+#endif // RECORDIFY_RASTERIZER_H
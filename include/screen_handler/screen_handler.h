@@ -3,7 +3,9 @@
 
 #include "screen_handler/screen_writer.h"
 #include "screen_handler/screen_reader.h"
+#include "screen_handler/quality_controller.h"
 #include "utils/geometry.h"
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -30,6 +32,19 @@ enum class CaptureQuality {
     ULTRA = 4       // 4K, 60fps, maximum bitrate
 };
 
+// How frames are captured into the pipeline
+enum class CaptureMode {
+    FULL_FRAME,     // Every frame carries the whole capture area
+    DIRTY_TILES     // Frames carry only tiles changed since the previous frame
+};
+
+// What the pipeline does when a stage cannot keep up
+enum class DropPolicy {
+    BLOCK,          // Capture waits for a free frame slot (no frames lost)
+    DROP_NEWEST,    // Skip capturing while every frame slot is in flight
+    DROP_OLDEST     // Encoders discard stale queued frames to catch up
+};
+
 // Recording configuration
 struct RecordingConfig {
     RecordingMode mode = RecordingMode::FULLSCREEN;
@@ -56,13 +71,38 @@ struct RecordingConfig {
     
     // Performance settings
     bool useHardwareAcceleration = true;
-    bool adaptiveQuality = true;
+    bool adaptiveQuality = true; // step encoding effort with load, see QualityController
     int bufferSize = 30; // frames
+    CaptureMode captureMode = CaptureMode::FULL_FRAME;
+    DropPolicy dropPolicy = DropPolicy::DROP_NEWEST;
+    int maxQueuedFrames = 4; // per encoder, before DROP_OLDEST discards
     
     // Output settings
-    std::string outputFormat = "MP4";
+    std::string outputFormat = "MP4"; // only AVI (MJPEG) and SPOOL (raw frames) are written so far
     std::string outputPath = "";
-    bool autoSave = true;
+    bool autoSave = true; // write rolling segments that survive a crash
+    float segmentDuration = 60.0f; // seconds per segment when autoSave is on
+    uint64_t spoolSize = 32ull << 30; // bytes preallocated for SPOOL output
+};
+
+// Why a frame left the pipeline without being written
+enum class DropReason {
+    NO_FREE_SLOT,   // every frame slot was in flight at the capture tick (DROP_NEWEST)
+    STALE,          // skipped by an encoder to catch up (DROP_OLDEST)
+    ENCODE_FAILED,  // the frame encoder rejected it
+    CAPTURE_FAILED  // the reader could not grab the screen at the capture tick
+};
+constexpr int DROP_REASON_COUNT = 4;
+
+// Latency distribution of one pipeline stage, in ms
+struct LatencySummary {
+    uint64_t count = 0;
+    float mean = 0.0f;
+    float p50 = 0.0f;
+    float p90 = 0.0f;
+    float p99 = 0.0f;
+    float p999 = 0.0f;
+    float max = 0.0f;
 };
 
 // Real-time capture statistics
@@ -77,10 +117,31 @@ struct CaptureStats {
     float captureTime = 0.0f;    // ms per frame
     float processTime = 0.0f;    // ms per frame
     float encodeTime = 0.0f;     // ms per frame
+    float writeTime = 0.0f;      // ms per frame
+    
+    // Distributions since start or reset; endToEnd runs from the end of the
+    // grab until the frame is written out (its write completion, or the frame
+    // writer returning without one), queueing and disk I/O included
+    LatencySummary captureLatency;
+    LatencySummary processLatency;
+    LatencySummary encodeLatency;
+    LatencySummary writeLatency;
+    LatencySummary endToEndLatency;
+    
+    // Frames waiting in front of each stage when the stats were taken
+    int processQueueDepth = 0;
+    int encodeQueueDepth = 0;    // all encoders
+    int writeQueueDepth = 0;
+    int freeSlots = 0;
+    int dropsByReason[DROP_REASON_COUNT] = {};
+    int writeErrors = 0;
+    int qualityStep = 0;         // adaptive quality ladder, 0 = full quality
     
     // Memory usage
     int memoryUsage = 0;         // MB
     int bufferUsage = 0;         // %
+    uint64_t poolHits = 0;       // frames served from pooled slabs
+    uint64_t poolMisses = 0;     // frames that fell back to the heap
     
     // Quality metrics
     float compressionRatio = 0.0f;
@@ -90,6 +151,26 @@ struct CaptureStats {
     std::chrono::steady_clock::time_point lastUpdate;
 };
 
+// Frame flowing through the capture -> process -> encode -> write pipeline
+struct PipelineFrame {
+    uint64_t sequence = 0;
+    bool incremental = false; // changes is filled instead of capture
+    ScreenCapture capture;
+    SparseCapture changes;
+    Utils::Point cursorPosition;
+    QualityLevel quality; // what the encoder should aim for at capture time, along its EncoderKnobs
+    
+    // Filled by the encode stage
+    std::vector<uint8_t> encodedData;
+    bool keyFrame = true;
+    bool dropped = false;
+    
+    // Per-stage completion times
+    std::chrono::steady_clock::time_point capturedAt;
+    std::chrono::steady_clock::time_point processedAt;
+    std::chrono::steady_clock::time_point encodedAt;
+};
+
 // Event types for the unified handler
 enum class ScreenEvent {
     CAPTURE_STARTED,
@@ -101,7 +182,8 @@ enum class ScreenEvent {
     ANNOTATION_REMOVED,
     DRAWING_STARTED,
     DRAWING_FINISHED,
-    ERROR_OCCURRED
+    ERROR_OCCURRED,
+    QUALITY_CHANGED     // adaptive quality stepped up or down
 };
 
 // Advanced screen interaction modes
@@ -217,11 +299,44 @@ public:
     CaptureStats getCaptureStats() const;
     void resetCaptureStats();
     
+    // Pipeline latencies, queue depths and drops in Prometheus text format.
+    // Safe to call from any thread, as are the exporters feeding on it.
+    std::string getMetricsText() const;
+    bool exportMetricsToFile(const std::string& path, int intervalMs = 5000);
+    bool serveMetrics(const std::string& socketPath); // unix socket, one scrape per connection
+    void stopMetricsExport();
+    
+    // Pipeline stage hooks, set before startCapture. They run on pipeline
+    // threads: the processor on the process thread, the encoder on every
+    // encode worker at once, and the writer on the writer thread, one frame
+    // at a time in capture order.
+    using FrameProcessor = std::function<void(PipelineFrame&)>;
+    using FrameEncoder = std::function<bool(PipelineFrame&)>;
+    using FrameWriter = std::function<bool(const PipelineFrame&)>;
+    // For writers whose output lands later on a thread of their own (e.g. a
+    // FileWriter's I/O thread): called after each frame the writer accepted,
+    // it must call `done` once that frame's bytes are in the file
+    using WriteCompletion = std::function<void(std::function<void()> done)>;
+    
+    void setFrameProcessor(FrameProcessor processor) { m_frameProcessor = processor; }
+    // `knobs`: which parts of PipelineFrame::quality the encoder acts on
+    void setFrameEncoder(FrameEncoder encoder, const EncoderKnobs& knobs = EncoderKnobs()) {
+        m_frameEncoder = encoder;
+        m_encoderKnobs = knobs;
+    }
+    void setFrameWriter(FrameWriter writer, WriteCompletion completion = WriteCompletion()) {
+        m_frameWriter = writer;
+        m_writeCompletion = completion;
+    }
+    
     // Performance optimization
     void setPerformanceMode(bool enabled); // Optimize for performance over quality
     void setPreviewEnabled(bool enabled);  // Show real-time preview
     void setBufferSize(int frames);
     void setThreadCount(int count);        // Parallel processing threads
+    // Adaptive quality tuning; takes effect on the next startCapture
+    void setAdaptiveQualityOptions(const AdaptiveQualityOptions& options);
+    QualityLevel getQualityLevel() const;
     
     // Error handling and diagnostics
     enum class ErrorCode {
@@ -240,7 +355,10 @@ public:
     bool hasError() const { return m_lastError != ErrorCode::SUCCESS; }
     void clearError();
     
-    // Event system
+    // Event system. The callback runs on the thread that raised the event:
+    // FRAME_CAPTURED on the pipeline's writer thread, QUALITY_CHANGED on its
+    // process thread, errors on whichever thread hit them, and the rest on
+    // the caller's. It must be thread-safe, and quick, as the stages wait on it.
     using EventCallback = std::function<void(ScreenEvent, const std::string&)>;
     void setEventCallback(EventCallback callback) { m_eventCallback = callback; }
     
@@ -286,11 +404,15 @@ private:
     
     // Callbacks
     EventCallback m_eventCallback;
+    FrameProcessor m_frameProcessor;
+    FrameEncoder m_frameEncoder;
+    EncoderKnobs m_encoderKnobs;
+    FrameWriter m_frameWriter;
+    WriteCompletion m_writeCompletion;
     
     // Internal capture state
     std::chrono::steady_clock::time_point m_captureStartTime;
-    std::vector<ScreenCapture> m_captureBuffer;
-    int m_currentFrame;
+    std::atomic<int> m_currentFrame; // bumped by the writer thread, reset by startCapture
     
     // Action recording
     bool m_recordingActions;
@@ -301,7 +423,9 @@ private:
     void shutdownComponents();
     bool validateConfig(const RecordingConfig& config);
     void updateCaptureArea();
-    void processFrame();
+    void processFrame(PipelineFrame& frame);
+    void encodeFrame(PipelineFrame& frame);
+    bool writeFrame(PipelineFrame& frame);
     void handleReaderEvents();
     void handleWriterEvents();
     
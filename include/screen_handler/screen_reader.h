@@ -1,13 +1,18 @@
 #ifndef RECORDIFY_SCREEN_READER_H
 #define RECORDIFY_SCREEN_READER_H
 
+#include "screen_handler/capture_source.h"
+#include "screen_handler/frame_pool.h"
+#include "utils/color_stats.h"
+#include "utils/ring_buffer.h"
+#include "screen_handler/screen_writer.h"
 #include "utils/geometry.h"
 #include <vector>
 #include <string>
 #include <functional>
 #include <chrono>
+#include <cstdint>
 #include <memory>
-#include <map>
 
 namespace Recordify {
 namespace ScreenHandler {
@@ -45,7 +50,7 @@ struct MouseState {
 
 // Keyboard state and input tracking
 struct KeyState {
-    int keyCode;
+    int keyCode = 0;
     bool pressed = false;
     bool wasPressed = false; // previous frame state
     std::chrono::steady_clock::time_point pressTime;
@@ -56,21 +61,82 @@ struct KeyState {
     float getPressedDuration() const;
 };
 
+// One bit per virtual key code
+struct KeyBitset {
+    uint64_t words[4] = {0, 0, 0, 0};
+    
+    bool test(int keyCode) const { return (words[keyCode >> 6] >> (keyCode & 63)) & 1; }
+    void set(int keyCode, bool value = true) {
+        uint64_t bit = uint64_t(1) << (keyCode & 63);
+        words[keyCode >> 6] = value ? (words[keyCode >> 6] | bit) : (words[keyCode >> 6] & ~bit);
+    }
+    bool any() const { return (words[0] | words[1] | words[2] | words[3]) != 0; }
+    int count() const;
+    
+    KeyBitset operator&(const KeyBitset& other) const;
+    KeyBitset operator|(const KeyBitset& other) const;
+    KeyBitset operator^(const KeyBitset& other) const;
+    bool operator==(const KeyBitset& other) const;
+    bool operator!=(const KeyBitset& other) const { return !(*this == other); }
+    
+    // Calls f(keyCode) for every set bit in ascending order
+    template <typename F>
+    void forEach(F&& f) const {
+        for (int word = 0; word < 4; ++word) {
+            for (uint64_t bits = words[word]; bits != 0; bits &= bits - 1) {
+                f(word * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+};
+
+// Cheap copy of which keys are down at a point in time
+struct KeySnapshot {
+    KeyBitset pressed;
+    std::chrono::steady_clock::time_point timestamp;
+    
+    KeyBitset changedSince(const KeySnapshot& earlier) const { return pressed ^ earlier.pressed; }
+};
+
+// Fixed-size key table indexed by virtual key code; copying never allocates
+class KeyTable {
+public:
+    static constexpr int KEY_COUNT = 256;
+    static bool isValid(int keyCode) { return keyCode >= 0 && keyCode < KEY_COUNT; }
+    
+    KeyTable();
+    
+    const KeyState& operator[](int keyCode) const { return m_keys[keyCode]; }
+    void press(int keyCode, std::chrono::steady_clock::time_point when);
+    void release(int keyCode, std::chrono::steady_clock::time_point when);
+    
+    // End of tick: the current state becomes the previous one
+    void advance();
+    
+    const KeyBitset& pressed() const { return m_pressed; }
+    const KeyBitset& previous() const { return m_previous; }
+    KeyBitset changed() const { return m_pressed ^ m_previous; }
+    
+private:
+    KeyState m_keys[KEY_COUNT];
+    KeyBitset m_pressed;
+    KeyBitset m_previous;
+};
+
 struct KeyboardState {
-    std::map<int, KeyState> keys;
+    KeyTable keys;
     std::string lastTypedText;
     std::string currentInputText; // for IME support
     
-    std::vector<int> modifierKeys; // Ctrl, Alt, Shift, etc.
-    
     std::chrono::steady_clock::time_point timestamp;
     
     // Helper methods
     bool isKeyPressed(int keyCode) const;
     bool isKeyJustPressed(int keyCode) const;
     bool isKeyJustReleased(int keyCode) const;
-    bool isModifierPressed(int modifier) const; // VK_CONTROL, VK_SHIFT, etc.
+    bool isModifierPressed(int modifier) const; // VK_CONTROL, VK_SHIFT, etc. (either side)
     std::vector<int> getPressedKeys() const;
+    KeySnapshot snapshot() const { return KeySnapshot{keys.pressed(), timestamp}; }
 };
 
 // Display and screen information
@@ -165,30 +231,114 @@ struct WindowInfo {
     bool intersects(const WindowInfo& other) const;
 };
 
-// Screen capture and content analysis
+// Read-only window onto captured pixels. Owns nothing and copies nothing;
+// valid while the frame it was taken from is alive and unchanged.
+struct FrameView {
+    const uint8_t* pixels = nullptr; // top-left pixel
+    size_t stride = 0;               // bytes from one row to the next
+    int width = 0, height = 0;
+    int bitsPerPixel = 24;
+    Utils::Rectangle area;           // screen coordinates
+    std::chrono::steady_clock::time_point timestamp;
+    
+    int bytesPerPixel() const { return bitsPerPixel / 8; }
+    size_t rowBytes() const { return static_cast<size_t>(width) * bytesPerPixel(); }
+    bool isValid() const { return pixels && width > 0 && height > 0 && stride >= rowBytes(); }
+    const uint8_t* row(int y) const { return pixels + stride * y; }
+    
+    // Part of the view (frame coordinates), clipped to it
+    FrameView subView(const Utils::Rectangle& rect) const;
+};
+
+// Screen capture and content analysis. A captured frame owns a handle on its
+// pooled pixel buffer and is move-only, so whole frames are never copied by
+// accident: share() hands out another handle on the same pixels, clone()
+// makes a deep copy, and view() gives read-only consumers a FrameView.
+// A crop narrows the frame to a sub-rectangle of the same buffer, so rows
+// may be wider than width * bytesPerPixel; always step by bytesPerRow().
 struct ScreenCapture {
     Utils::Rectangle area;
-    std::vector<uint8_t> pixelData;
-    int width, height;
-    int bitsPerPixel;
+    FrameBuffer pixelData; // borrowed from the reader's FramePool
+    size_t offset = 0;     // first pixel within pixelData
+    size_t stride = 0;     // bytes per row, 0 = tightly packed
+    int width = 0, height = 0;
+    int bitsPerPixel = 24;
     std::chrono::steady_clock::time_point timestamp;
     
+    ScreenCapture() = default;
+    ScreenCapture(ScreenCapture&&) noexcept = default;
+    ScreenCapture& operator=(ScreenCapture&&) noexcept = default;
+    ScreenCapture(const ScreenCapture&) = delete;
+    ScreenCapture& operator=(const ScreenCapture&) = delete;
+    
+    ScreenCapture share() const; // same pixels, no copy
+    ScreenCapture clone() const; // packed copy in a standalone buffer
+    
+    int bytesPerPixel() const { return bitsPerPixel / 8; }
+    size_t bytesPerRow() const { return stride ? stride : static_cast<size_t>(width) * bytesPerPixel(); }
+    const uint8_t* pixels() const { return pixelData.data() + offset; }
+    uint8_t* pixels() { return pixelData.data() + offset; }
+    bool hasPixels() const; // buffer covers width x height at bytesPerRow()
+    
+    FrameView view() const;
+    FrameView view(const Utils::Rectangle& rect) const { return view().subView(rect); } // frame coordinates
+    // Narrow to rect (frame coordinates) without touching the pixels
+    bool crop(const Utils::Rectangle& rect);
+    
     // Color analysis
     struct ColorStats {
         Color dominantColor;
         Color averageColor;
         std::vector<Color> colorPalette;
+        std::vector<uint32_t> luminanceHistogram; // 256 bins over sampled pixels
         float brightness = 0.0f;
-        float contrast = 0.0f;
-        float saturation = 0.0f;
+        float contrast = 0.0f;   // RMS contrast of luminance, 0-1
+        float saturation = 0.0f; // mean HSV saturation, 0-1
     };
     
-    ColorStats analyzeColors() const;
+    // Sub-sample rows/columns or spread bands over threads via options
+    ColorStats analyzeColors(const Utils::ColorStatsOptions& options = Utils::ColorStatsOptions()) const;
     bool hasMotion(const ScreenCapture& previous, float threshold = 0.1f) const;
     std::vector<Utils::Rectangle> findTextRegions() const;
+    
+    // Tile hashing for incremental capture. Regions and tiles are in frame
+    // coordinates (0,0 is the capture's top-left corner).
+    static constexpr int TILE_SIZE = 64;
+    std::vector<uint64_t> tileHashes; // row-major per tile; empty until hashTiles()
+    
+    void hashTiles();
+    int tileColumns() const { return (width + TILE_SIZE - 1) / TILE_SIZE; }
+    int tileRows() const { return (height + TILE_SIZE - 1) / TILE_SIZE; }
+    Utils::Rectangle tileRect(int tileIndex) const;
+    void findChangedTiles(const ScreenCapture& previous, std::vector<int>& changedTiles) const;
     std::vector<Utils::Rectangle> findChangedRegions(const ScreenCapture& previous) const;
 };
 
+// Changed tiles of a frame relative to the previous capture. Tile pixels are
+// packed row by row in tile order, so consumers never need the full frame.
+struct SparseCapture {
+    Utils::Rectangle area;
+    int width = 0, height = 0;
+    int bitsPerPixel = 24;
+    std::chrono::steady_clock::time_point timestamp;
+    bool keyFrame = false; // no reference frame; tiles cover the whole capture
+    
+    std::vector<Utils::Rectangle> tiles; // frame coordinates
+    std::vector<size_t> tileOffsets;     // start of each tile in pixelData
+    std::vector<uint8_t> pixelData;
+    
+    void clear();
+    bool empty() const { return tiles.empty(); }
+    int bytesPerPixel() const { return bitsPerPixel / 8; }
+    const uint8_t* tilePixels(size_t index) const { return pixelData.data() + tileOffsets[index]; }
+    
+    float changeRatio() const; // changed pixels / total pixels
+    bool hasMotion(float threshold = 0.1f) const { return changeRatio() > threshold; }
+    
+    // Copy the changed tiles into a full frame of the same geometry
+    bool applyTo(ScreenCapture& frame) const;
+};
+
 // Cursor and pointer information
 struct CursorInfo {
     Utils::Point position;
@@ -241,6 +391,11 @@ public:
     
     // Advanced mouse tracking
     std::vector<Utils::Point> getMouseTrail(int maxPoints = 50) const;
+    // Zero-copy view of the latest points; `sequence` receives what
+    // isMouseTrailIntact needs to tell whether the 128-point trail has
+    // wrapped past it, so check that after reading the points
+    Utils::Span<Utils::Point> getMouseTrailView(uint64_t& sequence, int maxPoints = 50) const;
+    bool isMouseTrailIntact(uint64_t sequence, size_t count) const;
     void clearMouseTrail();
     bool isMouseIdle(float seconds = 5.0f) const;
     Utils::Rectangle getMouseMovementBounds() const; // Bounding box of recent movement
@@ -255,6 +410,7 @@ public:
     
     // Advanced keyboard tracking
     std::vector<int> getKeySequence(int maxKeys = 20) const;
+    KeySnapshot getKeySnapshot() const;
     float getTypingSpeed() const; // Words per minute
     bool detectKeyboardShortcut(const std::vector<int>& keys) const;
     
@@ -275,13 +431,33 @@ public:
     // Screen capture capabilities
     bool captureScreen(ScreenCapture& capture, const Utils::Rectangle& area = Utils::Rectangle()) const;
     bool captureWindow(ScreenCapture& capture, uintptr_t windowHandle) const;
+    // Crop of a display grab: capture shares the full frame's buffer
     bool captureRegion(ScreenCapture& capture, const Utils::Rectangle& region) const;
     
+    // Pixel source for all captures; initialize() picks the platform default.
+    // Opens the source and takes the primary display size from its bounds.
+    bool setCaptureSource(std::unique_ptr<CaptureSource> source);
+    const char* getCaptureSourceName() const;
+    
+    // Incremental capture: only the tiles that changed since the last call,
+    // plus any overlapping `resend` (frame coordinates), e.g. tiles under an
+    // overlay that gets blended onto them downstream
+    bool captureChanges(SparseCapture& changes, const Utils::Rectangle& area = Utils::Rectangle(),
+                        const std::vector<Utils::Rectangle>& resend = std::vector<Utils::Rectangle>());
+    static constexpr int MAX_RECENT_CAPTURES = 3;
+    
+    // Frame buffer pool backing captured pixel data
+    bool configureFramePool(int frameCount, size_t frameBytes);
+    FramePool::Stats getFramePoolStats() const;
+    // Bytes a grab of `area` takes at the source's pixel format, after
+    // clipping to the source (empty area = primary display)
+    size_t getFrameBytes(const Utils::Rectangle& area = Utils::Rectangle()) const;
+    
     // Advanced capture features
     bool startContinuousCapture(const Utils::Rectangle& area, float fps = 30.0f);
     bool stopContinuousCapture();
     bool isContinuousCapturing() const;
-    std::vector<ScreenCapture> getRecentCaptures(int count = 10) const;
+    std::vector<ScreenCapture> getRecentCaptures(int count = 10) const; // shared, newest last
     
     // Screen content analysis
     bool detectMotion(const Utils::Rectangle& area, float threshold = 0.1f) const;
@@ -295,6 +471,7 @@ public:
     WindowInfo getActiveWindow() const;
     WindowInfo getForegroundWindow() const;
     WindowInfo getWindowAt(const Utils::Point& point) const;
+    std::vector<WindowInfo> getWindowsIn(const Utils::Rectangle& area) const; // visible, in list order
     WindowInfo getWindowByTitle(const std::string& title) const;
     WindowInfo getWindowByClassName(const std::string& className) const;
     WindowInfo getWindowByProcessId(unsigned long processId) const;
@@ -325,7 +502,10 @@ public:
     using WindowCallback = std::function<void(const WindowInfo&, const std::string& event)>;
     using DisplayCallback = std::function<void(const DisplayInfo&, const std::string& event)>;
     using CursorCallback = std::function<void(const CursorInfo&)>;
-    using CaptureCallback = std::function<void(const ScreenCapture&)>;
+    using CaptureCallback = std::function<void(const FrameView&)>; // capture thread, frame only borrowed
+    // Called once per key whose state changed since the previous tick
+    using KeyChangeCallback = std::function<void(int keyCode, bool pressed,
+                                                 std::chrono::steady_clock::time_point when)>;
     
     void setMouseCallback(MouseCallback callback);
     void setKeyboardCallback(KeyboardCallback callback);
@@ -333,6 +513,7 @@ public:
     void setDisplayCallback(DisplayCallback callback);
     void setCursorCallback(CursorCallback callback);
     void setCaptureCallback(CaptureCallback callback);
+    void setKeyChangeCallback(KeyChangeCallback callback);
     
     // Feature enable/disable
     void setMouseTrackingEnabled(bool enabled);
@@ -352,7 +533,14 @@ public:
     // Performance and configuration
     void setHighPrecisionMouse(bool enabled);
     void setRawInput(bool enabled);
-    void setUpdateRate(float hz); // Updates per second
+    void setUpdateRate(float hz); // Updates per second, up to 1000
+    
+    // Optional sampling thread: polls input at the update rate and queues
+    // timestamped events for a dispatcher thread that runs the callbacks.
+    // Set callbacks before starting; update() then only handles windows.
+    bool startSampling();
+    void stopSampling();
+    bool isSampling() const;
     void setCaptureQuality(int quality); // 0-100
     
     // Debugging and diagnostics
@@ -367,6 +555,7 @@ public:
         int keyboardEvents = 0;
         int windowEvents = 0;
         int captureEvents = 0;
+        int droppedEvents = 0; // input events lost to a full dispatch queue
     };
     
     ReaderStats getReaderStats() const;
@@ -398,8 +587,14 @@ private:
     DisplayCallback m_displayCallback;
     CursorCallback m_cursorCallback;
     CaptureCallback m_captureCallback;
+    KeyChangeCallback m_keyChangeCallback;
     
     // Internal methods
+    void sampleInput();
+    void samplingLoop();
+    void dispatchLoop();
+    void dispatchKeyboardEvent(const KeySnapshot& keys, const KeyBitset& changed, const std::string& typedText);
+    void deliverKeyChanges(const KeySnapshot& keys, const KeyBitset& changed);
     void processMouseEvents();
     void processKeyboardEvents();
     void processWindowEvents();
@@ -412,7 +607,7 @@ private:
     void notifyWindowChange(const WindowInfo& window, const std::string& event);
     void notifyDisplayChange(const DisplayInfo& display, const std::string& event);
     void notifyCursorChange(const CursorInfo& cursor);
-    void notifyCapture(const ScreenCapture& capture);
+    void notifyCapture(const ScreenCapture& capture) const;
     
     bool validateInitialization() const;
     void updateStats();
@@ -2,11 +2,14 @@
 #define RECORDIFY_SCREEN_WRITER_H
 
 #include "utils/geometry.h"
+#include <atomic>
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
 #include <chrono>
+#include <cstdint>
+#include <map>
 
 namespace Recordify {
 namespace ScreenHandler {
@@ -14,6 +17,9 @@ namespace ScreenHandler {
 // Forward declarations
 class ScreenCanvas;
 class DrawingLayer;
+class RasterSurface;
+class RasterPath;
+struct SparseCapture;
 
 // Drawing primitives and styles
 enum class ShapeType {
@@ -146,25 +152,52 @@ struct DrawingContext {
 };
 
 // Animation support
+enum class Easing : uint8_t {
+    LINEAR,
+    EASE_IN,     // cubic
+    EASE_OUT,
+    EASE_IN_OUT,
+    STEP         // holds the start value until the next keyframe
+};
+
+float applyEasing(Easing easing, float t); // t in 0-1
+
 struct AnimationKeyframe {
     float time; // 0-1
     Utils::Point position;
     float opacity;
     float scale;
     float rotation;
+    Easing easing = Easing::LINEAR; // towards the next keyframe
 };
 
 class Animation {
 public:
     Animation(float duration) : m_duration(duration) {}
-    
+    Animation(const Animation& other)
+        : m_duration(other.m_duration), m_keyframes(other.m_keyframes),
+          m_segmentHint(other.m_segmentHint.load(std::memory_order_relaxed)) {}
+    Animation& operator=(const Animation& other) {
+        m_duration = other.m_duration;
+        m_keyframes = other.m_keyframes;
+        m_segmentHint.store(other.m_segmentHint.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+    
+    // Keeps keyframes sorted by time; equal times keep insertion order
     void addKeyframe(const AnimationKeyframe& keyframe);
+    // Binary search, starting from the segment used last time. Safe to call
+    // from several threads at once; they only share the hint.
     AnimationKeyframe interpolate(float time) const;
     bool isFinished(float currentTime) const;
     
+    float getDuration() const { return m_duration; }
+    const std::vector<AnimationKeyframe>& getKeyframes() const { return m_keyframes; }
+    
 private:
     float m_duration;
     std::vector<AnimationKeyframe> m_keyframes;
+    mutable std::atomic<size_t> m_segmentHint{0}; // any value is valid, relaxed is enough
 };
 
 // Main ScreenWriter class
@@ -182,6 +215,16 @@ public:
     bool createCanvas(const Utils::Size& size);
     bool resizeCanvas(const Utils::Size& newSize);
     void clearCanvas(const Color& backgroundColor = Color::TRANSPARENT);
+    RasterSurface getCanvas() const; // premultiplied RGBA, copied under the render lock
+    
+    // Blends the visible layers onto a packed BGR24 (3) or BGRA32 (4) frame.
+    // Only tiles holding annotations are touched.
+    bool compositeLayers(uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel);
+    // Same, onto each tile of an incremental frame
+    bool compositeLayers(SparseCapture& changes);
+    // Overlay tiles holding annotations, in frame coordinates. Incremental
+    // capture resends these so compositeLayers can blend onto them.
+    std::vector<Utils::Rectangle> getAnnotatedTiles() const;
     
     // Layer management for advanced compositing
     int createLayer(const std::string& name = "");
@@ -272,6 +315,8 @@ public:
     bool removeAnnotation(int annotationId);
     bool updateAnnotation(int annotationId, const Annotation& newAnnotation);
     std::vector<Annotation> getAnnotations() const;
+    int getAnnotationAt(const Utils::Point& point) const; // topmost id, 0 if none
+    std::vector<int> getAnnotationsIn(const Utils::Rectangle& area) const; // visible ids, bottom to top
     void clearAnnotations();
     void undoLastAnnotation();
     void redoAnnotation();
@@ -306,6 +351,7 @@ public:
         float renderTime = 0.0f;
         int memoryUsage = 0;
         int layerCount = 0;
+        uint64_t compositedTiles = 0; // overlay tiles blended onto frames
     };
     
     RenderStats getRenderStats() const;
@@ -333,6 +379,10 @@ private:
     void notifyAnnotation(const Annotation& annotation);
     bool validateContext() const;
     void updateRenderStats();
+    Utils::Rectangle renderPath(RasterPath& path, const ShapeProperties& properties,
+                                bool fillable, bool roundCaps);
+    Utils::Rectangle renderText(RasterPath& path, const TextProperties& properties,
+                                const Utils::Rectangle& clip);
 };
 
 }} // namespace Recordify::ScreenHandler
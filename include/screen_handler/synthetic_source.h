@@ -0,0 +1,66 @@
+#ifndef RECORDIFY_SYNTHETIC_SOURCE_H
+#define RECORDIFY_SYNTHETIC_SOURCE_H
+
+#include "screen_handler/capture_source.h"
+#include <memory>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+// Scripted screen content for repeatable end-to-end measurements
+enum class SyntheticWorkload {
+    STATIC_DESKTOP,     // wallpaper and icons; only the taskbar clock ticks
+    SCROLLING_TERMINAL, // full-width terminal scrolling one text line per frame
+    VIDEO_REGION,       // centred 16:9 region repainted every frame
+    MOVING_WINDOW,      // textured window sliding back and forth, pointer dragging it
+    BLINKING_CURSOR     // idle full-screen terminal with a blinking block cursor
+};
+
+struct SyntheticConfig {
+    SyntheticWorkload workload = SyntheticWorkload::STATIC_DESKTOP;
+    int width = 1920;
+    int height = 1080;
+    uint32_t seed = 1;
+
+    // Fraction of screen pixels that differ from the previous frame on frames
+    // that change; negative picks the workload's typical value. The clock and
+    // the cursor only change every `period` frames, the others every frame.
+    float changedFraction = -1.0f;
+    int period = 15;
+};
+
+// Deterministic CaptureSource: frame N depends only on the config, so runs
+// with the same seed produce identical pixels. Every grab renders the next
+// frame; the changed area per frame is exact up to rounding to whole text
+// lines or pixels.
+class SyntheticSource : public CaptureSource {
+public:
+    explicit SyntheticSource(const SyntheticConfig& config = SyntheticConfig());
+    ~SyntheticSource() override;
+
+    const char* name() const override;
+    bool open() override;
+    void close() override;
+    Utils::Rectangle bounds() const override;
+    int bitsPerPixel() const override { return 32; }
+    bool grab(const Utils::Rectangle& area, uint8_t* pixels, size_t stride) override;
+    bool pointer(Utils::Point& position) override;
+
+    // Index of the last grabbed frame (-1 before the first grab)
+    int64_t getFrameIndex() const;
+    // Bounding box of what changed between the previous and last grabbed frame
+    Utils::Rectangle getChangedArea() const;
+    // Changed pixels between the previous and last grabbed frame over screen pixels
+    float getChangedFraction() const;
+
+    const SyntheticConfig& getConfig() const;
+    static const char* workloadName(SyntheticWorkload workload);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}} // namespace Recordify::ScreenHandler
+
+#endif // RECORDIFY_SYNTHETIC_SOURCE_H
@@ -0,0 +1,69 @@
+#ifndef RECORDIFY_UTILS_COLOR_CONVERT_H
+#define RECORDIFY_UTILS_COLOR_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Recordify {
+namespace Utils {
+
+// Packed RGB to planar 4:2:0 YUV (SSSE3/AVX2 with runtime dispatch, scalar
+// fallback). Every kernel produces bit-identical output:
+//   Y = (kR*R + kG*G + kB*B + bias) >> 15                (per pixel)
+//   U = (kR*sumR + kG*sumG + kB*sumB + bias) >> 17       (per 2x2 quad)
+// with Q15 coefficients and sums over each 2x2 quad. Odd widths/heights
+// repeat the last column/row into the final quad.
+namespace ColorConvert {
+
+enum class Isa {
+    SCALAR,
+    SSSE3,
+    AVX2
+};
+
+enum class PixelFormat {
+    BGR24,  // X11/GDI captures
+    BGRA32,
+    RGBA32
+};
+
+enum class Matrix {
+    BT601,
+    BT709
+};
+
+enum class Range {
+    LIMITED, // Y 16-235, UV 16-240 (video)
+    FULL     // 0-255 (JPEG)
+};
+
+struct ConvertOptions {
+    Matrix matrix = Matrix::BT601;
+    Range range = Range::LIMITED;
+    int threadCount = 1; // row bands converted in parallel; 0 = hardware concurrency
+};
+
+Isa detectIsa();
+Isa activeIsa();
+void setActiveIsa(Isa isa); // clamped to what the CPU supports
+const char* isaName(Isa isa);
+
+inline int bytesPerPixel(PixelFormat format) { return format == PixelFormat::BGR24 ? 3 : 4; }
+inline int chromaWidth(int width) { return (width + 1) / 2; }
+inline int chromaHeight(int height) { return (height + 1) / 2; }
+
+// Separate U and V planes of chromaWidth x chromaHeight
+bool convertToI420(const uint8_t* pixels, int width, int height, size_t stride, PixelFormat format,
+                   uint8_t* y, size_t yStride, uint8_t* u, size_t uStride, uint8_t* v, size_t vStride,
+                   const ConvertOptions& options = ConvertOptions());
+
+// One interleaved UV plane, chromaWidth pairs per row
+bool convertToNV12(const uint8_t* pixels, int width, int height, size_t stride, PixelFormat format,
+                   uint8_t* y, size_t yStride, uint8_t* uv, size_t uvStride,
+                   const ConvertOptions& options = ConvertOptions());
+
+} // namespace ColorConvert
+
+}} // namespace Recordify::Utils
+
+#endif // RECORDIFY_UTILS_COLOR_CONVERT_H
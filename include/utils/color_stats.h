@@ -0,0 +1,66 @@
+#ifndef RECORDIFY_UTILS_COLOR_STATS_H
+#define RECORDIFY_UTILS_COLOR_STATS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Recordify {
+namespace Utils {
+
+// Single-pass color statistics over BGR/BGRA frames (blue first, as captured).
+// Rows can be sub-sampled and split into bands analysed on separate threads;
+// the worker threads and their accumulators are kept between calls.
+struct ColorStatsOptions {
+    int rowStep = 1;      // analyse every Nth row
+    int columnStep = 1;   // analyse every Nth pixel within a row
+    int threadCount = 1;  // row bands analysed in parallel; 0 = hardware concurrency
+    int paletteSize = 8;  // dominant colors to report
+};
+
+struct ColorStatsResult {
+    struct PaletteEntry {
+        uint8_t r = 0, g = 0, b = 0;
+        float share = 0.0f; // fraction of sampled pixels
+    };
+    
+    uint64_t sampleCount = 0;
+    float meanRed = 0.0f, meanGreen = 0.0f, meanBlue = 0.0f; // 0-255
+    float meanLuminance = 0.0f;                              // BT.601, 0-255
+    float luminanceStdDev = 0.0f;
+    float meanSaturation = 0.0f;                             // HSV, 0-1
+    std::array<uint32_t, 256> luminanceHistogram{};
+    std::vector<PaletteEntry> palette;                       // most frequent first
+};
+
+// Palette buckets quantize each channel to this many bits
+constexpr int COLOR_BUCKET_BITS = 3;
+
+// Channel, luma and saturation sums of busy content run on SSE2/AVX2 with
+// runtime dispatch; long runs of identical pixels, and everything on the
+// scalar fallback, are folded once per run instead. All give identical
+// results. The histogram and palette are always filled per run, in scalar
+// code.
+namespace ColorStatsKernels {
+
+enum class Isa {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Best instruction set supported by this CPU, and the one currently in use
+Isa detectIsa();
+Isa activeIsa();
+void setActiveIsa(Isa isa); // clamped to what the CPU supports
+const char* isaName(Isa isa);
+
+} // namespace ColorStatsKernels
+
+ColorStatsResult computeColorStats(const uint8_t* pixels, int width, int height, size_t stride,
+                                   int bytesPerPixel, const ColorStatsOptions& options = ColorStatsOptions());
+
+}} // namespace Recordify::Utils
+
+#endif // RECORDIFY_UTILS_COLOR_STATS_H
@@ -0,0 +1,81 @@
+#ifndef RECORDIFY_UTILS_DIFF_KERNELS_H
+#define RECORDIFY_UTILS_DIFF_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Recordify {
+namespace Utils {
+
+// Frame differencing kernels (SSE2/AVX2 with runtime dispatch, scalar fallback).
+// A byte counts as changed when |current - previous| > threshold, and a 32-bit
+// pixel when any of its four bytes did. Rows must start on a pixel boundary.
+namespace DiffKernels {
+
+enum class Isa {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+struct DiffResult {
+    uint64_t changedBytes = 0;
+    uint64_t changedPixels = 0; // 4-byte groups from the start of each row
+    uint64_t sad = 0;          // sum of absolute differences
+    uint8_t maxDelta = 0;
+
+    void merge(const DiffResult& other) {
+        changedBytes += other.changedBytes;
+        changedPixels += other.changedPixels;
+        sad += other.sad;
+        if (other.maxDelta > maxDelta) maxDelta = other.maxDelta;
+    }
+
+    // Share of `pixels` that changed; whole pixels for 32-bit formats, bytes otherwise
+    float changeRatio(size_t pixels, int bytesPerPixel) const {
+        if (pixels == 0) return 0.0f;
+        if (bytesPerPixel == 4) return static_cast<float>(changedPixels) / pixels;
+        return static_cast<float>(changedBytes) / (pixels * bytesPerPixel);
+    }
+};
+
+struct FrameDiff {
+    int tileSize = 0;
+    int tileColumns = 0;
+    int tileRows = 0;
+    DiffResult total;
+    std::vector<DiffResult> tiles; // row-major
+
+    const DiffResult& tile(int column, int row) const { return tiles[row * tileColumns + column]; }
+};
+
+// Best instruction set supported by this CPU, and the one currently in use
+Isa detectIsa();
+Isa activeIsa();
+void setActiveIsa(Isa isa); // clamped to what the CPU supports
+const char* isaName(Isa isa);
+
+// Whole-buffer statistics in a single pass
+DiffResult diffBuffers(const uint8_t* current, const uint8_t* previous, size_t length,
+                       uint8_t threshold);
+
+// Whole-image statistics over `rows` rows of rowBytes each; rows may be
+// strided differently in the two images (e.g. crops of wider frames)
+DiffResult diffRows(const uint8_t* current, size_t currentStride, const uint8_t* previous,
+                    size_t previousStride, size_t rowBytes, int rows, uint8_t threshold);
+
+// Per-tile statistics for two frames of identical geometry. tileSize is in
+// pixels; rows are `stride` bytes apart.
+void diffFrames(const uint8_t* current, const uint8_t* previous, int width, int height,
+                size_t stride, int bytesPerPixel, int tileSize, uint8_t threshold,
+                FrameDiff& result);
+void diffFrames(const uint8_t* current, size_t currentStride, const uint8_t* previous, size_t previousStride,
+                int width, int height, int bytesPerPixel, int tileSize, uint8_t threshold,
+                FrameDiff& result);
+
+} // namespace DiffKernels
+
+}} // namespace Recordify::Utils
+
+#endif // RECORDIFY_UTILS_DIFF_KERNELS_H
@@ -0,0 +1,87 @@
+#ifndef RECORDIFY_UTILS_LATENCY_HISTOGRAM_H
+#define RECORDIFY_UTILS_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Recordify {
+namespace Utils {
+
+// HDR-style latency histogram in nanoseconds. Values below 64ns get a bucket
+// each; above that every power of two is split into 32 linear sub-buckets,
+// so a reported value is within ~3% of what was recorded. Values past
+// MAX_VALUE are clamped into the last bucket.
+//
+// record() is wait-free and may be called from any number of threads.
+// snapshot() flips writers onto the other half of a double buffer and waits
+// for in-flight records to land, so it sees each record either fully or not
+// at all; readers are serialized by a mutex.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int MAX_VALUE_BITS = 40; // ~18 minutes
+    static constexpr uint64_t MAX_VALUE = (1ull << MAX_VALUE_BITS) - 1;
+    static constexpr size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    struct Snapshot {
+        std::vector<uint64_t> counts; // per bucket
+        uint64_t count = 0;
+        uint64_t sum = 0;  // ns, of the clamped values
+        uint64_t min = 0;
+        uint64_t max = 0;
+
+        double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+        // Upper end of the bucket holding the given percentile (0-100), capped at max
+        uint64_t percentile(double percent) const;
+        // Samples whose bucket lies entirely at or below `value`
+        uint64_t countAtOrBelow(uint64_t value) const;
+        void merge(const Snapshot& other);
+    };
+
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t nanoseconds);
+    void record(std::chrono::steady_clock::duration elapsed) {
+        const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        record(static_cast<uint64_t>(std::max<int64_t>(0, ns)));
+    }
+
+    // Everything recorded since construction or the last reset
+    Snapshot snapshot() const;
+    void reset();
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketLowest(size_t index);
+    static uint64_t bucketHighest(size_t index);
+
+private:
+    struct Phase {
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts;
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> min{UINT64_MAX};
+        std::atomic<uint64_t> max{0};
+        std::atomic<int64_t> endEpoch{0}; // records finished in this phase
+    };
+
+    // Flips the active phase and folds the drained one into m_total
+    void collect() const;
+
+    mutable Phase m_phases[2];
+    // Records started; the sign selects the active phase (negative = odd)
+    mutable std::atomic<int64_t> m_startEpoch{0};
+    mutable std::mutex m_readerMutex;
+    mutable Snapshot m_total;
+};
+
+}} // namespace Recordify::Utils
+
+#endif // RECORDIFY_UTILS_LATENCY_HISTOGRAM_H
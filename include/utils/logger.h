@@ -0,0 +1,143 @@
+#ifndef RECORDIFY_UTILS_LOGGER_H
+#define RECORDIFY_UTILS_LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace Recordify {
+namespace Utils {
+
+// Prefixed so they can't collide with DEBUG/ERROR macros from build flags or windows.h
+enum class LogLevel {
+    LEVEL_TRACE = 0,
+    LEVEL_DEBUG = 1,
+    LEVEL_INFO = 2,
+    LEVEL_WARNING = 3,
+    LEVEL_ERROR = 4,
+    LEVEL_OFF = 5
+};
+
+// Levels below this are compiled out entirely, arguments included
+#ifndef RECORDIFY_LOG_LEVEL
+#ifdef DEBUG
+#define RECORDIFY_LOG_LEVEL 1
+#else
+#define RECORDIFY_LOG_LEVEL 2
+#endif
+#endif
+
+// A log call captured for formatting on the logger thread. Arguments are
+// stored raw (numbers) or copied into a small inline arena (text), so a
+// record is trivially copyable and building one never allocates.
+struct LogRecord {
+    static constexpr int MAX_ARGS = 16;
+    static constexpr int TEXT_BYTES = 224;
+
+    struct Arg {
+        enum Type : uint8_t { SIGNED, UNSIGNED, FLOATING, BOOLEAN, CHARACTER, TEXT } type;
+        uint16_t textOffset;
+        uint16_t textLength;
+        union {
+            int64_t i;
+            uint64_t u;
+            double d;
+        };
+    };
+
+    LogLevel level = LogLevel::LEVEL_INFO;
+    const char* component = nullptr; // must be a string literal
+    std::chrono::system_clock::time_point timestamp;
+    uint8_t argCount = 0;
+    bool truncated = false;
+    uint16_t textUsed = 0;
+    Arg args[MAX_ARGS];
+    char text[TEXT_BYTES];
+
+    void add(bool value) { if (Arg* arg = push(Arg::BOOLEAN)) arg->u = value; }
+    void add(char value) { if (Arg* arg = push(Arg::CHARACTER)) arg->u = static_cast<unsigned char>(value); }
+    void add(const char* value) { addText(value ? value : "(null)", value ? std::strlen(value) : 6); }
+    void add(const std::string& value) { addText(value.data(), value.size()); }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type add(T value) {
+        if constexpr (std::is_floating_point<T>::value) {
+            if (Arg* arg = push(Arg::FLOATING)) arg->d = static_cast<double>(value);
+        } else if constexpr (std::is_signed<T>::value || std::is_enum<T>::value) {
+            if (Arg* arg = push(Arg::SIGNED)) arg->i = static_cast<int64_t>(value);
+        } else {
+            if (Arg* arg = push(Arg::UNSIGNED)) arg->u = static_cast<uint64_t>(value);
+        }
+    }
+
+    void addText(const char* data, size_t length);
+    void format(std::string& out) const;
+
+private:
+    Arg* push(Arg::Type type); // nullptr once MAX_ARGS is reached
+};
+
+// Process-wide asynchronous logger. Producers enqueue records into a
+// bounded lock-free queue; one background thread formats and writes them.
+// A full queue drops the record rather than blocking the caller.
+class Logger {
+public:
+    static Logger& instance();
+
+    void setLevel(LogLevel level) { m_level.store(level, std::memory_order_relaxed); }
+    LogLevel getLevel() const { return m_level.load(std::memory_order_relaxed); }
+    bool shouldLog(LogLevel level) const { return level >= getLevel(); }
+
+    bool setOutputFile(const std::string& filePath); // appends
+    void setOutputStderr();
+
+    template <typename... Args>
+    void log(LogLevel level, const char* component, const Args&... args) {
+        LogRecord record;
+        record.level = level;
+        record.component = component;
+        record.timestamp = std::chrono::system_clock::now();
+        int expand[] = {0, (record.add(args), 0)...};
+        (void)expand;
+        submit(record);
+    }
+
+    void flush(); // blocks until everything submitted so far is written
+    void shutdown(); // drains and stops the thread; later records are written inline
+
+    uint64_t getDroppedRecords() const;
+
+    static const char* levelName(LogLevel level);
+
+private:
+    Logger();
+    ~Logger() = delete; // lives until process exit
+
+    void submit(const LogRecord& record);
+
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+    std::atomic<LogLevel> m_level{LogLevel::LEVEL_TRACE}; // compile-time level filters first
+};
+
+}} // namespace Recordify::Utils
+
+#define RECORDIFY_LOG(level, component, ...)                                                  \
+    do {                                                                                      \
+        if (static_cast<int>(level) >= RECORDIFY_LOG_LEVEL &&                                 \
+            ::Recordify::Utils::Logger::instance().shouldLog(level)) {                        \
+            ::Recordify::Utils::Logger::instance().log(level, component, __VA_ARGS__);        \
+        }                                                                                     \
+    } while (0)
+
+#define RECORDIFY_LOG_TRACE(component, ...) RECORDIFY_LOG(::Recordify::Utils::LogLevel::LEVEL_TRACE, component, __VA_ARGS__)
+#define RECORDIFY_LOG_DEBUG(component, ...) RECORDIFY_LOG(::Recordify::Utils::LogLevel::LEVEL_DEBUG, component, __VA_ARGS__)
+#define RECORDIFY_LOG_INFO(component, ...) RECORDIFY_LOG(::Recordify::Utils::LogLevel::LEVEL_INFO, component, __VA_ARGS__)
+#define RECORDIFY_LOG_WARN(component, ...) RECORDIFY_LOG(::Recordify::Utils::LogLevel::LEVEL_WARNING, component, __VA_ARGS__)
+#define RECORDIFY_LOG_ERROR(component, ...) RECORDIFY_LOG(::Recordify::Utils::LogLevel::LEVEL_ERROR, component, __VA_ARGS__)
+
+#endif // RECORDIFY_UTILS_LOGGER_H
@@ -0,0 +1,59 @@
+#ifndef RECORDIFY_UTILS_METRICS_EXPORTER_H
+#define RECORDIFY_UTILS_METRICS_EXPORTER_H
+
+#include "utils/latency_histogram.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Recordify {
+namespace Utils {
+
+// Builds metrics in the Prometheus text exposition format
+class PrometheusText {
+public:
+    // Starts a metric family; type is "counter", "gauge" or "histogram"
+    void family(const std::string& name, const char* type, const std::string& help);
+    // labels is the inside of the braces, e.g. stage="capture", or empty
+    void sample(const std::string& name, const std::string& labels, double value);
+    // Cumulative buckets at the given upper bounds (seconds), +Inf, _sum and _count
+    void histogram(const std::string& name, const std::string& labels, const LatencyHistogram::Snapshot& snapshot,
+                   const std::vector<double>& boundsSeconds);
+
+    const std::string& str() const { return m_text; }
+
+private:
+    std::string m_text;
+};
+
+// Publishes text produced on demand, either rewritten to a file every
+// interval (written aside then renamed, so node_exporter's textfile
+// collector never reads half a file) or sent to each client connecting to a
+// unix socket. One target at a time; start* replaces the previous one.
+class MetricsExporter {
+public:
+    using Provider = std::function<std::string()>;
+
+    MetricsExporter();
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    static bool writeFile(const std::string& path, const std::string& text);
+
+    bool startFile(const std::string& path, std::chrono::milliseconds interval, Provider provider);
+    bool startSocket(const std::string& path, Provider provider);
+    void stop();
+    bool isRunning() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}} // namespace Recordify::Utils
+
+#endif // RECORDIFY_UTILS_METRICS_EXPORTER_H
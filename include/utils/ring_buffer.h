@@ -0,0 +1,133 @@
+#ifndef RECORDIFY_UTILS_RING_BUFFER_H
+#define RECORDIFY_UTILS_RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "utils/lockfree_queue.h"
+
+namespace Recordify {
+namespace Utils {
+
+// Non-owning view over contiguous elements
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(const T* data, size_t size) : m_data(data), m_size(size) {}
+
+    const T* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+    const T& operator[](size_t index) const { return m_data[index]; }
+    const T& front() const { return m_data[0]; }
+    const T& back() const { return m_data[m_size - 1]; }
+
+private:
+    const T* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// Fixed-capacity history ring: one producer pushes, overwriting the oldest
+// entry once full, while one reader looks at the most recent entries.
+// Up to Capacity - 1 entries are readable; the remaining slot is the one the
+// producer may be writing. Storage is mirrored (every element is written
+// twice, Capacity apart) so the latest N elements are always contiguous and
+// can be handed out as a Span.
+// A view stays intact until the producer pushes Capacity - N more elements;
+// use isIntact() to check, or snapshot() for a validated copy.
+template <typename T, size_t Capacity>
+class RingBuffer {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "RingBuffer elements are copied with memcpy");
+
+public:
+    RingBuffer() = default;
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // Producer side
+    void push(const T& value) {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        const size_t slot = static_cast<size_t>(head) & MASK;
+        std::memcpy(&m_slots[slot], &value, sizeof(T));
+        std::memcpy(&m_slots[slot + Capacity], &value, sizeof(T));
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // Reader side. clear() only hides older entries, the producer is untouched.
+    void clear() {
+        m_floor.store(m_head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+    size_t size() const {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        return static_cast<size_t>(head - oldest(head));
+    }
+
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+    uint64_t totalPushed() const { return m_head.load(std::memory_order_acquire); }
+
+    // Latest maxItems elements, oldest first, without copying.
+    // `sequence` receives the push count the view was taken at.
+    Span<T> view(size_t maxItems, uint64_t* sequence = nullptr) const {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        const size_t count = std::min(maxItems, static_cast<size_t>(head - oldest(head)));
+        if (sequence) {
+            *sequence = head;
+        }
+        if (count == 0) {
+            return Span<T>();
+        }
+        const size_t start = static_cast<size_t>(head - count) & MASK;
+        return Span<T>(&m_slots[start], count);
+    }
+
+    // True if a view of `count` elements taken at `sequence` has not been overwritten
+    bool isIntact(uint64_t sequence, size_t count) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        return head - (sequence - count) < Capacity;
+    }
+
+    // Copy of the latest maxItems elements, oldest first, retried until consistent
+    std::vector<T> snapshot(size_t maxItems) const {
+        std::vector<T> result;
+        for (;;) {
+            uint64_t sequence = 0;
+            Span<T> latest = view(maxItems, &sequence);
+            result.resize(latest.size());
+            if (!latest.empty()) {
+                std::memcpy(result.data(), latest.data(), latest.size() * sizeof(T));
+            }
+            if (isIntact(sequence, latest.size())) {
+                return result;
+            }
+        }
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    uint64_t oldest(uint64_t head) const {
+        const uint64_t floor = m_floor.load(std::memory_order_relaxed);
+        const uint64_t retained = head >= Capacity ? head - (Capacity - 1) : 0;
+        return std::min(head, std::max(floor, retained));
+    }
+
+    T m_slots[Capacity * 2] = {};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_head{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_floor{0};
+};
+
+}} // namespace Recordify::Utils
+
+#endif // RECORDIFY_UTILS_RING_BUFFER_H
@@ -0,0 +1,213 @@
+#ifndef RECORDIFY_UTILS_SPATIAL_INDEX_H
+#define RECORDIFY_UTILS_SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/geometry.h"
+
+namespace Recordify {
+namespace Utils {
+
+// Uniform-grid index over rectangles, keyed by a small copyable handle
+// (window index, annotation id...). Each rectangle is listed in every cell it
+// overlaps; cells are sparse, so any coordinate range works. Rectangles that
+// would span more than MAX_CELLS cells (a full-screen desktop window, say) go
+// to a short overflow list that every query scans instead.
+// Queries report each key once, in no particular order. Not thread-safe.
+template <typename Key, typename Hash = std::hash<Key>>
+class SpatialGrid {
+public:
+    static constexpr int MAX_CELLS = 64;
+
+    explicit SpatialGrid(int cellSize = 128) : m_cellSize(std::max(1, cellSize)) {}
+
+    void clear() {
+        m_entries.clear();
+        m_cells.clear();
+        m_overflow.clear();
+    }
+
+    // Replaces the contents in one pass
+    void build(const std::vector<std::pair<Key, Rectangle>>& items) {
+        clear();
+        m_entries.reserve(items.size());
+        for (const auto& item : items) {
+            insert(item.first, item.second);
+        }
+    }
+
+    // Empty rectangles are ignored; inserting a known key moves it
+    void insert(const Key& key, const Rectangle& bounds) {
+        remove(key);
+        if (bounds.isEmpty()) {
+            return;
+        }
+        m_entries.emplace(key, bounds);
+        forEachCell(bounds, [this, &key](uint64_t cell) { m_cells[cell].push_back(key); },
+                    [this, &key]() { m_overflow.push_back(key); });
+    }
+
+    bool remove(const Key& key) {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            return false;
+        }
+        forEachCell(it->second,
+                    [this, &key](uint64_t cell) {
+                        auto list = m_cells.find(cell);
+                        eraseKey(list->second, key);
+                        if (list->second.empty()) {
+                            m_cells.erase(list);
+                        }
+                    },
+                    [this, &key]() { eraseKey(m_overflow, key); });
+        m_entries.erase(it);
+        return true;
+    }
+
+    bool contains(const Key& key) const { return m_entries.count(key) != 0; }
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+    int cellSize() const { return m_cellSize; }
+
+    Rectangle bounds(const Key& key) const {
+        auto it = m_entries.find(key);
+        return it != m_entries.end() ? it->second : Rectangle();
+    }
+
+    // fn(key, bounds) for every rectangle containing `point`
+    template <typename Fn>
+    void queryPoint(const Point& point, Fn&& fn) const {
+        auto cell = m_cells.find(cellKey(cellOf(point.x), cellOf(point.y)));
+        if (cell != m_cells.end()) {
+            for (const Key& key : cell->second) {
+                const Rectangle& bounds = m_entries.find(key)->second;
+                if (bounds.contains(point)) {
+                    fn(key, bounds);
+                }
+            }
+        }
+        for (const Key& key : m_overflow) {
+            const Rectangle& bounds = m_entries.find(key)->second;
+            if (bounds.contains(point)) {
+                fn(key, bounds);
+            }
+        }
+    }
+
+    // fn(key, bounds) for every rectangle intersecting `area`
+    template <typename Fn>
+    void queryRect(const Rectangle& area, Fn&& fn) const {
+        if (area.isEmpty()) {
+            return;
+        }
+        const int firstColumn = cellOf(area.x);
+        const int firstRow = cellOf(area.y);
+        forEachCell(area,
+                    [&](uint64_t cellId) {
+                        auto cell = m_cells.find(cellId);
+                        if (cell == m_cells.end()) {
+                            return;
+                        }
+                        const int column = static_cast<int32_t>(cellId >> 32);
+                        const int row = static_cast<int32_t>(cellId & 0xffffffffu);
+                        for (const Key& key : cell->second) {
+                            const Rectangle& bounds = m_entries.find(key)->second;
+                            // Report a key only from the first cell both rectangles share
+                            if (cellOf(bounds.x) > firstColumn ? column != cellOf(bounds.x) : column != firstColumn) {
+                                continue;
+                            }
+                            if (cellOf(bounds.y) > firstRow ? row != cellOf(bounds.y) : row != firstRow) {
+                                continue;
+                            }
+                            if (bounds.intersects(area)) {
+                                fn(key, bounds);
+                            }
+                        }
+                    },
+                    [&]() { scanCells(area, fn); });
+        for (const Key& key : m_overflow) {
+            const Rectangle& bounds = m_entries.find(key)->second;
+            if (bounds.intersects(area)) {
+                fn(key, bounds);
+            }
+        }
+    }
+
+    std::vector<Key> queryPoint(const Point& point) const {
+        std::vector<Key> keys;
+        queryPoint(point, [&keys](const Key& key, const Rectangle&) { keys.push_back(key); });
+        return keys;
+    }
+
+    std::vector<Key> queryRect(const Rectangle& area) const {
+        std::vector<Key> keys;
+        queryRect(area, [&keys](const Key& key, const Rectangle&) { keys.push_back(key); });
+        return keys;
+    }
+
+private:
+    int cellOf(int coordinate) const {
+        // Floor division so negative coordinates land in the right cell
+        return coordinate >= 0 ? coordinate / m_cellSize : -((-coordinate - 1) / m_cellSize) - 1;
+    }
+
+    static uint64_t cellKey(int column, int row) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(column)) << 32) | static_cast<uint32_t>(row);
+    }
+
+    // onCell(cellKey) for each cell `bounds` overlaps, or onOverflow() once if too many
+    template <typename OnCell, typename OnOverflow>
+    void forEachCell(const Rectangle& bounds, OnCell&& onCell, OnOverflow&& onOverflow) const {
+        const int firstColumn = cellOf(bounds.x);
+        const int lastColumn = cellOf(bounds.right() - 1);
+        const int firstRow = cellOf(bounds.y);
+        const int lastRow = cellOf(bounds.bottom() - 1);
+        const int64_t cells = static_cast<int64_t>(lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+        if (cells > MAX_CELLS) {
+            onOverflow();
+            return;
+        }
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                onCell(cellKey(column, row));
+            }
+        }
+    }
+
+    // Large query areas walk the occupied cells instead of every cell they cover
+    template <typename Fn>
+    void scanCells(const Rectangle& area, Fn& fn) const {
+        for (const auto& cell : m_cells) {
+            for (const Key& key : cell.second) {
+                const Rectangle& bounds = m_entries.find(key)->second;
+                // Each key is reported from the cell holding its top-left corner
+                if (cellKey(cellOf(bounds.x), cellOf(bounds.y)) == cell.first && bounds.intersects(area)) {
+                    fn(key, bounds);
+                }
+            }
+        }
+    }
+
+    static void eraseKey(std::vector<Key>& keys, const Key& key) {
+        auto it = std::find(keys.begin(), keys.end(), key);
+        if (it != keys.end()) {
+            *it = keys.back();
+            keys.pop_back();
+        }
+    }
+
+    int m_cellSize;
+    std::unordered_map<Key, Rectangle, Hash> m_entries;
+    std::unordered_map<uint64_t, std::vector<Key>> m_cells;
+    std::vector<Key> m_overflow; // entries spanning more than MAX_CELLS cells
+};
+
+}} // namespace Recordify::Utils
+
+#endif // RECORDIFY_UTILS_SPATIAL_INDEX_H
@@ -0,0 +1,116 @@
+#ifndef RECORDIFY_AVI_MUXER_H
+#define RECORDIFY_AVI_MUXER_H
+
+#include "file_manager/file_writer.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Recordify {
+namespace VideoHandler {
+
+// Single video stream OpenDML (AVI 2.0) writer. Packets are appended to the
+// 'movi' list as they arrive. Once a RIFF list reaches the RIFF limit the
+// file continues in a RIFF 'AVIX' list; each list ends with its own ix00
+// index, listed in the super index of the header. The first list also gets
+// a legacy idx1 so AVI 1.0 players see at least its frames. Files end when
+// the super index is full (MAX_RIFF_LISTS lists): writeFrame() then fails
+// once with an error and close() still finalizes what was written.
+// Disk writes happen on the FileWriter's I/O thread.
+class AviMuxer {
+public:
+    static constexpr uint64_t RIFF_BYTES = 1ull << 30;
+    static constexpr uint32_t MAX_RIFF_LISTS = 256;
+
+    AviMuxer() = default;
+    ~AviMuxer();
+    AviMuxer(const AviMuxer&) = delete;
+    AviMuxer& operator=(const AviMuxer&) = delete;
+
+    bool open(const std::string& path, int width, int height, float fps, uint32_t fourcc,
+              const FileManager::WriterOptions& output = FileManager::WriterOptions());
+    bool writeFrame(const uint8_t* data, size_t size, bool keyFrame);
+    bool close();
+    // Runs `callback` once the frames written so far are in the file
+    bool whenWritten(std::function<void()> callback) { return m_writer.whenWritten(std::move(callback)); }
+
+    bool isOpen() const { return m_writer.isOpen(); }
+    uint32_t getFrameCount() const { return m_frameCount; }
+    uint64_t getFileSize() const { return m_fileSize; }
+    // Size at which the next RIFF list starts; tests lower it
+    void setRiffLimit(uint64_t bytes) { m_riffLimit = bytes; }
+
+private:
+    struct IndexEntry {
+        uint32_t flags;
+        uint32_t offset; // from the 'movi' tag
+        uint32_t size;
+    };
+    struct ChunkEntry {
+        uint64_t offset; // of the packet data
+        uint32_t size;
+        bool keyFrame;
+    };
+
+    bool finishRiff();
+    bool startRiff();
+    bool patch(uint64_t offset, const std::vector<uint8_t>& bytes);
+    bool patch(uint64_t offset, uint32_t value);
+    bool fail(const char* reason);
+
+    FileManager::FileWriter m_writer;
+    std::string m_path;
+    float m_fps = 30.0f;
+    uint64_t m_fileSize = 0;
+    uint64_t m_riffLimit = RIFF_BYTES;
+    uint64_t m_riffStart = 0;   // current RIFF list
+    uint64_t m_moviStart = 0;   // its 'movi' tag
+    uint32_t m_riffLists = 0;   // finished, in the super index
+    uint32_t m_frameCount = 0;
+    uint32_t m_largestFrame = 0;
+    bool m_failed = false;
+    std::vector<IndexEntry> m_index;  // idx1, first RIFF list only
+    std::vector<ChunkEntry> m_chunks; // ix00 of the current RIFF list
+};
+
+// Reads back files written by AviMuxer: the fixed header layout and the
+// ix00 indexes listed in the super index. Used to join segments without
+// re-encoding.
+class AviReader {
+public:
+    AviReader() = default;
+    ~AviReader();
+    AviReader(const AviReader&) = delete;
+    AviReader& operator=(const AviReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    float getFps() const { return m_fps; }
+    uint32_t getFourcc() const { return m_fourcc; }
+    uint32_t getFrameCount() const { return static_cast<uint32_t>(m_index.size()); }
+
+    bool readFrame(uint32_t frame, std::vector<uint8_t>& packet, bool& keyFrame);
+
+private:
+    struct IndexEntry {
+        uint64_t offset; // of the packet data
+        uint32_t size;
+        bool keyFrame;
+    };
+
+    std::FILE* m_file = nullptr;
+    int m_width = 0, m_height = 0;
+    float m_fps = 0.0f;
+    uint32_t m_fourcc = 0;
+    std::vector<IndexEntry> m_index;
+};
+
+}} // namespace Recordify::VideoHandler
+
+#endif // RECORDIFY_AVI_MUXER_H
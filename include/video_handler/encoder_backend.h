@@ -0,0 +1,73 @@
+#ifndef RECORDIFY_ENCODER_BACKEND_H
+#define RECORDIFY_ENCODER_BACKEND_H
+
+#include "file_manager/file_writer.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Recordify {
+namespace VideoHandler {
+
+// Borrowed view of one raw frame: top-down rows of BGR24 or BGRA32 pixels
+struct VideoFrame {
+    const uint8_t* pixels = nullptr;
+    int width = 0, height = 0;
+    size_t stride = 0; // bytes per row
+    int bytesPerPixel = 3;
+
+    bool isValid() const {
+        return pixels && width > 0 && height > 0 && (bytesPerPixel == 3 || bytesPerPixel == 4) &&
+               stride >= static_cast<size_t>(width) * bytesPerPixel;
+    }
+};
+
+struct EncoderSettings {
+    std::string codec = "mjpeg";
+    int width = 0, height = 0; // 0: taken from the first frame
+    float fps = 30.0f;
+    int quality = 85;          // 1-100
+    int threads = 0;           // encode workers, 0 = pick from hardware_concurrency
+    size_t queueDepth = 8;     // frames waiting for a worker
+    bool blockWhenFull = false; // submit() waits instead of dropping (offline encodes)
+    FileManager::WriterOptions output; // batching, direct I/O and fsync for the output file
+    double segmentSeconds = 0.0;       // > 0: rolling crash-safe segments plus a manifest
+};
+
+// Codec plug-in point used by VideoEncoder. Frames always arrive at the size
+// the backend was opened with.
+class EncoderBackend {
+public:
+    virtual ~EncoderBackend() = default;
+
+    virtual const char* name() const = 0;
+    virtual uint32_t fourcc() const = 0; // stream handler/compression tag for the container
+
+    virtual bool open(const EncoderSettings& settings) = 0;
+    virtual void close() {}
+
+    // Appends one compressed frame to `packet`. Intra-only backends must allow
+    // concurrent calls; the others are driven from a single worker.
+    virtual bool encode(const VideoFrame& frame, std::vector<uint8_t>& packet, bool& keyFrame) = 0;
+    virtual bool isIntraOnly() const { return false; }
+};
+
+using BackendFactory = std::function<std::unique_ptr<EncoderBackend>()>;
+
+// Codec registry. "mjpeg" is always available; other backends (hardware
+// encoders, external libraries) register themselves under their own name.
+bool registerBackend(const std::string& codec, BackendFactory factory);
+std::unique_ptr<EncoderBackend> createBackend(const std::string& codec);
+std::vector<std::string> availableBackends();
+
+constexpr uint32_t makeFourcc(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16 | static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24;
+}
+
+}} // namespace Recordify::VideoHandler
+
+#endif // RECORDIFY_ENCODER_BACKEND_H
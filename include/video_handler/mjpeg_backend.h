@@ -0,0 +1,37 @@
+#ifndef RECORDIFY_MJPEG_BACKEND_H
+#define RECORDIFY_MJPEG_BACKEND_H
+
+#include "video_handler/encoder_backend.h"
+#include <cstdint>
+#include <vector>
+
+namespace Recordify {
+namespace VideoHandler {
+
+// Self-contained baseline JPEG encoder (4:2:0, standard Huffman tables), one
+// complete JFIF image per frame. Every frame is a key frame and encode() only
+// reads state set up by open(), so workers can encode frames in parallel.
+class MjpegBackend : public EncoderBackend {
+public:
+    const char* name() const override { return "mjpeg"; }
+    uint32_t fourcc() const override { return makeFourcc('M', 'J', 'P', 'G'); }
+
+    bool open(const EncoderSettings& settings) override;
+    bool encode(const VideoFrame& frame, std::vector<uint8_t>& packet, bool& keyFrame) override;
+    bool isIntraOnly() const override { return true; }
+
+    int getQuality() const { return m_quality; }
+
+private:
+    void writeHeaders(std::vector<uint8_t>& out, int width, int height) const;
+
+    int m_quality = 0;
+    uint8_t m_lumaTable[64];   // zigzag order, as written to DQT
+    uint8_t m_chromaTable[64];
+    float m_lumaScale[64];     // natural order, quantizer folded with the DCT scale
+    float m_chromaScale[64];
+};
+
+}} // namespace Recordify::VideoHandler
+
+#endif // RECORDIFY_MJPEG_BACKEND_H
@@ -0,0 +1,61 @@
+#ifndef RECORDIFY_SEGMENTED_MUXER_H
+#define RECORDIFY_SEGMENTED_MUXER_H
+
+#include "video_handler/avi_muxer.h"
+#include "file_manager/segment_manifest.h"
+#include <functional>
+#include <string>
+
+namespace Recordify {
+namespace VideoHandler {
+
+// AviMuxer that rolls over to a new file every segmentSeconds, at the next
+// key frame. Each segment is a complete AVI with its own index, synced
+// before the manifest lists it, so a killed process loses at most the
+// segment in progress. With segmentSeconds == 0 it writes the one file at
+// `path`, exactly like AviMuxer.
+class SegmentedMuxer {
+public:
+    SegmentedMuxer() = default;
+    ~SegmentedMuxer();
+    SegmentedMuxer(const SegmentedMuxer&) = delete;
+    SegmentedMuxer& operator=(const SegmentedMuxer&) = delete;
+
+    bool open(const std::string& path, int width, int height, float fps, uint32_t fourcc,
+              const FileManager::WriterOptions& output = FileManager::WriterOptions(), double segmentSeconds = 0.0);
+    bool writeFrame(const uint8_t* data, size_t size, bool keyFrame);
+    bool close();
+    // Runs `callback` once the frames written so far are in their file;
+    // closing a segment writes out everything in it
+    bool whenWritten(std::function<void()> callback) { return m_muxer.whenWritten(std::move(callback)); }
+
+    bool isOpen() const { return m_open; }
+    bool isSegmented() const { return m_segmentFrames > 0; }
+    uint64_t getFrameCount() const { return m_finishedFrames + (m_muxer.isOpen() ? m_muxer.getFrameCount() : 0); }
+    const FileManager::SegmentManifest& getManifest() const { return m_manifest; }
+
+private:
+    bool openSegment();
+    bool closeSegment();
+
+    AviMuxer m_muxer;
+    FileManager::SegmentManifest m_manifest;
+    FileManager::WriterOptions m_output;
+    std::string m_path;
+    int m_width = 0, m_height = 0;
+    float m_fps = 30.0f;
+    uint32_t m_fourcc = 0;
+    uint32_t m_segmentFrames = 0; // frames per segment, 0 = single file
+    uint64_t m_finishedFrames = 0;
+    bool m_open = false;
+};
+
+// Joins the segments listed in a manifest into one AVI by copying packets.
+// Output past AviMuxer::RIFF_BYTES continues in OpenDML AVIX lists, so
+// there is no 2 GiB cap. Fails if the segments don't share a format.
+bool concatenateSegments(const std::string& manifestPath, const std::string& outputPath,
+                         const FileManager::WriterOptions& output = FileManager::WriterOptions());
+
+}} // namespace Recordify::VideoHandler
+
+#endif // RECORDIFY_SEGMENTED_MUXER_H
@@ -0,0 +1,82 @@
+#ifndef RECORDIFY_VIDEO_ENCODER_H
+#define RECORDIFY_VIDEO_ENCODER_H
+
+#include "video_handler/encoder_backend.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Recordify {
+
+namespace ScreenHandler {
+class ScreenHandler;
+struct ScreenCapture;
+struct PipelineFrame;
+}
+
+namespace VideoHandler {
+
+// Turns in-memory frames into a video file: color conversion and encoding
+// run on worker threads through an EncoderBackend, packets are muxed into an
+// AVI in submission order (or into rolling segments, see
+// EncoderSettings::segmentSeconds). Nothing touches disk except the output.
+//
+// Frames arrive one of two ways:
+//  - submit(), which queues the frame for the encoder's own workers;
+//  - attach(), which hooks the ScreenHandler pipeline so its encode workers
+//    compress frames and its writer stage muxes them, in capture order.
+//    Backends with inter frames are encoded on the writer stage instead, so
+//    they see frames in capture order too.
+// The output size is fixed by the settings or by the first frame; frames of
+// any other size are dropped.
+class VideoEncoder {
+public:
+    struct Stats {
+        uint64_t framesSubmitted = 0;
+        uint64_t framesEncoded = 0;
+        uint64_t framesWritten = 0;
+        uint64_t framesDropped = 0; // queue full, wrong size or encode failure
+        uint64_t bytesWritten = 0;  // compressed frame data
+        float encodeTime = 0.0f;    // ms per frame, conversion included
+    };
+
+    VideoEncoder();
+    ~VideoEncoder();
+    VideoEncoder(const VideoEncoder&) = delete;
+    VideoEncoder& operator=(const VideoEncoder&) = delete;
+
+    // Backend picked from the registry by settings.codec
+    bool open(const std::string& path, const EncoderSettings& settings = EncoderSettings());
+    bool open(const std::string& path, const EncoderSettings& settings, std::unique_ptr<EncoderBackend> backend);
+    // Encodes everything still queued and finalizes the file
+    bool close();
+    bool isOpen() const;
+
+    // Queues a frame for the workers. The capture's pooled buffer is kept
+    // alive until encoded instead of being copied; raw frames are copied.
+    bool submit(const ScreenHandler::ScreenCapture& capture);
+    bool submit(const VideoFrame& frame);
+    // No copy: the frame's pixels are used in place and `owner` is held until
+    // the frame is encoded, so it must keep them valid until then
+    bool submit(const VideoFrame& frame, std::shared_ptr<const void> owner);
+
+    // Pipeline hooks. Install before ScreenHandler::startCapture().
+    void attach(ScreenHandler::ScreenHandler& handler);
+    void detach(ScreenHandler::ScreenHandler& handler);
+    bool encodeFrame(ScreenHandler::PipelineFrame& frame);      // any encode worker
+    bool writeFrame(const ScreenHandler::PipelineFrame& frame); // writer stage, in order
+    // Runs `done` once the packets muxed so far are in the file
+    bool whenWritten(std::function<void()> done);
+
+    Stats getStats() const;
+    const std::string& getPath() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}} // namespace Recordify::VideoHandler
+
+#endif // RECORDIFY_VIDEO_ENCODER_H
@@ -4,6 +4,8 @@
 #include "audio_handler/audio_capture.h"
 #include "video_handler/video_encoder.h"
 #include "file_manager/file_writer.h"
+#include "file_manager/frame_spool.h"
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
@@ -26,8 +28,8 @@ public:
 private:
     std::unique_ptr<ScreenHandler::ScreenHandler> m_screenHandler;
     // AudioHandler::AudioCapture* m_audioCapture;
-    // VideoHandler::VideoEncoder* m_videoEncoder;
-    // FileManager::FileWriter* m_fileWriter;
+    std::unique_ptr<VideoHandler::VideoEncoder> m_videoEncoder; // owns the output FileWriter
+    std::unique_ptr<FileManager::FrameSpool> m_frameSpool;      // SPOOL output: raw frames, encoded offline
     
     bool m_isRecording;
     bool m_isPaused;
@@ -58,6 +60,10 @@ bool Recorder::initialize() {
         return false;
     }
     
+    // Captured frames go straight from the pipeline into the encoder, or the spool
+    m_videoEncoder = std::make_unique<VideoHandler::VideoEncoder>();
+    m_frameSpool = std::make_unique<FileManager::FrameSpool>();
+    
     m_initialized = true;
     std::cout << "[Recorder] Initialization completed successfully" << std::endl;
     return true;
@@ -76,9 +82,45 @@ void Recorder::startRecording() {
     
     std::cout << "[Recorder] Starting recording..." << std::endl;
     
+    ScreenHandler::RecordingConfig config = m_screenHandler->getRecordingConfig();
+    if (config.outputFormat == "SPOOL" || config.outputFormat == "spool") {
+        // Lossless capture at full rate; tools/spool_replay encodes it afterwards
+        std::string path = config.outputPath.empty() ? "recording.spool" : config.outputPath;
+        // One index slot per 256 KB of spool, enough for captures much smaller than the screen
+        const uint32_t maxFrames = static_cast<uint32_t>(std::max<uint64_t>(1, config.spoolSize >> 18));
+        if (!m_frameSpool->create(path, maxFrames, config.spoolSize)) {
+            std::cout << "[Recorder] Cannot create frame spool " << path << std::endl;
+            return;
+        }
+        m_videoEncoder->detach(*m_screenHandler);
+        m_frameSpool->attach(*m_screenHandler);
+        m_screenHandler->startCapture(config);
+        m_isRecording = true;
+        m_isPaused = false;
+        std::cout << "[Recorder] Spooling raw frames to " << path << std::endl;
+        return;
+    }
+    
+    VideoHandler::EncoderSettings settings;
+    settings.fps = config.fps;
+    // Long recordings lose at most a second on power loss; syncs run on the I/O thread
+    settings.output.sync = FileManager::SyncPolicy::INTERVAL;
+    // Auto-save splits the recording into segments, so a crash costs one segment at most
+    settings.segmentSeconds = config.autoSave ? config.segmentDuration : 0.0;
+    if (config.outputFormat != "AVI" && config.outputFormat != "avi") {
+        std::cout << "[Recorder] " << config.outputFormat << " output is not supported yet, writing AVI" << std::endl;
+    }
+    std::string path = config.outputPath.empty() ? "recording.avi" : config.outputPath;
+    if (!m_videoEncoder->open(path, settings)) {
+        std::cout << "[Recorder] Cannot open video output " << path << std::endl;
+        return;
+    }
+    m_frameSpool->detach(*m_screenHandler);
+    m_videoEncoder->attach(*m_screenHandler);
+    
     // Start screen capture
     if (m_screenHandler) {
-        m_screenHandler->startCapture();
+        m_screenHandler->startCapture(config);
     }
     
     m_isRecording = true;
@@ -100,6 +142,14 @@ void Recorder::stopRecording() {
         m_screenHandler->stopCapture();
     }
     
+    // Pipeline is drained, finalize the file
+    if (m_videoEncoder && m_videoEncoder->isOpen()) {
+        m_videoEncoder->close();
+    }
+    if (m_frameSpool && m_frameSpool->isOpen()) {
+        m_frameSpool->close();
+    }
+    
     m_isRecording = false;
     m_isPaused = false;
     
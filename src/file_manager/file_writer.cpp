@@ -0,0 +1,819 @@
+#include "file_manager/file_writer.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define RECORDIFY_IO_URING 1
+#endif
+#endif
+
+namespace Recordify {
+namespace FileManager {
+
+namespace {
+
+// Buffer, offset and length alignment for direct I/O; covers 512e and 4Kn disks
+constexpr size_t DIRECT_ALIGNMENT = 4096;
+
+void* alignedAlloc(size_t alignment, size_t bytes) {
+#ifdef _WIN32
+    return _aligned_malloc(bytes, alignment);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, bytes) != 0) {
+        return nullptr;
+    }
+    return ptr;
+#endif
+}
+
+void alignedFree(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+float millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Positional writes on a raw OS handle, no user-space buffering
+class OsFile {
+public:
+    OsFile() = default;
+    ~OsFile() { close(); }
+    OsFile(const OsFile&) = delete;
+    OsFile& operator=(const OsFile&) = delete;
+
+    bool open(const std::string& path, bool create, bool direct) {
+#ifdef _WIN32
+        DWORD flags = FILE_ATTRIBUTE_NORMAL | (direct ? FILE_FLAG_NO_BUFFERING : 0);
+        m_handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                               create ? CREATE_ALWAYS : OPEN_EXISTING, flags, nullptr);
+        return m_handle != INVALID_HANDLE_VALUE;
+#else
+        int flags = O_WRONLY | O_CLOEXEC | (create ? O_CREAT | O_TRUNC : 0);
+        if (direct) {
+#ifdef O_DIRECT
+            flags |= O_DIRECT;
+#else
+            return false;
+#endif
+        }
+        m_fd = ::open(path.c_str(), flags, 0644);
+        return m_fd >= 0;
+#endif
+    }
+
+    bool writeAt(const uint8_t* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+#ifdef _WIN32
+            OVERLAPPED position = {};
+            position.Offset = static_cast<DWORD>(offset);
+            position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD written = 0;
+            const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+            if (!WriteFile(m_handle, data, chunk, &written, &position) || written == 0) {
+                return false;
+            }
+#else
+            const ssize_t written = ::pwrite(m_fd, data, size, static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+#endif
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<uint64_t>(written);
+        }
+        return true;
+    }
+
+    bool sync() {
+#ifdef _WIN32
+        return FlushFileBuffers(m_handle) != 0;
+#elif defined(__linux__)
+        return ::fdatasync(m_fd) == 0;
+#else
+        return ::fsync(m_fd) == 0;
+#endif
+    }
+
+    bool truncate(uint64_t size) {
+#ifdef _WIN32
+        FILE_END_OF_FILE_INFO end;
+        end.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        return SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &end, sizeof(end)) != 0;
+#else
+        return ::ftruncate(m_fd, static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_handle);
+            m_handle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+#endif
+    }
+
+    bool isOpen() const {
+#ifdef _WIN32
+        return m_handle != INVALID_HANDLE_VALUE;
+#else
+        return m_fd >= 0;
+#endif
+    }
+
+#ifndef _WIN32
+    int fd() const { return m_fd; }
+#endif
+
+private:
+#ifdef _WIN32
+    HANDLE m_handle = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+};
+
+#ifdef RECORDIFY_IO_URING
+
+// Just enough io_uring for queued writes, on the raw syscalls so there is
+// no liburing dependency. Only the I/O thread touches it.
+class Uring {
+public:
+    Uring() = default;
+    ~Uring() {
+        if (m_sqes) munmap(m_sqes, m_sqesBytes);
+        if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqRingBytes);
+        if (m_sqRing) munmap(m_sqRing, m_sqRingBytes);
+        if (m_fd >= 0) ::close(m_fd);
+    }
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    bool init(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0) {
+            return false;
+        }
+
+        m_sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            m_sqRingBytes = m_cqRingBytes = std::max(m_sqRingBytes, m_cqRingBytes);
+        }
+        m_sqRing = map(m_sqRingBytes, IORING_OFF_SQ_RING);
+        m_cqRing = singleMap ? m_sqRing : map(m_cqRingBytes, IORING_OFF_CQ_RING);
+        m_sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(map(m_sqesBytes, IORING_OFF_SQES));
+        if (!m_sqRing || !m_cqRing || !m_sqes) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(m_sqRing);
+        m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(m_cqRing);
+        m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        m_entries = params.sq_entries;
+        return true;
+    }
+
+    unsigned capacity() const { return m_entries; }
+
+    // At most capacity() writes between submitAndWait() calls
+    void prepareWrite(int fd, const void* data, size_t size, uint64_t offset, uint64_t userData) {
+        const unsigned tail = *m_sqTail;
+        const unsigned index = tail & m_sqMask;
+        io_uring_sqe& sqe = m_sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uintptr_t>(data);
+        sqe.len = static_cast<uint32_t>(size);
+        sqe.off = offset;
+        sqe.user_data = userData;
+        m_sqArray[index] = index;
+        __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++m_prepared;
+    }
+
+    // Submits everything prepared and waits for all of it to complete
+    template <typename Complete>
+    bool submitAndWait(Complete&& complete) {
+        unsigned unsubmitted = m_prepared, outstanding = m_prepared;
+        m_prepared = 0;
+        while (outstanding > 0) {
+            const long submitted = syscall(__NR_io_uring_enter, m_fd, unsubmitted, 1, IORING_ENTER_GETEVENTS,
+                                           nullptr, 0);
+            if (submitted < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            unsubmitted -= static_cast<unsigned>(submitted);
+
+            unsigned head = *m_cqHead;
+            const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head, --outstanding) {
+                const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+                complete(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    void* map(size_t bytes, off_t offset) {
+        void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    int m_fd = -1;
+    unsigned m_entries = 0;
+    unsigned m_prepared = 0;
+    void* m_sqRing = nullptr;
+    void* m_cqRing = nullptr;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqRingBytes = 0, m_cqRingBytes = 0, m_sqesBytes = 0;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+};
+
+#endif // RECORDIFY_IO_URING
+
+} // namespace
+
+const char* backendName(IoBackend backend) {
+    switch (backend) {
+        case IoBackend::AUTO: return "auto";
+        case IoBackend::IO_URING: return "io_uring";
+        case IoBackend::PWRITE: return "pwrite";
+    }
+    return "unknown";
+}
+
+struct FileWriter::Impl {
+    struct Batch {
+        uint8_t* data = nullptr;
+        size_t used = 0;
+    };
+
+    struct Job {
+        enum Kind { DATA, PATCH, SYNC } kind = DATA;
+        Batch* batch = nullptr;     // DATA: back to the free list once written
+        uint64_t offset = 0;
+        size_t size = 0;
+        std::vector<uint8_t> bytes; // PATCH
+        uint64_t ticket = 0;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    struct Waiter {
+        uint64_t end; // runs once bytes [0, end) are written
+        std::function<void()> callback;
+    };
+
+    std::string path;
+    WriterOptions options;
+    IoBackend backend = IoBackend::PWRITE;
+    bool direct = false;
+    std::atomic<bool> opened{false};
+    std::atomic<bool> failed{false};
+
+    // Touched by the I/O thread only while the writer is open
+    OsFile file;
+    OsFile patchFile; // buffered handle for unaligned patches under direct I/O
+#ifdef RECORDIFY_IO_URING
+    std::unique_ptr<Uring> ring;
+#endif
+    std::chrono::steady_clock::time_point lastSync;
+
+    // Producer side: the batch being filled
+    mutable std::mutex writeMutex;
+    std::vector<Batch> batches;
+    Batch* current = nullptr;
+    uint64_t currentOffset = 0; // file offset of current->data
+    uint64_t position = 0;
+    bool currentQueued = false; // flushed and unchanged since
+
+    // Shared with the I/O thread
+    mutable std::mutex queueMutex;
+    std::condition_variable jobReady, jobDone;
+    std::deque<Job> jobs;
+    std::vector<Batch*> freeBatches;
+    uint64_t nextTicket = 0, doneTicket = 0;
+    uint64_t writtenThrough = 0; // every byte before it has been written
+    std::deque<Waiter> waiters;  // by end
+    bool stopping = false;
+    std::thread ioThread;
+    Stats stats;
+
+    ~Impl() {
+        for (Batch& batch : batches) {
+            alignedFree(batch.data);
+        }
+    }
+
+    Batch* acquireBatch();
+    uint64_t push(Job&& job);
+    bool queueCurrent(bool partial); // writeMutex held
+    bool waitFor(uint64_t ticket);
+
+    void ioLoop();
+    bool writeBatches(std::vector<Job>& group);
+    bool writePatch(const Job& job);
+    bool syncFile();
+    void fail(const char* what);
+};
+
+FileWriter::Impl::Batch* FileWriter::Impl::acquireBatch() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (freeBatches.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        jobDone.wait(lock, [this] { return !freeBatches.empty() || failed.load(); });
+        stats.stalls++;
+        stats.stallTime += millisecondsSince(start);
+    }
+    if (freeBatches.empty()) {
+        return nullptr;
+    }
+    Batch* batch = freeBatches.back();
+    freeBatches.pop_back();
+    return batch;
+}
+
+uint64_t FileWriter::Impl::push(Job&& job) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    job.ticket = ++nextTicket;
+    job.queued = std::chrono::steady_clock::now();
+    const uint64_t ticket = job.ticket;
+    jobs.push_back(std::move(job));
+    jobReady.notify_one();
+    return ticket;
+}
+
+bool FileWriter::Impl::queueCurrent(bool partial) {
+    Batch* next = acquireBatch();
+    if (!next) {
+        return false;
+    }
+
+    Job job;
+    job.batch = current;
+    job.offset = currentOffset;
+    job.size = current->used;
+    // A partial batch is carried over, so batches always start block-aligned
+    // and the next write of it covers the whole block again
+    if (partial) {
+        std::memcpy(next->data, current->data, current->used);
+        next->used = current->used;
+    } else {
+        next->used = 0;
+        currentOffset += options.batchSize;
+    }
+    push(std::move(job));
+    current = next;
+    currentQueued = partial;
+    return true;
+}
+
+bool FileWriter::Impl::waitFor(uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    jobDone.wait(lock, [&] { return doneTicket >= ticket || failed.load(); });
+    return !failed.load();
+}
+
+void FileWriter::Impl::fail(const char* what) {
+    RECORDIFY_LOG_ERROR("FileWriter", what, " failed on ", path, ": ", std::strerror(errno));
+    failed.store(true);
+}
+
+void FileWriter::Impl::ioLoop() {
+    std::vector<Job> group;
+    std::vector<std::function<void()>> completed;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return; // stopping, and everything is written
+            }
+            // Consecutive batches go to the kernel together
+            do {
+                group.push_back(std::move(jobs.front()));
+                jobs.pop_front();
+            } while (!jobs.empty() && group.back().kind == Job::DATA && jobs.front().kind == Job::DATA);
+        }
+
+        bool ok = !failed.load();
+        if (ok) {
+            switch (group.front().kind) {
+                case Job::DATA: ok = writeBatches(group); break;
+                case Job::PATCH: ok = writePatch(group.front()); break;
+                case Job::SYNC: ok = syncFile(); break;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (const Job& job : group) {
+                if (job.kind == Job::DATA) {
+                    freeBatches.push_back(job.batch);
+                    stats.bytesWritten += job.size;
+                    stats.batchesWritten++;
+                    stats.maxWriteTime = std::max(stats.maxWriteTime, millisecondsSince(job.queued));
+                    if (ok) {
+                        writtenThrough = std::max(writtenThrough, job.offset + job.size);
+                    }
+                }
+            }
+            while (!waiters.empty() && waiters.front().end <= writtenThrough) {
+                completed.push_back(std::move(waiters.front().callback));
+                waiters.pop_front();
+            }
+        }
+        
+        // Before the tickets complete, so flush() returns after them
+        for (auto& callback : completed) {
+            callback();
+        }
+        completed.clear();
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        doneTicket = group.back().ticket;
+        if (!ok) {
+            failed.store(true);
+        }
+        jobDone.notify_all();
+        group.clear();
+    }
+}
+
+bool FileWriter::Impl::writeBatches(std::vector<Job>& group) {
+    // Direct I/O only moves whole blocks: pad the tail, close() trims it
+    std::vector<size_t> sizes;
+    sizes.reserve(group.size());
+    for (Job& job : group) {
+        size_t size = job.size;
+        if (direct) {
+            size = roundUp(job.size, DIRECT_ALIGNMENT);
+            std::memset(job.batch->data + job.size, 0, size - job.size);
+        }
+        sizes.push_back(size);
+    }
+
+    bool ok = true;
+#ifdef RECORDIFY_IO_URING
+    if (ring) {
+        for (size_t first = 0; first < group.size() && ok; first += ring->capacity()) {
+            const size_t last = std::min(group.size(), first + ring->capacity());
+            for (size_t i = first; i < last; ++i) {
+                ring->prepareWrite(file.fd(), group[i].batch->data, sizes[i], group[i].offset, i);
+            }
+            // Short or failed completions are finished synchronously
+            ok = ring->submitAndWait([&](uint64_t i, int32_t result) {
+                const size_t done = result > 0 ? static_cast<size_t>(result) : 0;
+                if (done < sizes[i]) {
+                    if (result < 0) errno = -result;
+                    ok = file.writeAt(group[i].batch->data + done, sizes[i] - done, group[i].offset + done) && ok;
+                }
+            }) && ok;
+        }
+    } else
+#endif
+    {
+        for (size_t i = 0; i < group.size() && ok; ++i) {
+            ok = file.writeAt(group[i].batch->data, sizes[i], group[i].offset);
+        }
+    }
+    if (!ok) {
+        fail("Write");
+        return false;
+    }
+
+    if (options.sync == SyncPolicy::ALWAYS ||
+        (options.sync == SyncPolicy::INTERVAL && millisecondsSince(lastSync) >= options.syncIntervalMs)) {
+        return syncFile();
+    }
+    return true;
+}
+
+bool FileWriter::Impl::writePatch(const Job& job) {
+    OsFile& target = direct ? patchFile : file;
+    if (!target.isOpen() && !target.open(path, false, false)) {
+        fail("Open for patching");
+        return false;
+    }
+    if (!target.writeAt(job.bytes.data(), job.bytes.size(), job.offset)) {
+        fail("Patch");
+        return false;
+    }
+    return true;
+}
+
+bool FileWriter::Impl::syncFile() {
+    lastSync = std::chrono::steady_clock::now();
+    if (!file.sync()) {
+        fail("Sync");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(queueMutex);
+    stats.syncs++;
+    return true;
+}
+
+// FileWriter
+FileWriter::FileWriter()
+    : m_impl(std::make_unique<Impl>()) {
+}
+
+FileWriter::~FileWriter() {
+    close();
+}
+
+bool FileWriter::open(const std::string& path, const WriterOptions& options) {
+    if (isOpen()) {
+        RECORDIFY_LOG_WARN("FileWriter", "Already writing ", m_impl->path);
+        return false;
+    }
+    if (options.batchSize == 0 || options.queueDepth <= 0) {
+        RECORDIFY_LOG_WARN("FileWriter", "Invalid batch size ", options.batchSize, " or queue depth ",
+                           options.queueDepth);
+        return false;
+    }
+
+    auto impl = std::make_unique<Impl>();
+    impl->path = path;
+    impl->options = options;
+    impl->options.batchSize = roundUp(options.batchSize, DIRECT_ALIGNMENT);
+
+    impl->direct = options.directIo && impl->file.open(path, true, true);
+    if (!impl->direct) {
+        if (options.directIo) {
+            RECORDIFY_LOG_INFO("FileWriter", "Direct I/O unavailable for ", path, ", using buffered writes");
+        }
+        if (!impl->file.open(path, true, false)) {
+            RECORDIFY_LOG_WARN("FileWriter", "Cannot create ", path, ": ", std::strerror(errno));
+            return false;
+        }
+    }
+
+    if (options.backend != IoBackend::PWRITE) {
+#ifdef RECORDIFY_IO_URING
+        impl->ring = std::make_unique<Uring>();
+        if (impl->ring->init(static_cast<unsigned>(options.queueDepth))) {
+            impl->backend = IoBackend::IO_URING;
+        } else {
+            impl->ring.reset();
+        }
+#endif
+        if (options.backend == IoBackend::IO_URING && impl->backend != IoBackend::IO_URING) {
+            RECORDIFY_LOG_INFO("FileWriter", "io_uring unavailable, using pwrite for ", path);
+        }
+    }
+
+    // One batch being filled plus queueDepth queued or in flight
+    impl->batches.resize(static_cast<size_t>(options.queueDepth) + 1);
+    for (Impl::Batch& batch : impl->batches) {
+        batch.data = static_cast<uint8_t*>(alignedAlloc(DIRECT_ALIGNMENT, impl->options.batchSize));
+        if (!batch.data) {
+            RECORDIFY_LOG_WARN("FileWriter", "Cannot allocate ", impl->batches.size(), " batches of ",
+                               impl->options.batchSize, " bytes");
+            return false;
+        }
+        impl->freeBatches.push_back(&batch);
+    }
+    impl->current = impl->freeBatches.back();
+    impl->freeBatches.pop_back();
+
+    impl->lastSync = std::chrono::steady_clock::now();
+    impl->ioThread = std::thread(&Impl::ioLoop, impl.get());
+    impl->opened.store(true);
+    m_impl = std::move(impl);
+
+    RECORDIFY_LOG_DEBUG("FileWriter", "Writing ", path, " with ", backendName(m_impl->backend),
+                        m_impl->direct ? ", direct I/O" : "");
+    return true;
+}
+
+bool FileWriter::close() {
+    if (!isOpen()) {
+        return false;
+    }
+    bool ok = flush();
+
+    {
+        std::lock_guard<std::mutex> lock(m_impl->queueMutex);
+        m_impl->stopping = true;
+        m_impl->jobReady.notify_one();
+    }
+    m_impl->ioThread.join();
+    m_impl->opened.store(false);
+
+    ok = ok && !m_impl->failed.load();
+    if (m_impl->direct && !m_impl->file.truncate(m_impl->position)) {
+        m_impl->fail("Truncate");
+        ok = false;
+    }
+    if (m_impl->options.sync != SyncPolicy::NEVER) {
+        ok = m_impl->syncFile() && ok;
+    }
+    m_impl->file.close();
+    m_impl->patchFile.close();
+#ifdef RECORDIFY_IO_URING
+    m_impl->ring.reset();
+#endif
+
+    if (!ok) {
+        RECORDIFY_LOG_WARN("FileWriter", "Failed finalizing ", m_impl->path);
+    }
+    return ok;
+}
+
+bool FileWriter::isOpen() const {
+    return m_impl->opened.load();
+}
+
+bool FileWriter::write(const void* data, size_t size) {
+    if (!isOpen()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_impl->writeMutex);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        if (m_impl->failed.load()) {
+            return false;
+        }
+        Impl::Batch* batch = m_impl->current;
+        const size_t chunk = std::min(size, m_impl->options.batchSize - batch->used);
+        std::memcpy(batch->data + batch->used, bytes, chunk);
+        batch->used += chunk;
+        m_impl->position += chunk;
+        m_impl->currentQueued = false;
+        bytes += chunk;
+        size -= chunk;
+
+        {
+            std::lock_guard<std::mutex> queueLock(m_impl->queueMutex);
+            m_impl->stats.bytesQueued += chunk;
+        }
+        if (batch->used == m_impl->options.batchSize && !m_impl->queueCurrent(false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FileWriter::writeAt(uint64_t offset, const void* data, size_t size) {
+    if (!isOpen()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_impl->writeMutex);
+    if (offset + size > m_impl->position) {
+        RECORDIFY_LOG_WARN("FileWriter", "Patch at ", offset, " runs past the ", m_impl->position,
+                           " bytes written to ", m_impl->path);
+        return false;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    // Bytes still in the batch being filled are patched in place
+    if (offset + size > m_impl->currentOffset) {
+        const uint64_t start = std::max(offset, m_impl->currentOffset);
+        std::memcpy(m_impl->current->data + (start - m_impl->currentOffset), bytes + (start - offset),
+                    static_cast<size_t>(offset + size - start));
+        m_impl->currentQueued = false;
+        size = static_cast<size_t>(start - offset);
+    }
+    if (size == 0) {
+        return true;
+    }
+
+    Impl::Job job;
+    job.kind = Impl::Job::PATCH;
+    job.offset = offset;
+    job.bytes.assign(bytes, bytes + size);
+    m_impl->push(std::move(job));
+    return !m_impl->failed.load();
+}
+
+bool FileWriter::flush() {
+    if (!isOpen()) {
+        return false;
+    }
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->writeMutex);
+        if (m_impl->current->used > 0 && !m_impl->currentQueued && !m_impl->queueCurrent(true)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> queueLock(m_impl->queueMutex);
+        ticket = m_impl->nextTicket;
+    }
+    return m_impl->waitFor(ticket);
+}
+
+bool FileWriter::whenWritten(std::function<void()> callback) {
+    if (!isOpen()) {
+        return false;
+    }
+    uint64_t end;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->writeMutex);
+        end = m_impl->position;
+    }
+    std::unique_lock<std::mutex> lock(m_impl->queueMutex);
+    if (m_impl->failed.load()) {
+        return false;
+    }
+    if (m_impl->writtenThrough >= end) {
+        lock.unlock();
+        callback();
+        return true;
+    }
+    m_impl->waiters.push_back({end, std::move(callback)});
+    return true;
+}
+
+bool FileWriter::sync() {
+    if (!flush()) {
+        return false;
+    }
+    Impl::Job job;
+    job.kind = Impl::Job::SYNC;
+    return m_impl->waitFor(m_impl->push(std::move(job)));
+}
+
+uint64_t FileWriter::getPosition() const {
+    std::lock_guard<std::mutex> lock(m_impl->writeMutex);
+    return m_impl->position;
+}
+
+bool FileWriter::isDirect() const {
+    return m_impl->direct;
+}
+
+IoBackend FileWriter::getBackend() const {
+    return m_impl->backend;
+}
+
+FileWriter::Stats FileWriter::getStats() const {
+    std::lock_guard<std::mutex> lock(m_impl->queueMutex);
+    return m_impl->stats;
+}
+
+const std::string& FileWriter::getPath() const {
+    return m_impl->path;
+}
+
+}} // namespace Recordify::FileManager
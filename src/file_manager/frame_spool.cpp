@@ -0,0 +1,488 @@
+#include "file_manager/frame_spool.h"
+#include "screen_handler/screen_handler.h"
+#include "utils/logger.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Recordify {
+namespace FileManager {
+
+namespace {
+
+const char MAGIC[8] = {'R', 'F', 'S', 'P', 'O', 'O', 'L', '1'};
+const uint32_t VERSION = 1;
+constexpr uint64_t HEADER_BYTES = 4096;
+constexpr uint64_t PAGE_BYTES = 4096;
+constexpr uint64_t FRAME_ALIGNMENT = 64; // frames start on a cache line
+
+// On-disk layout; little-endian, fixed-width fields only
+struct SpoolHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t maxFrames;
+    uint64_t indexOffset;
+    uint64_t dataOffset;
+    uint64_t dataCapacity;
+    uint64_t dataUsed;
+    uint32_t frameCount; // published after the frame's data and index entry
+    uint32_t complete;
+};
+
+struct SpoolEntry {
+    uint64_t offset; // from dataOffset
+    uint64_t size;
+    uint64_t stride;
+    int64_t timestamp; // steady_clock nanoseconds
+    int32_t x, y, areaWidth, areaHeight;
+    int32_t width, height;
+    int32_t bitsPerPixel;
+    int32_t reserved;
+};
+
+static_assert(sizeof(SpoolHeader) <= HEADER_BYTES, "spool header must fit its page");
+static_assert(sizeof(SpoolEntry) == 64, "spool index entries are fixed-size");
+
+uint64_t roundUp(uint64_t value, uint64_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// Whole-file shared mapping
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { unmap(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Writable mapping of a new file of `bytes`, with the disk space reserved
+    bool create(const std::string& path, uint64_t bytes) {
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        // Extending a mapping's size allocates the file, failing up front on a full disk
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(bytes >> 32),
+                                       static_cast<DWORD>(bytes), nullptr);
+        m_data = m_mapping ? static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, 0)) : nullptr;
+#else
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) {
+            return false;
+        }
+#ifdef __linux__
+        // Allocated blocks, not a sparse file: a full disk would otherwise SIGBUS the capture thread
+        if (::posix_fallocate(m_fd, 0, static_cast<off_t>(bytes)) != 0) {
+            unmap();
+            return false;
+        }
+#else
+        if (::ftruncate(m_fd, static_cast<off_t>(bytes)) != 0) {
+            unmap();
+            return false;
+        }
+#endif
+        void* data = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        m_data = data == MAP_FAILED ? nullptr : static_cast<uint8_t*>(data);
+#endif
+        m_size = bytes;
+        m_writable = true;
+        if (!m_data) {
+            unmap();
+        }
+        return m_data != nullptr;
+    }
+
+    bool openReadOnly(const std::string& path) {
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size;
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+            unmap();
+            return false;
+        }
+        m_size = static_cast<uint64_t>(size.QuadPart);
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        m_data = m_mapping ? static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (m_fd < 0 || ::fstat(m_fd, &info) != 0 || info.st_size == 0) {
+            unmap();
+            return false;
+        }
+        m_size = static_cast<uint64_t>(info.st_size);
+        void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        m_data = data == MAP_FAILED ? nullptr : static_cast<uint8_t*>(data);
+#endif
+        m_writable = false;
+        if (!m_data) {
+            unmap();
+        }
+        return m_data != nullptr;
+    }
+
+    // Writes dirty pages back to the file
+    bool flush() {
+#ifdef _WIN32
+        return FlushViewOfFile(m_data, 0) && FlushFileBuffers(m_file);
+#else
+        return ::msync(m_data, m_size, MS_SYNC) == 0;
+#endif
+    }
+
+    // Unmaps, cutting the file down to `bytes` first when writable
+    bool close(uint64_t bytes) {
+        if (!m_data) {
+            return false;
+        }
+        bool ok = !m_writable || flush();
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        m_data = nullptr;
+        m_mapping = nullptr;
+        if (m_writable) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(bytes);
+            ok = SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN) && SetEndOfFile(m_file) && ok;
+        }
+#else
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        if (m_writable) {
+            ok = ::ftruncate(m_fd, static_cast<off_t>(bytes)) == 0 && ok;
+        }
+#endif
+        unmap();
+        return ok;
+    }
+
+    uint8_t* data() const { return m_data; }
+    uint64_t size() const { return m_size; }
+
+private:
+    void unmap() {
+#ifdef _WIN32
+        if (m_data) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+        }
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) {
+            ::munmap(m_data, m_size);
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+        m_fd = -1;
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+    uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+    bool m_writable = false;
+};
+
+} // namespace
+
+struct FrameSpool::Impl {
+    MappedFile file;
+    std::string path;
+    bool writing = false;
+    uint64_t dropped = 0;
+
+    // Full frame rebuilt from DIRTY_TILES pipeline frames
+    ScreenHandler::ScreenCapture reference{};
+
+    SpoolHeader* header() const { return reinterpret_cast<SpoolHeader*>(file.data()); }
+    SpoolEntry* index() const { return reinterpret_cast<SpoolEntry*>(file.data() + header()->indexOffset); }
+    uint8_t* frameData() const { return file.data() + header()->dataOffset; }
+
+    bool validate() const;
+    bool append(const SpoolFrameInfo& info, const uint8_t* pixels, size_t sourceStride);
+};
+
+bool FrameSpool::Impl::validate() const {
+    const SpoolHeader* h = header();
+    if (file.size() < HEADER_BYTES || std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || h->version != VERSION) {
+        return false;
+    }
+    // A crashed writer leaves the full preallocated file, a finished one is trimmed to dataUsed
+    const uint64_t indexEnd = h->indexOffset + static_cast<uint64_t>(h->maxFrames) * sizeof(SpoolEntry);
+    return h->indexOffset >= HEADER_BYTES && indexEnd <= h->dataOffset && h->frameCount <= h->maxFrames &&
+           h->dataUsed <= h->dataCapacity && h->dataOffset + h->dataUsed <= file.size();
+}
+
+// sourceStride 0: pixels are info.size contiguous bytes; otherwise rows of
+// info.stride bytes, sourceStride apart
+bool FrameSpool::Impl::append(const SpoolFrameInfo& info, const uint8_t* pixels, size_t sourceStride) {
+    if (!file.data() || !writing || !pixels || info.size == 0) {
+        return false;
+    }
+
+    SpoolHeader* h = header();
+    const uint64_t offset = roundUp(h->dataUsed, FRAME_ALIGNMENT);
+    if (h->frameCount >= h->maxFrames || offset + info.size > h->dataCapacity) {
+        if (dropped++ == 0) {
+            RECORDIFY_LOG_WARN("FrameSpool", path, " is full after ", h->frameCount, " frames, dropping the rest");
+        }
+        return false;
+    }
+
+    uint8_t* target = frameData() + offset;
+    if (sourceStride == 0 || sourceStride == info.stride) {
+        std::memcpy(target, pixels, info.size);
+    } else {
+        for (int y = 0; y < info.height; ++y) {
+            std::memcpy(target + info.stride * y, pixels + sourceStride * y, info.stride);
+        }
+    }
+
+    SpoolEntry& entry = index()[h->frameCount];
+    entry.offset = offset;
+    entry.size = info.size;
+    entry.stride = info.stride;
+    entry.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(info.timestamp.time_since_epoch()).count();
+    entry.x = info.area.x;
+    entry.y = info.area.y;
+    entry.areaWidth = info.area.width;
+    entry.areaHeight = info.area.height;
+    entry.width = info.width;
+    entry.height = info.height;
+    entry.bitsPerPixel = info.bitsPerPixel;
+    entry.reserved = 0;
+
+    // A reader mapping the live file sees the count only after the frame is in place
+    h->dataUsed = offset + info.size;
+    std::atomic_thread_fence(std::memory_order_release);
+    h->frameCount = h->frameCount + 1;
+    return true;
+}
+
+FrameSpool::FrameSpool() : m_impl(std::make_unique<Impl>()) {}
+
+FrameSpool::~FrameSpool() {
+    close();
+}
+
+bool FrameSpool::create(const std::string& path, uint32_t maxFrames, uint64_t dataBytes) {
+    if (isOpen()) {
+        RECORDIFY_LOG_WARN("FrameSpool", "Already open: ", m_impl->path);
+        return false;
+    }
+    if (maxFrames == 0 || dataBytes == 0) {
+        RECORDIFY_LOG_WARN("FrameSpool", "Spool ", path, " needs room for at least one frame");
+        return false;
+    }
+
+    const uint64_t dataOffset = roundUp(HEADER_BYTES + static_cast<uint64_t>(maxFrames) * sizeof(SpoolEntry),
+                                        PAGE_BYTES);
+    const uint64_t dataCapacity = roundUp(dataBytes, PAGE_BYTES);
+    if (!m_impl->file.create(path, dataOffset + dataCapacity)) {
+        RECORDIFY_LOG_ERROR("FrameSpool", "Cannot preallocate ", (dataOffset + dataCapacity) >> 20, " MB for ",
+                            path);
+        std::remove(path.c_str());
+        return false;
+    }
+
+    SpoolHeader* h = m_impl->header();
+    std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+    h->version = VERSION;
+    h->maxFrames = maxFrames;
+    h->indexOffset = HEADER_BYTES;
+    h->dataOffset = dataOffset;
+    h->dataCapacity = dataCapacity;
+    h->dataUsed = 0;
+    h->frameCount = 0;
+    h->complete = 0;
+
+    m_impl->path = path;
+    m_impl->writing = true;
+    m_impl->dropped = 0;
+    m_impl->reference = ScreenHandler::ScreenCapture{};
+    RECORDIFY_LOG_INFO("FrameSpool", "Spooling up to ", maxFrames, " frames / ", dataCapacity >> 20, " MB to ",
+                       path);
+    return true;
+}
+
+bool FrameSpool::open(const std::string& path) {
+    if (isOpen()) {
+        RECORDIFY_LOG_WARN("FrameSpool", "Already open: ", m_impl->path);
+        return false;
+    }
+    if (!m_impl->file.openReadOnly(path) || !m_impl->validate()) {
+        RECORDIFY_LOG_WARN("FrameSpool", path, " is not a readable frame spool");
+        m_impl->file.close(0);
+        return false;
+    }
+    m_impl->path = path;
+    m_impl->writing = false;
+    if (!isComplete()) {
+        RECORDIFY_LOG_INFO("FrameSpool", path, " was not closed by its writer, reading its ", getFrameCount(),
+                           " frames");
+    }
+    return true;
+}
+
+bool FrameSpool::close() {
+    if (!isOpen()) {
+        return false;
+    }
+    if (!m_impl->writing) {
+        return m_impl->file.close(0);
+    }
+
+    // Data reaches the file before the header says the spool is finished
+    bool ok = m_impl->file.flush();
+    SpoolHeader* h = m_impl->header();
+    h->complete = 1;
+    const uint64_t used = h->dataOffset + h->dataUsed;
+    ok = m_impl->file.close(used) && ok;
+    m_impl->writing = false;
+    m_impl->reference = ScreenHandler::ScreenCapture{};
+    if (m_impl->dropped > 0) {
+        RECORDIFY_LOG_WARN("FrameSpool", m_impl->dropped, " frames did not fit in ", m_impl->path);
+    }
+    if (!ok) {
+        RECORDIFY_LOG_ERROR("FrameSpool", "Failed finishing ", m_impl->path);
+    }
+    return ok;
+}
+
+bool FrameSpool::isOpen() const {
+    return m_impl->file.data() != nullptr;
+}
+
+bool FrameSpool::append(const ScreenHandler::ScreenCapture& capture) {
+    if (!capture.hasPixels()) {
+        return false;
+    }
+    SpoolFrameInfo info;
+    info.area = capture.area;
+    info.width = capture.width;
+    info.height = capture.height;
+    info.bitsPerPixel = capture.bitsPerPixel;
+    info.stride = static_cast<size_t>(capture.width) * capture.bytesPerPixel(); // crops are packed on the way in
+    info.size = info.stride * capture.height;
+    info.timestamp = capture.timestamp;
+    return m_impl->append(info, capture.pixels(), capture.bytesPerRow());
+}
+
+bool FrameSpool::append(const SpoolFrameInfo& info, const uint8_t* pixels) {
+    return m_impl->append(info, pixels, 0);
+}
+
+bool FrameSpool::getFrame(uint32_t index, SpoolFrameInfo& info, const uint8_t*& pixels) const {
+    if (!isOpen() || index >= getFrameCount()) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const SpoolEntry& entry = m_impl->index()[index];
+    if (entry.offset + entry.size > m_impl->header()->dataUsed || entry.height <= 0 ||
+        entry.stride * static_cast<uint64_t>(entry.height) > entry.size) {
+        RECORDIFY_LOG_WARN("FrameSpool", "Frame ", index, " of ", m_impl->path, " is corrupt");
+        return false;
+    }
+
+    info.area = Utils::Rectangle(entry.x, entry.y, entry.areaWidth, entry.areaHeight);
+    info.width = entry.width;
+    info.height = entry.height;
+    info.bitsPerPixel = entry.bitsPerPixel;
+    info.stride = static_cast<size_t>(entry.stride);
+    info.size = static_cast<size_t>(entry.size);
+    info.timestamp = std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(entry.timestamp)));
+    pixels = m_impl->frameData() + entry.offset;
+    return true;
+}
+
+uint32_t FrameSpool::getFrameCount() const {
+    return isOpen() ? m_impl->header()->frameCount : 0;
+}
+
+uint32_t FrameSpool::getCapacity() const {
+    return isOpen() ? m_impl->header()->maxFrames : 0;
+}
+
+uint64_t FrameSpool::getDataUsed() const {
+    return isOpen() ? m_impl->header()->dataUsed : 0;
+}
+
+uint64_t FrameSpool::getDataCapacity() const {
+    return isOpen() ? m_impl->header()->dataCapacity : 0;
+}
+
+uint64_t FrameSpool::getDroppedFrames() const {
+    return m_impl->dropped;
+}
+
+bool FrameSpool::isComplete() const {
+    return isOpen() && m_impl->header()->complete != 0;
+}
+
+void FrameSpool::attach(ScreenHandler::ScreenHandler& handler) {
+    handler.setFrameWriter([this](const ScreenHandler::PipelineFrame& frame) { return writeFrame(frame); });
+}
+
+void FrameSpool::detach(ScreenHandler::ScreenHandler& handler) {
+    handler.setFrameWriter(ScreenHandler::ScreenHandler::FrameWriter());
+}
+
+bool FrameSpool::writeFrame(const ScreenHandler::PipelineFrame& frame) {
+    if (!frame.incremental) {
+        return append(frame.capture);
+    }
+
+    // Rebuild the full picture; the spool only holds whole frames
+    const ScreenHandler::SparseCapture& changes = frame.changes;
+    ScreenHandler::ScreenCapture& reference = m_impl->reference;
+    const bool sameFormat = changes.width == reference.width && changes.height == reference.height &&
+                            changes.bitsPerPixel == reference.bitsPerPixel;
+    if (changes.keyFrame && !sameFormat) {
+        reference.width = changes.width;
+        reference.height = changes.height;
+        reference.bitsPerPixel = changes.bitsPerPixel;
+        reference.pixelData =
+            ScreenHandler::FrameBuffer::allocate(static_cast<size_t>(changes.width) * changes.height *
+                                                 changes.bytesPerPixel());
+    } else if (!sameFormat || reference.pixelData.empty()) {
+        ++m_impl->dropped; // nothing to apply the tiles to until the next key frame
+        return false;
+    }
+    reference.area = changes.area;
+    return changes.applyTo(reference) && append(reference);
+}
+
+const std::string& FrameSpool::getPath() const {
+    return m_impl->path;
+}
+
+}} // namespace Recordify::FileManager
@@ -0,0 +1,186 @@
+#include "file_manager/segment_manifest.h"
+#include "utils/logger.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Recordify {
+namespace FileManager {
+
+namespace {
+
+const char* const MAGIC = "recordify-segments";
+const int VERSION = 1;
+
+// "dir/name.ext" -> "dir/", "name", ".ext"
+void splitPath(const std::string& path, std::string& directory, std::string& name, std::string& extension) {
+    const size_t slash = path.find_last_of("/\\");
+    directory = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    name = slash == std::string::npos ? path : path.substr(slash + 1);
+    const size_t dot = name.find_last_of('.');
+    extension = dot == std::string::npos || dot == 0 ? std::string() : name.substr(dot);
+    name = name.substr(0, name.size() - extension.size());
+}
+
+bool syncFile(std::FILE* file) {
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return ::fsync(fileno(file)) == 0;
+#endif
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// A rename is only durable once the directory entry is. This also covers
+// the segment files the manifest lists, which live in the same directory.
+bool syncDirectory(const std::string& directory) {
+#ifdef _WIN32
+    (void)directory; // MOVEFILE_WRITE_THROUGH already flushed it
+    return true;
+#else
+    const int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+} // namespace
+
+SegmentManifest::SegmentManifest(const std::string& outputPath) {
+    splitPath(outputPath, m_directory, m_base, m_extension);
+    m_path = m_directory + m_base + ".manifest";
+}
+
+std::string SegmentManifest::segmentName(size_t index) const {
+    char number[16];
+    std::snprintf(number, sizeof(number), "_%05zu", index);
+    return m_base + number + m_extension;
+}
+
+std::string SegmentManifest::resolve(const SegmentInfo& segment) const {
+    return m_directory + segment.file;
+}
+
+uint64_t SegmentManifest::getTotalFrames() const {
+    uint64_t frames = 0;
+    for (const auto& segment : m_segments) {
+        frames += segment.frames;
+    }
+    return frames;
+}
+
+double SegmentManifest::getTotalDuration() const {
+    double duration = 0.0;
+    for (const auto& segment : m_segments) {
+        duration += segment.duration;
+    }
+    return duration;
+}
+
+bool SegmentManifest::add(const SegmentInfo& segment) {
+    m_segments.push_back(segment);
+    return save();
+}
+
+bool SegmentManifest::finish() {
+    m_complete = true;
+    return save();
+}
+
+bool SegmentManifest::save() const {
+    const std::string temp = m_path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (!file) {
+        RECORDIFY_LOG_WARN("SegmentManifest", "Cannot create ", temp);
+        return false;
+    }
+
+    // File names go last on their line so they may contain spaces
+    std::fprintf(file, "%s %d\n", MAGIC, VERSION);
+    std::fprintf(file, "stream %s %d %d %.6g\n", m_stream.codec.empty() ? "-" : m_stream.codec.c_str(),
+                 m_stream.width, m_stream.height, m_stream.fps);
+    for (const auto& segment : m_segments) {
+        std::fprintf(file, "segment %u %.3f %llu %s\n", segment.frames, segment.duration,
+                     static_cast<unsigned long long>(segment.bytes), segment.file.c_str());
+    }
+    if (m_complete) {
+        std::fprintf(file, "complete\n");
+    }
+
+    bool ok = std::fflush(file) == 0 && syncFile(file);
+    ok = std::fclose(file) == 0 && ok;
+    ok = ok && replaceFile(temp, m_path);
+    if (!ok) {
+        RECORDIFY_LOG_WARN("SegmentManifest", "Failed writing ", m_path);
+        std::remove(temp.c_str());
+        return false;
+    }
+    if (!syncDirectory(m_directory)) {
+        RECORDIFY_LOG_WARN("SegmentManifest", "Cannot sync the directory of ", m_path);
+        return false;
+    }
+    return true;
+}
+
+bool SegmentManifest::load(const std::string& manifestPath) {
+    std::ifstream in(manifestPath);
+    std::string magic;
+    int version = 0;
+    if (!(in >> magic >> version) || magic != MAGIC || version != VERSION) {
+        RECORDIFY_LOG_WARN("SegmentManifest", manifestPath, " is not a segment manifest");
+        return false;
+    }
+
+    std::string extension;
+    splitPath(manifestPath, m_directory, m_base, extension);
+    m_path = manifestPath;
+    m_stream = StreamInfo();
+    m_segments.clear();
+    m_complete = false;
+
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "stream") {
+            fields >> m_stream.codec >> m_stream.width >> m_stream.height >> m_stream.fps;
+        } else if (kind == "segment") {
+            SegmentInfo segment;
+            fields >> segment.frames >> segment.duration >> segment.bytes >> std::ws;
+            std::getline(fields, segment.file);
+            if (!fields.fail() && !segment.file.empty()) {
+                m_segments.push_back(segment);
+            }
+        } else if (kind == "complete") {
+            m_complete = true;
+        }
+    }
+    if (!m_segments.empty()) {
+        std::string directory, name;
+        splitPath(m_segments.front().file, directory, name, m_extension);
+    }
+    return true;
+}
+
+}} // namespace Recordify::FileManager
@@ -0,0 +1,188 @@
+#include "screen_handler/animation_batch.h"
+#include <algorithm>
+#include <limits>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+void AnimationBatch::add(int objectId, const Animation& animation) {
+    remove(objectId);
+
+    const auto& keyframes = animation.getKeyframes();
+    if (keyframes.empty()) {
+        return;
+    }
+
+    m_rows[objectId] = m_ids.size();
+    m_ids.push_back(objectId);
+    m_elapsed.push_back(0.0f);
+    // A zero-length animation jumps straight to its end
+    m_inverseDuration.push_back(animation.getDuration() > 0.0f ? 1.0f / animation.getDuration()
+                                                               : std::numeric_limits<float>::infinity());
+    m_firstKey.push_back(static_cast<uint32_t>(m_keyTime.size()));
+    m_keyCount.push_back(static_cast<uint32_t>(keyframes.size()));
+    m_segment.push_back(0);
+
+    for (const auto& keyframe : keyframes) {
+        m_keyTime.push_back(keyframe.time);
+        m_keyEasing.push_back(keyframe.easing);
+        m_keyValue[X].push_back(static_cast<float>(keyframe.position.x));
+        m_keyValue[Y].push_back(static_cast<float>(keyframe.position.y));
+        m_keyValue[OPACITY].push_back(keyframe.opacity);
+        m_keyValue[SCALE].push_back(keyframe.scale);
+        m_keyValue[ROTATION].push_back(keyframe.rotation);
+    }
+}
+
+bool AnimationBatch::remove(int objectId) {
+    int index = indexOf(objectId);
+    if (index < 0) {
+        return false;
+    }
+    removeAt(static_cast<size_t>(index));
+    return true;
+}
+
+void AnimationBatch::clear() {
+    m_rows.clear();
+    m_ids.clear();
+    m_elapsed.clear();
+    m_inverseDuration.clear();
+    m_firstKey.clear();
+    m_keyCount.clear();
+    m_segment.clear();
+    m_keyTime.clear();
+    m_keyEasing.clear();
+    for (auto& channel : m_keyValue) {
+        channel.clear();
+    }
+}
+
+int AnimationBatch::indexOf(int objectId) const {
+    auto it = m_rows.find(objectId);
+    return it != m_rows.end() ? static_cast<int>(it->second) : -1;
+}
+
+void AnimationBatch::removeAt(size_t index) {
+    // Close the gap in the keyframe arrays
+    const uint32_t first = m_firstKey[index];
+    const uint32_t count = m_keyCount[index];
+    m_keyTime.erase(m_keyTime.begin() + first, m_keyTime.begin() + first + count);
+    m_keyEasing.erase(m_keyEasing.begin() + first, m_keyEasing.begin() + first + count);
+    for (auto& channel : m_keyValue) {
+        channel.erase(channel.begin() + first, channel.begin() + first + count);
+    }
+    for (auto& key : m_firstKey) {
+        if (key > first) {
+            key -= count;
+        }
+    }
+
+    // Swap-remove the row; order doesn't matter
+    const size_t last = m_ids.size() - 1;
+    m_rows.erase(m_ids[index]);
+    if (index != last) {
+        m_ids[index] = m_ids[last];
+        m_elapsed[index] = m_elapsed[last];
+        m_inverseDuration[index] = m_inverseDuration[last];
+        m_firstKey[index] = m_firstKey[last];
+        m_keyCount[index] = m_keyCount[last];
+        m_segment[index] = m_segment[last];
+        m_rows[m_ids[index]] = index;
+    }
+    m_ids.pop_back();
+    m_elapsed.pop_back();
+    m_inverseDuration.pop_back();
+    m_firstKey.pop_back();
+    m_keyCount.pop_back();
+    m_segment.pop_back();
+}
+
+void AnimationBatch::advance(float deltaTime, std::vector<int>& finished) {
+    const size_t count = m_ids.size();
+    m_evaluatedIds = m_ids;
+    m_evaluatedTime.resize(count);
+    m_from.resize(count);
+    m_to.resize(count);
+    m_weight.resize(count);
+
+    // Pass 1: local time, segment and eased weight per animation
+    for (size_t i = 0; i < count; ++i) {
+        m_elapsed[i] = std::max(0.0f, m_elapsed[i] + deltaTime);
+        const float time = std::min(1.0f, m_elapsed[i] * m_inverseDuration[i]);
+        m_evaluatedTime[i] = time;
+
+        const uint32_t first = m_firstKey[i];
+        const uint32_t last = first + m_keyCount[i] - 1;
+        if (time <= m_keyTime[first] || first == last) {
+            m_from[i] = m_to[i] = first;
+            m_weight[i] = 0.0f;
+            continue;
+        }
+        if (time >= m_keyTime[last]) {
+            m_from[i] = m_to[i] = last;
+            m_weight[i] = 0.0f;
+            continue;
+        }
+
+        // Cursor only moves forward unless time was rewound
+        uint32_t segment = first + m_segment[i];
+        if (m_keyTime[segment] > time) {
+            segment = first;
+        }
+        while (m_keyTime[segment + 1] <= time) {
+            ++segment;
+        }
+        m_segment[i] = segment - first;
+
+        const float start = m_keyTime[segment];
+        m_from[i] = segment;
+        m_to[i] = segment + 1;
+        m_weight[i] = applyEasing(m_keyEasing[segment], (time - start) / (m_keyTime[segment + 1] - start));
+    }
+
+    // Pass 2: interpolate each channel in one flat loop
+    const uint32_t* from = m_from.data();
+    const uint32_t* to = m_to.data();
+    const float* weight = m_weight.data();
+    for (int channel = 0; channel < CHANNELS; ++channel) {
+        m_result[channel].resize(count);
+        const float* values = m_keyValue[channel].data();
+        float* out = m_result[channel].data();
+        for (size_t i = 0; i < count; ++i) {
+            const float a = values[from[i]];
+            const float b = values[to[i]];
+            out[i] = a + weight[i] * (b - a);
+        }
+    }
+
+    // Drop what finished; results stay in the evaluated arrays
+    for (size_t i = count; i-- > 0;) {
+        if (m_evaluatedTime[i] >= 1.0f) {
+            finished.push_back(m_ids[i]);
+            removeAt(i);
+        }
+    }
+}
+
+bool AnimationBatch::getState(int objectId, AnimationKeyframe& state) const {
+    auto it = std::find(m_evaluatedIds.begin(), m_evaluatedIds.end(), objectId);
+    if (it == m_evaluatedIds.end()) {
+        return false;
+    }
+    state = getStateAt(static_cast<size_t>(it - m_evaluatedIds.begin()));
+    return true;
+}
+
+AnimationKeyframe AnimationBatch::getStateAt(size_t index) const {
+    AnimationKeyframe state;
+    state.time = m_evaluatedTime[index];
+    state.position.x = static_cast<int>(m_result[X][index]);
+    state.position.y = static_cast<int>(m_result[Y][index]);
+    state.opacity = m_result[OPACITY][index];
+    state.scale = m_result[SCALE][index];
+    state.rotation = m_result[ROTATION][index];
+    return state;
+}
+
+}} // namespace Recordify::ScreenHandler
@@ -0,0 +1,29 @@
+#include "screen_handler/capture_source.h"
+#include "screen_handler/synthetic_source.h"
+#include "utils/logger.h"
+#include <cstdlib>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+std::unique_ptr<CaptureSource> createSimulatedCaptureSource() {
+    return std::make_unique<SyntheticSource>();
+}
+
+std::unique_ptr<CaptureSource> createDefaultCaptureSource() {
+#ifndef _WIN32
+    const char* display = std::getenv("DISPLAY");
+    if (display && *display) {
+        std::unique_ptr<CaptureSource> source = createX11CaptureSource();
+        if (source && source->open()) {
+            return source;
+        }
+    }
+#endif
+    RECORDIFY_LOG_INFO("CaptureSource", "No display to capture, using a synthetic desktop");
+    std::unique_ptr<CaptureSource> source = createSimulatedCaptureSource();
+    source->open();
+    return source;
+}
+
+}} // namespace Recordify::ScreenHandler
@@ -0,0 +1,266 @@
+#include "screen_handler/frame_pool.h"
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace Recordify {
+namespace ScreenHandler {
+
+namespace {
+
+void* alignedAlloc(size_t alignment, size_t bytes) {
+#ifdef _WIN32
+    return _aligned_malloc(bytes, alignment);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, bytes) != 0) {
+        return nullptr;
+    }
+    return ptr;
+#endif
+}
+
+void alignedFree(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+// FrameBuffer implementation
+FrameBuffer::FrameBuffer(Block* block, size_t size)
+    : m_block(block)
+    , m_size(size) {
+    m_block->refs.store(1, std::memory_order_relaxed);
+}
+
+FrameBuffer::FrameBuffer(const FrameBuffer& other)
+    : m_block(other.m_block)
+    , m_size(other.m_size) {
+    if (m_block) {
+        m_block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept
+    : m_block(other.m_block)
+    , m_size(other.m_size) {
+    other.m_block = nullptr;
+    other.m_size = 0;
+}
+
+FrameBuffer& FrameBuffer::operator=(const FrameBuffer& other) {
+    if (this != &other) {
+        if (other.m_block) {
+            other.m_block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        release();
+        m_block = other.m_block;
+        m_size = other.m_size;
+    }
+    return *this;
+}
+
+FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_block = other.m_block;
+        m_size = other.m_size;
+        other.m_block = nullptr;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+FrameBuffer::~FrameBuffer() {
+    release();
+}
+
+FrameBuffer FrameBuffer::allocate(size_t bytes) {
+    auto* block = new Block();
+    block->capacity = roundUp(bytes == 0 ? 1 : bytes, FramePool::pageSize());
+    block->data = static_cast<uint8_t*>(alignedAlloc(FramePool::pageSize(), block->capacity));
+    if (!block->data) {
+        delete block;
+        throw std::bad_alloc();
+    }
+    block->recycle = [](Block* heapBlock) {
+        alignedFree(heapBlock->data);
+        delete heapBlock;
+    };
+    return FrameBuffer(block, bytes);
+}
+
+bool FrameBuffer::resize(size_t bytes) {
+    if (!m_block || bytes > m_block->capacity) {
+        return false;
+    }
+    m_size = bytes;
+    return true;
+}
+
+void FrameBuffer::reset() {
+    release();
+}
+
+void FrameBuffer::release() {
+    if (m_block && m_block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_block->recycle(m_block);
+    }
+    m_block = nullptr;
+    m_size = 0;
+}
+
+// FramePool implementation
+struct FramePool::State {
+    std::mutex mutex;
+    std::vector<FrameBuffer::Block> blocks;
+    std::vector<FrameBuffer::Block*> freeList;
+    uint8_t* slabMemory = nullptr;
+    std::shared_ptr<void> slabOwner; // set when the memory isn't ours to free
+    size_t slabBytes = 0;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    ~State() {
+        if (!slabOwner) {
+            alignedFree(slabMemory);
+        }
+    }
+
+    static void recycle(FrameBuffer::Block* block) {
+        // Hold the owner reference until the block is back on the free list
+        std::shared_ptr<void> owner = std::move(block->owner);
+        auto* state = static_cast<State*>(owner.get());
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->freeList.push_back(block);
+        }
+    }
+};
+
+FramePool::FramePool()
+    : m_state(std::make_shared<State>()) {
+}
+
+FramePool::FramePool(int slabCount, size_t slabBytes)
+    : FramePool() {
+    configure(slabCount, slabBytes);
+}
+
+FramePool::~FramePool() = default;
+
+bool FramePool::configure(int slabCount, size_t slabBytes, const SlabAllocator& allocator) {
+    if (slabCount <= 0 || slabBytes == 0) {
+        return false;
+    }
+
+    auto state = std::make_shared<State>();
+    state->slabBytes = roundUp(slabBytes, pageSize());
+    const size_t totalBytes = state->slabBytes * static_cast<size_t>(slabCount);
+    if (allocator) {
+        SlabMemory memory = allocator(totalBytes);
+        state->slabMemory = memory.data;
+        state->slabOwner = memory.data ? std::move(memory.owner) : nullptr;
+    }
+    if (!state->slabOwner) {
+        state->slabMemory = static_cast<uint8_t*>(alignedAlloc(pageSize(), totalBytes));
+    }
+    if (!state->slabMemory) {
+        return false;
+    }
+
+    state->blocks = std::vector<FrameBuffer::Block>(static_cast<size_t>(slabCount));
+    state->freeList.reserve(static_cast<size_t>(slabCount));
+    for (int i = 0; i < slabCount; ++i) {
+        auto& block = state->blocks[static_cast<size_t>(i)];
+        block.data = state->slabMemory + state->slabBytes * static_cast<size_t>(i);
+        block.capacity = state->slabBytes;
+        block.pooled = true;
+        block.recycle = &State::recycle;
+        state->freeList.push_back(&block);
+    }
+
+    // Buffers borrowed from the previous slab set keep it alive until returned,
+    // and so does an acquire() still working on it
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_state.swap(state);
+    }
+    return true;
+}
+
+std::shared_ptr<FramePool::State> FramePool::currentState() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_state;
+}
+
+bool FramePool::isConfigured() const {
+    return !currentState()->blocks.empty();
+}
+
+FrameBuffer FramePool::acquire(size_t bytes) {
+    std::shared_ptr<State> state = currentState();
+    if (bytes <= state->slabBytes) {
+        FrameBuffer::Block* block = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->freeList.empty()) {
+                block = state->freeList.back();
+                state->freeList.pop_back();
+            }
+        }
+
+        if (block) {
+            state->hits.fetch_add(1, std::memory_order_relaxed);
+            block->owner = std::move(state);
+            return FrameBuffer(block, bytes);
+        }
+    }
+
+    state->misses.fetch_add(1, std::memory_order_relaxed);
+    return FrameBuffer::allocate(bytes);
+}
+
+FramePool::Stats FramePool::getStats() const {
+    std::shared_ptr<State> state = currentState();
+    Stats stats;
+    stats.hits = state->hits.load(std::memory_order_relaxed);
+    stats.misses = state->misses.load(std::memory_order_relaxed);
+    stats.slabCount = static_cast<int>(state->blocks.size());
+    stats.slabBytes = state->slabBytes;
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    stats.slabsInUse = stats.slabCount - static_cast<int>(state->freeList.size());
+    return stats;
+}
+
+void FramePool::resetStats() {
+    std::shared_ptr<State> state = currentState();
+    state->hits.store(0, std::memory_order_relaxed);
+    state->misses.store(0, std::memory_order_relaxed);
+}
+
+size_t FramePool::pageSize() {
+#ifdef _WIN32
+    return 4096;
+#else
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+#endif
+}
+
+}} // namespace Recordify::ScreenHandler
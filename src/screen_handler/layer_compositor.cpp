@@ -0,0 +1,416 @@
+#include "screen_handler/layer_compositor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+namespace {
+
+inline uint32_t mul255(uint32_t x, uint32_t y) {
+    uint32_t t = x * y + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// Premultiplied source-over of `count` RGBA pixels, with opacity folded in
+void blendPixelsOver(uint8_t* dst, const uint8_t* src, size_t count, uint32_t opacity) {
+    for (size_t i = 0; i < count; ++i, dst += 4, src += 4) {
+        uint32_t alpha = src[3];
+        if (alpha == 0) {
+            continue;
+        }
+        if (opacity == 255 && alpha == 255) {
+            std::memcpy(dst, src, 4);
+            continue;
+        }
+        uint32_t r = src[0], g = src[1], b = src[2];
+        if (opacity != 255) {
+            r = mul255(r, opacity);
+            g = mul255(g, opacity);
+            b = mul255(b, opacity);
+            alpha = mul255(alpha, opacity);
+        }
+        uint32_t inverse = 255 - alpha;
+        dst[0] = static_cast<uint8_t>(std::min(255u, r + mul255(dst[0], inverse)));
+        dst[1] = static_cast<uint8_t>(std::min(255u, g + mul255(dst[1], inverse)));
+        dst[2] = static_cast<uint8_t>(std::min(255u, b + mul255(dst[2], inverse)));
+        dst[3] = static_cast<uint8_t>(std::min(255u, alpha + mul255(dst[3], inverse)));
+    }
+}
+
+// Tiles are contiguous since TILE_STRIDE is exactly one row of pixels
+void blendTileOver(uint8_t* dst, const uint8_t* src, uint32_t opacity) {
+    blendPixelsOver(dst, src, TiledSurface::TILE_SIZE * TiledSurface::TILE_SIZE, opacity);
+}
+
+// One overlay row onto a destination row. R/G/B/A are the destination byte
+// offsets of each source channel; A < 0 means the destination has no alpha.
+template <int BYTES, int R, int G, int B, int A>
+void blendRowOnto(uint8_t* dst, const uint8_t* src, int count) {
+    for (int i = 0; i < count; ++i, dst += BYTES, src += 4) {
+        uint32_t alpha = src[3];
+        if (alpha == 0) {
+            continue;
+        }
+        if (alpha == 255) {
+            dst[R] = src[0];
+            dst[G] = src[1];
+            dst[B] = src[2];
+            if constexpr (A >= 0) dst[A] = 255;
+            continue;
+        }
+        uint32_t inverse = 255 - alpha;
+        dst[R] = static_cast<uint8_t>(std::min(255u, src[0] + mul255(dst[R], inverse)));
+        dst[G] = static_cast<uint8_t>(std::min(255u, src[1] + mul255(dst[G], inverse)));
+        dst[B] = static_cast<uint8_t>(std::min(255u, src[2] + mul255(dst[B], inverse)));
+        if constexpr (A >= 0) {
+            dst[A] = static_cast<uint8_t>(std::min(255u, alpha + mul255(dst[A], inverse)));
+        }
+    }
+}
+
+using RowBlender = void (*)(uint8_t*, const uint8_t*, int);
+
+RowBlender frameBlender(int bytesPerPixel) {
+    if (bytesPerPixel == 3) {
+        return &blendRowOnto<3, 2, 1, 0, -1>;
+    }
+    if (bytesPerPixel == 4) {
+        return &blendRowOnto<4, 2, 1, 0, 3>;
+    }
+    return nullptr;
+}
+
+// Blends `rect` (overlay coordinates, within one tile) of the tile at
+// `source` onto a frame whose pixel at `origin` is `pixels`
+void blendTileOnto(RowBlender blendRow, const uint8_t* source, const Utils::Rectangle& rect, uint8_t* pixels,
+                   const Utils::Point& origin, size_t stride, int bytesPerPixel) {
+    for (int row = 0; row < rect.height; ++row) {
+        uint8_t* dst = pixels + stride * (rect.y - origin.y + row) +
+                       static_cast<size_t>(rect.x - origin.x) * bytesPerPixel;
+        const uint8_t* src = source + (rect.y % TiledSurface::TILE_SIZE + row) * TiledSurface::TILE_STRIDE +
+                             (rect.x % TiledSurface::TILE_SIZE) * 4;
+        blendRow(dst, src, rect.width);
+    }
+}
+
+} // namespace
+
+// TiledSurface
+TiledSurface::TiledSurface(int width, int height) {
+    resize(width, height);
+}
+
+bool TiledSurface::resize(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        m_tiles.clear();
+        m_dirty.clear();
+        m_width = m_height = m_columns = m_rows = m_occupied = 0;
+        m_anyDirty = false;
+        return false;
+    }
+
+    // The grid is anchored at (0,0), so tiles that still fit keep their place
+    const int columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const int rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+    std::vector<std::unique_ptr<Tile>> tiles(static_cast<size_t>(columns) * rows);
+    int occupied = 0;
+    for (int row = 0; row < std::min(rows, m_rows); ++row) {
+        for (int column = 0; column < std::min(columns, m_columns); ++column) {
+            auto& tile = m_tiles[row * m_columns + column];
+            if (!tile) {
+                continue;
+            }
+
+            // Clear whatever now lies beyond the right or bottom edge
+            int keepWidth = std::min(TILE_SIZE, width - column * TILE_SIZE);
+            int keepHeight = std::min(TILE_SIZE, height - row * TILE_SIZE);
+            for (int y = 0; y < TILE_SIZE; ++y) {
+                uint8_t* line = tile->pixels + y * TILE_STRIDE;
+                if (y >= keepHeight) {
+                    std::memset(line, 0, TILE_STRIDE);
+                } else if (keepWidth < TILE_SIZE) {
+                    std::memset(line + keepWidth * 4, 0, (TILE_SIZE - keepWidth) * 4);
+                }
+            }
+            tiles[row * columns + column] = std::move(tile);
+            ++occupied;
+        }
+    }
+
+    m_tiles = std::move(tiles);
+    m_width = width;
+    m_height = height;
+    m_columns = columns;
+    m_rows = rows;
+    m_occupied = occupied;
+    // Everything kept has moved in the consumer's eyes
+    m_dirty.assign(m_tiles.size(), 0);
+    m_anyDirty = false;
+    markOccupiedDirty();
+    return true;
+}
+
+void TiledSurface::clear() {
+    for (int tile = 0; tile < tileCount(); ++tile) {
+        if (m_tiles[tile]) {
+            releaseTile(tile);
+            markDirty(tile);
+        }
+    }
+}
+
+Utils::Rectangle TiledSurface::tileRect(int tile) const {
+    int x = (tile % m_columns) * TILE_SIZE;
+    int y = (tile / m_columns) * TILE_SIZE;
+    return Utils::Rectangle(x, y, std::min(TILE_SIZE, m_width - x), std::min(TILE_SIZE, m_height - y));
+}
+
+uint8_t* TiledSurface::acquireTile(int tile) {
+    if (!m_tiles[tile]) {
+        m_tiles[tile] = std::make_unique<Tile>();
+        std::memset(m_tiles[tile]->pixels, 0, sizeof(Tile::pixels));
+        ++m_occupied;
+    }
+    return m_tiles[tile]->pixels;
+}
+
+void TiledSurface::releaseTile(int tile) {
+    if (m_tiles[tile]) {
+        m_tiles[tile].reset();
+        --m_occupied;
+    }
+}
+
+void TiledSurface::markOccupiedDirty() {
+    for (int tile = 0; tile < tileCount(); ++tile) {
+        if (m_tiles[tile]) {
+            markDirty(tile);
+        }
+    }
+}
+
+void TiledSurface::clearDirty() {
+    if (m_anyDirty) {
+        std::fill(m_dirty.begin(), m_dirty.end(), 0);
+        m_anyDirty = false;
+    }
+}
+
+void TiledSurface::blendSpan(int x, int y, const uint8_t* coverage, int count, PremultipliedColor color) {
+    if (y < 0 || y >= m_height) {
+        return;
+    }
+    if (x < 0) {
+        coverage -= x;
+        count += x;
+        x = 0;
+    }
+    count = std::min(count, m_width - x);
+
+    const int rowBase = (y / TILE_SIZE) * m_columns;
+    const size_t rowOffset = static_cast<size_t>(y % TILE_SIZE) * TILE_STRIDE;
+    while (count > 0) {
+        int inTileX = x % TILE_SIZE;
+        int chunk = std::min(count, TILE_SIZE - inTileX);
+        int tile = rowBase + x / TILE_SIZE;
+
+        uint8_t* pixels = tileData(tile);
+        if (!pixels && std::any_of(coverage, coverage + chunk, [](uint8_t c) { return c != 0; })) {
+            pixels = acquireTile(tile);
+        }
+        if (pixels) {
+            Rasterizer::blendSpan(pixels + rowOffset + inTileX * 4, coverage, chunk, color);
+            markDirty(tile);
+        }
+
+        x += chunk;
+        coverage += chunk;
+        count -= chunk;
+    }
+}
+
+void TiledSurface::blendSurface(const RasterSurface& image, int x, int y, const Utils::Rectangle& clip) {
+    const Utils::Rectangle area = Utils::Rectangle(x, y, image.width(), image.height())
+                                      .intersection(clip).intersection(bounds());
+    for (int row = area.y; row < area.bottom(); ++row) {
+        const uint8_t* source = image.row(row - y) + static_cast<size_t>(area.x - x) * 4;
+        const int rowBase = (row / TILE_SIZE) * m_columns;
+        const size_t rowOffset = static_cast<size_t>(row % TILE_SIZE) * TILE_STRIDE;
+        int column = area.x;
+        while (column < area.right()) {
+            int inTileX = column % TILE_SIZE;
+            int chunk = std::min(area.right() - column, TILE_SIZE - inTileX);
+            int tile = rowBase + column / TILE_SIZE;
+
+            uint8_t* pixels = tileData(tile);
+            if (!pixels) {
+                bool covered = false;
+                for (int i = 0; i < chunk && !covered; ++i) {
+                    covered = source[i * 4 + 3] != 0;
+                }
+                pixels = covered ? acquireTile(tile) : nullptr;
+            }
+            if (pixels) {
+                blendPixelsOver(pixels + rowOffset + inTileX * 4, source, chunk, 255);
+                markDirty(tile);
+            }
+
+            column += chunk;
+            source += static_cast<size_t>(chunk) * 4;
+        }
+    }
+}
+
+PremultipliedColor TiledSurface::pixel(int x, int y) const {
+    PremultipliedColor color;
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) {
+        return color;
+    }
+    const uint8_t* pixels = tileData((y / TILE_SIZE) * m_columns + x / TILE_SIZE);
+    if (pixels) {
+        const uint8_t* p = pixels + (y % TILE_SIZE) * TILE_STRIDE + (x % TILE_SIZE) * 4;
+        color.r = p[0];
+        color.g = p[1];
+        color.b = p[2];
+        color.a = p[3];
+    }
+    return color;
+}
+
+// LayerCompositor
+bool LayerCompositor::resize(int width, int height) {
+    m_occupiedList.clear();
+    m_invalidated = true;
+    return m_overlay.resize(width, height);
+}
+
+void LayerCompositor::invalidate() {
+    m_invalidated = true;
+}
+
+void LayerCompositor::update(const std::vector<LayerRef>& layers) {
+    bool changed = m_invalidated;
+    for (const auto& layer : layers) {
+        changed = changed || layer.surface->hasDirtyTiles();
+    }
+    if (!changed) {
+        return;
+    }
+
+    for (int tile = 0; tile < m_overlay.tileCount(); ++tile) {
+        bool rebuild = m_invalidated;
+        for (size_t i = 0; i < layers.size() && !rebuild; ++i) {
+            rebuild = layers[i].surface->tileCount() == m_overlay.tileCount() && layers[i].surface->isDirty(tile);
+        }
+        if (!rebuild) {
+            continue;
+        }
+
+        uint8_t* out = m_overlay.tileData(tile);
+        if (out) {
+            std::memset(out, 0, TiledSurface::TILE_SIZE * TiledSurface::TILE_STRIDE);
+        }
+        bool contributed = false;
+        for (const auto& layer : layers) {
+            if (!layer.visible || layer.opacity <= 0.0f ||
+                layer.surface->tileCount() != m_overlay.tileCount()) {
+                continue;
+            }
+            const uint8_t* source = layer.surface->tileData(tile);
+            if (!source) {
+                continue;
+            }
+            if (!out) {
+                out = m_overlay.acquireTile(tile);
+            }
+            blendTileOver(out, source, static_cast<uint32_t>(std::min(layer.opacity, 1.0f) * 255.0f + 0.5f));
+            contributed = true;
+        }
+        if (!contributed) {
+            m_overlay.releaseTile(tile);
+        }
+        m_stats.tilesRebuilt++;
+    }
+
+    for (const auto& layer : layers) {
+        layer.surface->clearDirty();
+    }
+    m_invalidated = false;
+
+    m_occupiedList.clear();
+    for (int tile = 0; tile < m_overlay.tileCount(); ++tile) {
+        if (m_overlay.hasTile(tile)) {
+            m_occupiedList.push_back(tile);
+        }
+    }
+}
+
+int LayerCompositor::compositeOnto(uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel) {
+    const RowBlender blendRow = frameBlender(bytesPerPixel);
+    if (!blendRow) {
+        return 0;
+    }
+
+    const Utils::Rectangle frame(0, 0, width, height);
+    int blended = 0;
+    for (int tile : m_occupiedList) {
+        Utils::Rectangle rect = m_overlay.tileRect(tile).intersection(frame);
+        if (rect.isEmpty()) {
+            continue;
+        }
+        blendTileOnto(blendRow, m_overlay.tileData(tile), rect, pixels, Utils::Point(0, 0), stride, bytesPerPixel);
+        ++blended;
+    }
+
+    m_stats.tilesComposited += blended;
+    m_stats.framesComposited++;
+    return blended;
+}
+
+int LayerCompositor::compositeOnto(uint8_t* pixels, const Utils::Rectangle& area, size_t stride, int bytesPerPixel) {
+    const RowBlender blendRow = frameBlender(bytesPerPixel);
+    const Utils::Rectangle clipped = area.intersection(m_overlay.bounds());
+    if (!blendRow || clipped.isEmpty()) {
+        return 0;
+    }
+
+    // Only the overlay tiles under the area
+    const int size = TiledSurface::TILE_SIZE;
+    int blended = 0;
+    for (int row = clipped.top() / size; row <= (clipped.bottom() - 1) / size; ++row) {
+        for (int column = clipped.left() / size; column <= (clipped.right() - 1) / size; ++column) {
+            const int tile = row * m_overlay.tileColumns() + column;
+            if (!m_overlay.hasTile(tile)) {
+                continue;
+            }
+            blendTileOnto(blendRow, m_overlay.tileData(tile), m_overlay.tileRect(tile).intersection(clipped),
+                          pixels, area.topLeft(), stride, bytesPerPixel);
+            ++blended;
+        }
+    }
+
+    m_stats.tilesComposited += blended;
+    return blended;
+}
+
+int LayerCompositor::compositeOnto(RasterSurface& surface) {
+    const Utils::Rectangle bounds = surface.bounds();
+    int blended = 0;
+    for (int tile : m_occupiedList) {
+        Utils::Rectangle rect = m_overlay.tileRect(tile).intersection(bounds);
+        if (rect.isEmpty()) {
+            continue;
+        }
+        const uint8_t* source = m_overlay.tileData(tile);
+        for (int row = 0; row < rect.height; ++row) {
+            blendRowOnto<4, 0, 1, 2, 3>(surface.row(rect.y + row) + static_cast<size_t>(rect.x) * 4,
+                                        source + (rect.y % TiledSurface::TILE_SIZE + row) * TiledSurface::TILE_STRIDE,
+                                        rect.width);
+        }
+        ++blended;
+    }
+    return blended;
+}
+
+}} // namespace Recordify::ScreenHandler
@@ -0,0 +1,144 @@
+#include "screen_handler/quality_controller.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+namespace {
+
+const char* presetName(EncoderPreset preset) {
+    switch (preset) {
+        case EncoderPreset::QUALITY: return "quality";
+        case EncoderPreset::BALANCED: return "balanced";
+        case EncoderPreset::FAST: return "fast";
+    }
+    return "quality";
+}
+
+} // namespace
+
+std::string QualityLevel::describe(float fps) const {
+    char text[96];
+    std::snprintf(text, sizeof(text), "scale %g, %s, %s preset, %g fps", resolutionScale,
+                  chroma == ChromaSubsampling::YUV420 ? "4:2:0" : "4:4:4", presetName(preset), fps * fpsScale);
+    return text;
+}
+
+QualityController::QualityController(const AdaptiveQualityOptions& options) : m_options(options) {
+    reset(m_fps);
+}
+
+void QualityController::setOptions(const AdaptiveQualityOptions& options) {
+    m_options = options;
+    reset(m_fps);
+}
+
+void QualityController::setEncoderKnobs(const EncoderKnobs& knobs) {
+    m_knobs = knobs;
+    reset(m_fps);
+}
+
+void QualityController::reset(float fps) {
+    m_fps = fps > 0.0f ? fps : 30.0f;
+    m_ladder.assign(1, QualityLevel());
+
+    // Each step takes the previous one and turns a single knob further down
+    auto addStep = [this](auto change) {
+        QualityLevel level = m_ladder.back();
+        change(level);
+        level.step = static_cast<int>(m_ladder.size());
+        m_ladder.push_back(level);
+    };
+    if (m_options.scaleResolution && m_knobs.resolution) {
+        addStep([](QualityLevel& level) { level.resolutionScale = 0.75f; });
+        addStep([](QualityLevel& level) { level.resolutionScale = 0.5f; });
+    }
+    if (m_options.subsampleChroma && m_knobs.chroma) {
+        addStep([](QualityLevel& level) { level.chroma = ChromaSubsampling::YUV420; });
+    }
+    if (m_options.lowerPreset && m_knobs.preset) {
+        addStep([](QualityLevel& level) { level.preset = EncoderPreset::BALANCED; });
+        addStep([](QualityLevel& level) { level.preset = EncoderPreset::FAST; });
+    }
+    if (m_options.lowerFrameRate) {
+        addStep([](QualityLevel& level) { level.fpsScale = 0.75f; });
+        addStep([](QualityLevel& level) { level.fpsScale = 0.5f; });
+    }
+
+    m_stepCost.assign(m_ladder.size(), 0.0f);
+    m_encodeBeforeStep = 0.0f;
+    m_measureStep = false;
+    m_step = 0;
+    m_load = 0.0f;
+    m_overloadedStreak = 0;
+    m_headroomStreak = 0;
+    m_lastChange = std::chrono::steady_clock::time_point();
+}
+
+float QualityController::getFrameBudget(int step) const {
+    return 1000.0f / (m_fps * m_ladder[step].fpsScale);
+}
+
+float QualityController::relativeCost(const QualityLevel& level) {
+    float cost = level.resolutionScale * level.resolutionScale;
+    if (level.chroma == ChromaSubsampling::YUV420) {
+        cost *= 0.5f; // 1.5 samples per pixel instead of 3
+    }
+    return cost;
+}
+
+QualityController::Decision QualityController::evaluate(const PipelineLoad& load,
+                                                        std::chrono::steady_clock::time_point now) {
+    // Encoders share the frames, so each one only needs to keep up with 1/N of them
+    const float encodeMs = load.encodeMs / std::max(1, load.encoders);
+    m_load = (load.captureMs + encodeMs) / getFrameBudget(m_step);
+
+    const bool overloaded = m_load > m_options.stepDownLoad || load.newDrops > 0 ||
+                            (load.backlogLimit > 0 && load.backlog >= load.backlogLimit);
+
+    // Timings measured right after a change still mix in the old level
+    if (now - m_lastChange < m_options.settleTime) {
+        m_overloadedStreak = 0;
+        m_headroomStreak = 0;
+        return Decision::HOLD;
+    }
+
+    // First settled timing after a step down: what the step saved
+    if (m_measureStep && encodeMs > 0.0f) {
+        m_stepCost[m_step] = std::min(1.0f, std::max(0.1f, encodeMs / m_encodeBeforeStep));
+    }
+    m_measureStep = false;
+
+    bool headroom = false;
+    if (!overloaded && m_step > 0) {
+        // Capture cost doesn't depend on the level; scale the encode share only
+        const float ratio = m_stepCost[m_step] > 0.0f
+                                ? 1.0f / m_stepCost[m_step]
+                                : relativeCost(m_ladder[m_step - 1]) / relativeCost(getLevel());
+        const float predicted = load.captureMs + encodeMs * ratio;
+        headroom = predicted < m_options.stepUpLoad * getFrameBudget(m_step - 1);
+    }
+
+    m_overloadedStreak = overloaded ? m_overloadedStreak + 1 : 0;
+    m_headroomStreak = headroom ? m_headroomStreak + 1 : 0;
+
+    Decision decision = Decision::HOLD;
+    if (m_overloadedStreak >= m_options.stepDownSamples && m_step + 1 < getStepCount()) {
+        ++m_step;
+        decision = Decision::STEP_DOWN;
+        m_encodeBeforeStep = encodeMs;
+        m_measureStep = encodeMs > 0.0f;
+    } else if (m_headroomStreak >= m_options.stepUpSamples) {
+        --m_step;
+        decision = Decision::STEP_UP;
+    }
+    if (decision != Decision::HOLD) {
+        m_overloadedStreak = 0;
+        m_headroomStreak = 0;
+        m_lastChange = now;
+    }
+    return decision;
+}
+
+}} // namespace Recordify::ScreenHandler
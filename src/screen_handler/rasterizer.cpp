@@ -0,0 +1,880 @@
+#include "screen_handler/rasterizer.h"
+#include "screen_handler/layer_compositor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#define RECORDIFY_RASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Recordify {
+namespace ScreenHandler {
+
+namespace {
+
+constexpr float PI = 3.14159265358979323846f;
+
+// Classic 5x8 column-major font for ASCII 0x20-0x7E; bit 0 is the top row,
+// bit 7 the descender row
+const uint8_t GLYPHS[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x08, 0x07, 0x03, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x80, 0x70, 0x30, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x00, 0x60, 0x60, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x00, 0x14, 0x00, 0x00},
+    {0x00, 0x40, 0x34, 0x00, 0x00}, {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x59, 0x09, 0x06}, {0x3E, 0x41, 0x5D, 0x59, 0x4E},
+    {0x7C, 0x12, 0x11, 0x12, 0x7C}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x41, 0x3E}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x41, 0x51, 0x73}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x1C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x26, 0x49, 0x49, 0x49, 0x32}, {0x03, 0x01, 0x7F, 0x01, 0x03}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x59, 0x49, 0x4D, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x41},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x41, 0x7F}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x03, 0x07, 0x08, 0x00}, {0x20, 0x54, 0x54, 0x78, 0x40},
+    {0x7F, 0x28, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x28}, {0x38, 0x44, 0x44, 0x28, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x00, 0x08, 0x7E, 0x09, 0x02}, {0x18, 0xA4, 0xA4, 0x9C, 0x78},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x40, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x78, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0xFC, 0x18, 0x24, 0x24, 0x18},
+    {0x18, 0x24, 0x24, 0x18, 0xFC}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x24},
+    {0x04, 0x04, 0x3F, 0x44, 0x24}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x4C, 0x90, 0x90, 0x90, 0x7C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x77, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02}
+};
+
+constexpr int GLYPH_COLUMNS = 5;
+constexpr int GLYPH_ROWS = 8;
+constexpr int GLYPH_ADVANCE = 6;
+constexpr int GLYPH_BASELINE = 7;
+constexpr float BOLD_WIDEN = 0.6f;  // in glyph cells
+constexpr float ITALIC_SHEAR = 0.2f;
+
+// Exact x * y / 255 for 8-bit operands, as used by both blend paths
+inline uint32_t mul255(uint32_t x, uint32_t y) {
+    uint32_t t = x * y + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+int segmentsForRadius(float radius, float tolerance) {
+    if (radius <= tolerance) {
+        return 8;
+    }
+    float step = 2.0f * std::acos(1.0f - tolerance / radius);
+    int segments = static_cast<int>(std::ceil(2.0f * PI / step));
+    return std::clamp(segments, 8, 1024);
+}
+
+float signedArea(const PointF* points, size_t count) {
+    float area = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const PointF& a = points[i];
+        const PointF& b = points[(i + 1) % count];
+        area += a.x * b.y - b.x * a.y;
+    }
+    return area * 0.5f;
+}
+
+// Stroke pieces are unioned by clamping accumulated coverage, so every
+// polygon the stroker emits must share the same (positive) winding
+void addPositive(RasterPath& path, PointF* points, size_t count) {
+    float area = signedArea(points, count);
+    if (std::fabs(area) < 1e-6f) {
+        return;
+    }
+    if (area < 0.0f) {
+        std::reverse(points, points + count);
+    }
+    path.moveTo(points[0].x, points[0].y);
+    for (size_t i = 1; i < count; ++i) {
+        path.lineTo(points[i].x, points[i].y);
+    }
+    path.close();
+}
+
+PointF normalFor(const PointF& a, const PointF& b, float halfWidth) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float length = std::sqrt(dx * dx + dy * dy);
+    return PointF(-dy / length * halfWidth, dx / length * halfWidth);
+}
+
+int glyphIndex(unsigned char c) {
+    return (c >= 0x20 && c <= 0x7E) ? c - 0x20 : '?' - 0x20;
+}
+
+} // namespace
+
+// PremultipliedColor
+PremultipliedColor PremultipliedColor::fromStraight(uint8_t r, uint8_t g, uint8_t b, uint8_t a,
+                                                    float opacity) {
+    opacity = std::clamp(opacity, 0.0f, 1.0f);
+    uint32_t alpha = static_cast<uint32_t>(a * opacity + 0.5f);
+    PremultipliedColor color;
+    color.r = static_cast<uint8_t>(mul255(r, alpha));
+    color.g = static_cast<uint8_t>(mul255(g, alpha));
+    color.b = static_cast<uint8_t>(mul255(b, alpha));
+    color.a = static_cast<uint8_t>(alpha);
+    return color;
+}
+
+// RasterSurface
+RasterSurface::RasterSurface(int width, int height) {
+    resize(width, height);
+}
+
+RasterSurface::RasterSurface(const RasterSurface& other) {
+    *this = other;
+}
+
+RasterSurface& RasterSurface::operator=(const RasterSurface& other) {
+    // The aligned offset depends on where the vector landed, so copy row by row
+    if (this != &other) {
+        if (other.isEmpty()) {
+            release();
+        } else {
+            resize(other.m_width, other.m_height);
+            for (int y = 0; y < m_height; ++y) {
+                std::memcpy(row(y), other.row(y), static_cast<size_t>(m_width) * 4);
+            }
+        }
+    }
+    return *this;
+}
+
+bool RasterSurface::resize(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        release();
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_stride = (static_cast<size_t>(width) * 4 + 15) & ~static_cast<size_t>(15);
+    m_pixels.assign(m_stride * height + 15, 0);
+    m_offset = (16 - reinterpret_cast<uintptr_t>(m_pixels.data()) % 16) % 16;
+    return true;
+}
+
+void RasterSurface::release() {
+    std::vector<uint8_t>().swap(m_pixels);
+    m_offset = 0;
+    m_stride = 0;
+    m_width = 0;
+    m_height = 0;
+}
+
+void RasterSurface::clear(PremultipliedColor color) {
+    if (isEmpty()) {
+        return;
+    }
+    if (color.a == 0) {
+        for (int y = 0; y < m_height; ++y) {
+            std::memset(row(y), 0, static_cast<size_t>(m_width) * 4);
+        }
+        return;
+    }
+
+    const uint8_t value[4] = {color.r, color.g, color.b, color.a};
+    uint8_t* first = row(0);
+    for (int x = 0; x < m_width; ++x) {
+        std::memcpy(first + x * 4, value, 4);
+    }
+    for (int y = 1; y < m_height; ++y) {
+        std::memcpy(row(y), first, static_cast<size_t>(m_width) * 4);
+    }
+}
+
+PremultipliedColor RasterSurface::pixel(int x, int y) const {
+    PremultipliedColor color;
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) {
+        return color;
+    }
+    const uint8_t* p = row(y) + x * 4;
+    color.r = p[0];
+    color.g = p[1];
+    color.b = p[2];
+    color.a = p[3];
+    return color;
+}
+
+uint64_t RasterSurface::hash() const {
+    uint64_t hash = 14695981039346656037ull;
+    for (int y = 0; y < m_height; ++y) {
+        const uint8_t* p = row(y);
+        for (size_t i = 0; i < static_cast<size_t>(m_width) * 4; ++i) {
+            hash = (hash ^ p[i]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+// RasterPath
+void RasterPath::moveTo(float x, float y) {
+    m_contours.push_back({m_points.size(), m_points.size() + 1, false});
+    m_points.emplace_back(x, y);
+    m_open = true;
+}
+
+void RasterPath::lineTo(float x, float y) {
+    if (!m_open) {
+        moveTo(x, y);
+        return;
+    }
+    m_points.emplace_back(x, y);
+    m_contours.back().end = m_points.size();
+}
+
+void RasterPath::cubicTo(const PointF& control1, const PointF& control2, const PointF& end,
+                         float tolerance) {
+    if (!m_open) {
+        moveTo(control1.x, control1.y);
+    }
+    const PointF start = m_points.back();
+
+    // Uniform subdivision: the chord error is bounded by max|B''| / (8 n^2)
+    float ddx = std::max(std::fabs(start.x - 2 * control1.x + control2.x),
+                         std::fabs(control1.x - 2 * control2.x + end.x));
+    float ddy = std::max(std::fabs(start.y - 2 * control1.y + control2.y),
+                         std::fabs(control1.y - 2 * control2.y + end.y));
+    float dd = std::sqrt(ddx * ddx + ddy * ddy);
+    int segments = std::clamp(static_cast<int>(std::ceil(std::sqrt(0.75f * dd / tolerance))), 1, 256);
+
+    for (int i = 1; i <= segments; ++i) {
+        float t = static_cast<float>(i) / segments;
+        float u = 1.0f - t;
+        float w0 = u * u * u;
+        float w1 = 3 * u * u * t;
+        float w2 = 3 * u * t * t;
+        float w3 = t * t * t;
+        lineTo(w0 * start.x + w1 * control1.x + w2 * control2.x + w3 * end.x,
+               w0 * start.y + w1 * control1.y + w2 * control2.y + w3 * end.y);
+    }
+}
+
+void RasterPath::close() {
+    if (m_open) {
+        m_contours.back().closed = true;
+        m_open = false;
+    }
+}
+
+void RasterPath::clear() {
+    m_points.clear();
+    m_contours.clear();
+    m_open = false;
+}
+
+void RasterPath::addPolygon(const std::vector<PointF>& points, bool closed) {
+    if (points.empty()) {
+        return;
+    }
+    moveTo(points[0].x, points[0].y);
+    for (size_t i = 1; i < points.size(); ++i) {
+        lineTo(points[i].x, points[i].y);
+    }
+    if (closed) {
+        close();
+    } else {
+        m_open = false;
+    }
+}
+
+void RasterPath::addRect(float x, float y, float width, float height) {
+    moveTo(x, y);
+    lineTo(x + width, y);
+    lineTo(x + width, y + height);
+    lineTo(x, y + height);
+    close();
+}
+
+void RasterPath::addRoundedRect(float x, float y, float width, float height, float radius,
+                                float tolerance) {
+    radius = std::min(radius, std::min(std::fabs(width), std::fabs(height)) * 0.5f);
+    if (radius <= 0.0f) {
+        addRect(x, y, width, height);
+        return;
+    }
+
+    int steps = std::max(2, segmentsForRadius(radius, tolerance) / 4);
+    const PointF centers[4] = {
+        {x + width - radius, y + radius},
+        {x + width - radius, y + height - radius},
+        {x + radius, y + height - radius},
+        {x + radius, y + radius}
+    };
+
+    // Same winding as addRect: top-right, bottom-right, bottom-left, top-left
+    moveTo(x + radius, y);
+    for (int corner = 0; corner < 4; ++corner) {
+        float startAngle = -0.5f * PI + corner * 0.5f * PI;
+        for (int i = 0; i <= steps; ++i) {
+            float angle = startAngle + 0.5f * PI * i / steps;
+            lineTo(centers[corner].x + radius * std::cos(angle),
+                   centers[corner].y + radius * std::sin(angle));
+        }
+    }
+    close();
+}
+
+void RasterPath::addEllipse(float cx, float cy, float rx, float ry, float tolerance) {
+    rx = std::fabs(rx);
+    ry = std::fabs(ry);
+    if (rx <= 0.0f || ry <= 0.0f) {
+        return;
+    }
+
+    int segments = segmentsForRadius(std::max(rx, ry), tolerance);
+    moveTo(cx + rx, cy);
+    for (int i = 1; i < segments; ++i) {
+        float angle = 2.0f * PI * i / segments;
+        lineTo(cx + rx * std::cos(angle), cy + ry * std::sin(angle));
+    }
+    close();
+}
+
+void RasterPath::addText(const std::string& text, float x, float y, float size, bool bold,
+                         bool italic, float letterSpacing) {
+    const float scale = size / GLYPH_ROWS;
+    const float widen = bold ? BOLD_WIDEN * scale : 0.0f;
+    const float baseline = y + GLYPH_BASELINE * scale;
+    float penX = x;
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if ((c & 0xC0) == 0x80) {
+            continue; // UTF-8 continuation byte, the lead byte already drew '?'
+        }
+
+        const uint8_t* columns = GLYPHS[glyphIndex(c)];
+        for (int column = 0; column < GLYPH_COLUMNS; ++column) {
+            uint8_t bits = columns[column];
+            // One rectangle per vertical run of lit cells
+            while (bits) {
+                int top = __builtin_ctz(bits);
+                int bottom = top;
+                while (bottom < GLYPH_ROWS && (bits & (1u << bottom))) {
+                    bits = static_cast<uint8_t>(bits & ~(1u << bottom));
+                    ++bottom;
+                }
+
+                float left = penX + column * scale;
+                float right = left + scale + widen;
+                float yTop = y + top * scale;
+                float yBottom = y + bottom * scale;
+                float shearTop = italic ? (baseline - yTop) * ITALIC_SHEAR : 0.0f;
+                float shearBottom = italic ? (baseline - yBottom) * ITALIC_SHEAR : 0.0f;
+
+                moveTo(left + shearTop, yTop);
+                lineTo(right + shearTop, yTop);
+                lineTo(right + shearBottom, yBottom);
+                lineTo(left + shearBottom, yBottom);
+                close();
+            }
+        }
+        penX += GLYPH_ADVANCE * scale + widen + letterSpacing;
+    }
+}
+
+float RasterPath::measureText(const std::string& text, float size, bool bold, float letterSpacing) {
+    const float scale = size / GLYPH_ROWS;
+    const float advance = GLYPH_ADVANCE * scale + (bold ? BOLD_WIDEN * scale : 0.0f) + letterSpacing;
+    size_t glyphs = 0;
+    for (char c : text) {
+        if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+            ++glyphs;
+        }
+    }
+    // The trailing blank column and spacing don't count towards the width
+    return glyphs == 0 ? 0.0f : glyphs * advance - scale - letterSpacing;
+}
+
+RasterPath RasterPath::stroked(const StrokeStyle& style) const {
+    RasterPath result;
+    const float halfWidth = style.width * 0.5f;
+    if (halfWidth <= 0.0f) {
+        return result;
+    }
+
+    RasterPath dashedPath;
+    const RasterPath& source = style.dashPattern.empty()
+        ? *this : (dashedPath = dashed(style.dashPattern, style.dashOffset));
+
+    std::vector<PointF> points;
+    for (const auto& contour : source.m_contours) {
+        // Drop repeated points so every segment has a direction
+        points.clear();
+        for (size_t i = contour.begin; i < contour.end; ++i) {
+            const PointF& p = source.m_points[i];
+            if (points.empty() || std::fabs(p.x - points.back().x) > 1e-4f ||
+                std::fabs(p.y - points.back().y) > 1e-4f) {
+                points.push_back(p);
+            }
+        }
+        bool closed = contour.closed && points.size() > 2;
+        if (closed && std::fabs(points.front().x - points.back().x) <= 1e-4f &&
+            std::fabs(points.front().y - points.back().y) <= 1e-4f) {
+            points.pop_back();
+        }
+        if (points.empty()) {
+            continue;
+        }
+
+        if (points.size() == 1) {
+            const PointF& p = points[0];
+            if (style.cap == LineCap::ROUND) {
+                result.addEllipse(p.x, p.y, halfWidth, halfWidth);
+            } else if (style.cap == LineCap::SQUARE) {
+                result.addRect(p.x - halfWidth, p.y - halfWidth, style.width, style.width);
+            }
+            continue;
+        }
+
+        const size_t count = points.size();
+        const size_t segments = closed ? count : count - 1;
+        for (size_t i = 0; i < segments; ++i) {
+            PointF a = points[i];
+            PointF b = points[(i + 1) % count];
+            PointF n = normalFor(a, b, halfWidth);
+
+            if (!closed && style.cap == LineCap::SQUARE) {
+                // Extend open ends by half the width along the segment
+                PointF along(n.y, -n.x);
+                if (i == 0) { a.x -= along.x; a.y -= along.y; }
+                if (i == segments - 1) { b.x += along.x; b.y += along.y; }
+            }
+
+            PointF quad[4] = {
+                {a.x - n.x, a.y - n.y}, {b.x - n.x, b.y - n.y},
+                {b.x + n.x, b.y + n.y}, {a.x + n.x, a.y + n.y}
+            };
+            addPositive(result, quad, 4);
+        }
+
+        // Joins fill the wedges between consecutive segment quads
+        size_t firstJoin = closed ? 0 : 1;
+        size_t lastJoin = closed ? count : count - 1;
+        for (size_t i = firstJoin; i < lastJoin; ++i) {
+            const PointF& prev = points[(i + count - 1) % count];
+            const PointF& p = points[i];
+            const PointF& next = points[(i + 1) % count];
+            PointF n0 = normalFor(prev, p, halfWidth);
+            PointF n1 = normalFor(p, next, halfWidth);
+
+            float cosTurn = (n0.x * n1.x + n0.y * n1.y) / (halfWidth * halfWidth);
+            if (cosTurn < 0.95f && halfWidth > 1.0f) {
+                result.addEllipse(p.x, p.y, halfWidth, halfWidth);
+            } else {
+                PointF outer[3] = {p, {p.x + n0.x, p.y + n0.y}, {p.x + n1.x, p.y + n1.y}};
+                PointF inner[3] = {p, {p.x - n0.x, p.y - n0.y}, {p.x - n1.x, p.y - n1.y}};
+                addPositive(result, outer, 3);
+                addPositive(result, inner, 3);
+            }
+        }
+
+        if (!closed && style.cap == LineCap::ROUND) {
+            result.addEllipse(points.front().x, points.front().y, halfWidth, halfWidth);
+            result.addEllipse(points.back().x, points.back().y, halfWidth, halfWidth);
+        }
+    }
+    return result;
+}
+
+RasterPath RasterPath::dashed(const std::vector<float>& pattern, float offset) const {
+    float total = 0.0f;
+    for (float length : pattern) {
+        if (length < 0.0f || !std::isfinite(length)) {
+            return *this;
+        }
+        total += length;
+    }
+    if (total <= 0.0f) {
+        return *this;
+    }
+
+    // An odd pattern repeats once more so on/off alternate consistently
+    std::vector<float> dashes(pattern);
+    if (dashes.size() % 2 != 0) {
+        dashes.insert(dashes.end(), pattern.begin(), pattern.end());
+        total *= 2.0f;
+    }
+
+    float phase = std::fmod(offset, total);
+    if (phase < 0.0f) {
+        phase += total;
+    }
+    size_t startIndex = 0;
+    for (size_t guard = 0; phase > 0.0f && phase >= dashes[startIndex] && guard < dashes.size(); ++guard) {
+        phase -= dashes[startIndex];
+        startIndex = (startIndex + 1) % dashes.size();
+    }
+
+    RasterPath result;
+    for (const auto& contour : m_contours) {
+        size_t index = startIndex;
+        float remaining = dashes[index] - phase;
+        bool drawing = false;
+
+        size_t count = contour.end - contour.begin;
+        size_t segments = contour.closed ? count : count - 1;
+        for (size_t i = 0; i < segments; ++i) {
+            const PointF& a = m_points[contour.begin + i];
+            const PointF& b = m_points[contour.begin + (i + 1) % count];
+            float length = std::hypot(b.x - a.x, b.y - a.y);
+            float position = 0.0f;
+
+            while (length - position > 0.0f) {
+                float step = std::min(remaining, length - position);
+                bool on = index % 2 == 0;
+                if (on) {
+                    if (!drawing) {
+                        float t = position / length;
+                        result.moveTo(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t);
+                        drawing = true;
+                    }
+                    float t = (position + step) / length;
+                    result.lineTo(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t);
+                }
+                position += step;
+                remaining -= step;
+
+                // Zero-length dashes come out as single points, which the
+                // stroker caps; that is how dotted lines are made
+                if (remaining <= 1e-5f) {
+                    index = (index + 1) % dashes.size();
+                    remaining = dashes[index];
+                    drawing = false;
+                }
+            }
+        }
+        result.m_open = false;
+    }
+    return result;
+}
+
+void RasterPath::translate(float dx, float dy) {
+    for (auto& point : m_points) {
+        point.x += dx;
+        point.y += dy;
+    }
+}
+
+// Rasterizer
+Rasterizer::Rasterizer(RasterSurface& surface) {
+    setTarget(surface);
+}
+
+Rasterizer::Rasterizer(TiledSurface& surface) {
+    setTarget(surface);
+}
+
+void Rasterizer::setTarget(RasterSurface& surface) {
+    m_surface = &surface;
+    m_tiles = nullptr;
+    m_clip = surface.bounds();
+}
+
+void Rasterizer::setTarget(TiledSurface& surface) {
+    m_surface = nullptr;
+    m_tiles = &surface;
+    m_clip = surface.bounds();
+}
+
+Utils::Rectangle Rasterizer::targetBounds() const {
+    return m_tiles ? m_tiles->bounds() : m_surface->bounds();
+}
+
+void Rasterizer::setClip(const Utils::Rectangle& clip) {
+    m_clip = clip.isEmpty() ? targetBounds() : clip.intersection(targetBounds());
+}
+
+Utils::Rectangle Rasterizer::stroke(const RasterPath& path, const StrokeStyle& style,
+                                    PremultipliedColor color) {
+    return fill(path.stroked(style), color);
+}
+
+Utils::Rectangle Rasterizer::fill(const RasterPath& path, PremultipliedColor color) {
+    const Utils::Rectangle clip = m_clip.intersection(targetBounds());
+    if (clip.isEmpty() || color.isTransparent() || path.isEmpty()) {
+        return Utils::Rectangle();
+    }
+
+    const float width = static_cast<float>(clip.width);
+    const float height = static_cast<float>(clip.height);
+    const auto& points = path.points();
+
+    // Build edges in clip-local space. Segments are split where they cross the
+    // left/right clip edges and the outside pieces are pinned to the border,
+    // which keeps the coverage inside the clip exact.
+    m_edges.clear();
+    auto addEdge = [&](PointF a, PointF b) {
+        a.x = std::clamp(a.x, 0.0f, width);
+        b.x = std::clamp(b.x, 0.0f, width);
+        if (a.y == b.y) {
+            return;
+        }
+        Edge edge;
+        edge.direction = a.y < b.y ? 1.0f : -1.0f;
+        if (a.y > b.y) {
+            std::swap(a, b);
+        }
+        if (b.y <= 0.0f || a.y >= height) {
+            return;
+        }
+        edge.yTop = a.y;
+        edge.yBottom = b.y;
+        edge.xTop = a.x;
+        edge.dxdy = (b.x - a.x) / (b.y - a.y);
+        m_edges.push_back(edge);
+    };
+
+    for (const auto& contour : path.contours()) {
+        size_t count = contour.end - contour.begin;
+        if (count < 2) {
+            continue;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            // Fills always close their contours
+            PointF a = points[contour.begin + i];
+            PointF b = points[contour.begin + (i + 1) % count];
+            a.x -= clip.x; a.y -= clip.y;
+            b.x -= clip.x; b.y -= clip.y;
+
+            float splits[2];
+            int splitCount = 0;
+            for (float border : {0.0f, width}) {
+                if ((a.x < border) != (b.x < border) && a.x != b.x) {
+                    float t = (border - a.x) / (b.x - a.x);
+                    if (t > 0.0f && t < 1.0f) {
+                        splits[splitCount++] = t;
+                    }
+                }
+            }
+            if (splitCount == 2 && splits[0] > splits[1]) {
+                std::swap(splits[0], splits[1]);
+            }
+
+            PointF from = a;
+            for (int s = 0; s < splitCount; ++s) {
+                PointF to(a.x + (b.x - a.x) * splits[s], a.y + (b.y - a.y) * splits[s]);
+                addEdge(from, to);
+                from = to;
+            }
+            addEdge(from, b);
+        }
+    }
+    if (m_edges.empty()) {
+        return Utils::Rectangle();
+    }
+
+    std::sort(m_edges.begin(), m_edges.end(),
+              [](const Edge& l, const Edge& r) { return l.yTop < r.yTop; });
+    float yMax = 0.0f;
+    for (const auto& edge : m_edges) {
+        yMax = std::max(yMax, edge.yBottom);
+    }
+
+    m_accumulation.assign(static_cast<size_t>(clip.width) + 2, 0.0f);
+    m_coverage.resize(static_cast<size_t>(clip.width));
+    m_active.clear();
+
+    int yStart = std::max(0, static_cast<int>(std::floor(m_edges.front().yTop)));
+    int yEnd = std::min(clip.height, static_cast<int>(std::ceil(yMax)));
+    int touchedLeft = clip.width, touchedRight = 0, touchedTop = -1, touchedBottom = -1;
+    size_t nextEdge = 0;
+
+    for (int y = yStart; y < yEnd; ++y) {
+        while (nextEdge < m_edges.size() && m_edges[nextEdge].yTop < y + 1) {
+            m_active.push_back(&m_edges[nextEdge++]);
+        }
+        m_active.erase(std::remove_if(m_active.begin(), m_active.end(),
+                                      [y](const Edge* edge) { return edge->yBottom <= y; }),
+                       m_active.end());
+        if (m_active.empty()) {
+            if (nextEdge < m_edges.size()) {
+                y = std::max(y, static_cast<int>(std::floor(m_edges[nextEdge].yTop)) - 1);
+            }
+            continue;
+        }
+
+        m_touchedBegin = clip.width + 2;
+        m_touchedEnd = 0;
+        for (const Edge* edge : m_active) {
+            accumulateRow(*edge, y);
+        }
+        if (m_touchedEnd <= m_touchedBegin) {
+            continue;
+        }
+
+        // Running sum of signed area gives per-pixel coverage; the span is
+        // trimmed to the pixels that actually ended up covered
+        const int rowEnd = std::min(m_touchedEnd, clip.width);
+        int spanBegin = rowEnd;
+        int spanEnd = m_touchedBegin;
+        float sum = 0.0f;
+        for (int x = m_touchedBegin; x < rowEnd; ++x) {
+            sum += m_accumulation[x];
+            float coverage = std::min(1.0f, std::fabs(sum));
+            uint8_t alpha = m_antiAliasing
+                ? static_cast<uint8_t>(coverage * 255.0f + 0.5f)
+                : (coverage >= 0.5f ? 255 : 0);
+            m_coverage[x] = alpha;
+            if (alpha) {
+                spanBegin = std::min(spanBegin, x);
+                spanEnd = x + 1;
+            }
+        }
+        std::fill(m_accumulation.begin() + m_touchedBegin, m_accumulation.begin() + m_touchedEnd, 0.0f);
+
+        if (spanEnd > spanBegin) {
+            const uint8_t* coverage = m_coverage.data() + spanBegin;
+            if (m_tiles) {
+                m_tiles->blendSpan(clip.x + spanBegin, clip.y + y, coverage, spanEnd - spanBegin, color);
+            } else {
+                uint8_t* row = m_surface->row(clip.y + y) + static_cast<size_t>(clip.x + spanBegin) * 4;
+                blendSpan(row, coverage, spanEnd - spanBegin, color);
+            }
+
+            touchedLeft = std::min(touchedLeft, spanBegin);
+            touchedRight = std::max(touchedRight, spanEnd);
+            if (touchedTop < 0) touchedTop = y;
+            touchedBottom = y + 1;
+        }
+    }
+
+    if (touchedTop < 0) {
+        return Utils::Rectangle();
+    }
+    return Utils::Rectangle(clip.x + touchedLeft, clip.y + touchedTop,
+                            touchedRight - touchedLeft, touchedBottom - touchedTop);
+}
+
+void Rasterizer::accumulateRow(const Edge& edge, int y) {
+    const float width = static_cast<float>(m_coverage.size());
+    float y0 = std::max(static_cast<float>(y), edge.yTop);
+    float y1 = std::min(static_cast<float>(y + 1), edge.yBottom);
+    if (y1 <= y0) {
+        return;
+    }
+
+    float xa = std::clamp(edge.xTop + (y0 - edge.yTop) * edge.dxdy, 0.0f, width);
+    float xb = std::clamp(edge.xTop + (y1 - edge.yTop) * edge.dxdy, 0.0f, width);
+    float d = (y1 - y0) * edge.direction;
+    float x0 = std::min(xa, xb);
+    float x1 = std::max(xa, xb);
+    float* acc = m_accumulation.data();
+
+    // Distribute the signed trapezoid area of this edge piece over the cells
+    // it crosses; everything to the right inherits it through the running sum
+    int x0i = static_cast<int>(x0);
+    int x1i = static_cast<int>(std::ceil(x1));
+    if (x1i <= x0i + 1) {
+        float xmf = 0.5f * (xa + xb) - x0i;
+        acc[x0i] += d - d * xmf;
+        acc[x0i + 1] += d * xmf;
+        m_touchedBegin = std::min(m_touchedBegin, x0i);
+        m_touchedEnd = std::max(m_touchedEnd, x0i + 2);
+        return;
+    }
+
+    float s = 1.0f / (x1 - x0);
+    float x0f = x0 - x0i;
+    float a0 = 0.5f * s * (1.0f - x0f) * (1.0f - x0f);
+    float x1f = x1 - x1i + 1.0f;
+    float am = 0.5f * s * x1f * x1f;
+    acc[x0i] += d * a0;
+    if (x1i == x0i + 2) {
+        acc[x0i + 1] += d * (1.0f - a0 - am);
+    } else {
+        float a1 = s * (1.5f - x0f);
+        acc[x0i + 1] += d * (a1 - a0);
+        for (int x = x0i + 2; x < x1i - 1; ++x) {
+            acc[x] += d * s;
+        }
+        float a2 = a1 + (x1i - x0i - 3) * s;
+        acc[x1i - 1] += d * (1.0f - a2 - am);
+    }
+    acc[x1i] += d * am;
+    m_touchedBegin = std::min(m_touchedBegin, x0i);
+    m_touchedEnd = std::max(m_touchedEnd, x1i + 1);
+}
+
+void Rasterizer::blendSpan(uint8_t* pixels, const uint8_t* coverage, int count,
+                           PremultipliedColor color, bool allowSimd) {
+    int i = 0;
+
+#ifdef RECORDIFY_RASTER_SSE2
+    if (allowSimd) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(128);
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i color16 = _mm_set_epi16(color.a, color.b, color.g, color.r,
+                                              color.a, color.b, color.g, color.r);
+        uint32_t packed;
+        const uint8_t bytes[4] = {color.r, color.g, color.b, color.a};
+        std::memcpy(&packed, bytes, 4);
+        const __m128i solid = _mm_set1_epi32(static_cast<int>(packed));
+
+        auto mul255 = [&](__m128i x, __m128i y) {
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), bias);
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        };
+        auto blendHalf = [&](__m128i dst, __m128i cov) {
+            __m128i src = mul255(color16, cov);
+            __m128i srcAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0xFF), 0xFF);
+            return _mm_add_epi16(src, mul255(dst, _mm_sub_epi16(full, srcAlpha)));
+        };
+
+        for (; i + 4 <= count; i += 4) {
+            uint32_t cov4;
+            std::memcpy(&cov4, coverage + i, 4);
+            if (cov4 == 0) {
+                continue;
+            }
+            __m128i* target = reinterpret_cast<__m128i*>(pixels + i * 4);
+            if (cov4 == 0xFFFFFFFFu && color.a == 255) {
+                _mm_storeu_si128(target, solid);
+                continue;
+            }
+
+            // Replicate each pixel's coverage across its four channels
+            __m128i cov = _mm_cvtsi32_si128(static_cast<int>(cov4));
+            cov = _mm_unpacklo_epi8(cov, cov);
+            cov = _mm_unpacklo_epi16(cov, cov);
+
+            __m128i dst = _mm_loadu_si128(target);
+            __m128i low = blendHalf(_mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi8(cov, zero));
+            __m128i high = blendHalf(_mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi8(cov, zero));
+            _mm_storeu_si128(target, _mm_packus_epi16(low, high));
+        }
+    }
+#else
+    (void)allowSimd;
+#endif
+
+    for (; i < count; ++i) {
+        uint32_t cov = coverage[i];
+        if (cov == 0) {
+            continue;
+        }
+        uint8_t* p = pixels + i * 4;
+        uint32_t srcAlpha = mul255(color.a, cov);
+        uint32_t inverse = 255 - srcAlpha;
+        p[0] = static_cast<uint8_t>(std::min(255u, mul255(color.r, cov) + mul255(p[0], inverse)));
+        p[1] = static_cast<uint8_t>(std::min(255u, mul255(color.g, cov) + mul255(p[1], inverse)));
+        p[2] = static_cast<uint8_t>(std::min(255u, mul255(color.b, cov) + mul255(p[2], inverse)));
+        p[3] = static_cast<uint8_t>(std::min(255u, srcAlpha + mul255(p[3], inverse)));
+    }
+}
+
+}} // namespace Recordify::ScreenHandler
@@ -1,47 +1,518 @@
 #include "screen_handler/screen_handler.h"
+#include <cstdio>
 #include <iostream>
 #include <algorithm>
 #include <thread>
 #include <future>
+#include <atomic>
+#include <mutex>
+#include "utils/diff_kernels.h"
+#include "utils/latency_histogram.h"
+#include "utils/lockfree_queue.h"
+#include "utils/metrics_exporter.h"
 
 namespace Recordify {
 namespace ScreenHandler {
 
 // ScreenHandler implementation
+// Staged frame pipeline: capture -> process -> encode (N workers) -> write.
+// Stages exchange PipelineFrame slots through bounded lock-free queues; every
+// queue can hold all slots, so pushes never fail and backpressure comes from
+// running out of free slots at the capture stage.
 struct ScreenHandler::ThreadingImpl {
-    std::vector<std::thread> workerThreads;
-    std::atomic<bool> shouldStop{false};
-    std::mutex captureMutex;
-    std::condition_variable captureCondition;
-    
-    void startThreads(int threadCount) {
-        shouldStop = false;
-        workerThreads.reserve(threadCount);
+    using FrameQueue = Utils::SpscQueue<PipelineFrame*>;
+    using WriteQueue = Utils::MpscQueue<PipelineFrame*>;
+    
+    enum Stage { NO_STAGE = -1, CAPTURE = 0, PROCESS = 1, ENCODE = 2, WRITE = 3 };
+    
+    ScreenHandler* owner = nullptr;
+    std::vector<std::unique_ptr<PipelineFrame>> slots;
+    std::unique_ptr<FrameQueue> freeFrames;                 // write -> capture
+    std::unique_ptr<FrameQueue> processQueue;               // capture -> process
+    std::vector<std::unique_ptr<FrameQueue>> encodeQueues;  // process -> encoders
+    std::unique_ptr<WriteQueue> writeQueue;                 // encoders -> write
+    
+    std::thread captureThread;
+    std::thread processThread;
+    std::vector<std::thread> encodeThreads;
+    std::thread writeThread;
+    
+    // Stages up to this level drain their queue and exit
+    std::atomic<int> stopLevel{NO_STAGE};
+    std::atomic<bool> paused{false};
+    int encoderCount = 0; // 0 = pick from hardware_concurrency
+    
+    // Pipeline configuration, fixed while running
+    float fps = 30.0f;
+    CaptureMode captureMode = CaptureMode::FULL_FRAME;
+    bool followCursor = false;
+    DropPolicy dropPolicy = DropPolicy::DROP_NEWEST;
+    size_t maxQueuedFrames = 4;
+    
+    std::mutex areaMutex;
+    Utils::Rectangle captureArea;
+    
+    // Guards the queue pointers against depth sampling while they are replaced
+    mutable std::mutex queueMutex;
+    
+    // Stage timings (moving averages in ms) and frame counters
+    std::atomic<float> captureTime{0.0f};
+    std::atomic<float> processTime{0.0f};
+    std::atomic<float> encodeTime{0.0f};
+    std::atomic<float> writeTime{0.0f};
+    std::atomic<int> framesWritten{0};
+    std::atomic<int> framesDropped{0};
+    
+    // Latency distributions per stage and from capture to written, drop
+    // reasons and writer failures; readable from any thread
+    Utils::LatencyHistogram stageLatency[WRITE + 1];
+    // Shared with write completions, which may run after the pipeline stops
+    std::shared_ptr<Utils::LatencyHistogram> endToEndLatency = std::make_shared<Utils::LatencyHistogram>();
+    std::atomic<int> drops[DROP_REASON_COUNT] = {};
+    std::atomic<int> writeErrors{0};
+    
+    Utils::MetricsExporter metricsExporter;
+    
+    // Adaptive quality: evaluated on the write thread, which owns the
+    // controller while running; the others read the current step and fps
+    bool adaptive = false;
+    AdaptiveQualityOptions qualityOptions;
+    QualityController quality;
+    std::atomic<int> qualityStep{0};
+    std::atomic<float> activeFps{30.0f};
+    std::chrono::steady_clock::time_point nextEvaluation;
+    int lastLoadDrops = 0;
+    
+    bool isRunning() const { return captureThread.joinable(); }
+    
+    // Upstream stages have joined once this turns true, so a stage that sees
+    // it before an empty pop has drained its queue
+    bool stageStopped(Stage stage) const {
+        return stage <= stopLevel.load(std::memory_order_acquire);
+    }
+    
+    static float elapsedMs(std::chrono::steady_clock::time_point start,
+                           std::chrono::steady_clock::time_point end) {
+        return std::chrono::duration<float, std::milli>(end - start).count();
+    }
+    
+    static void recordTiming(std::atomic<float>& average, float sampleMs) {
+        float current = average.load(std::memory_order_relaxed);
+        float updated;
+        do {
+            updated = current == 0.0f ? sampleMs : current * 0.9f + sampleMs * 0.1f;
+        } while (!average.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+    }
+    
+    void recordStage(Stage stage, std::atomic<float>& average, std::chrono::steady_clock::time_point start,
+                     std::chrono::steady_clock::time_point end) {
+        stageLatency[stage].record(end - start);
+        recordTiming(average, elapsedMs(start, end));
+    }
+    
+    void countDrop(DropReason reason) {
+        drops[static_cast<int>(reason)].fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    static LatencySummary summarize(const Utils::LatencyHistogram::Snapshot& snapshot) {
+        LatencySummary summary;
+        summary.count = snapshot.count;
+        summary.mean = static_cast<float>(snapshot.mean() / 1e6);
+        summary.p50 = snapshot.percentile(50.0) / 1e6f;
+        summary.p90 = snapshot.percentile(90.0) / 1e6f;
+        summary.p99 = snapshot.percentile(99.0) / 1e6f;
+        summary.p999 = snapshot.percentile(99.9) / 1e6f;
+        summary.max = snapshot.max / 1e6f;
+        return summary;
+    }
+    
+    // Everything here is atomic or snapshotted, so any thread may call it
+    void fillStats(CaptureStats& stats) const {
+        stats.totalFrames = framesWritten.load();
+        stats.droppedFrames = framesDropped.load();
+        stats.captureTime = captureTime.load();
+        stats.processTime = processTime.load();
+        stats.encodeTime = encodeTime.load();
+        stats.writeTime = writeTime.load();
         
-        for (int i = 0; i < threadCount; ++i) {
-            workerThreads.emplace_back([this]() {
-                while (!shouldStop) {
-                    std::unique_lock<std::mutex> lock(captureMutex);
-                    captureCondition.wait_for(lock, std::chrono::milliseconds(16));
-                    
-                    if (!shouldStop) {
-                        // Process capture work here
-                    }
-                }
-            });
+        stats.captureLatency = summarize(stageLatency[CAPTURE].snapshot());
+        stats.processLatency = summarize(stageLatency[PROCESS].snapshot());
+        stats.encodeLatency = summarize(stageLatency[ENCODE].snapshot());
+        stats.writeLatency = summarize(stageLatency[WRITE].snapshot());
+        stats.endToEndLatency = summarize(endToEndLatency->snapshot());
+        
+        for (int reason = 0; reason < DROP_REASON_COUNT; ++reason) {
+            stats.dropsByReason[reason] = drops[reason].load();
+        }
+        stats.writeErrors = writeErrors.load();
+        stats.qualityStep = qualityStep.load();
+        
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!freeFrames) return;
+        stats.freeSlots = static_cast<int>(freeFrames->size());
+        stats.processQueueDepth = static_cast<int>(processQueue->size());
+        stats.encodeQueueDepth = 0;
+        for (const auto& queue : encodeQueues) {
+            stats.encodeQueueDepth += static_cast<int>(queue->size());
+        }
+        stats.writeQueueDepth = static_cast<int>(writeQueue->size());
+    }
+    
+    std::string metricsText() const {
+        static const char* const stageNames[] = {"capture", "process", "encode", "write"};
+        static const char* const dropNames[] = {"no_free_slot", "stale", "encode_failed", "capture_failed"};
+        static const std::vector<double> bounds = {0.0005, 0.001, 0.002, 0.004, 0.008, 0.016, 0.033,
+                                                   0.066, 0.1, 0.25, 0.5, 1.0, 2.5};
+        
+        Utils::LatencyHistogram::Snapshot snapshots[WRITE + 2];
+        for (int stage = CAPTURE; stage <= WRITE; ++stage) {
+            snapshots[stage] = stageLatency[stage].snapshot();
+        }
+        snapshots[WRITE + 1] = endToEndLatency->snapshot();
+        CaptureStats stats;
+        fillStats(stats);
+        
+        Utils::PrometheusText text;
+        text.family("recordify_stage_latency_seconds", "histogram", "Time spent in each pipeline stage per frame");
+        for (int stage = CAPTURE; stage <= WRITE; ++stage) {
+            text.histogram("recordify_stage_latency_seconds", std::string("stage=\"") + stageNames[stage] + "\"",
+                           snapshots[stage], bounds);
         }
+        text.family("recordify_frame_latency_seconds", "histogram",
+                    "Time from capture until the frame was written out, disk I/O included");
+        text.histogram("recordify_frame_latency_seconds", "", snapshots[WRITE + 1], bounds);
+        
+        text.family("recordify_latency_quantile_seconds", "gauge", "Latency percentiles since start or reset");
+        for (int stage = CAPTURE; stage <= WRITE + 1; ++stage) {
+            const char* name = stage <= WRITE ? stageNames[stage] : "end_to_end";
+            const std::string label = std::string("stage=\"") + name + "\"";
+            for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+                char value[16];
+                std::snprintf(value, sizeof(value), "%g", quantile);
+                text.sample("recordify_latency_quantile_seconds", label + ",quantile=\"" + value + "\"",
+                            snapshots[stage].percentile(quantile * 100.0) / 1e9);
+            }
+        }
+        
+        text.family("recordify_frames_written_total", "counter", "Frames handed to the frame writer");
+        text.sample("recordify_frames_written_total", "", stats.totalFrames);
+        text.family("recordify_frames_dropped_total", "counter", "Frames discarded before writing");
+        for (int reason = 0; reason < DROP_REASON_COUNT; ++reason) {
+            text.sample("recordify_frames_dropped_total", std::string("reason=\"") + dropNames[reason] + "\"",
+                        stats.dropsByReason[reason]);
+        }
+        text.family("recordify_write_errors_total", "counter", "Frames the frame writer failed on");
+        text.sample("recordify_write_errors_total", "", stats.writeErrors);
+        
+        text.family("recordify_queue_depth", "gauge", "Frames waiting in front of each stage");
+        text.sample("recordify_queue_depth", "queue=\"process\"", stats.processQueueDepth);
+        text.sample("recordify_queue_depth", "queue=\"encode\"", stats.encodeQueueDepth);
+        text.sample("recordify_queue_depth", "queue=\"write\"", stats.writeQueueDepth);
+        text.family("recordify_free_frame_slots", "gauge", "Frame slots available to the capture stage");
+        text.sample("recordify_free_frame_slots", "", stats.freeSlots);
+        text.family("recordify_quality_step", "gauge", "Adaptive quality step, 0 = full quality");
+        text.sample("recordify_quality_step", "", stats.qualityStep);
+        return text.str();
+    }
+    
+    static void idleWait(int& idleRounds) {
+        if (++idleRounds < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(250));
+        }
+    }
+    
+    void setCaptureArea(const Utils::Rectangle& area) {
+        std::lock_guard<std::mutex> lock(areaMutex);
+        captureArea = area;
+    }
+    
+    Utils::Rectangle getCaptureArea() {
+        std::lock_guard<std::mutex> lock(areaMutex);
+        return captureArea;
+    }
+    
+    void resetStats() {
+        captureTime = 0.0f;
+        processTime = 0.0f;
+        encodeTime = 0.0f;
+        writeTime = 0.0f;
+        framesWritten = 0;
+        framesDropped = 0;
+        for (auto& histogram : stageLatency) {
+            histogram.reset();
+        }
+        endToEndLatency->reset();
+        for (auto& count : drops) {
+            count = 0;
+        }
+        writeErrors = 0;
+    }
+    
+    void startThreads(ScreenHandler* handler, const RecordingConfig& config) {
+        owner = handler;
+        fps = config.fps;
+        captureMode = config.captureMode;
+        followCursor = config.mode == RecordingMode::FOLLOW_CURSOR;
+        dropPolicy = config.dropPolicy;
+        maxQueuedFrames = static_cast<size_t>(std::max(1, config.maxQueuedFrames));
+        setCaptureArea(config.captureArea);
+        
+        adaptive = config.adaptiveQuality;
+        quality.setOptions(qualityOptions);
+        quality.setEncoderKnobs(handler->m_encoderKnobs);
+        quality.reset(fps);
+        qualityStep = 0;
+        activeFps = fps;
+        nextEvaluation = std::chrono::steady_clock::now() + qualityOptions.interval;
+        lastLoadDrops = 0;
+        
+        int workers = encoderCount > 0 ? encoderCount
+                                       : std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 2);
+        size_t slotCount = static_cast<size_t>(std::max(2, config.bufferSize));
+        
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            slots.clear();
+            freeFrames = std::make_unique<FrameQueue>(slotCount);
+            processQueue = std::make_unique<FrameQueue>(slotCount);
+            writeQueue = std::make_unique<WriteQueue>(slotCount);
+            encodeQueues.clear();
+            for (int i = 0; i < workers; ++i) {
+                encodeQueues.push_back(std::make_unique<FrameQueue>(slotCount));
+            }
+            for (size_t i = 0; i < slotCount; ++i) {
+                slots.push_back(std::make_unique<PipelineFrame>());
+                freeFrames->tryPush(slots.back().get());
+            }
+        }
+        
+        stopLevel = NO_STAGE;
+        paused = false;
+        
+        writeThread = std::thread([this, slotCount]() { writeLoop(slotCount); });
+        for (int i = 0; i < workers; ++i) {
+            encodeThreads.emplace_back([this, i]() { encodeLoop(*encodeQueues[i]); });
+        }
+        processThread = std::thread([this]() { processLoop(); });
+        captureThread = std::thread([this]() { captureLoop(); });
     }
     
     void stopThreads() {
-        shouldStop = true;
-        captureCondition.notify_all();
+        if (!isRunning()) return;
+        
+        // Stop from the front so every captured frame drains through the pipeline
+        stopLevel = CAPTURE;
+        captureThread.join();
+        stopLevel = PROCESS;
+        processThread.join();
+        stopLevel = ENCODE;
+        for (auto& thread : encodeThreads) {
+            thread.join();
+        }
+        encodeThreads.clear();
+        stopLevel = WRITE;
+        writeThread.join();
+    }
+    
+    static std::chrono::steady_clock::duration frameInterval(float framesPerSecond) {
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<float>(1.0f / framesPerSecond));
+    }
+    
+    void captureLoop() {
+        float intervalFps = activeFps.load(std::memory_order_relaxed);
+        auto interval = frameInterval(intervalFps);
+        auto nextFrame = std::chrono::steady_clock::now();
+        uint64_t sequence = 0;
+        PipelineFrame* spare = nullptr; // slot of a failed grab, reused next tick
+        // Incremental frames resend the tiles under the overlay, and those it
+        // covered last frame so erased annotations get cleaned up
+        ScreenWriter* overlay = owner->m_config.enableAnnotations ? owner->m_writer.get() : nullptr;
+        std::vector<Utils::Rectangle> overlayTiles;
+        std::vector<Utils::Rectangle> resendTiles;
         
-        for (auto& thread : workerThreads) {
-            if (thread.joinable()) {
-                thread.join();
+        while (!stageStopped(CAPTURE)) {
+            // The quality controller may have changed the frame rate
+            const float currentFps = activeFps.load(std::memory_order_relaxed);
+            if (currentFps != intervalFps) {
+                nextFrame += frameInterval(currentFps) - interval;
+                intervalFps = currentFps;
+                interval = frameInterval(currentFps);
+            }
+            
+            std::this_thread::sleep_until(nextFrame);
+            nextFrame += interval;
+            auto now = std::chrono::steady_clock::now();
+            if (now - nextFrame > interval) {
+                nextFrame = now; // fell behind, don't try to catch up with a burst
+            }
+            
+            if (paused.load(std::memory_order_relaxed)) continue;
+            
+            PipelineFrame* frame = spare;
+            spare = nullptr;
+            if (!frame && !freeFrames->tryPop(frame)) {
+                if (dropPolicy != DropPolicy::BLOCK) {
+                    framesDropped.fetch_add(1, std::memory_order_relaxed);
+                    countDrop(DropReason::NO_FREE_SLOT);
+                    continue;
+                }
+                int idleRounds = 0;
+                while (!freeFrames->tryPop(frame)) {
+                    if (stageStopped(CAPTURE)) return;
+                    idleWait(idleRounds);
+                }
+            }
+            
+            auto start = std::chrono::steady_clock::now();
+            frame->incremental = captureMode == CaptureMode::DIRTY_TILES;
+            bool captured;
+            if (frame->incremental) {
+                frame->capture.pixelData.reset(); // the reader keeps the full frame
+                if (overlay) {
+                    resendTiles.swap(overlayTiles);
+                    overlayTiles = overlay->getAnnotatedTiles();
+                    resendTiles.insert(resendTiles.end(), overlayTiles.begin(), overlayTiles.end());
+                }
+                captured = owner->m_reader->captureChanges(frame->changes, getCaptureArea(), resendTiles);
+            } else if (followCursor) {
+                // Window around the cursor, kept on the display; only that region is
+                // grabbed, packed into the frame's own buffer
+                Utils::Rectangle area = getCaptureArea();
+                Utils::Point cursor = owner->m_reader->getMousePosition();
+                area.x = cursor.x - area.width / 2;
+                area.y = cursor.y - area.height / 2;
+                captured = owner->m_reader->captureRegion(frame->capture, area);
+            } else {
+                captured = owner->m_reader->captureScreen(frame->capture, getCaptureArea());
+            }
+            frame->capturedAt = std::chrono::steady_clock::now();
+            recordStage(CAPTURE, captureTime, start, frame->capturedAt);
+            
+            // Only the writer pushes free slots, so keep this one instead of
+            // sending a frame with stale pixels down the pipeline
+            if (!captured) {
+                spare = frame;
+                framesDropped.fetch_add(1, std::memory_order_relaxed);
+                countDrop(DropReason::CAPTURE_FAILED);
+                continue;
+            }
+            
+            frame->sequence = sequence++;
+            frame->quality = quality.getLevel(qualityStep.load(std::memory_order_relaxed));
+            frame->dropped = false;
+            frame->encodedData.clear();
+            processQueue->tryPush(frame);
+        }
+    }
+    
+    void processLoop() {
+        size_t nextEncoder = 0;
+        int idleRounds = 0;
+        PipelineFrame* frame = nullptr;
+        
+        for (;;) {
+            const bool stopping = stageStopped(PROCESS);
+            if (!processQueue->tryPop(frame)) {
+                if (stopping) return;
+                idleWait(idleRounds);
+                continue;
+            }
+            idleRounds = 0;
+            
+            auto start = std::chrono::steady_clock::now();
+            owner->processFrame(*frame);
+            frame->processedAt = std::chrono::steady_clock::now();
+            recordStage(PROCESS, processTime, start, frame->processedAt);
+            
+            encodeQueues[nextEncoder]->tryPush(frame);
+            nextEncoder = (nextEncoder + 1) % encodeQueues.size();
+        }
+    }
+    
+    void encodeLoop(FrameQueue& queue) {
+        int idleRounds = 0;
+        PipelineFrame* frame = nullptr;
+        
+        for (;;) {
+            const bool stopping = stageStopped(ENCODE);
+            if (!queue.tryPop(frame)) {
+                if (stopping) return;
+                idleWait(idleRounds);
+                continue;
+            }
+            idleRounds = 0;
+            
+            // Skip stale frames so the encoder catches up with the newest ones
+            if (dropPolicy == DropPolicy::DROP_OLDEST && queue.size() >= maxQueuedFrames) {
+                frame->dropped = true;
+                countDrop(DropReason::STALE);
+            } else {
+                auto start = std::chrono::steady_clock::now();
+                owner->encodeFrame(*frame);
+                frame->encodedAt = std::chrono::steady_clock::now();
+                recordStage(ENCODE, encodeTime, start, frame->encodedAt);
+                if (frame->dropped) {
+                    countDrop(DropReason::ENCODE_FAILED);
+                }
+            }
+            
+            writeQueue->tryPush(frame);
+        }
+    }
+    
+    void writeLoop(size_t slotCount) {
+        // Encoders finish out of order; restore capture order before writing
+        std::vector<PipelineFrame*> pending(slotCount, nullptr);
+        uint64_t nextSequence = 0;
+        int idleRounds = 0;
+        PipelineFrame* frame = nullptr;
+        
+        for (;;) {
+            const bool stopping = stageStopped(WRITE);
+            if (!writeQueue->tryPop(frame)) {
+                if (stopping) return;
+                idleWait(idleRounds);
+                continue;
+            }
+            idleRounds = 0;
+            pending[frame->sequence % slotCount] = frame;
+            
+            PipelineFrame* ready = nullptr;
+            while ((ready = pending[nextSequence % slotCount]) != nullptr &&
+                   ready->sequence == nextSequence) {
+                pending[nextSequence % slotCount] = nullptr;
+                nextSequence++;
+                
+                if (ready->dropped) {
+                    framesDropped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    auto start = std::chrono::steady_clock::now();
+                    const bool accepted = owner->writeFrame(*ready);
+                    auto written = std::chrono::steady_clock::now();
+                    recordStage(WRITE, writeTime, start, written);
+                    if (accepted && owner->m_writeCompletion) {
+                        // The frame is done once its bytes are in the file
+                        auto latency = endToEndLatency;
+                        const auto capturedAt = ready->capturedAt;
+                        owner->m_writeCompletion([latency, capturedAt]() {
+                            latency->record(std::chrono::steady_clock::now() - capturedAt);
+                        });
+                    } else {
+                        endToEndLatency->record(written - ready->capturedAt);
+                    }
+                    framesWritten.fetch_add(1, std::memory_order_relaxed);
+                }
+                
+                freeFrames->tryPush(ready);
+            }
+            
+            if (adaptive && std::chrono::steady_clock::now() >= nextEvaluation) {
+                owner->optimizePerformance();
             }
         }
-        workerThreads.clear();
     }
 };
 
@@ -69,6 +540,7 @@ ScreenHandler::ScreenHandler()
 }
 
 ScreenHandler::~ScreenHandler() {
+    stopMetricsExport();
     shutdown();
     std::cout << "[ScreenHandler] Destroyed" << std::endl;
 }
@@ -178,9 +650,14 @@ bool ScreenHandler::startCapture(const RecordingConfig& config) {
         }
     }
     
-    // Start threading system
-    int threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 2);
-    m_threading->startThreads(threadCount);
+    // Size the frame pool so steady-state capture reuses the same slabs; an
+    // empty area grabs the whole primary display
+    size_t frameBytes = m_reader->getFrameBytes(m_config.captureArea);
+    int frameCount = std::max(1, m_config.bufferSize) + ScreenReader::MAX_RECENT_CAPTURES;
+    if (frameBytes > 0 && !m_reader->configureFramePool(frameCount, frameBytes)) {
+        setError(ErrorCode::INSUFFICIENT_RESOURCES, "Failed to allocate frame pool");
+        return false;
+    }
     
     m_isCapturing = true;
     m_isPaused = false;
@@ -191,6 +668,10 @@ bool ScreenHandler::startCapture(const RecordingConfig& config) {
     m_stats = CaptureStats{};
     m_stats.startTime = m_captureStartTime;
     m_stats.targetFPS = m_config.fps;
+    m_threading->resetStats();
+    
+    // Start the capture pipeline
+    m_threading->startThreads(this, m_config);
     
     notifyEvent(ScreenEvent::CAPTURE_STARTED, "Capture started successfully");
     std::cout << "[ScreenHandler] Capture started successfully" << std::endl;
@@ -233,6 +714,7 @@ bool ScreenHandler::pauseCapture() {
     std::cout << "[ScreenHandler] Pausing capture..." << std::endl;
     
     m_isPaused = true;
+    m_threading->paused = true;
     notifyEvent(ScreenEvent::CAPTURE_PAUSED, "Capture paused");
     return true;
 }
@@ -246,6 +728,7 @@ bool ScreenHandler::resumeCapture() {
     std::cout << "[ScreenHandler] Resuming capture..." << std::endl;
     
     m_isPaused = false;
+    m_threading->paused = false;
     notifyEvent(ScreenEvent::CAPTURE_RESUMED, "Capture resumed");
     return true;
 }
@@ -438,7 +921,7 @@ bool ScreenHandler::enableKeyboardOverlay() {
         if (m_writer->isRealTimeDrawing() && !state.lastTypedText.empty()) {
             // Show typed text as overlay
             auto mousePos = m_reader->getMousePosition();
-            ScreenWriter::TextProperties textProps;
+            TextProperties textProps;
             textProps.color = Color::WHITE;
             textProps.font.size = 16.0f;
             
@@ -484,6 +967,95 @@ std::vector<Utils::Rectangle> ScreenHandler::findTextRegions() {
     return regions;
 }
 
+// Screen comparison and analysis
+bool ScreenHandler::compareScreens(const ScreenCapture& capture1, const ScreenCapture& capture2,
+                                   float& similarity, std::vector<Utils::Rectangle>& differences) {
+    differences.clear();
+    
+    bool sameGeometry = capture1.width == capture2.width && capture1.height == capture2.height &&
+                        capture1.bitsPerPixel == capture2.bitsPerPixel &&
+                        capture1.hasPixels() == capture2.hasPixels();
+    if (!sameGeometry) {
+        similarity = 0.0f;
+        differences.push_back(capture1.area);
+        return true;
+    }
+    if (!capture1.hasPixels()) {
+        similarity = 1.0f;
+        return true;
+    }
+    
+    // Either side may be a crop, so each keeps its own row stride
+    int bytesPerPixel = capture1.bytesPerPixel();
+    Utils::DiffKernels::FrameDiff diff;
+    Utils::DiffKernels::diffFrames(capture1.pixels(), capture1.bytesPerRow(),
+                                   capture2.pixels(), capture2.bytesPerRow(),
+                                   capture1.width, capture1.height, bytesPerPixel,
+                                   ScreenCapture::TILE_SIZE, 10, diff);
+    
+    similarity = 1.0f - diff.total.changeRatio(static_cast<size_t>(capture1.width) * capture1.height,
+                                                bytesPerPixel);
+    
+    // Report changed tiles in screen coordinates, merging horizontal runs
+    for (int row = 0; row < diff.tileRows; ++row) {
+        bool extending = false;
+        for (int column = 0; column < diff.tileColumns; ++column) {
+            if (diff.tile(column, row).changedBytes == 0) {
+                extending = false;
+                continue;
+            }
+            
+            Utils::Rectangle tile = capture1.tileRect(row * diff.tileColumns + column)
+                                        .translated(capture1.area.topLeft());
+            if (extending) {
+                differences.back().width += tile.width;
+            } else {
+                differences.push_back(tile);
+                extending = true;
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool ScreenHandler::waitForScreenChange(const Utils::Rectangle& area, float timeout) {
+    if (!m_reader) return false;
+    
+    Utils::Rectangle watchArea = area.isEmpty() ? getCurrentCaptureArea() : area;
+    ScreenCapture reference;
+    ScreenCapture current;
+    if (!m_reader->captureScreen(reference, watchArea)) {
+        return false;
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<float>(timeout);
+    auto pollInterval = std::chrono::duration<float>(1.0f / std::max(1.0f, m_config.fps));
+    
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(pollInterval);
+        if (!m_reader->captureScreen(current, watchArea)) {
+            return false;
+        }
+        
+        if (current.width != reference.width || current.height != reference.height ||
+            current.bitsPerPixel != reference.bitsPerPixel || !current.hasPixels() || !reference.hasPixels()) {
+            return true;
+        }
+        auto diff = Utils::DiffKernels::diffRows(current.pixels(), current.bytesPerRow(),
+                                                 reference.pixels(), reference.bytesPerRow(),
+                                                 static_cast<size_t>(current.width) * current.bytesPerPixel(),
+                                                 current.height, 10);
+        if (diff.changedBytes > 0) {
+            std::cout << "[ScreenHandler] Screen changed (max delta " << static_cast<int>(diff.maxDelta)
+                      << ")" << std::endl;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
 // Recording and playback
 bool ScreenHandler::startActionRecording() {
     if (m_recordingActions) return true;
@@ -512,11 +1084,32 @@ std::vector<ScreenHandler::RecordedAction> ScreenHandler::getRecordedActions() c
 
 // Statistics
 CaptureStats ScreenHandler::getCaptureStats() const {
-    return m_stats;
+    CaptureStats stats = m_stats;
+    
+    m_threading->fillStats(stats);
+    stats.lastUpdate = std::chrono::steady_clock::now();
+    
+    float elapsed = std::chrono::duration<float>(stats.lastUpdate - stats.startTime).count();
+    if (m_isCapturing && elapsed > 0.0f) {
+        stats.actualFPS = stats.totalFrames / elapsed;
+    }
+    
+    if (m_reader) {
+        auto poolStats = m_reader->getFramePoolStats();
+        stats.poolHits = poolStats.hits;
+        stats.poolMisses = poolStats.misses;
+        if (poolStats.slabCount > 0) {
+            stats.bufferUsage = poolStats.slabsInUse * 100 / poolStats.slabCount;
+            stats.memoryUsage = static_cast<int>(poolStats.slabBytes * poolStats.slabCount / (1024 * 1024));
+        }
+    }
+    
+    return stats;
 }
 
 void ScreenHandler::resetCaptureStats() {
     m_stats = CaptureStats{};
+    m_threading->resetStats();
     if (m_isCapturing) {
         m_stats.startTime = std::chrono::steady_clock::now();
         m_stats.targetFPS = m_config.fps;
@@ -524,6 +1117,93 @@ void ScreenHandler::resetCaptureStats() {
     std::cout << "[ScreenHandler] Reset capture statistics" << std::endl;
 }
 
+std::string ScreenHandler::getMetricsText() const {
+    return m_threading->metricsText();
+}
+
+bool ScreenHandler::exportMetricsToFile(const std::string& path, int intervalMs) {
+    return m_threading->metricsExporter.startFile(path, std::chrono::milliseconds(std::max(10, intervalMs)),
+                                                  [this]() { return getMetricsText(); });
+}
+
+bool ScreenHandler::serveMetrics(const std::string& socketPath) {
+    return m_threading->metricsExporter.startSocket(socketPath, [this]() { return getMetricsText(); });
+}
+
+void ScreenHandler::stopMetricsExport() {
+    m_threading->metricsExporter.stop();
+}
+
+// Performance optimization
+void ScreenHandler::setBufferSize(int frames) {
+    if (frames < 2) {
+        logError("Buffer size must be at least 2 frames");
+        return;
+    }
+    
+    m_config.bufferSize = frames;
+    std::cout << "[ScreenHandler] Set buffer size to " << frames << " frames" << std::endl;
+}
+
+void ScreenHandler::setThreadCount(int count) {
+    // Takes effect on the next startCapture
+    m_threading->encoderCount = std::max(0, count);
+    std::cout << "[ScreenHandler] Set encoder thread count to " << count << std::endl;
+}
+
+void ScreenHandler::setAdaptiveQualityOptions(const AdaptiveQualityOptions& options) {
+    m_threading->qualityOptions = options;
+}
+
+QualityLevel ScreenHandler::getQualityLevel() const {
+    return m_threading->quality.getLevel(m_threading->qualityStep.load());
+}
+
+// Runs on the write thread every AdaptiveQualityOptions::interval while
+// RecordingConfig::adaptiveQuality is on
+void ScreenHandler::optimizePerformance() {
+    ThreadingImpl& pipeline = *m_threading;
+    auto now = std::chrono::steady_clock::now();
+    pipeline.nextEvaluation = now + pipeline.quality.getOptions().interval;
+    
+    PipelineLoad load;
+    load.captureMs = pipeline.captureTime.load();
+    load.encodeMs = pipeline.encodeTime.load();
+    load.encoders = static_cast<int>(pipeline.encodeQueues.size());
+    load.backlog = static_cast<int>(pipeline.processQueue->size());
+    for (const auto& queue : pipeline.encodeQueues) {
+        load.backlog += static_cast<int>(queue->size());
+    }
+    load.backlogLimit = static_cast<int>(pipeline.slots.size() / 2);
+    
+    // Failed captures and encodes say nothing about load; a stats reset restarts the count
+    const int drops = pipeline.drops[static_cast<int>(DropReason::NO_FREE_SLOT)].load() +
+                      pipeline.drops[static_cast<int>(DropReason::STALE)].load();
+    load.newDrops = std::max(0, drops - pipeline.lastLoadDrops);
+    pipeline.lastLoadDrops = drops;
+    
+    const float budget = pipeline.quality.getFrameBudget(pipeline.quality.getLevel().step);
+    QualityController::Decision decision = pipeline.quality.evaluate(load, now);
+    if (decision == QualityController::Decision::HOLD) return;
+    
+    const QualityLevel& level = pipeline.quality.getLevel();
+    pipeline.qualityStep.store(level.step);
+    pipeline.activeFps.store(pipeline.fps * level.fpsScale);
+    
+    char measured[96];
+    std::snprintf(measured, sizeof(measured), "capture + encode at %.0f%% of the %.1f ms frame budget",
+                  pipeline.quality.getLoad() * 100.0f, budget);
+    std::string details = std::string(decision == QualityController::Decision::STEP_DOWN ? "Lowered" : "Raised") +
+                          " quality to step " + std::to_string(level.step) + " of " +
+                          std::to_string(pipeline.quality.getStepCount() - 1) + " (" +
+                          level.describe(pipeline.fps) + "): " + measured;
+    if (load.newDrops > 0) {
+        details += ", " + std::to_string(load.newDrops) + " frames dropped";
+    }
+    std::cout << "[ScreenHandler] " << details << std::endl;
+    notifyEvent(ScreenEvent::QUALITY_CHANGED, details);
+}
+
 // Error handling
 void ScreenHandler::clearError() {
     m_lastError = ErrorCode::SUCCESS;
@@ -628,6 +1308,10 @@ void ScreenHandler::updateCaptureArea() {
             break;
     }
     
+    if (m_threading->isRunning()) {
+        m_threading->setCaptureArea(m_config.captureArea);
+    }
+    
     std::cout << "[ScreenHandler] Updated capture area: [" 
               << m_config.captureArea.x << "," << m_config.captureArea.y << "," 
               << m_config.captureArea.width << "," << m_config.captureArea.height << "]" << std::endl;
@@ -636,15 +1320,8 @@ void ScreenHandler::updateCaptureArea() {
 void ScreenHandler::handleReaderEvents() {
     if (!m_isCapturing || m_isPaused) return;
     
-    // Process frame if needed
-    auto now = std::chrono::steady_clock::now();
-    auto frameInterval = std::chrono::duration<float>(1.0f / m_config.fps);
-    auto timeSinceLastFrame = now - m_stats.lastUpdate;
-    
-    if (timeSinceLastFrame >= frameInterval) {
-        processFrame();
-        m_stats.lastUpdate = now;
-    }
+    // Frames are paced by the capture stage; keep overlays in step with input
+    synchronizeComponents();
 }
 
 void ScreenHandler::handleWriterEvents() {
@@ -654,20 +1331,46 @@ void ScreenHandler::handleWriterEvents() {
     }
 }
 
-void ScreenHandler::processFrame() {
-    if (!m_isCapturing || m_isPaused) return;
+// Pipeline stages (run on ThreadingImpl threads)
+void ScreenHandler::processFrame(PipelineFrame& frame) {
+    if (m_config.includeCursor) {
+        frame.cursorPosition = m_reader->getMousePosition();
+    }
     
-    m_currentFrame++;
-    m_stats.totalFrames++;
+    // Burn annotations into the frame. Incremental frames carry their own copy
+    // of each tile, including those under the overlay; a full-frame buffer
+    // still shared with the reader must stay pristine.
+    ScreenCapture& capture = frame.capture;
+    if (m_config.enableAnnotations && m_writer) {
+        if (frame.incremental) {
+            m_writer->compositeLayers(frame.changes);
+        } else if (capture.pixelData.unique() && capture.hasPixels()) {
+            m_writer->compositeLayers(capture.pixels(), capture.width, capture.height, capture.bytesPerRow(),
+                                      capture.bytesPerPixel());
+        }
+    }
     
-    // Calculate actual FPS
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - m_stats.startTime);
-    if (elapsed.count() > 0) {
-        m_stats.actualFPS = static_cast<float>(m_stats.totalFrames) / elapsed.count();
+    if (m_frameProcessor) {
+        m_frameProcessor(frame);
+    }
+}
+
+void ScreenHandler::encodeFrame(PipelineFrame& frame) {
+    if (m_frameEncoder && !m_frameEncoder(frame)) {
+        frame.dropped = true;
+    }
+}
+
+bool ScreenHandler::writeFrame(PipelineFrame& frame) {
+    const bool accepted = !m_frameWriter || m_frameWriter(frame);
+    if (!accepted) {
+        m_threading->writeErrors.fetch_add(1, std::memory_order_relaxed);
+        logError("Frame writer failed on frame " + std::to_string(frame.sequence));
     }
     
-    notifyEvent(ScreenEvent::FRAME_CAPTURED, "Frame " + std::to_string(m_currentFrame));
+    const int frameNumber = m_currentFrame.fetch_add(1, std::memory_order_relaxed) + 1;
+    notifyEvent(ScreenEvent::FRAME_CAPTURED, "Frame " + std::to_string(frameNumber));
+    return accepted;
 }
 
 void ScreenHandler::setError(ErrorCode code, const std::string& message) {
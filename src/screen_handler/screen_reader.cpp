@@ -1,9 +1,15 @@
 #include "screen_handler/screen_reader.h"
-#include <iostream>
+#include "utils/diff_kernels.h"
+#include "utils/lockfree_queue.h"
+#include "utils/logger.h"
+#include "utils/ring_buffer.h"
+#include "utils/spatial_index.h"
+#include <atomic>
 #include <algorithm>
-#include <random>
 #include <thread>
 #include <cmath>
+#include <cstring>
+#include <mutex>
 
 namespace Recordify {
 namespace ScreenHandler {
@@ -48,33 +54,103 @@ float KeyState::getPressedDuration() const {
     return duration.count() / 1000.0f; // Convert to seconds
 }
 
+// KeyBitset helper methods
+int KeyBitset::count() const {
+    return __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]) +
+           __builtin_popcountll(words[2]) + __builtin_popcountll(words[3]);
+}
+
+KeyBitset KeyBitset::operator&(const KeyBitset& other) const {
+    KeyBitset result;
+    for (int i = 0; i < 4; ++i) result.words[i] = words[i] & other.words[i];
+    return result;
+}
+
+KeyBitset KeyBitset::operator|(const KeyBitset& other) const {
+    KeyBitset result;
+    for (int i = 0; i < 4; ++i) result.words[i] = words[i] | other.words[i];
+    return result;
+}
+
+KeyBitset KeyBitset::operator^(const KeyBitset& other) const {
+    KeyBitset result;
+    for (int i = 0; i < 4; ++i) result.words[i] = words[i] ^ other.words[i];
+    return result;
+}
+
+bool KeyBitset::operator==(const KeyBitset& other) const {
+    return words[0] == other.words[0] && words[1] == other.words[1] &&
+           words[2] == other.words[2] && words[3] == other.words[3];
+}
+
+// KeyTable implementation
+KeyTable::KeyTable() {
+    for (int keyCode = 0; keyCode < KEY_COUNT; ++keyCode) {
+        m_keys[keyCode].keyCode = keyCode;
+    }
+}
+
+void KeyTable::press(int keyCode, std::chrono::steady_clock::time_point when) {
+    if (!isValid(keyCode) || m_keys[keyCode].pressed) return;
+    m_keys[keyCode].pressed = true;
+    m_keys[keyCode].pressTime = when;
+    m_pressed.set(keyCode);
+}
+
+void KeyTable::release(int keyCode, std::chrono::steady_clock::time_point when) {
+    if (!isValid(keyCode) || !m_keys[keyCode].pressed) return;
+    m_keys[keyCode].pressed = false;
+    m_keys[keyCode].releaseTime = when;
+    m_pressed.set(keyCode, false);
+}
+
+void KeyTable::advance() {
+    // Only keys that changed this tick need their previous state updated
+    changed().forEach([this](int keyCode) {
+        m_keys[keyCode].wasPressed = m_keys[keyCode].pressed;
+    });
+    m_previous = m_pressed;
+}
+
+namespace {
+
+// Generic modifier codes also match their left/right variants
+KeyBitset modifierMask(int modifier) {
+    KeyBitset mask;
+    if (KeyTable::isValid(modifier)) mask.set(modifier);
+    switch (modifier) {
+        case 0x10: mask.set(0xA0); mask.set(0xA1); break; // VK_SHIFT
+        case 0x11: mask.set(0xA2); mask.set(0xA3); break; // VK_CONTROL
+        case 0x12: mask.set(0xA4); mask.set(0xA5); break; // VK_MENU
+        case 0x5B: mask.set(0x5C); break;                 // VK_LWIN/VK_RWIN
+        default: break;
+    }
+    return mask;
+}
+
+} // namespace
+
 // KeyboardState helper methods
 bool KeyboardState::isKeyPressed(int keyCode) const {
-    auto it = keys.find(keyCode);
-    return it != keys.end() && it->second.pressed;
+    return KeyTable::isValid(keyCode) && keys.pressed().test(keyCode);
 }
 
 bool KeyboardState::isKeyJustPressed(int keyCode) const {
-    auto it = keys.find(keyCode);
-    return it != keys.end() && it->second.isJustPressed();
+    return KeyTable::isValid(keyCode) && keys[keyCode].isJustPressed();
 }
 
 bool KeyboardState::isKeyJustReleased(int keyCode) const {
-    auto it = keys.find(keyCode);
-    return it != keys.end() && it->second.isJustReleased();
+    return KeyTable::isValid(keyCode) && keys[keyCode].isJustReleased();
 }
 
 bool KeyboardState::isModifierPressed(int modifier) const {
-    return std::find(modifierKeys.begin(), modifierKeys.end(), modifier) != modifierKeys.end();
+    return (keys.pressed() & modifierMask(modifier)).any();
 }
 
 std::vector<int> KeyboardState::getPressedKeys() const {
     std::vector<int> pressedKeys;
-    for (const auto& pair : keys) {
-        if (pair.second.pressed) {
-            pressedKeys.push_back(pair.first);
-        }
-    }
+    pressedKeys.reserve(keys.pressed().count());
+    keys.pressed().forEach([&pressedKeys](int keyCode) { pressedKeys.push_back(keyCode); });
     return pressedKeys;
 }
 
@@ -87,62 +163,285 @@ bool WindowInfo::intersects(const WindowInfo& other) const {
     return bounds.intersects(other.bounds);
 }
 
+// FrameView methods
+FrameView FrameView::subView(const Utils::Rectangle& rect) const {
+    FrameView view = *this;
+    Utils::Rectangle clipped = rect.intersection(Utils::Rectangle(0, 0, width, height));
+    view.width = clipped.width;
+    view.height = clipped.height;
+    view.area = Utils::Rectangle(area.x + clipped.x, area.y + clipped.y, clipped.width, clipped.height);
+    view.pixels = clipped.isEmpty() ? nullptr
+                                    : pixels + stride * clipped.y + static_cast<size_t>(clipped.x) * bytesPerPixel();
+    return view;
+}
+
+// ScreenCapture ownership and views
+ScreenCapture ScreenCapture::share() const {
+    ScreenCapture shared;
+    shared.area = area;
+    shared.pixelData = pixelData;
+    shared.offset = offset;
+    shared.stride = stride;
+    shared.width = width;
+    shared.height = height;
+    shared.bitsPerPixel = bitsPerPixel;
+    shared.timestamp = timestamp;
+    shared.tileHashes = tileHashes;
+    return shared;
+}
+
+ScreenCapture ScreenCapture::clone() const {
+    ScreenCapture copy;
+    copy.area = area;
+    copy.width = width;
+    copy.height = height;
+    copy.bitsPerPixel = bitsPerPixel;
+    copy.timestamp = timestamp;
+    copy.tileHashes = tileHashes;
+    if (!hasPixels()) {
+        return copy;
+    }
+    
+    const size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel();
+    copy.pixelData = FrameBuffer::allocate(rowBytes * height);
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(copy.pixels() + rowBytes * y, pixels() + bytesPerRow() * y, rowBytes);
+    }
+    return copy;
+}
+
+bool ScreenCapture::hasPixels() const {
+    if (width <= 0 || height <= 0 || bytesPerPixel() <= 0) {
+        return false;
+    }
+    const size_t lastRowEnd = bytesPerRow() * (height - 1) + static_cast<size_t>(width) * bytesPerPixel();
+    return bytesPerRow() >= static_cast<size_t>(width) * bytesPerPixel() && pixelData.size() >= offset + lastRowEnd;
+}
+
+FrameView ScreenCapture::view() const {
+    FrameView view;
+    view.pixels = hasPixels() ? pixels() : nullptr;
+    view.stride = bytesPerRow();
+    view.width = width;
+    view.height = height;
+    view.bitsPerPixel = bitsPerPixel;
+    view.area = area;
+    view.timestamp = timestamp;
+    return view;
+}
+
+bool ScreenCapture::crop(const Utils::Rectangle& rect) {
+    Utils::Rectangle clipped = rect.intersection(Utils::Rectangle(0, 0, width, height));
+    if (clipped.isEmpty() || !hasPixels()) {
+        return false;
+    }
+    
+    stride = bytesPerRow();
+    offset += stride * clipped.y + static_cast<size_t>(clipped.x) * bytesPerPixel();
+    area = Utils::Rectangle(area.x + clipped.x, area.y + clipped.y, clipped.width, clipped.height);
+    width = clipped.width;
+    height = clipped.height;
+    tileHashes.clear();
+    return true;
+}
+
 // ScreenCapture analysis methods
-ScreenCapture::ColorStats ScreenCapture::analyzeColors() const {
+ScreenCapture::ColorStats ScreenCapture::analyzeColors(const Utils::ColorStatsOptions& options) const {
     ColorStats stats;
     
-    if (pixelData.empty() || width == 0 || height == 0) {
+    if (!hasPixels()) {
         return stats;
     }
     
-    // Simplified color analysis
-    uint64_t totalR = 0, totalG = 0, totalB = 0;
-    int pixelCount = width * height;
-    int bytesPerPixel = bitsPerPixel / 8;
-    
-    for (int i = 0; i < pixelCount && i * bytesPerPixel + 2 < pixelData.size(); ++i) {
-        int offset = i * bytesPerPixel;
-        uint8_t b = pixelData[offset];
-        uint8_t g = pixelData[offset + 1];
-        uint8_t r = pixelData[offset + 2];
-        
-        totalR += r;
-        totalG += g;
-        totalB += b;
+    Utils::ColorStatsResult result = Utils::computeColorStats(pixels(), width, height, bytesPerRow(),
+                                                              bytesPerPixel(), options);
+    if (result.sampleCount == 0) {
+        return stats;
     }
     
-    if (pixelCount > 0) {
-        stats.averageColor = Color(
-            static_cast<uint8_t>(totalR / pixelCount),
-            static_cast<uint8_t>(totalG / pixelCount),
-            static_cast<uint8_t>(totalB / pixelCount)
-        );
-        
-        // Simplified brightness calculation
-        stats.brightness = (totalR + totalG + totalB) / (3.0f * 255.0f * pixelCount);
+    stats.averageColor = Color(static_cast<uint8_t>(result.meanRed + 0.5f),
+                               static_cast<uint8_t>(result.meanGreen + 0.5f),
+                               static_cast<uint8_t>(result.meanBlue + 0.5f));
+    stats.colorPalette.reserve(result.palette.size());
+    for (const auto& entry : result.palette) {
+        stats.colorPalette.emplace_back(entry.r, entry.g, entry.b);
     }
+    stats.dominantColor = stats.colorPalette.empty() ? stats.averageColor : stats.colorPalette.front();
+    stats.luminanceHistogram.assign(result.luminanceHistogram.begin(), result.luminanceHistogram.end());
     
-    stats.dominantColor = stats.averageColor; // Simplified
-    stats.contrast = 0.5f; // Placeholder
-    stats.saturation = 0.5f; // Placeholder
+    stats.brightness = result.meanLuminance / 255.0f;
+    stats.contrast = std::min(1.0f, result.luminanceStdDev / 127.5f);
+    stats.saturation = result.meanSaturation;
     
     return stats;
 }
 
 bool ScreenCapture::hasMotion(const ScreenCapture& previous, float threshold) const {
-    if (pixelData.size() != previous.pixelData.size()) {
+    if (width != previous.width || height != previous.height || bitsPerPixel != previous.bitsPerPixel) {
         return true; // Different sizes = motion
     }
+    if (!hasPixels() || !previous.hasPixels()) {
+        return false;
+    }
+    
+    const size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel();
+    auto diff = Utils::DiffKernels::diffRows(pixels(), bytesPerRow(), previous.pixels(), previous.bytesPerRow(),
+                                             rowBytes, height, 10);
+    
+    return diff.changeRatio(static_cast<size_t>(width) * height, bytesPerPixel()) > threshold;
+}
+
+namespace {
+
+// 64-bit multiply/rotate hash over a tile row, eight bytes at a time
+inline uint64_t hashBytes(const uint8_t* data, size_t length, uint64_t seed) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = seed;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < length; ++i) {
+        hash = (hash ^ data[i]) * prime;
+    }
+    return hash ^ (hash >> 32);
+}
+
+void computeTileHashes(const ScreenCapture& capture, std::vector<uint64_t>& hashes) {
+    const int tileSize = ScreenCapture::TILE_SIZE;
+    int columns = capture.tileColumns();
+    int bytesPerPixel = capture.bytesPerPixel();
+    size_t stride = capture.bytesPerRow();
+    
+    hashes.assign(static_cast<size_t>(columns) * capture.tileRows(), 0);
+    if (!capture.hasPixels()) {
+        return;
+    }
+    
+    for (int y = 0; y < capture.height; ++y) {
+        const uint8_t* row = capture.pixels() + stride * y;
+        uint64_t* rowHashes = hashes.data() + static_cast<size_t>(y / tileSize) * columns;
+        for (int tx = 0; tx < columns; ++tx) {
+            int x = tx * tileSize;
+            size_t length = static_cast<size_t>(std::min(tileSize, capture.width - x)) * bytesPerPixel;
+            rowHashes[tx] = hashBytes(row + static_cast<size_t>(x) * bytesPerPixel, length, rowHashes[tx] + y);
+        }
+    }
+}
+
+// Running mean over every update since the stats were reset
+void addUpdateTime(ScreenReader::ReaderStats& stats, std::chrono::steady_clock::duration elapsed) {
+    stats.eventsProcessed++;
+    const float milliseconds = std::chrono::duration<float, std::milli>(elapsed).count();
+    stats.averageUpdateTime += (milliseconds - stats.averageUpdateTime) / stats.eventsProcessed;
+}
+
+} // namespace
+
+void ScreenCapture::hashTiles() {
+    computeTileHashes(*this, tileHashes);
+}
+
+Utils::Rectangle ScreenCapture::tileRect(int tileIndex) const {
+    int columns = tileColumns();
+    int x = (tileIndex % columns) * TILE_SIZE;
+    int y = (tileIndex / columns) * TILE_SIZE;
+    return Utils::Rectangle(x, y, std::min(TILE_SIZE, width - x), std::min(TILE_SIZE, height - y));
+}
+
+void ScreenCapture::findChangedTiles(const ScreenCapture& previous, std::vector<int>& changedTiles) const {
+    changedTiles.clear();
+    int tileCount = tileColumns() * tileRows();
     
-    uint64_t differences = 0;
-    for (size_t i = 0; i < pixelData.size(); ++i) {
-        if (std::abs(static_cast<int>(pixelData[i]) - static_cast<int>(previous.pixelData[i])) > 10) {
-            differences++;
+    bool sameGeometry = width == previous.width && height == previous.height &&
+                        bitsPerPixel == previous.bitsPerPixel;
+    if (!sameGeometry) {
+        for (int i = 0; i < tileCount; ++i) {
+            changedTiles.push_back(i);
         }
+        return;
+    }
+    
+    // Reuse cached hashes where available, hash the rest locally
+    std::vector<uint64_t> currentScratch, previousScratch;
+    const std::vector<uint64_t>* current = &tileHashes;
+    const std::vector<uint64_t>* reference = &previous.tileHashes;
+    if (current->size() != static_cast<size_t>(tileCount)) {
+        computeTileHashes(*this, currentScratch);
+        current = &currentScratch;
+    }
+    if (reference->size() != static_cast<size_t>(tileCount)) {
+        computeTileHashes(previous, previousScratch);
+        reference = &previousScratch;
     }
     
-    float changeRatio = static_cast<float>(differences) / pixelData.size();
-    return changeRatio > threshold;
+    for (int i = 0; i < tileCount; ++i) {
+        if ((*current)[i] != (*reference)[i]) {
+            changedTiles.push_back(i);
+        }
+    }
+}
+
+std::vector<Utils::Rectangle> ScreenCapture::findChangedRegions(const ScreenCapture& previous) const {
+    std::vector<int> changedTiles;
+    findChangedTiles(previous, changedTiles);
+    
+    // Merge horizontally adjacent tiles into runs
+    std::vector<Utils::Rectangle> regions;
+    int lastTile = -2;
+    for (int tile : changedTiles) {
+        Utils::Rectangle rect = tileRect(tile);
+        if (tile == lastTile + 1 && !regions.empty() && regions.back().y == rect.y) {
+            regions.back().width += rect.width;
+        } else {
+            regions.push_back(rect);
+        }
+        lastTile = tile;
+    }
+    return regions;
+}
+
+// SparseCapture methods
+void SparseCapture::clear() {
+    tiles.clear();
+    tileOffsets.clear();
+    pixelData.clear();
+    keyFrame = false;
+}
+
+float SparseCapture::changeRatio() const {
+    if (width <= 0 || height <= 0) return 0.0f;
+    
+    int64_t changedPixels = 0;
+    for (const auto& tile : tiles) {
+        changedPixels += tile.area();
+    }
+    return static_cast<float>(changedPixels) / (static_cast<int64_t>(width) * height);
+}
+
+bool SparseCapture::applyTo(ScreenCapture& frame) const {
+    if (frame.width != width || frame.height != height || frame.bitsPerPixel != bitsPerPixel ||
+        !frame.hasPixels()) {
+        return false;
+    }
+    
+    size_t stride = frame.bytesPerRow();
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const auto& tile = tiles[i];
+        size_t rowBytes = static_cast<size_t>(tile.width) * bytesPerPixel();
+        const uint8_t* source = tilePixels(i);
+        for (int y = 0; y < tile.height; ++y) {
+            std::memcpy(frame.pixels() + stride * (tile.y + y) + tile.x * bytesPerPixel(),
+                        source + rowBytes * y, rowBytes);
+        }
+    }
+    
+    frame.timestamp = timestamp;
+    frame.tileHashes.clear();
+    return true;
 }
 
 // ScreenReader implementation
@@ -153,23 +452,145 @@ struct ScreenReader::Impl {
     std::vector<DisplayInfo> displays;
     SystemMetrics systemMetrics;
     std::vector<WindowInfo> windows;
+    Utils::SpatialGrid<size_t> windowIndex; // visible windows by position in `windows`
     CursorInfo cursorInfo;
     
-    // Tracking data
-    std::vector<Utils::Point> mouseTrail;
-    std::vector<int> keySequence;
+    // Tracking data, pushed by the update thread and read lock-free by callers
+    Utils::RingBuffer<Utils::Point, 128> mouseTrail;
+    Utils::RingBuffer<int, 128> keySequence;
+    Utils::RingBuffer<Utils::Point, 256> cursorPath;
+    std::atomic<bool> cursorPathRecording{false};
     std::vector<ScreenCapture> recentCaptures;
     
+    // Pixel storage for captures
+    FramePool framePool;
+    std::unique_ptr<CaptureSource> source = createSimulatedCaptureSource();
+    std::mutex sourceMutex; // serializes grabs and source swaps
+    bool sourceChosen = false; // set explicitly, initialize() keeps it
+    std::mutex captureMutex; // guards recentCaptures
+    std::vector<int> changedTiles;
+    
     // Statistics
     ScreenReader::ReaderStats stats;
     
-    // Simulation helpers
-    std::mt19937 rng{std::random_device{}()};
+    // Guards the current input states and stats once sampling runs on its own thread
+    mutable std::mutex stateMutex;
+    
+    // Input sampling thread and callback dispatcher
+    // Keyboard events carry only the key bitsets; the dispatcher replays
+    // them onto its own KeyboardState copy
+    struct InputEvent {
+        enum Type { MOUSE, KEYBOARD, CURSOR } type = MOUSE;
+        MouseState mouse;
+        CursorInfo cursor;
+        KeySnapshot keys;
+        KeyBitset changedKeys;
+        std::string typedText;
+    };
+    
+    static constexpr float MAX_UPDATE_RATE = 1000.0f;
+    static constexpr size_t EVENT_QUEUE_CAPACITY = 1024;
+    
+    std::atomic<int64_t> updatePeriodMicros{16667}; // 60 Hz
+    std::atomic<bool> highPrecisionMouse{false};
+    std::atomic<bool> sampling{false};
+    std::atomic<bool> dispatching{false};
+    std::thread samplingThread;
+    std::thread dispatchThread;
+    Utils::SpscQueue<InputEvent> events{EVENT_QUEUE_CAPACITY};
+    KeyboardState dispatchKeyboardState; // owned by the dispatcher thread
+    // Copy handed to the keyboard callback when update() runs it directly;
+    // assigned over each time so its strings keep their capacity
+    KeyboardState callbackKeyboardState;
+    
     std::chrono::steady_clock::time_point lastUpdate;
     std::chrono::steady_clock::time_point lastMouseMove;
     
-    void logOperation(const std::string& operation) {
-        std::cout << "[ScreenReader] " << operation << std::endl;
+    std::chrono::microseconds updatePeriod() const {
+        return std::chrono::microseconds(updatePeriodMicros.load(std::memory_order_relaxed));
+    }
+    
+    // Sleep until the next sample; high precision mode spins through the
+    // last stretch since sleep wake-up jitter is larger than a 1 kHz period
+    void waitUntil(std::chrono::steady_clock::time_point deadline) const {
+        if (highPrecisionMouse.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_until(deadline - std::chrono::microseconds(200));
+            while (std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+        } else {
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+    
+    void queueEvent(InputEvent&& event) {
+        if (!events.tryPush(std::move(event))) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stats.droppedEvents++;
+        }
+    }
+    
+    // Reuse the capture's buffer when nobody else holds it, otherwise borrow a slab
+    void prepareFrameBuffer(ScreenCapture& capture, size_t bytes) {
+        capture.offset = 0;
+        if (capture.pixelData.unique() && capture.pixelData.resize(bytes)) {
+            return;
+        }
+        capture.pixelData = framePool.acquire(bytes);
+    }
+    
+    // Grabs `area` (screen coordinates, clipped to the source) into capture as a packed frame
+    bool grab(ScreenCapture& capture, const Utils::Rectangle& area) {
+        std::lock_guard<std::mutex> lock(sourceMutex);
+        Utils::Rectangle bounds = source->bounds();
+        Utils::Rectangle target = bounds.isEmpty() ? area : area.intersection(bounds);
+        if (target.isEmpty()) {
+            return false;
+        }
+        
+        capture.area = target;
+        capture.width = target.width;
+        capture.height = target.height;
+        capture.bitsPerPixel = source->bitsPerPixel();
+        capture.stride = static_cast<size_t>(capture.width) * capture.bytesPerPixel();
+        capture.timestamp = std::chrono::steady_clock::now();
+        capture.tileHashes.clear();
+        
+        prepareFrameBuffer(capture, capture.stride * capture.height);
+        if (!source->grab(target, capture.pixels(), capture.stride)) {
+            RECORDIFY_LOG_WARN("ScreenReader", "Capture source ", source->name(), " failed to grab [",
+                               target.x, ",", target.y, ",", target.width, ",", target.height, "]");
+            return false;
+        }
+        return true;
+    }
+    
+    // Slabs come from the source when it can grab into them without a copy;
+    // called again on a source change so the pool follows it. sourceMutex held.
+    bool configureFramePool(int frameCount, size_t frameBytes) {
+        return framePool.configure(frameCount, frameBytes, source->slabAllocator());
+    }
+
+    void reconfigureFramePool() {
+        const FramePool::Stats pool = framePool.getStats();
+        if (pool.slabCount > 0) {
+            configureFramePool(pool.slabCount, pool.slabBytes);
+        }
+    }
+
+    // Primary display follows what the source can actually grab
+    void applySourceBounds() {
+        Utils::Rectangle bounds = source->bounds();
+        if (bounds.isEmpty() || displays.empty()) {
+            return;
+        }
+        DisplayInfo& primary = displays[0];
+        const int taskbar = primary.bounds.height - primary.workArea.height;
+        primary.bounds = bounds;
+        primary.workArea = Utils::Rectangle(bounds.x, bounds.y, bounds.width, bounds.height - taskbar);
+        primary.bitsPerPixel = source->bitsPerPixel();
+        systemMetrics.primaryScreenSize = Utils::Size(bounds.width, bounds.height);
+        systemMetrics.virtualScreenSize = systemMetrics.primaryScreenSize;
     }
     
     void initializeDisplays() {
@@ -194,7 +615,7 @@ struct ScreenReader::Impl {
         
         displays.push_back(primary);
         
-        logOperation("Initialized " + std::to_string(displays.size()) + " display(s)");
+        RECORDIFY_LOG_INFO("ScreenReader", "Initialized ", displays.size(), " display(s)");
     }
     
     void initializeSystemMetrics() {
@@ -212,36 +633,40 @@ struct ScreenReader::Impl {
         systemMetrics.maxTouchPoints = 0;
         systemMetrics.hasStylus = false;
         
-        logOperation("Initialized system metrics");
+        RECORDIFY_LOG_INFO("ScreenReader", "Initialized system metrics");
     }
     
-    void simulateMouseMovement() {
-        // Simulate realistic mouse movement
-        std::uniform_int_distribution<int> xDist(0, 1919);
-        std::uniform_int_distribution<int> yDist(0, 1079);
+    // Pointer position comes from the capture source; sources that don't
+    // report one leave the mouse where it is
+    void samplePointer() {
+        Utils::Point newPos = currentMouseState.position;
+        {
+            std::lock_guard<std::mutex> lock(sourceMutex);
+            source->pointer(newPos);
+        }
         
-        Utils::Point newPos(xDist(rng), yDist(rng));
+        auto now = std::chrono::steady_clock::now();
+        currentMouseState.previousPosition = currentMouseState.position;
+        currentMouseState.timestamp = now;
+        if (newPos == currentMouseState.position) {
+            currentMouseState.velocity = 0.0f;
+            return;
+        }
         
         // Calculate velocity
-        auto now = std::chrono::steady_clock::now();
         if (lastMouseMove != std::chrono::steady_clock::time_point{}) {
-            auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastMouseMove);
+            auto timeDiff = std::chrono::duration_cast<std::chrono::microseconds>(now - lastMouseMove);
             if (timeDiff.count() > 0) {
                 float distance = currentMouseState.getDistance(newPos);
-                currentMouseState.velocity = distance / (timeDiff.count() / 1000.0f);
+                currentMouseState.velocity = distance / (timeDiff.count() / 1000000.0f);
             }
         }
         
-        currentMouseState.previousPosition = currentMouseState.position;
         currentMouseState.position = newPos;
-        currentMouseState.timestamp = now;
         lastMouseMove = now;
         
         // Add to trail
-        mouseTrail.push_back(newPos);
-        if (mouseTrail.size() > 100) {
-            mouseTrail.erase(mouseTrail.begin());
-        }
+        mouseTrail.push(newPos);
     }
     
     void updateWindows() {
@@ -271,6 +696,26 @@ struct ScreenReader::Impl {
         notepad.isVisible = true;
         notepad.isFocused = true;
         windows.push_back(notepad);
+        
+        indexWindows();
+    }
+    
+    void indexWindows() {
+        std::vector<std::pair<size_t, Utils::Rectangle>> visible;
+        visible.reserve(windows.size());
+        for (size_t i = 0; i < windows.size(); ++i) {
+            if (windows[i].isVisible) {
+                visible.push_back({i, windows[i].bounds});
+            }
+        }
+        // About four cells across the screen, so even a full-screen window
+        // stays within the grid's cell limit instead of its overflow list
+        const Utils::Size screen = systemMetrics.virtualScreenSize;
+        const int cellSize = std::max(128, (std::max(screen.width, screen.height) / 4 + 127) / 128 * 128);
+        if (windowIndex.cellSize() != cellSize) {
+            windowIndex = Utils::SpatialGrid<size_t>(cellSize);
+        }
+        windowIndex.build(visible);
     }
     
     void updateCursor() {
@@ -281,6 +726,13 @@ struct ScreenReader::Impl {
         cursorInfo.size = Utils::Size(32, 32);
         cursorInfo.hotspot = Utils::Point(0, 0);
         cursorInfo.timestamp = std::chrono::steady_clock::now();
+        
+        if (cursorPathRecording.load(std::memory_order_relaxed)) {
+            Utils::Span<Utils::Point> last = cursorPath.view(1);
+            if (last.empty() || last.back() != cursorInfo.position) {
+                cursorPath.push(cursorInfo.position);
+            }
+        }
     }
 };
 
@@ -296,24 +748,32 @@ ScreenReader::ScreenReader()
     , m_captureTrackingEnabled(true) {
     
     m_impl->lastUpdate = std::chrono::steady_clock::now();
-    std::cout << "[ScreenReader] Created" << std::endl;
+    RECORDIFY_LOG_INFO("ScreenReader", "Created");
 }
 
 ScreenReader::~ScreenReader() {
     shutdown();
-    std::cout << "[ScreenReader] Destroyed" << std::endl;
+    RECORDIFY_LOG_INFO("ScreenReader", "Destroyed");
 }
 
 bool ScreenReader::initialize() {
     if (m_initialized) {
-        m_impl->logOperation("Already initialized");
+        RECORDIFY_LOG_INFO("ScreenReader", "Already initialized");
         return true;
     }
     
-    m_impl->logOperation("Initializing...");
+    RECORDIFY_LOG_INFO("ScreenReader", "Initializing...");
     
     m_impl->initializeDisplays();
     m_impl->initializeSystemMetrics();
+    {
+        std::lock_guard<std::mutex> lock(m_impl->sourceMutex);
+        if (!m_impl->sourceChosen) {
+            m_impl->source = createDefaultCaptureSource();
+            m_impl->reconfigureFramePool();
+        }
+        m_impl->applySourceBounds();
+    }
     m_impl->updateWindows();
     
     // Initialize mouse state
@@ -325,25 +785,25 @@ bool ScreenReader::initialize() {
     m_impl->currentKeyboardState.timestamp = std::chrono::steady_clock::now();
     
     m_initialized = true;
-    m_impl->logOperation("Initialization completed successfully");
+    RECORDIFY_LOG_INFO("ScreenReader", "Initialization completed successfully");
     return true;
 }
 
 void ScreenReader::shutdown() {
     if (!m_initialized) return;
     
-    m_impl->logOperation("Shutting down...");
+    RECORDIFY_LOG_INFO("ScreenReader", "Shutting down...");
     
     stopMonitoring();
     
     m_initialized = false;
-    m_impl->logOperation("Shutdown completed");
+    RECORDIFY_LOG_INFO("ScreenReader", "Shutdown completed");
 }
 
 void ScreenReader::startMonitoring() {
     if (m_isMonitoring) return;
     
-    m_impl->logOperation("Starting monitoring");
+    RECORDIFY_LOG_INFO("ScreenReader", "Starting monitoring");
     m_isMonitoring = true;
     m_impl->stats = ReaderStats{}; // Reset stats
 }
@@ -351,51 +811,104 @@ void ScreenReader::startMonitoring() {
 void ScreenReader::stopMonitoring() {
     if (!m_isMonitoring) return;
     
-    m_impl->logOperation("Stopping monitoring");
+    RECORDIFY_LOG_INFO("ScreenReader", "Stopping monitoring");
+    stopSampling();
     m_isMonitoring = false;
 }
 
 void ScreenReader::update() {
     if (!m_isMonitoring || !m_initialized) return;
     
-    auto now = std::chrono::steady_clock::now();
-    auto timeSinceLastUpdate = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_impl->lastUpdate);
+    // Input is sampled by the sampling thread when it runs; window
+    // enumeration stays on the caller and never runs faster than 60 Hz
+    bool sampling = isSampling();
+    auto minimumPeriod = sampling ? std::chrono::microseconds(16667) : m_impl->updatePeriod();
     
-    // Update at most 60 FPS
-    if (timeSinceLastUpdate.count() < 16) return;
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_impl->lastUpdate < minimumPeriod) return;
     
     m_impl->lastUpdate = now;
     
-    // Process events for enabled features
-    if (m_mouseTrackingEnabled) {
-        processMouseEvents();
-    }
-    
-    if (m_keyboardTrackingEnabled) {
-        processKeyboardEvents();
+    if (!sampling) {
+        sampleInput();
     }
     
     if (m_windowTrackingEnabled) {
         processWindowEvents();
     }
     
-    if (m_cursorTrackingEnabled) {
-        processCursorEvents();
+    if (!sampling) {
+        updateStats();
+    }
+}
+
+void ScreenReader::setUpdateInterval(int milliseconds) {
+    setUpdateRate(milliseconds > 0 ? 1000.0f / milliseconds : Impl::MAX_UPDATE_RATE);
+}
+
+void ScreenReader::setUpdateRate(float hz) {
+    hz = std::max(1.0f, std::min(hz, Impl::MAX_UPDATE_RATE));
+    m_impl->updatePeriodMicros.store(static_cast<int64_t>(1000000.0f / hz), std::memory_order_relaxed);
+    RECORDIFY_LOG_INFO("ScreenReader", "Update rate set to ", static_cast<int>(hz), " Hz");
+}
+
+void ScreenReader::setHighPrecisionMouse(bool enabled) {
+    m_impl->highPrecisionMouse.store(enabled, std::memory_order_relaxed);
+    RECORDIFY_LOG_INFO("ScreenReader", "High precision mouse ", enabled ? "enabled" : "disabled");
+}
+
+bool ScreenReader::startSampling() {
+    if (!m_initialized) {
+        RECORDIFY_LOG_WARN("ScreenReader", "Cannot start sampling: not initialized");
+        return false;
+    }
+    if (isSampling()) return true;
+    
+    startMonitoring();
+    
+    m_impl->dispatching = true;
+    m_impl->dispatchThread = std::thread(&ScreenReader::dispatchLoop, this);
+    m_impl->sampling = true;
+    m_impl->samplingThread = std::thread(&ScreenReader::samplingLoop, this);
+    
+    RECORDIFY_LOG_INFO("ScreenReader", "Started input sampling at ",
+                       1000000 / m_impl->updatePeriodMicros.load(), " Hz");
+    return true;
+}
+
+void ScreenReader::stopSampling() {
+    if (!isSampling()) return;
+    
+    // Stop the sampler first so the dispatcher can drain everything it queued
+    m_impl->sampling = false;
+    if (m_impl->samplingThread.joinable()) {
+        m_impl->samplingThread.join();
+    }
+    m_impl->dispatching = false;
+    if (m_impl->dispatchThread.joinable()) {
+        m_impl->dispatchThread.join();
     }
     
-    updateStats();
+    RECORDIFY_LOG_INFO("ScreenReader", "Stopped input sampling");
+}
+
+bool ScreenReader::isSampling() const {
+    return m_impl->sampling.load(std::memory_order_acquire);
 }
 
 // Mouse tracking
 MouseState ScreenReader::getCurrentMouseState() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     return m_impl->currentMouseState;
 }
 
 Utils::Point ScreenReader::getMousePosition() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     return m_impl->currentMouseState.position;
 }
 
 Utils::Point ScreenReader::getMouseVelocity() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     float vx = m_impl->currentMouseState.velocity * 
                (m_impl->currentMouseState.position.x - m_impl->currentMouseState.previousPosition.x);
     float vy = m_impl->currentMouseState.velocity * 
@@ -404,6 +917,7 @@ Utils::Point ScreenReader::getMouseVelocity() const {
 }
 
 bool ScreenReader::isMouseButtonPressed(int button) const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     switch (button) {
         case 0: return m_impl->currentMouseState.leftButton.pressed;
         case 1: return m_impl->currentMouseState.rightButton.pressed;
@@ -415,19 +929,41 @@ bool ScreenReader::isMouseButtonPressed(int button) const {
 }
 
 std::vector<Utils::Point> ScreenReader::getMouseTrail(int maxPoints) const {
-    std::vector<Utils::Point> trail = m_impl->mouseTrail;
-    if (trail.size() > static_cast<size_t>(maxPoints)) {
-        trail.erase(trail.begin(), trail.end() - maxPoints);
-    }
-    return trail;
+    return m_impl->mouseTrail.snapshot(static_cast<size_t>(std::max(0, maxPoints)));
+}
+
+Utils::Span<Utils::Point> ScreenReader::getMouseTrailView(uint64_t& sequence, int maxPoints) const {
+    return m_impl->mouseTrail.view(static_cast<size_t>(std::max(0, maxPoints)), &sequence);
+}
+
+bool ScreenReader::isMouseTrailIntact(uint64_t sequence, size_t count) const {
+    return m_impl->mouseTrail.isIntact(sequence, count);
 }
 
 void ScreenReader::clearMouseTrail() {
     m_impl->mouseTrail.clear();
-    m_impl->logOperation("Cleared mouse trail");
+    RECORDIFY_LOG_INFO("ScreenReader", "Cleared mouse trail");
+}
+
+Utils::Rectangle ScreenReader::getMouseMovementBounds() const {
+    std::vector<Utils::Point> trail = m_impl->mouseTrail.snapshot(m_impl->mouseTrail.capacity());
+    if (trail.empty()) {
+        return Utils::Rectangle();
+    }
+    
+    Utils::Point topLeft = trail.front();
+    Utils::Point bottomRight = trail.front();
+    for (const auto& point : trail) {
+        topLeft.x = std::min(topLeft.x, point.x);
+        topLeft.y = std::min(topLeft.y, point.y);
+        bottomRight.x = std::max(bottomRight.x, point.x);
+        bottomRight.y = std::max(bottomRight.y, point.y);
+    }
+    return Utils::Rectangle(topLeft, bottomRight);
 }
 
 bool ScreenReader::isMouseIdle(float seconds) const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     auto now = std::chrono::steady_clock::now();
     auto idleDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_impl->lastMouseMove);
     return idleDuration.count() / 1000.0f > seconds;
@@ -435,17 +971,29 @@ bool ScreenReader::isMouseIdle(float seconds) const {
 
 // Keyboard tracking
 KeyboardState ScreenReader::getCurrentKeyboardState() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     return m_impl->currentKeyboardState;
 }
 
 bool ScreenReader::isKeyPressed(int keyCode) const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     return m_impl->currentKeyboardState.isKeyPressed(keyCode);
 }
 
 std::string ScreenReader::getLastTypedText() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     return m_impl->currentKeyboardState.lastTypedText;
 }
 
+KeySnapshot ScreenReader::getKeySnapshot() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
+    return m_impl->currentKeyboardState.snapshot();
+}
+
+std::vector<int> ScreenReader::getKeySequence(int maxKeys) const {
+    return m_impl->keySequence.snapshot(static_cast<size_t>(std::max(0, maxKeys)));
+}
+
 // Display information
 std::vector<DisplayInfo> ScreenReader::getDisplays() const {
     return m_impl->displays;
@@ -523,27 +1071,214 @@ Utils::Size ScreenReader::getDPI(int displayId) const {
 bool ScreenReader::captureScreen(ScreenCapture& capture, const Utils::Rectangle& area) const {
     Utils::Rectangle captureArea = area.isEmpty() ? getPrimaryDisplay().bounds : area;
     
-    m_impl->logOperation("Capturing screen area: [" + std::to_string(captureArea.x) + "," + 
-                        std::to_string(captureArea.y) + "," + std::to_string(captureArea.width) + "," + 
-                        std::to_string(captureArea.height) + "]");
+    RECORDIFY_LOG_DEBUG("ScreenReader", "Capturing screen area: [", captureArea.x, ",", captureArea.y,
+                        ",", captureArea.width, ",", captureArea.height, "]");
+    
+    if (!m_impl->grab(capture, captureArea)) {
+        return false;
+    }
+    notifyCapture(capture);
+    return true;
+}
+
+bool ScreenReader::captureRegion(ScreenCapture& capture, const Utils::Rectangle& region) const {
+    if (region.isEmpty()) {
+        return false;
+    }
+    
+    // Keep the region's size when it runs off the display (FOLLOW_CURSOR near an edge)
+    Utils::Rectangle bounds = getDisplayAt(region.center()).bounds;
+    Utils::Rectangle target = region;
+    if (target.width <= bounds.width && target.height <= bounds.height) {
+        target.x = std::clamp(target.x, bounds.x, bounds.x + bounds.width - target.width);
+        target.y = std::clamp(target.y, bounds.y, bounds.y + bounds.height - target.height);
+    }
+    
+    // Only the part on the display is read from the source
+    if (!m_impl->grab(capture, target.intersection(bounds))) {
+        return false;
+    }
+    notifyCapture(capture);
+    return true;
+}
+
+bool ScreenReader::captureWindow(ScreenCapture& capture, uintptr_t windowHandle) const {
+    for (const auto& window : m_impl->windows) {
+        if (window.windowHandle == windowHandle) {
+            return captureRegion(capture, window.bounds);
+        }
+    }
+    return false;
+}
+
+bool ScreenReader::setCaptureSource(std::unique_ptr<CaptureSource> source) {
+    if (!source || !source->open()) {
+        RECORDIFY_LOG_WARN("ScreenReader", "Cannot open capture source ", source ? source->name() : "(null)");
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_impl->sourceMutex);
+    m_impl->source->close();
+    m_impl->source = std::move(source);
+    m_impl->sourceChosen = true;
+    m_impl->reconfigureFramePool();
+    m_impl->applySourceBounds();
+    RECORDIFY_LOG_INFO("ScreenReader", "Capturing through ", m_impl->source->name());
+    return true;
+}
+
+const char* ScreenReader::getCaptureSourceName() const {
+    std::lock_guard<std::mutex> lock(m_impl->sourceMutex);
+    return m_impl->source->name();
+}
+
+std::vector<ScreenCapture> ScreenReader::getRecentCaptures(int count) const {
+    std::vector<ScreenCapture> captures;
+    std::lock_guard<std::mutex> lock(m_impl->captureMutex);
+    const auto& history = m_impl->recentCaptures;
+    size_t first = history.size() - std::min(history.size(), static_cast<size_t>(std::max(0, count)));
+    for (size_t i = first; i < history.size(); ++i) {
+        // The shared buffer stays out of the capture recycling until released
+        captures.push_back(history[i].share());
+    }
+    return captures;
+}
+
+bool ScreenReader::captureChanges(SparseCapture& changes, const Utils::Rectangle& area,
+                                  const std::vector<Utils::Rectangle>& resend) {
+    // Recycle the oldest history entry as the capture target
+    ScreenCapture current;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->captureMutex);
+        auto& history = m_impl->recentCaptures;
+        if (history.size() >= static_cast<size_t>(MAX_RECENT_CAPTURES)) {
+            current = std::move(history.front());
+            history.erase(history.begin());
+        }
+    }
+    
+    if (!captureScreen(current, area)) {
+        return false;
+    }
+    current.hashTiles();
+    
+    changes.clear();
+    changes.area = current.area;
+    changes.width = current.width;
+    changes.height = current.height;
+    changes.bitsPerPixel = current.bitsPerPixel;
+    changes.timestamp = current.timestamp;
     
-    capture.area = captureArea;
-    capture.width = captureArea.width;
-    capture.height = captureArea.height;
-    capture.bitsPerPixel = 24;
-    capture.timestamp = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(m_impl->captureMutex);
+    auto& history = m_impl->recentCaptures;
+    auto& changedTiles = m_impl->changedTiles;
     
-    // Simulate pixel data
-    int pixelCount = capture.width * capture.height;
-    int bytesPerPixel = capture.bitsPerPixel / 8;
-    capture.pixelData.resize(pixelCount * bytesPerPixel);
+    if (!history.empty() && history.back().area == current.area) {
+        current.findChangedTiles(history.back(), changedTiles);
+        if (!resend.empty()) {
+            const Utils::Rectangle frame(0, 0, current.width, current.height);
+            const int tileSize = ScreenCapture::TILE_SIZE;
+            const int columns = current.tileColumns();
+            for (const Utils::Rectangle& requested : resend) {
+                Utils::Rectangle rect = requested.intersection(frame);
+                if (rect.isEmpty()) {
+                    continue;
+                }
+                for (int row = rect.top() / tileSize; row <= (rect.bottom() - 1) / tileSize; ++row) {
+                    for (int column = rect.left() / tileSize; column <= (rect.right() - 1) / tileSize; ++column) {
+                        changedTiles.push_back(row * columns + column);
+                    }
+                }
+            }
+            // Tiles stay in tile order
+            std::sort(changedTiles.begin(), changedTiles.end());
+            changedTiles.erase(std::unique(changedTiles.begin(), changedTiles.end()), changedTiles.end());
+        }
+    } else {
+        changes.keyFrame = true;
+        changedTiles.clear();
+        for (int i = 0; i < current.tileColumns() * current.tileRows(); ++i) {
+            changedTiles.push_back(i);
+        }
+    }
     
-    // Fill with simulated data
-    std::fill(capture.pixelData.begin(), capture.pixelData.end(), 128);
+    // Pack changed tiles row by row
+    int bytesPerPixel = current.bytesPerPixel();
+    size_t stride = current.bytesPerRow();
+    for (int tile : changedTiles) {
+        Utils::Rectangle rect = current.tileRect(tile);
+        size_t rowBytes = static_cast<size_t>(rect.width) * bytesPerPixel;
+        changes.tiles.push_back(rect);
+        changes.tileOffsets.push_back(changes.pixelData.size());
+        for (int y = 0; y < rect.height; ++y) {
+            const uint8_t* row = current.pixels() + stride * (rect.y + y) + rect.x * bytesPerPixel;
+            changes.pixelData.insert(changes.pixelData.end(), row, row + rowBytes);
+        }
+    }
     
+    history.push_back(std::move(current));
     return true;
 }
 
+// Screen content analysis
+bool ScreenReader::detectMotion(const Utils::Rectangle& area, float threshold) const {
+    ScreenCapture current;
+    if (!captureScreen(current, area)) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_impl->captureMutex);
+    if (m_impl->recentCaptures.empty() || m_impl->recentCaptures.back().area != current.area) {
+        return false; // nothing to compare against
+    }
+    return current.hasMotion(m_impl->recentCaptures.back(), threshold);
+}
+
+std::vector<Utils::Rectangle> ScreenReader::findChangedRegions(const Utils::Rectangle& area) const {
+    std::vector<Utils::Rectangle> regions;
+    ScreenCapture current;
+    if (!captureScreen(current, area)) {
+        return regions;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_impl->captureMutex);
+    if (m_impl->recentCaptures.empty() || m_impl->recentCaptures.back().area != current.area) {
+        return regions;
+    }
+    
+    // Report in screen coordinates
+    for (const auto& region : current.findChangedRegions(m_impl->recentCaptures.back())) {
+        regions.push_back(region.translated(current.area.topLeft()));
+    }
+    return regions;
+}
+
+bool ScreenReader::configureFramePool(int frameCount, size_t frameBytes) {
+    std::lock_guard<std::mutex> lock(m_impl->sourceMutex);
+    if (!m_impl->configureFramePool(frameCount, frameBytes)) {
+        RECORDIFY_LOG_WARN("ScreenReader", "Failed to configure frame pool");
+        return false;
+    }
+    
+    RECORDIFY_LOG_INFO("ScreenReader", "Configured frame pool: ", frameCount, " x ", frameBytes, " bytes");
+    return true;
+}
+
+FramePool::Stats ScreenReader::getFramePoolStats() const {
+    return m_impl->framePool.getStats();
+}
+
+size_t ScreenReader::getFrameBytes(const Utils::Rectangle& area) const {
+    Utils::Rectangle target = area.isEmpty() ? getPrimaryDisplay().bounds : area;
+    std::lock_guard<std::mutex> lock(m_impl->sourceMutex);
+    Utils::Rectangle bounds = m_impl->source->bounds();
+    if (!bounds.isEmpty()) {
+        target = target.intersection(bounds);
+    }
+    const size_t bytesPerPixel = static_cast<size_t>(m_impl->source->bitsPerPixel() / 8);
+    return target.isEmpty() ? 0 : static_cast<size_t>(target.width) * target.height * bytesPerPixel;
+}
+
 // Window management
 std::vector<WindowInfo> ScreenReader::getVisibleWindows() const {
     std::vector<WindowInfo> visibleWindows;
@@ -567,31 +1302,64 @@ WindowInfo ScreenReader::getActiveWindow() const {
 }
 
 WindowInfo ScreenReader::getWindowAt(const Utils::Point& point) const {
-    for (const auto& window : m_impl->windows) {
-        if (window.isVisible && window.containsPoint(point)) {
-            return window;
-        }
+    // Same answer as a front-to-back scan: the earliest window in the list wins
+    size_t best = m_impl->windows.size();
+    m_impl->windowIndex.queryPoint(point, [&best](size_t index, const Utils::Rectangle&) {
+        best = std::min(best, index);
+    });
+    return best < m_impl->windows.size() ? m_impl->windows[best] : WindowInfo{};
+}
+
+std::vector<WindowInfo> ScreenReader::getWindowsIn(const Utils::Rectangle& area) const {
+    std::vector<size_t> hits = m_impl->windowIndex.queryRect(area);
+    std::sort(hits.begin(), hits.end());
+    
+    std::vector<WindowInfo> result;
+    result.reserve(hits.size());
+    for (size_t index : hits) {
+        result.push_back(m_impl->windows[index]);
     }
-    return WindowInfo{};
+    return result;
 }
 
 // Cursor information
 CursorInfo ScreenReader::getCurrentCursor() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     return m_impl->cursorInfo;
 }
 
 bool ScreenReader::isCursorVisible() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     return m_impl->cursorInfo.isVisible;
 }
 
+void ScreenReader::startCursorTracking() {
+    m_impl->cursorPath.clear();
+    m_impl->cursorPathRecording.store(true, std::memory_order_relaxed);
+    RECORDIFY_LOG_INFO("ScreenReader", "Started cursor path tracking");
+}
+
+void ScreenReader::stopCursorTracking() {
+    m_impl->cursorPathRecording.store(false, std::memory_order_relaxed);
+    RECORDIFY_LOG_INFO("ScreenReader", "Stopped cursor path tracking");
+}
+
+std::vector<Utils::Point> ScreenReader::getCursorPath(int maxPoints) const {
+    return m_impl->cursorPath.snapshot(static_cast<size_t>(std::max(0, maxPoints)));
+}
+
 // Statistics
 ScreenReader::ReaderStats ScreenReader::getReaderStats() const {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
     return m_impl->stats;
 }
 
 void ScreenReader::resetReaderStats() {
-    m_impl->stats = ReaderStats{};
-    m_impl->logOperation("Reset reader statistics");
+    {
+        std::lock_guard<std::mutex> lock(m_impl->stateMutex);
+        m_impl->stats = ReaderStats{};
+    }
+    RECORDIFY_LOG_INFO("ScreenReader", "Reset reader statistics");
 }
 
 // Event callbacks
@@ -607,40 +1375,114 @@ void ScreenReader::setWindowCallback(WindowCallback callback) {
     m_windowCallback = callback;
 }
 
+void ScreenReader::setCaptureCallback(CaptureCallback callback) {
+    m_captureCallback = callback;
+}
+
+// Set before capturing starts; runs on the capturing thread
+void ScreenReader::notifyCapture(const ScreenCapture& capture) const {
+    if (m_captureCallback) {
+        m_captureCallback(capture.view());
+    }
+}
+
+void ScreenReader::setKeyChangeCallback(KeyChangeCallback callback) {
+    m_keyChangeCallback = callback;
+}
+
 // Feature toggles
 void ScreenReader::setMouseTrackingEnabled(bool enabled) {
     m_mouseTrackingEnabled = enabled;
-    m_impl->logOperation("Mouse tracking " + std::string(enabled ? "enabled" : "disabled"));
+    RECORDIFY_LOG_INFO("ScreenReader", "Mouse tracking ", enabled ? "enabled" : "disabled");
 }
 
 void ScreenReader::setKeyboardTrackingEnabled(bool enabled) {
     m_keyboardTrackingEnabled = enabled;
-    m_impl->logOperation("Keyboard tracking " + std::string(enabled ? "enabled" : "disabled"));
+    RECORDIFY_LOG_INFO("ScreenReader", "Keyboard tracking ", enabled ? "enabled" : "disabled");
 }
 
 // Private methods
+void ScreenReader::sampleInput() {
+    if (m_mouseTrackingEnabled) {
+        processMouseEvents();
+    }
+    
+    if (m_keyboardTrackingEnabled) {
+        processKeyboardEvents();
+    }
+    
+    if (m_cursorTrackingEnabled) {
+        processCursorEvents();
+    }
+}
+
+// State is updated under stateMutex; callbacks run outside it, either
+// inline or on the dispatcher thread while sampling
 void ScreenReader::processMouseEvents() {
-    m_impl->simulateMouseMovement();
-    m_impl->stats.mouseEvents++;
+    Impl::InputEvent event;
+    event.type = Impl::InputEvent::MOUSE;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->stateMutex);
+        m_impl->samplePointer();
+        m_impl->stats.mouseEvents++;
+        event.mouse = m_impl->currentMouseState;
+    }
     
-    if (m_mouseCallback) {
-        m_mouseCallback(m_impl->currentMouseState);
+    if (!m_mouseCallback) return;
+    if (isSampling()) {
+        m_impl->queueEvent(std::move(event));
+    } else {
+        m_mouseCallback(event.mouse);
     }
 }
 
 void ScreenReader::processKeyboardEvents() {
-    // Update keyboard state
-    m_impl->currentKeyboardState.timestamp = std::chrono::steady_clock::now();
-    m_impl->stats.keyboardEvents++;
+    bool sampling = isSampling();
+    bool wantsState = m_keyboardCallback && !sampling;
+    KeyboardState& state = m_impl->callbackKeyboardState;
+    Impl::InputEvent event;
+    event.type = Impl::InputEvent::KEYBOARD;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->stateMutex);
+        KeyboardState& keyboard = m_impl->currentKeyboardState;
+        keyboard.timestamp = std::chrono::steady_clock::now();
+        m_impl->stats.keyboardEvents++;
+        
+        event.keys = keyboard.snapshot();
+        event.changedKeys = keyboard.keys.changed();
+        if (sampling) {
+            event.typedText = keyboard.lastTypedText;
+        } else if (wantsState) {
+            state = keyboard;
+        }
+        keyboard.keys.advance();
+    }
+    
+    if (!m_keyboardCallback && !m_keyChangeCallback) return;
+    if (sampling) {
+        m_impl->queueEvent(std::move(event));
+        return;
+    }
     
     if (m_keyboardCallback) {
-        m_keyboardCallback(m_impl->currentKeyboardState);
+        m_keyboardCallback(state);
     }
+    deliverKeyChanges(event.keys, event.changedKeys);
+}
+
+void ScreenReader::deliverKeyChanges(const KeySnapshot& keys, const KeyBitset& changed) {
+    if (!m_keyChangeCallback) return;
+    changed.forEach([&](int keyCode) {
+        m_keyChangeCallback(keyCode, keys.pressed.test(keyCode), keys.timestamp);
+    });
 }
 
 void ScreenReader::processWindowEvents() {
     m_impl->updateWindows();
-    m_impl->stats.windowEvents++;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->stateMutex);
+        m_impl->stats.windowEvents++;
+    }
     
     if (m_windowCallback) {
         for (const auto& window : m_impl->windows) {
@@ -650,19 +1492,90 @@ void ScreenReader::processWindowEvents() {
 }
 
 void ScreenReader::processCursorEvents() {
-    m_impl->updateCursor();
+    Impl::InputEvent event;
+    event.type = Impl::InputEvent::CURSOR;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->stateMutex);
+        m_impl->updateCursor();
+        event.cursor = m_impl->cursorInfo;
+    }
     
-    if (m_cursorCallback) {
-        m_cursorCallback(m_impl->cursorInfo);
+    if (!m_cursorCallback) return;
+    if (isSampling()) {
+        m_impl->queueEvent(std::move(event));
+    } else {
+        m_cursorCallback(event.cursor);
     }
 }
 
-void ScreenReader::updateStats() {
-    m_impl->stats.eventsProcessed++;
+void ScreenReader::samplingLoop() {
+    auto next = std::chrono::steady_clock::now();
+    while (m_impl->sampling.load(std::memory_order_acquire)) {
+        auto start = std::chrono::steady_clock::now();
+        sampleInput();
+        
+        {
+            std::lock_guard<std::mutex> lock(m_impl->stateMutex);
+            addUpdateTime(m_impl->stats, std::chrono::steady_clock::now() - start);
+        }
+        
+        // Fixed-rate schedule; after a stall resume from now instead of bursting
+        next += m_impl->updatePeriod();
+        if (next < start) {
+            next = start + m_impl->updatePeriod();
+        }
+        m_impl->waitUntil(next);
+    }
+}
+
+void ScreenReader::dispatchLoop() {
+    Impl::InputEvent event;
+    for (;;) {
+        if (!m_impl->events.tryPop(event)) {
+            if (!m_impl->dispatching.load(std::memory_order_acquire)) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(250));
+            continue;
+        }
+        
+        switch (event.type) {
+            case Impl::InputEvent::MOUSE:
+                if (m_mouseCallback) m_mouseCallback(event.mouse);
+                break;
+            case Impl::InputEvent::KEYBOARD:
+                dispatchKeyboardEvent(event.keys, event.changedKeys, event.typedText);
+                break;
+            case Impl::InputEvent::CURSOR:
+                if (m_cursorCallback) m_cursorCallback(event.cursor);
+                break;
+        }
+    }
+}
+
+void ScreenReader::dispatchKeyboardEvent(const KeySnapshot& keys, const KeyBitset& changed,
+                                         const std::string& typedText) {
+    KeyboardState& keyboard = m_impl->dispatchKeyboardState;
+    changed.forEach([&](int keyCode) {
+        if (keys.pressed.test(keyCode)) {
+            keyboard.keys.press(keyCode, keys.timestamp);
+        } else {
+            keyboard.keys.release(keyCode, keys.timestamp);
+        }
+    });
+    keyboard.lastTypedText = typedText;
+    keyboard.timestamp = keys.timestamp;
     
-    auto now = std::chrono::steady_clock::now();
-    auto updateTime = std::chrono::duration_cast<std::chrono::microseconds>(now - m_impl->lastUpdate);
-    m_impl->stats.averageUpdateTime = updateTime.count() / 1000.0f; // Convert to milliseconds
+    if (m_keyboardCallback) {
+        m_keyboardCallback(keyboard);
+    }
+    deliverKeyChanges(keys, changed);
+    keyboard.keys.advance();
+}
+
+void ScreenReader::updateStats() {
+    std::lock_guard<std::mutex> lock(m_impl->stateMutex);
+    addUpdateTime(m_impl->stats, std::chrono::steady_clock::now() - m_impl->lastUpdate);
 }
 
 }} // namespace Recordify::ScreenHandler
@@ -1,13 +1,315 @@
 #include "screen_handler/screen_writer.h"
-#include <iostream>
+#include "screen_handler/rasterizer.h"
+#include "screen_handler/layer_compositor.h"
+#include "screen_handler/screen_reader.h"
+#include "screen_handler/animation_batch.h"
+#include "utils/logger.h"
+#include "utils/spatial_index.h"
 #include <algorithm>
 #include <cmath>
+#include <mutex>
 #include <sstream>
 #include <iomanip>
 
 namespace Recordify {
 namespace ScreenHandler {
 
+namespace {
+
+PremultipliedColor toPremultiplied(const Color& color, float opacity) {
+    return PremultipliedColor::fromStraight(color.r, color.g, color.b, color.a, opacity);
+}
+
+// Same as Transform::apply but keeps subpixel precision for the rasterizer
+PointF applyTransform(const DrawingContext::Transform& transform, const PointF& point) {
+    float x = point.x * transform.scaleX;
+    float y = point.y * transform.scaleY;
+    if (transform.rotationAngle != 0.0f) {
+        float cos_a = std::cos(transform.rotationAngle);
+        float sin_a = std::sin(transform.rotationAngle);
+        float new_x = x * cos_a - y * sin_a;
+        float new_y = x * sin_a + y * cos_a;
+        x = new_x;
+        y = new_y;
+    }
+    return PointF(x + transform.translation.x, y + transform.translation.y);
+}
+
+// Uniform scale applied to stroke widths under a non-uniform transform
+float transformScale(float scaleX, float scaleY) {
+    return std::sqrt(std::fabs(scaleX * scaleY));
+}
+
+PointF toPointF(const Utils::Point& point) {
+    return PointF(static_cast<float>(point.x), static_cast<float>(point.y));
+}
+
+void addTextLine(RasterPath& path, const std::string& line, float x, float y, const FontProperties& font) {
+    path.addText(line, x, y, font.size, font.isBold(), font.isItalic(), font.letterSpacing);
+
+    // Decorations sit relative to the 8-row glyph cell: underline below the
+    // baseline, strikethrough through the x-height
+    float cell = font.size / 8.0f;
+    float thickness = std::max(1.0f, cell * 0.75f);
+    float width = RasterPath::measureText(line, font.size, font.isBold(), font.letterSpacing);
+    if (font.isUnderlined()) {
+        path.addRect(x, y + 7.25f * cell, width, thickness);
+    }
+    if (font.style & static_cast<int>(TextStyle::STRIKETHROUGH)) {
+        path.addRect(x, y + 4.0f * cell - thickness * 0.5f, width, thickness);
+    }
+}
+
+// Greedy word wrap; maxWidth <= 0 only splits on newlines
+std::vector<std::string> wrapText(const std::string& text, const FontProperties& font, float maxWidth) {
+    std::vector<std::string> lines;
+    std::istringstream paragraphs(text);
+    std::string paragraph;
+    while (std::getline(paragraphs, paragraph)) {
+        if (maxWidth <= 0.0f) {
+            lines.push_back(paragraph);
+            continue;
+        }
+
+        std::istringstream words(paragraph);
+        std::string word;
+        std::string line;
+        while (words >> word) {
+            std::string candidate = line.empty() ? word : line + " " + word;
+            if (!line.empty() &&
+                RasterPath::measureText(candidate, font.size, font.isBold(), font.letterSpacing) > maxWidth) {
+                lines.push_back(line);
+                line = word;
+            } else {
+                line = candidate;
+            }
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Device-space bounds of a path once stroked `strokeWidth` wide. Joins are
+// round or bevelled, so half the width plus a pixel of anti-aliasing covers it.
+Utils::Rectangle pathBounds(const RasterPath& path, float strokeWidth) {
+    if (path.points().empty()) {
+        return Utils::Rectangle();
+    }
+    float minX = path.points().front().x, maxX = minX;
+    float minY = path.points().front().y, maxY = minY;
+    for (const auto& point : path.points()) {
+        minX = std::min(minX, point.x);
+        maxX = std::max(maxX, point.x);
+        minY = std::min(minY, point.y);
+        maxY = std::max(maxY, point.y);
+    }
+    float margin = strokeWidth * 0.5f + 1.0f;
+    int left = static_cast<int>(std::floor(minX - margin));
+    int top = static_cast<int>(std::floor(minY - margin));
+    return Utils::Rectangle(left, top, static_cast<int>(std::ceil(maxX + margin)) - left,
+                            static_cast<int>(std::ceil(maxY + margin)) - top);
+}
+
+// Fill, stroke and shadow of a device-space path into the rasterizer's target.
+// scaleX/scaleY are the transform's, used for stroke widths and the shadow offset.
+Utils::Rectangle paintPath(Rasterizer& rasterizer, const RasterPath& path, const ShapeProperties& properties,
+                           bool fillable, bool roundCaps, float scaleX, float scaleY, float opacity) {
+    const float scale = transformScale(scaleX, scaleY);
+
+    StrokeStyle stroke;
+    stroke.width = properties.strokeWidth * scale;
+    stroke.cap = roundCaps ? LineCap::ROUND : LineCap::BUTT;
+    stroke.dashOffset = properties.dashOffset * scale;
+    for (float dash : properties.dashPattern) {
+        stroke.dashPattern.push_back(dash * scale);
+    }
+
+    // Gradients aren't supported by the software path yet; fillColor is used
+    const bool filled = fillable && properties.filled && properties.fillColor.a > 0;
+    const bool stroked = stroke.width > 0.0f && properties.strokeColor.a > 0;
+
+    Utils::Rectangle touched;
+    if (properties.shadowColor.a > 0 && (filled || stroked)) {
+        // Hard-edged shadow, shadowBlur is ignored
+        RasterPath shadow = path;
+        shadow.translate(properties.shadowOffset.x * scaleX, properties.shadowOffset.y * scaleY);
+        PremultipliedColor shadowColor = toPremultiplied(properties.shadowColor, opacity);
+        if (filled) {
+            touched = touched.united(rasterizer.fill(shadow, shadowColor));
+        }
+        if (stroked) {
+            touched = touched.united(rasterizer.stroke(shadow, stroke, shadowColor));
+        }
+    }
+    if (filled) {
+        touched = touched.united(rasterizer.fill(path, toPremultiplied(properties.fillColor, opacity)));
+    }
+    if (stroked) {
+        touched = touched.united(rasterizer.stroke(path, stroke, toPremultiplied(properties.strokeColor, opacity)));
+    }
+    return touched;
+}
+
+Utils::Rectangle paintText(Rasterizer& rasterizer, const RasterPath& path, const TextProperties& properties,
+                           float scaleX, float scaleY, float opacity) {
+    Utils::Rectangle touched;
+    if (properties.shadowColor.a > 0) {
+        RasterPath shadow = path;
+        shadow.translate(properties.shadowOffset.x * scaleX, properties.shadowOffset.y * scaleY);
+        touched = rasterizer.fill(shadow, toPremultiplied(properties.shadowColor, opacity));
+    }
+    if (properties.outlineWidth > 0.0f && properties.outlineColor.a > 0) {
+        // Stroke centred on the glyph edges; the fill covers the inner half
+        StrokeStyle outline;
+        outline.width = properties.outlineWidth * 2.0f * transformScale(scaleX, scaleY);
+        touched = touched.united(rasterizer.stroke(path, outline, toPremultiplied(properties.outlineColor, opacity)));
+    }
+    return touched.united(rasterizer.fill(path, toPremultiplied(properties.color, opacity)));
+}
+
+// Canvas-space geometry of an annotation, built once when it is cached
+struct AnnotationShape {
+    RasterPath path;
+    ShapeProperties properties;
+    bool fillable;
+    bool roundCaps;
+};
+
+struct AnnotationGeometry {
+    std::vector<AnnotationShape> shapes;
+    RasterPath text;
+
+    // `scale` is applied to stroke widths and shadow offsets, as paintPath does
+    Utils::Rectangle bounds(const ScreenWriter::Annotation& annotation, float scale = 1.0f) const {
+        Utils::Rectangle result;
+        for (const auto& shape : shapes) {
+            Utils::Rectangle box = pathBounds(shape.path, shape.properties.strokeWidth * scale);
+            result = result.united(box).united(box.translated(shape.properties.shadowOffset * scale));
+        }
+        if (!text.isEmpty()) {
+            Utils::Rectangle box = pathBounds(text, annotation.textProps.outlineWidth * 2.0f * scale);
+            result = result.united(box).united(box.translated(annotation.textProps.shadowOffset * scale));
+        }
+        return result;
+    }
+    
+    // Scales and rotates (radians) about the centre of `around`, then offsets
+    void applyPose(const AnimationKeyframe& pose, const Utils::Rectangle& around) {
+        const float cx = around.x + around.width * 0.5f;
+        const float cy = around.y + around.height * 0.5f;
+        const float cosA = std::cos(pose.rotation) * pose.scale;
+        const float sinA = std::sin(pose.rotation) * pose.scale;
+        auto apply = [&](const PointF& point) {
+            float x = point.x - cx;
+            float y = point.y - cy;
+            return PointF(cx + x * cosA - y * sinA + pose.position.x, cy + x * sinA + y * cosA + pose.position.y);
+        };
+        for (auto& shape : shapes) {
+            shape.path.transform(apply);
+        }
+        text.transform(apply);
+    }
+
+    void translate(float dx, float dy) {
+        for (auto& shape : shapes) {
+            shape.path.translate(dx, dy);
+        }
+        text.translate(dx, dy);
+    }
+};
+
+// Maps the annotation types used around the app onto drawable shapes.
+// Unknown types with several points are drawn as a freehand stroke.
+AnnotationGeometry buildAnnotationGeometry(const ScreenWriter::Annotation& annotation) {
+    AnnotationGeometry geometry;
+    const auto& points = annotation.points;
+    const auto& properties = annotation.shapeProps;
+    const std::string& type = annotation.type;
+    if (points.empty()) {
+        return geometry;
+    }
+
+    if (type == "text" || !annotation.text.empty()) {
+        const FontProperties& font = annotation.textProps.font;
+        const float lineHeight = font.size * font.lineHeight;
+        std::vector<std::string> lines = wrapText(annotation.text, font,
+                                                  static_cast<float>(annotation.textProps.maxWidth));
+        for (size_t i = 0; i < lines.size(); ++i) {
+            addTextLine(geometry.text, lines[i], static_cast<float>(points[0].x),
+                        points[0].y + i * lineHeight, font);
+        }
+        return geometry;
+    }
+
+    auto add = [&geometry, &properties](RasterPath path, bool fillable, bool roundCaps) {
+        geometry.shapes.push_back({std::move(path), properties, fillable, roundCaps});
+    };
+
+    RasterPath path;
+    if (type == "click" || points.size() == 1) {
+        // A dot where the click landed
+        const float radius = std::max(6.0f, properties.strokeWidth * 3.0f);
+        path.addEllipse(static_cast<float>(points[0].x), static_cast<float>(points[0].y), radius, radius);
+        add(std::move(path), true, false);
+    } else if (type == "drag" || type == "rectangle" || type == "highlight") {
+        float x = static_cast<float>(std::min(points[0].x, points[1].x));
+        float y = static_cast<float>(std::min(points[0].y, points[1].y));
+        float width = static_cast<float>(std::abs(points[1].x - points[0].x));
+        float height = static_cast<float>(std::abs(points[1].y - points[0].y));
+        if (properties.cornerRadius > 0.0f) {
+            path.addRoundedRect(x, y, width, height, properties.cornerRadius);
+        } else {
+            path.addRect(x, y, width, height);
+        }
+        add(std::move(path), true, false);
+    } else if (type == "circle") {
+        float radius = points[0].distanceTo(points[1]);
+        path.addEllipse(static_cast<float>(points[0].x), static_cast<float>(points[0].y), radius, radius);
+        add(std::move(path), true, false);
+    } else if (type == "ellipse") {
+        path.addEllipse((points[0].x + points[1].x) * 0.5f, (points[0].y + points[1].y) * 0.5f,
+                        std::abs(points[1].x - points[0].x) * 0.5f, std::abs(points[1].y - points[0].y) * 0.5f);
+        add(std::move(path), true, false);
+    } else if (type == "arrow") {
+        const PointF start = toPointF(points[0]);
+        const PointF end = toPointF(points[1]);
+        float length = points[0].distanceTo(points[1]);
+        if (length <= 0.0f) {
+            return geometry;
+        }
+        float headSize = std::min(std::max(10.0f, properties.strokeWidth * 4.0f), length);
+        float ux = (end.x - start.x) / length;
+        float uy = (end.y - start.y) / length;
+        PointF base(end.x - ux * headSize, end.y - uy * headSize);
+        path.moveTo(start.x, start.y);
+        path.lineTo(base.x, base.y);
+        add(std::move(path), false, false);
+
+        float halfBase = headSize * 0.5f;
+        RasterPath head;
+        head.addPolygon({end,
+                         PointF(base.x - uy * halfBase, base.y + ux * halfBase),
+                         PointF(base.x + uy * halfBase, base.y - ux * halfBase)}, true);
+        ShapeProperties headProperties = properties;
+        headProperties.filled = true;
+        headProperties.fillColor = properties.strokeColor;
+        headProperties.strokeWidth = 0.0f;
+        geometry.shapes.push_back({std::move(head), headProperties, true, false});
+    } else {
+        std::vector<PointF> vertices;
+        vertices.reserve(points.size());
+        for (const auto& point : points) {
+            vertices.push_back(toPointF(point));
+        }
+        const bool polygon = type == "polygon" && points.size() >= 3;
+        path.addPolygon(vertices, polygon);
+        add(std::move(path), polygon, !polygon);
+    }
+    return geometry;
+}
+
+} // namespace
+
 // Color static members
 const Color Color::BLACK(0, 0, 0);
 const Color Color::WHITE(255, 255, 255);
@@ -136,12 +438,34 @@ Utils::Rectangle DrawingContext::Transform::apply(const Utils::Rectangle& rect)
 }
 
 // Animation methods
+float applyEasing(Easing easing, float t) {
+    t = std::clamp(t, 0.0f, 1.0f);
+    switch (easing) {
+        case Easing::LINEAR:
+            return t;
+        case Easing::EASE_IN:
+            return t * t * t;
+        case Easing::EASE_OUT: {
+            float inverse = 1.0f - t;
+            return 1.0f - inverse * inverse * inverse;
+        }
+        case Easing::EASE_IN_OUT:
+            if (t < 0.5f) {
+                return 4.0f * t * t * t;
+            } else {
+                float inverse = 2.0f - 2.0f * t;
+                return 1.0f - 0.5f * inverse * inverse * inverse;
+            }
+        case Easing::STEP:
+            return t < 1.0f ? 0.0f : 1.0f;
+    }
+    return t;
+}
+
 void Animation::addKeyframe(const AnimationKeyframe& keyframe) {
-    m_keyframes.push_back(keyframe);
-    std::sort(m_keyframes.begin(), m_keyframes.end(),
-              [](const AnimationKeyframe& a, const AnimationKeyframe& b) {
-                  return a.time < b.time;
-              });
+    auto position = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), keyframe.time,
+                                     [](float time, const AnimationKeyframe& other) { return time < other.time; });
+    m_keyframes.insert(position, keyframe);
 }
 
 AnimationKeyframe Animation::interpolate(float time) const {
@@ -149,35 +473,44 @@ AnimationKeyframe Animation::interpolate(float time) const {
         return AnimationKeyframe{};
     }
     
-    if (m_keyframes.size() == 1 || time <= 0.0f) {
+    if (m_keyframes.size() == 1 || time <= m_keyframes.front().time) {
         return m_keyframes.front();
     }
     
-    if (time >= 1.0f) {
+    if (time >= m_keyframes.back().time) {
         return m_keyframes.back();
     }
     
-    // Find the two keyframes to interpolate between
-    for (size_t i = 0; i < m_keyframes.size() - 1; ++i) {
-        if (time >= m_keyframes[i].time && time <= m_keyframes[i + 1].time) {
-            const auto& k1 = m_keyframes[i];
-            const auto& k2 = m_keyframes[i + 1];
-            
-            float t = (time - k1.time) / (k2.time - k1.time);
-            
-            AnimationKeyframe result;
-            result.time = time;
-            result.position.x = static_cast<int>(k1.position.x + t * (k2.position.x - k1.position.x));
-            result.position.y = static_cast<int>(k1.position.y + t * (k2.position.y - k1.position.y));
-            result.opacity = k1.opacity + t * (k2.opacity - k1.opacity);
-            result.scale = k1.scale + t * (k2.scale - k1.scale);
-            result.rotation = k1.rotation + t * (k2.rotation - k1.rotation);
-            
-            return result;
+    // Playback mostly moves forward, so try the last segment and its successor first
+    size_t segment = m_segmentHint.load(std::memory_order_relaxed);
+    const size_t last = m_keyframes.size() - 1;
+    auto inSegment = [this, time](size_t i) {
+        return i < m_keyframes.size() - 1 && m_keyframes[i].time <= time && time < m_keyframes[i + 1].time;
+    };
+    if (!inSegment(segment)) {
+        if (inSegment(segment + 1)) {
+            ++segment;
+        } else {
+            auto next = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time,
+                                         [](float value, const AnimationKeyframe& other) { return value < other.time; });
+            segment = std::min(static_cast<size_t>(next - m_keyframes.begin()), last) - 1;
         }
+        m_segmentHint.store(segment, std::memory_order_relaxed);
     }
     
-    return m_keyframes.back();
+    const auto& k1 = m_keyframes[segment];
+    const auto& k2 = m_keyframes[segment + 1];
+    float t = applyEasing(k1.easing, (time - k1.time) / (k2.time - k1.time));
+    
+    AnimationKeyframe result;
+    result.time = time;
+    result.position.x = static_cast<int>(k1.position.x + t * (k2.position.x - k1.position.x));
+    result.position.y = static_cast<int>(k1.position.y + t * (k2.position.y - k1.position.y));
+    result.opacity = k1.opacity + t * (k2.opacity - k1.opacity);
+    result.scale = k1.scale + t * (k2.scale - k1.scale);
+    result.rotation = k1.rotation + t * (k2.rotation - k1.rotation);
+    result.easing = k1.easing;
+    return result;
 }
 
 bool Animation::isFinished(float currentTime) const {
@@ -189,6 +522,10 @@ struct ScreenWriter::Impl {
     // Canvas and rendering state
     Utils::Size canvasSize;
     bool hasCanvas = false;
+    RasterSurface canvas; // layers flattened over the background, built on demand
+    bool canvasStale = true;
+    PremultipliedColor background;
+    Rasterizer rasterizer{canvas}; // keeps its scratch buffers between draws
     
     // Layer management
     struct Layer {
@@ -197,34 +534,252 @@ struct ScreenWriter::Impl {
         float opacity = 1.0f;
         bool visible = true;
         std::vector<int> objects;
+        TiledSurface surface; // what has been drawn on this layer
     };
     
     std::vector<Layer> layers;
     int activeLayerId = 0;
     int nextLayerId = 1;
+    LayerCompositor compositor;
+    
+    // Drawing runs on the caller's thread, compositing on the pipeline's
+    std::mutex renderMutex;
     
     // Annotation management
     std::vector<ScreenWriter::Annotation> annotations;
     int nextAnnotationId = 1;
+    
+    // Retained display list: each annotation is rasterized once into a sprite,
+    // and sprites are blitted into annotationSurface only where something changed
+    struct AnnotationSprite {
+        int id;
+        bool visible;
+        Utils::Rectangle bounds; // canvas space, empty when nothing would show
+        RasterSurface pixels;
+        bool clipped = false;    // bounds were cut by the canvas edge
+        bool posed = false;      // drawn with `pose` from an animation
+        AnimationKeyframe pose{};
+    };
+    
+    std::vector<AnnotationSprite> sprites; // same order as annotations
+    Utils::SpatialGrid<int> annotationIndex; // ids of visible sprites by bounds
+    TiledSurface annotationSurface;        // composited above every layer
+    std::vector<Utils::Rectangle> annotationDamage;
+    std::vector<int> hits; // query scratch
     std::vector<ScreenWriter::Annotation> undoStack;
     std::vector<ScreenWriter::Annotation> redoStack;
     
-    // Animation management
-    std::map<int, Animation> activeAnimations;
+    // Animation management; animated annotations are re-posed each update
+    AnimationBatch animations;
     std::chrono::steady_clock::time_point lastAnimationUpdate;
     
     // Render statistics
     ScreenWriter::RenderStats renderStats;
     std::chrono::steady_clock::time_point lastStatsReset;
     
-    void logOperation(const std::string& operation) {
-        std::cout << "[ScreenWriter] " << operation << std::endl;
+    // Layers are appended with increasing ids, so the list is sorted by id
+    Layer* findLayer(int layerId) {
+        auto it = std::lower_bound(layers.begin(), layers.end(), layerId,
+                                   [](const Layer& layer, int id) { return layer.id < id; });
+        return (it != layers.end() && it->id == layerId) ? &(*it) : nullptr;
     }
     
-    Layer* findLayer(int layerId) {
-        auto it = std::find_if(layers.begin(), layers.end(),
-                              [layerId](const Layer& layer) { return layer.id == layerId; });
-        return (it != layers.end()) ? &(*it) : nullptr;
+    // The helpers below expect renderMutex to be held
+    void updateCompositor() {
+        flushAnnotations();
+        std::vector<LayerCompositor::LayerRef> refs;
+        refs.reserve(layers.size() + 1);
+        for (auto& layer : layers) {
+            refs.push_back({&layer.surface, layer.opacity, layer.visible});
+        }
+        refs.push_back({&annotationSurface, 1.0f, true});
+        compositor.update(refs);
+    }
+    
+    void rasterizeAnnotation(const ScreenWriter::Annotation& annotation, AnnotationSprite& sprite) {
+        sprite.id = annotation.id;
+        sprite.visible = annotation.visible;
+        sprite.bounds = Utils::Rectangle();
+        sprite.pixels.release();
+        if (!hasCanvas) {
+            return; // rebuilt once a canvas exists
+        }
+        
+        AnnotationGeometry geometry = buildAnnotationGeometry(annotation);
+        float scale = 1.0f;
+        float opacity = 1.0f;
+        if (sprite.posed) {
+            geometry.applyPose(sprite.pose, geometry.bounds(annotation));
+            scale = sprite.pose.scale;
+            opacity = sprite.pose.opacity;
+        }
+        
+        Utils::Rectangle full = geometry.bounds(annotation, scale);
+        Utils::Rectangle bounds = full.intersection(annotationSurface.bounds());
+        sprite.clipped = bounds != full;
+        if (bounds.isEmpty() || opacity <= 0.0f || !sprite.pixels.resize(bounds.width, bounds.height)) {
+            return;
+        }
+        geometry.translate(static_cast<float>(-bounds.x), static_cast<float>(-bounds.y));
+        
+        rasterizer.setTarget(sprite.pixels);
+        rasterizer.setAntiAliasing(true);
+        Utils::Rectangle touched;
+        for (const auto& shape : geometry.shapes) {
+            touched = touched.united(paintPath(rasterizer, shape.path, shape.properties, shape.fillable,
+                                               shape.roundCaps, scale, scale, shape.properties.opacity * opacity));
+        }
+        if (!geometry.text.isEmpty()) {
+            touched = touched.united(paintText(rasterizer, geometry.text, annotation.textProps, scale, scale,
+                                               opacity));
+        }
+        
+        if (touched.isEmpty()) {
+            sprite.pixels.release();
+        } else {
+            sprite.bounds = bounds;
+        }
+    }
+    
+    // Annotations only ever get appended with a fresh id, so both lists stay sorted by id
+    std::vector<ScreenWriter::Annotation>::iterator findAnnotation(int id) {
+        auto it = std::lower_bound(annotations.begin(), annotations.end(), id,
+                                   [](const ScreenWriter::Annotation& annotation, int value) {
+                                       return annotation.id < value;
+                                   });
+        return (it != annotations.end() && it->id == id) ? it : annotations.end();
+    }
+    
+    const AnnotationSprite* findSprite(int id) const {
+        auto it = std::lower_bound(sprites.begin(), sprites.end(), id,
+                                   [](const AnnotationSprite& sprite, int value) { return sprite.id < value; });
+        return (it != sprites.end() && it->id == id) ? &(*it) : nullptr;
+    }
+    
+    void indexSprite(const AnnotationSprite& sprite) {
+        if (sprite.visible && !sprite.bounds.isEmpty()) {
+            annotationIndex.insert(sprite.id, sprite.bounds);
+        } else {
+            annotationIndex.remove(sprite.id);
+        }
+    }
+    
+    void damageSprite(const AnnotationSprite& sprite) {
+        if (!sprite.visible || sprite.bounds.isEmpty()) {
+            return;
+        }
+        // Nobody may be compositing yet; keep the list short
+        if (annotationDamage.size() >= 64) {
+            Utils::Rectangle merged;
+            for (const auto& rect : annotationDamage) {
+                merged = merged.united(rect);
+            }
+            annotationDamage.assign(1, merged);
+        }
+        annotationDamage.push_back(sprite.bounds);
+    }
+    
+    // Moves are a blit of the cached sprite; anything else re-rasterizes it
+    void poseAnnotation(int id, const AnimationKeyframe& pose) {
+        auto annotation = findAnnotation(id);
+        if (annotation == annotations.end()) {
+            return; // not an annotation, nothing to draw
+        }
+        AnnotationSprite& sprite = sprites[annotation - annotations.begin()];
+        
+        const bool sameShape = sprite.posed && sprite.pose.opacity == pose.opacity &&
+                               sprite.pose.scale == pose.scale && sprite.pose.rotation == pose.rotation;
+        if (sameShape) {
+            Utils::Point delta = pose.position - sprite.pose.position;
+            if (delta == Utils::Point()) {
+                return;
+            }
+            Utils::Rectangle moved = sprite.bounds.translated(delta);
+            if (!sprite.clipped && !sprite.bounds.isEmpty() && annotationSurface.bounds().contains(moved)) {
+                damageSprite(sprite);
+                sprite.bounds = moved;
+                sprite.pose = pose;
+                damageSprite(sprite);
+                indexSprite(sprite);
+                return;
+            }
+        }
+        
+        damageSprite(sprite);
+        sprite.posed = true;
+        sprite.pose = pose;
+        rasterizeAnnotation(*annotation, sprite);
+        damageSprite(sprite);
+        indexSprite(sprite);
+    }
+    
+    void unposeAnnotation(int id) {
+        auto annotation = findAnnotation(id);
+        if (annotation == annotations.end()) {
+            return;
+        }
+        AnnotationSprite& sprite = sprites[annotation - annotations.begin()];
+        if (sprite.posed) {
+            damageSprite(sprite);
+            sprite.posed = false;
+            rasterizeAnnotation(*annotation, sprite);
+            damageSprite(sprite);
+            indexSprite(sprite);
+        }
+    }
+    
+    void rebuildSprites() {
+        annotationDamage.push_back(annotationSurface.bounds());
+        sprites.resize(annotations.size());
+        annotationIndex.clear();
+        for (size_t i = 0; i < annotations.size(); ++i) {
+            rasterizeAnnotation(annotations[i], sprites[i]);
+            indexSprite(sprites[i]);
+        }
+    }
+    
+    // Re-blits the cached sprites over damaged tiles only; nothing is re-rasterized
+    void flushAnnotations() {
+        if (annotationDamage.empty()) {
+            return;
+        }
+        for (int tile = 0; tile < annotationSurface.tileCount(); ++tile) {
+            const Utils::Rectangle rect = annotationSurface.tileRect(tile);
+            bool damaged = false;
+            for (size_t i = 0; i < annotationDamage.size() && !damaged; ++i) {
+                damaged = annotationDamage[i].intersects(rect);
+            }
+            if (!damaged) {
+                continue;
+            }
+            
+            annotationSurface.releaseTile(tile);
+            annotationSurface.markDirty(tile);
+            
+            // Blend in display order, which is id order
+            hits.clear();
+            annotationIndex.queryRect(rect, [this](int id, const Utils::Rectangle&) { hits.push_back(id); });
+            std::sort(hits.begin(), hits.end());
+            for (int id : hits) {
+                const AnnotationSprite* sprite = findSprite(id);
+                annotationSurface.blendSurface(sprite->pixels, sprite->bounds.x, sprite->bounds.y, rect);
+            }
+        }
+        annotationDamage.clear();
+        canvasStale = true;
+    }
+    
+    void updateMemoryUsage() {
+        size_t bytes = canvas.stride() * canvas.height() + compositor.overlay().memoryUsage() +
+                       annotationSurface.memoryUsage();
+        for (const auto& layer : layers) {
+            bytes += layer.surface.memoryUsage();
+        }
+        for (const auto& sprite : sprites) {
+            bytes += sprite.pixels.stride() * sprite.pixels.height();
+        }
+        renderStats.memoryUsage = static_cast<int>(bytes);
+        renderStats.layerCount = static_cast<int>(layers.size());
     }
 };
 
@@ -235,60 +790,70 @@ ScreenWriter::ScreenWriter()
     , m_realTimeDrawing(false) {
     
     // Initialize default layer
-    m_impl->layers.push_back({0, "Default", 1.0f, true, {}});
+    m_impl->layers.push_back({0, "Default", 1.0f, true, {}, {}});
     m_impl->lastAnimationUpdate = std::chrono::steady_clock::now();
     m_impl->lastStatsReset = std::chrono::steady_clock::now();
     
-    std::cout << "[ScreenWriter] Created" << std::endl;
+    RECORDIFY_LOG_INFO("ScreenWriter", "Created");
 }
 
 ScreenWriter::~ScreenWriter() {
     shutdown();
-    std::cout << "[ScreenWriter] Destroyed" << std::endl;
+    RECORDIFY_LOG_INFO("ScreenWriter", "Destroyed");
 }
 
 bool ScreenWriter::initialize() {
     if (m_initialized) {
-        m_impl->logOperation("Already initialized");
+        RECORDIFY_LOG_INFO("ScreenWriter", "Already initialized");
         return true;
     }
     
-    m_impl->logOperation("Initializing...");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Initializing...");
     
     // Initialize platform-specific rendering context
     // This would include setting up DirectX, OpenGL, or software rendering
     
     m_initialized = true;
-    m_impl->logOperation("Initialization completed successfully");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Initialization completed successfully");
     return true;
 }
 
 void ScreenWriter::shutdown() {
     if (!m_initialized) return;
     
-    m_impl->logOperation("Shutting down...");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Shutting down...");
     
     stopRealTimeDrawing();
     disableOverlay();
     clearAnnotations();
     
     m_initialized = false;
-    m_impl->logOperation("Shutdown completed");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Shutdown completed");
 }
 
 bool ScreenWriter::createCanvas(const Utils::Size& size) {
-    m_impl->logOperation("Creating canvas: " + std::to_string(size.width) + "x" + std::to_string(size.height));
+    RECORDIFY_LOG_INFO("ScreenWriter", "Creating canvas: ", size.width, "x", size.height);
     
     if (size.isEmpty()) {
-        m_impl->logOperation("Invalid canvas size");
+        RECORDIFY_LOG_WARN("ScreenWriter", "Invalid canvas size");
         return false;
     }
     
-    m_impl->canvasSize = size;
-    m_impl->hasCanvas = true;
-    
-    // Initialize rendering surface
-    // Platform-specific implementation would go here
+    {
+        std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+        if (!m_impl->canvas.resize(size.width, size.height)) {
+            RECORDIFY_LOG_WARN("ScreenWriter", "Failed to allocate canvas");
+            return false;
+        }
+        for (auto& layer : m_impl->layers) {
+            layer.surface.resize(size.width, size.height);
+        }
+        m_impl->annotationSurface.resize(size.width, size.height);
+        m_impl->compositor.resize(size.width, size.height);
+        m_impl->canvasSize = size;
+        m_impl->hasCanvas = true;
+        m_impl->rebuildSprites();
+    }
     
     clearCanvas();
     return true;
@@ -299,28 +864,115 @@ bool ScreenWriter::resizeCanvas(const Utils::Size& newSize) {
         return createCanvas(newSize);
     }
     
-    m_impl->logOperation("Resizing canvas from " + std::to_string(m_impl->canvasSize.width) + "x" + 
-                        std::to_string(m_impl->canvasSize.height) + " to " + 
-                        std::to_string(newSize.width) + "x" + std::to_string(newSize.height));
+    RECORDIFY_LOG_INFO("ScreenWriter", "Resizing canvas from ", m_impl->canvasSize.width, "x",
+                       m_impl->canvasSize.height, " to ", newSize.width, "x", newSize.height);
     
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    if (!m_impl->canvas.resize(newSize.width, newSize.height)) {
+        RECORDIFY_LOG_WARN("ScreenWriter", "Invalid canvas size");
+        return false;
+    }
+    
+    // Layer tiles are anchored at the origin, so the overlapping area survives
+    for (auto& layer : m_impl->layers) {
+        layer.surface.resize(newSize.width, newSize.height);
+    }
+    m_impl->annotationSurface.resize(newSize.width, newSize.height);
+    m_impl->compositor.resize(newSize.width, newSize.height);
     m_impl->canvasSize = newSize;
+    m_impl->rebuildSprites(); // sprites are clipped to the canvas
+    m_impl->canvasStale = true;
+    m_impl->updateMemoryUsage();
     return true;
 }
 
 void ScreenWriter::clearCanvas(const Color& backgroundColor) {
-    m_impl->logOperation("Clearing canvas with color " + backgroundColor.toHex());
+    RECORDIFY_LOG_INFO("ScreenWriter", "Clearing canvas with color ", backgroundColor.toHex());
     
     if (!m_impl->hasCanvas) {
-        m_impl->logOperation("No canvas to clear");
+        RECORDIFY_LOG_WARN("ScreenWriter", "No canvas to clear");
         return;
     }
     
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    
     // Clear all layers and annotations
     for (auto& layer : m_impl->layers) {
         layer.objects.clear();
+        layer.surface.clear();
     }
     
-    // Platform-specific canvas clearing would go here
+    m_impl->background = toPremultiplied(backgroundColor, 1.0f);
+    m_impl->canvasStale = true;
+    m_impl->updateMemoryUsage();
+}
+
+RasterSurface ScreenWriter::getCanvas() const {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    m_impl->updateCompositor();
+    if (m_impl->canvasStale) {
+        m_impl->canvas.clear(m_impl->background);
+        m_impl->compositor.compositeOnto(m_impl->canvas);
+        m_impl->canvasStale = false;
+    }
+    return m_impl->canvas;
+}
+
+bool ScreenWriter::compositeLayers(uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel) {
+    if (!pixels || width <= 0 || height <= 0 || (bytesPerPixel != 3 && bytesPerPixel != 4)) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    if (!m_impl->hasCanvas) {
+        return false;
+    }
+    m_impl->updateCompositor();
+    if (m_impl->compositor.isEmpty()) {
+        return true;
+    }
+    m_impl->renderStats.compositedTiles += m_impl->compositor.compositeOnto(pixels, width, height, stride,
+                                                                           bytesPerPixel);
+    return true;
+}
+
+bool ScreenWriter::compositeLayers(SparseCapture& changes) {
+    const int bytesPerPixel = changes.bytesPerPixel();
+    if (bytesPerPixel != 3 && bytesPerPixel != 4) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    if (!m_impl->hasCanvas) {
+        return false;
+    }
+    m_impl->updateCompositor();
+    if (m_impl->compositor.isEmpty()) {
+        return true;
+    }
+    for (size_t i = 0; i < changes.tiles.size(); ++i) {
+        const Utils::Rectangle& tile = changes.tiles[i];
+        m_impl->renderStats.compositedTiles +=
+            m_impl->compositor.compositeOnto(changes.pixelData.data() + changes.tileOffsets[i], tile,
+                                             static_cast<size_t>(tile.width) * bytesPerPixel, bytesPerPixel);
+    }
+    return true;
+}
+
+std::vector<Utils::Rectangle> ScreenWriter::getAnnotatedTiles() const {
+    std::vector<Utils::Rectangle> tiles;
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    if (!m_impl->hasCanvas) {
+        return tiles;
+    }
+    m_impl->updateCompositor();
+    const TiledSurface& overlay = m_impl->compositor.overlay();
+    for (int tile = 0; tile < overlay.tileCount(); ++tile) {
+        if (overlay.hasTile(tile)) {
+            tiles.push_back(overlay.tileRect(tile));
+        }
+    }
+    return tiles;
 }
 
 // Layer management
@@ -328,24 +980,31 @@ int ScreenWriter::createLayer(const std::string& name) {
     int layerId = m_impl->nextLayerId++;
     std::string layerName = name.empty() ? ("Layer " + std::to_string(layerId)) : name;
     
-    m_impl->logOperation("Creating layer: " + layerName + " (ID: " + std::to_string(layerId) + ")");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Creating layer: ", layerName, " (ID: ", layerId, ")");
     
-    m_impl->layers.push_back({layerId, layerName, 1.0f, true, {}});
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    m_impl->layers.push_back({layerId, layerName, 1.0f, true, {}, {}});
+    if (m_impl->hasCanvas) {
+        m_impl->layers.back().surface.resize(m_impl->canvasSize.width, m_impl->canvasSize.height);
+    }
     return layerId;
 }
 
 bool ScreenWriter::removeLayer(int layerId) {
     if (layerId == 0) {
-        m_impl->logOperation("Cannot remove default layer");
+        RECORDIFY_LOG_WARN("ScreenWriter", "Cannot remove default layer");
         return false;
     }
     
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
     auto it = std::find_if(m_impl->layers.begin(), m_impl->layers.end(),
                           [layerId](const Impl::Layer& layer) { return layer.id == layerId; });
     
     if (it != m_impl->layers.end()) {
-        m_impl->logOperation("Removing layer ID: " + std::to_string(layerId));
+        RECORDIFY_LOG_INFO("ScreenWriter", "Removing layer ID: ", layerId);
         m_impl->layers.erase(it);
+        m_impl->compositor.invalidate();
+        m_impl->canvasStale = true;
         
         if (m_impl->activeLayerId == layerId) {
             m_impl->activeLayerId = 0; // Reset to default layer
@@ -353,44 +1012,55 @@ bool ScreenWriter::removeLayer(int layerId) {
         return true;
     }
     
-    m_impl->logOperation("Layer not found: " + std::to_string(layerId));
+    RECORDIFY_LOG_WARN("ScreenWriter", "Layer not found: ", layerId);
     return false;
 }
 
 bool ScreenWriter::setActiveLayer(int layerId) {
     auto* layer = m_impl->findLayer(layerId);
     if (layer) {
-        m_impl->logOperation("Setting active layer to: " + std::to_string(layerId));
+        RECORDIFY_LOG_INFO("ScreenWriter", "Setting active layer to: ", layerId);
         m_impl->activeLayerId = layerId;
         return true;
     }
     
-    m_impl->logOperation("Layer not found: " + std::to_string(layerId));
+    RECORDIFY_LOG_WARN("ScreenWriter", "Layer not found: ", layerId);
     return false;
 }
 
 bool ScreenWriter::setLayerOpacity(int layerId, float opacity) {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
     auto* layer = m_impl->findLayer(layerId);
     if (layer) {
         opacity = std::clamp(opacity, 0.0f, 1.0f);
-        m_impl->logOperation("Setting layer " + std::to_string(layerId) + " opacity to: " + std::to_string(opacity));
-        layer->opacity = opacity;
+        RECORDIFY_LOG_INFO("ScreenWriter", "Setting layer ", layerId, " opacity to: ", opacity);
+        if (layer->opacity != opacity) {
+            layer->opacity = opacity;
+            layer->surface.markOccupiedDirty();
+            m_impl->canvasStale = true;
+        }
         return true;
     }
     return false;
 }
 
 bool ScreenWriter::setLayerVisible(int layerId, bool visible) {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
     auto* layer = m_impl->findLayer(layerId);
     if (layer) {
-        m_impl->logOperation("Setting layer " + std::to_string(layerId) + " visibility to: " + (visible ? "true" : "false"));
-        layer->visible = visible;
+        RECORDIFY_LOG_INFO("ScreenWriter", "Setting layer ", layerId, " visibility to: ", visible);
+        if (layer->visible != visible) {
+            layer->visible = visible;
+            layer->surface.markOccupiedDirty();
+            m_impl->canvasStale = true;
+        }
         return true;
     }
     return false;
 }
 
 std::vector<int> ScreenWriter::getLayerIds() const {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
     std::vector<int> ids;
     for (const auto& layer : m_impl->layers) {
         ids.push_back(layer.id);
@@ -401,139 +1071,388 @@ std::vector<int> ScreenWriter::getLayerIds() const {
 // Drawing context management
 void ScreenWriter::pushContext() {
     m_contextStack.push_back(m_currentContext);
-    m_impl->logOperation("Pushed drawing context (stack size: " + std::to_string(m_contextStack.size()) + ")");
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Pushed drawing context (stack size: ", m_contextStack.size(), ")");
 }
 
 void ScreenWriter::popContext() {
     if (!m_contextStack.empty()) {
         m_currentContext = m_contextStack.back();
         m_contextStack.pop_back();
-        m_impl->logOperation("Popped drawing context (stack size: " + std::to_string(m_contextStack.size()) + ")");
+        RECORDIFY_LOG_DEBUG("ScreenWriter", "Popped drawing context (stack size: ",
+                            m_contextStack.size(), ")");
     } else {
-        m_impl->logOperation("Context stack is empty, cannot pop");
+        RECORDIFY_LOG_WARN("ScreenWriter", "Context stack is empty, cannot pop");
     }
 }
 
 void ScreenWriter::setClipRect(const Utils::Rectangle& rect) {
     m_currentContext.clipRect = rect;
-    m_impl->logOperation("Set clip rect: [" + std::to_string(rect.x) + "," + std::to_string(rect.y) + "," +
-                        std::to_string(rect.width) + "," + std::to_string(rect.height) + "]");
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Set clip rect: [", rect.x, ",", rect.y, ",", rect.width, ",",
+                        rect.height, "]");
 }
 
 void ScreenWriter::clearClipRect() {
     m_currentContext.clipRect = Utils::Rectangle();
-    m_impl->logOperation("Cleared clip rect");
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Cleared clip rect");
 }
 
 void ScreenWriter::setGlobalOpacity(float opacity) {
     m_currentContext.globalOpacity = std::clamp(opacity, 0.0f, 1.0f);
-    m_impl->logOperation("Set global opacity: " + std::to_string(m_currentContext.globalOpacity));
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Set global opacity: ", m_currentContext.globalOpacity);
 }
 
 void ScreenWriter::setTransform(const DrawingContext::Transform& transform) {
     m_currentContext.transform = transform;
-    m_impl->logOperation("Set transform: scale(" + std::to_string(transform.scaleX) + "," + 
-                        std::to_string(transform.scaleY) + ") rotate(" + std::to_string(transform.rotationAngle) + 
-                        ") translate(" + std::to_string(transform.translation.x) + "," + 
-                        std::to_string(transform.translation.y) + ")");
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Set transform: scale(", transform.scaleX, ",", transform.scaleY,
+                        ") rotate(", transform.rotationAngle, ") translate(", transform.translation.x, ",",
+                        transform.translation.y, ")");
 }
 
 void ScreenWriter::resetTransform() {
     m_currentContext.transform = DrawingContext::Transform();
-    m_impl->logOperation("Reset transform to identity");
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Reset transform to identity");
 }
 
 // Text rendering
 bool ScreenWriter::drawText(const std::string& text, const Utils::Point& position, const TextProperties& properties) {
     if (!m_initialized || text.empty()) return false;
-    
-    m_impl->logOperation("Drawing text: '" + text + "' at (" + std::to_string(position.x) + "," + std::to_string(position.y) + ")");
-    
-    // Apply transform
-    Utils::Point transformedPos = m_currentContext.transform.apply(position);
-    
-    // Check clipping
-    if (!m_currentContext.clipRect.isEmpty() && !m_currentContext.clipRect.contains(transformedPos)) {
-        m_impl->logOperation("Text clipped, skipping");
+    if (!validateContext()) {
+        RECORDIFY_LOG_DEBUG("ScreenWriter", "No canvas, text not drawn");
         return false;
     }
-    
-    // Platform-specific text rendering would go here
-    notifyDrawing(transformedPos, "text");
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing text: '", text, "' at (", position.x, ",", position.y, ")");
+
+    RasterPath path;
+    const float lineHeight = properties.font.size * properties.font.lineHeight;
+    std::vector<std::string> lines = wrapText(text, properties.font, static_cast<float>(properties.maxWidth));
+    for (size_t i = 0; i < lines.size(); ++i) {
+        addTextLine(path, lines[i], static_cast<float>(position.x), position.y + i * lineHeight, properties.font);
+    }
+
+    if (renderText(path, properties, m_currentContext.clipRect).isEmpty()) {
+        RECORDIFY_LOG_DEBUG("ScreenWriter", "Text clipped, skipping");
+        return false;
+    }
+
+    notifyDrawing(m_currentContext.transform.apply(position), "text");
     updateRenderStats();
-    
+
     return true;
 }
 
 bool ScreenWriter::drawTextInRect(const std::string& text, const Utils::Rectangle& bounds, const TextProperties& properties) {
     if (!m_initialized || text.empty()) return false;
-    
-    m_impl->logOperation("Drawing text in rect: '" + text + "' in bounds [" + 
-                        std::to_string(bounds.x) + "," + std::to_string(bounds.y) + "," +
-                        std::to_string(bounds.width) + "," + std::to_string(bounds.height) + "]");
-    
-    // Apply transform
-    Utils::Rectangle transformedBounds = m_currentContext.transform.apply(bounds);
-    
-    // Platform-specific bounded text rendering would go here
-    // This would handle word wrapping, alignment, etc.
-    
+    if (!validateContext()) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing text in rect: '", text, "' in bounds [", bounds.x, ",",
+                        bounds.y, ",", bounds.width, ",", bounds.height, "]");
+
+    float maxWidth = -1.0f;
+    if (properties.wordWrap) {
+        maxWidth = static_cast<float>(properties.maxWidth > 0 ? std::min(properties.maxWidth, bounds.width)
+                                                              : bounds.width);
+    }
+
+    RasterPath path;
+    const float lineHeight = properties.font.size * properties.font.lineHeight;
+    std::vector<std::string> lines = wrapText(text, properties.font, maxWidth);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        float y = bounds.y + i * lineHeight;
+        if (y >= bounds.bottom()) {
+            break;
+        }
+
+        // JUSTIFY falls back to left alignment
+        float slack = bounds.width - RasterPath::measureText(lines[i], properties.font.size,
+                                                             properties.font.isBold(),
+                                                             properties.font.letterSpacing);
+        float x = static_cast<float>(bounds.x);
+        if (properties.alignment == TextAlignment::CENTER) {
+            x += slack * 0.5f;
+        } else if (properties.alignment == TextAlignment::RIGHT) {
+            x += slack;
+        }
+        addTextLine(path, lines[i], x, y, properties.font);
+    }
+
+    // Text never spills outside its box
+    Utils::Rectangle clip = m_currentContext.transform.apply(bounds);
+    if (!m_currentContext.clipRect.isEmpty()) {
+        clip = clip.isEmpty() ? m_currentContext.clipRect : clip.intersection(m_currentContext.clipRect);
+    }
+    renderText(path, properties, clip);
+
     updateRenderStats();
     return true;
 }
 
 // Shape drawing
+bool ScreenWriter::drawShape(ShapeType type, const std::vector<Utils::Point>& points,
+                             const ShapeProperties& properties) {
+    if (points.empty()) return false;
+
+    switch (type) {
+        case ShapeType::RECTANGLE:
+            if (points.size() < 2) return false;
+            return drawRectangle(Utils::Rectangle(std::min(points[0].x, points[1].x),
+                                                  std::min(points[0].y, points[1].y),
+                                                  std::abs(points[1].x - points[0].x),
+                                                  std::abs(points[1].y - points[0].y)), properties);
+        case ShapeType::CIRCLE:
+            if (points.size() < 2) return false;
+            return drawCircle(points[0], points[0].distanceTo(points[1]), properties);
+        case ShapeType::ELLIPSE:
+            // Two opposite corners of the bounding box
+            if (points.size() < 2) return false;
+            return drawEllipse(points[0].midpoint(points[1]),
+                               std::abs(points[1].x - points[0].x) * 0.5f,
+                               std::abs(points[1].y - points[0].y) * 0.5f, properties);
+        case ShapeType::LINE:
+            if (points.size() < 2) return false;
+            return drawLine(points[0], points[1], properties);
+        case ShapeType::ARROW:
+            if (points.size() < 2) return false;
+            return drawArrow(points[0], points[1], std::max(10.0f, properties.strokeWidth * 4.0f), properties);
+        case ShapeType::POLYGON:
+            return drawPolygon(points, properties);
+        case ShapeType::FREEHAND:
+            return drawPolyline(points, properties);
+        case ShapeType::BEZIER_CURVE:
+            if (points.size() < 4) return drawPolyline(points, properties);
+            return drawBezierCurve(points[0], points[1], points[2], points[3], properties);
+    }
+    return false;
+}
+
 bool ScreenWriter::drawRectangle(const Utils::Rectangle& rect, const ShapeProperties& properties) {
-    if (!m_initialized) return false;
-    
-    m_impl->logOperation("Drawing rectangle: [" + std::to_string(rect.x) + "," + std::to_string(rect.y) + "," +
-                        std::to_string(rect.width) + "," + std::to_string(rect.height) + "]");
-    
-    Utils::Rectangle transformedRect = m_currentContext.transform.apply(rect);
-    
-    // Platform-specific rectangle rendering would go here
-    notifyDrawing(transformedRect.topLeft(), "rectangle");
+    if (!validateContext()) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing rectangle: [", rect.x, ",", rect.y, ",", rect.width,
+                        ",", rect.height, "]");
+
+    RasterPath path;
+    if (properties.cornerRadius > 0.0f) {
+        path.addRoundedRect(rect.x, rect.y, rect.width, rect.height, properties.cornerRadius);
+    } else {
+        path.addRect(rect.x, rect.y, rect.width, rect.height);
+    }
+    renderPath(path, properties, true, false);
+
+    notifyDrawing(m_currentContext.transform.apply(rect).topLeft(), "rectangle");
     updateRenderStats();
-    
+
+    return true;
+}
+
+bool ScreenWriter::drawRoundedRectangle(const Utils::Rectangle& rect, float radius,
+                                        const ShapeProperties& properties) {
+    if (!validateContext()) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing rounded rectangle: [", rect.x, ",", rect.y, ",",
+                        rect.width, ",", rect.height, "] radius(", radius, ")");
+
+    RasterPath path;
+    path.addRoundedRect(rect.x, rect.y, rect.width, rect.height, radius);
+    renderPath(path, properties, true, false);
+
+    notifyDrawing(m_currentContext.transform.apply(rect).topLeft(), "rectangle");
+    updateRenderStats();
+
     return true;
 }
 
 bool ScreenWriter::drawCircle(const Utils::Point& center, float radius, const ShapeProperties& properties) {
-    if (!m_initialized || radius <= 0) return false;
-    
-    m_impl->logOperation("Drawing circle: center(" + std::to_string(center.x) + "," + std::to_string(center.y) + 
-                        ") radius(" + std::to_string(radius) + ")");
-    
-    Utils::Point transformedCenter = m_currentContext.transform.apply(center);
-    
-    // Platform-specific circle rendering would go here
-    notifyDrawing(transformedCenter, "circle");
+    if (!validateContext() || radius <= 0) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing circle: center(", center.x, ",", center.y, ") radius(",
+                        radius, ")");
+
+    RasterPath path;
+    path.addEllipse(center.x, center.y, radius, radius);
+    renderPath(path, properties, true, false);
+
+    notifyDrawing(m_currentContext.transform.apply(center), "circle");
     updateRenderStats();
-    
+
+    return true;
+}
+
+bool ScreenWriter::drawEllipse(const Utils::Point& center, float radiusX, float radiusY,
+                               const ShapeProperties& properties) {
+    if (!validateContext() || radiusX <= 0 || radiusY <= 0) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing ellipse: center(", center.x, ",", center.y, ") radii(",
+                        radiusX, ",", radiusY, ")");
+
+    RasterPath path;
+    path.addEllipse(center.x, center.y, radiusX, radiusY);
+    renderPath(path, properties, true, false);
+
+    notifyDrawing(m_currentContext.transform.apply(center), "ellipse");
+    updateRenderStats();
+
     return true;
 }
 
 bool ScreenWriter::drawLine(const Utils::Point& start, const Utils::Point& end, const ShapeProperties& properties) {
-    if (!m_initialized) return false;
-    
-    m_impl->logOperation("Drawing line: (" + std::to_string(start.x) + "," + std::to_string(start.y) + 
-                        ") to (" + std::to_string(end.x) + "," + std::to_string(end.y) + ")");
-    
-    Utils::Point transformedStart = m_currentContext.transform.apply(start);
-    Utils::Point transformedEnd = m_currentContext.transform.apply(end);
-    
-    // Platform-specific line rendering would go here
-    notifyDrawing(transformedStart, "line");
+    if (!validateContext()) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing line: (", start.x, ",", start.y, ") to (", end.x, ",",
+                        end.y, ")");
+
+    RasterPath path;
+    path.moveTo(start.x, start.y);
+    path.lineTo(end.x, end.y);
+    renderPath(path, properties, false, false);
+
+    notifyDrawing(m_currentContext.transform.apply(start), "line");
     updateRenderStats();
-    
+
+    return true;
+}
+
+bool ScreenWriter::drawPolyline(const std::vector<Utils::Point>& points, const ShapeProperties& properties) {
+    if (!validateContext() || points.size() < 2) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing polyline: ", points.size(), " points");
+
+    std::vector<PointF> vertices;
+    vertices.reserve(points.size());
+    for (const auto& point : points) {
+        vertices.push_back(toPointF(point));
+    }
+
+    // Round caps so freehand strokes look like pen marks
+    RasterPath path;
+    path.addPolygon(vertices, false);
+    renderPath(path, properties, false, true);
+
+    notifyDrawing(m_currentContext.transform.apply(points.front()), "polyline");
+    updateRenderStats();
+
     return true;
 }
 
+bool ScreenWriter::drawPolygon(const std::vector<Utils::Point>& points, const ShapeProperties& properties) {
+    if (!validateContext() || points.size() < 3) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing polygon: ", points.size(), " points");
+
+    std::vector<PointF> vertices;
+    vertices.reserve(points.size());
+    for (const auto& point : points) {
+        vertices.push_back(toPointF(point));
+    }
+
+    RasterPath path;
+    path.addPolygon(vertices, true);
+    renderPath(path, properties, true, false);
+
+    notifyDrawing(m_currentContext.transform.apply(points.front()), "polygon");
+    updateRenderStats();
+
+    return true;
+}
+
+bool ScreenWriter::drawArrow(const Utils::Point& start, const Utils::Point& end, float headSize,
+                             const ShapeProperties& properties) {
+    if (!validateContext()) return false;
+
+    float length = start.distanceTo(end);
+    if (length <= 0.0f) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing arrow: (", start.x, ",", start.y, ") to (", end.x, ",",
+                        end.y, ")");
+
+    // The shaft stops at the base of the head so the tip stays sharp
+    headSize = std::min(headSize, length);
+    float ux = (end.x - start.x) / length;
+    float uy = (end.y - start.y) / length;
+    PointF base(end.x - ux * headSize, end.y - uy * headSize);
+
+    RasterPath shaft;
+    shaft.moveTo(start.x, start.y);
+    shaft.lineTo(base.x, base.y);
+    renderPath(shaft, properties, false, false);
+
+    ShapeProperties headProperties = properties;
+    headProperties.filled = true;
+    headProperties.fillColor = properties.strokeColor;
+    headProperties.strokeWidth = 0.0f;
+
+    float halfBase = headSize * 0.5f;
+    RasterPath head;
+    head.addPolygon({toPointF(end),
+                     PointF(base.x - uy * halfBase, base.y + ux * halfBase),
+                     PointF(base.x + uy * halfBase, base.y - ux * halfBase)}, true);
+    renderPath(head, headProperties, true, false);
+
+    notifyDrawing(m_currentContext.transform.apply(start), "arrow");
+    updateRenderStats();
+
+    return true;
+}
+
+bool ScreenWriter::drawBezierCurve(const Utils::Point& start, const Utils::Point& control1,
+                                   const Utils::Point& control2, const Utils::Point& end,
+                                   const ShapeProperties& properties) {
+    if (!validateContext()) return false;
+
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Drawing bezier: (", start.x, ",", start.y, ") to (", end.x, ",",
+                        end.y, ")");
+
+    RasterPath path;
+    path.moveTo(start.x, start.y);
+    path.cubicTo(toPointF(control1), toPointF(control2), toPointF(end));
+    renderPath(path, properties, false, true);
+
+    notifyDrawing(m_currentContext.transform.apply(start), "bezier");
+    updateRenderStats();
+
+    return true;
+}
+
+// Animation support
+void ScreenWriter::startAnimation(int objectId, const Animation& animation) {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Starting animation for object ", objectId, " (",
+                        animation.getKeyframes().size(), " keyframes)");
+    m_impl->animations.add(objectId, animation);
+}
+
+void ScreenWriter::stopAnimation(int objectId) {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    if (m_impl->animations.remove(objectId)) {
+        RECORDIFY_LOG_DEBUG("ScreenWriter", "Stopped animation for object ", objectId);
+    }
+    m_impl->unposeAnnotation(objectId);
+}
+
+void ScreenWriter::updateAnimations(float deltaTime) {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    m_impl->lastAnimationUpdate = std::chrono::steady_clock::now();
+    if (m_impl->animations.empty()) {
+        return;
+    }
+    
+    // Finished animations leave their object at the final keyframe
+    std::vector<int> finished;
+    m_impl->animations.advance(deltaTime, finished);
+    const auto& ids = m_impl->animations.getObjectIds();
+    for (size_t i = 0; i < ids.size(); ++i) {
+        m_impl->poseAnnotation(ids[i], m_impl->animations.getStateAt(i));
+    }
+    for (int id : finished) {
+        RECORDIFY_LOG_DEBUG("ScreenWriter", "Animation finished for object ", id);
+    }
+}
+
 // Overlay operations
 bool ScreenWriter::enableOverlay() {
     if (m_overlayEnabled) return true;
     
-    m_impl->logOperation("Enabling screen overlay");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Enabling screen overlay");
     
     // Platform-specific overlay initialization would go here
     // This would create a transparent window that covers the screen
@@ -545,7 +1464,7 @@ bool ScreenWriter::enableOverlay() {
 bool ScreenWriter::disableOverlay() {
     if (!m_overlayEnabled) return true;
     
-    m_impl->logOperation("Disabling screen overlay");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Disabling screen overlay");
     
     // Platform-specific overlay cleanup would go here
     
@@ -556,10 +1475,10 @@ bool ScreenWriter::disableOverlay() {
 bool ScreenWriter::startRealTimeDrawing() {
     if (m_realTimeDrawing) return true;
     
-    m_impl->logOperation("Starting real-time drawing mode");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Starting real-time drawing mode");
     
     if (!enableOverlay()) {
-        m_impl->logOperation("Failed to enable overlay for real-time drawing");
+        RECORDIFY_LOG_WARN("ScreenWriter", "Failed to enable overlay for real-time drawing");
         return false;
     }
     
@@ -570,7 +1489,7 @@ bool ScreenWriter::startRealTimeDrawing() {
 bool ScreenWriter::stopRealTimeDrawing() {
     if (!m_realTimeDrawing) return true;
     
-    m_impl->logOperation("Stopping real-time drawing mode");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Stopping real-time drawing mode");
     
     m_realTimeDrawing = false;
     return true;
@@ -579,39 +1498,109 @@ bool ScreenWriter::stopRealTimeDrawing() {
 // Annotation management
 int ScreenWriter::addAnnotation(const Annotation& annotation) {
     Annotation newAnnotation = annotation;
-    newAnnotation.id = m_impl->nextAnnotationId++;
-    newAnnotation.timestamp = std::chrono::steady_clock::now();
     
-    m_impl->annotations.push_back(newAnnotation);
-    m_impl->undoStack.push_back(newAnnotation);
-    m_impl->redoStack.clear(); // Clear redo stack on new action
+    {
+        std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+        newAnnotation.id = m_impl->nextAnnotationId++;
+        newAnnotation.timestamp = std::chrono::steady_clock::now();
+        
+        Impl::AnnotationSprite sprite;
+        m_impl->rasterizeAnnotation(newAnnotation, sprite);
+        m_impl->damageSprite(sprite);
+        m_impl->indexSprite(sprite);
+        m_impl->sprites.push_back(std::move(sprite));
+        
+        m_impl->annotations.push_back(newAnnotation);
+        m_impl->undoStack.push_back(newAnnotation);
+        m_impl->redoStack.clear(); // Clear redo stack on new action
+    }
     
-    m_impl->logOperation("Added annotation ID: " + std::to_string(newAnnotation.id));
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Added annotation ID: ", newAnnotation.id);
     notifyAnnotation(newAnnotation);
     
     return newAnnotation.id;
 }
 
 bool ScreenWriter::removeAnnotation(int annotationId) {
-    auto it = std::find_if(m_impl->annotations.begin(), m_impl->annotations.end(),
-                          [annotationId](const Annotation& ann) { return ann.id == annotationId; });
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    auto it = m_impl->findAnnotation(annotationId);
     
     if (it != m_impl->annotations.end()) {
-        m_impl->logOperation("Removing annotation ID: " + std::to_string(annotationId));
+        RECORDIFY_LOG_INFO("ScreenWriter", "Removing annotation ID: ", annotationId);
+        auto sprite = m_impl->sprites.begin() + (it - m_impl->annotations.begin());
+        m_impl->damageSprite(*sprite);
+        m_impl->annotationIndex.remove(annotationId);
+        m_impl->animations.remove(annotationId);
+        m_impl->sprites.erase(sprite);
         m_impl->annotations.erase(it);
         return true;
     }
     
-    m_impl->logOperation("Annotation not found: " + std::to_string(annotationId));
+    RECORDIFY_LOG_WARN("ScreenWriter", "Annotation not found: ", annotationId);
     return false;
 }
 
+bool ScreenWriter::updateAnnotation(int annotationId, const Annotation& newAnnotation) {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    auto it = m_impl->findAnnotation(annotationId);
+    
+    if (it == m_impl->annotations.end()) {
+        RECORDIFY_LOG_WARN("ScreenWriter", "Annotation not found: ", annotationId);
+        return false;
+    }
+    
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Updating annotation ID: ", annotationId);
+    auto& sprite = m_impl->sprites[it - m_impl->annotations.begin()];
+    m_impl->damageSprite(sprite);
+    
+    // Identity and creation time stay with the original
+    const auto timestamp = it->timestamp;
+    *it = newAnnotation;
+    it->id = annotationId;
+    it->timestamp = timestamp;
+    m_impl->rasterizeAnnotation(*it, sprite);
+    m_impl->damageSprite(sprite);
+    m_impl->indexSprite(sprite);
+    return true;
+}
+
+int ScreenWriter::getAnnotationAt(const Utils::Point& point) const {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    
+    // Topmost wins: the most recently added annotation whose pixels cover the point
+    int best = 0;
+    m_impl->annotationIndex.queryPoint(point, [this, &point, &best](int id, const Utils::Rectangle& bounds) {
+        if (id <= best) {
+            return;
+        }
+        const Impl::AnnotationSprite* sprite = m_impl->findSprite(id);
+        if (sprite->pixels.pixel(point.x - bounds.x, point.y - bounds.y).a > 0) {
+            best = id;
+        }
+    });
+    return best;
+}
+
+std::vector<int> ScreenWriter::getAnnotationsIn(const Utils::Rectangle& area) const {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    std::vector<int> ids = m_impl->annotationIndex.queryRect(area);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
 std::vector<ScreenWriter::Annotation> ScreenWriter::getAnnotations() const {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
     return m_impl->annotations;
 }
 
 void ScreenWriter::clearAnnotations() {
-    m_impl->logOperation("Clearing all annotations (" + std::to_string(m_impl->annotations.size()) + " items)");
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    RECORDIFY_LOG_INFO("ScreenWriter", "Clearing all annotations (", m_impl->annotations.size(), " items)");
+    for (const auto& sprite : m_impl->sprites) {
+        m_impl->damageSprite(sprite);
+    }
+    m_impl->sprites.clear();
+    m_impl->annotationIndex.clear();
     m_impl->annotations.clear();
     m_impl->undoStack.clear();
     m_impl->redoStack.clear();
@@ -624,9 +1613,9 @@ void ScreenWriter::undoLastAnnotation() {
         m_impl->redoStack.push_back(annotation);
         
         removeAnnotation(annotation.id);
-        m_impl->logOperation("Undid annotation ID: " + std::to_string(annotation.id));
+        RECORDIFY_LOG_INFO("ScreenWriter", "Undid annotation ID: ", annotation.id);
     } else {
-        m_impl->logOperation("Nothing to undo");
+        RECORDIFY_LOG_INFO("ScreenWriter", "Nothing to undo");
     }
 }
 
@@ -636,32 +1625,39 @@ void ScreenWriter::redoAnnotation() {
         m_impl->redoStack.pop_back();
         
         addAnnotation(annotation);
-        m_impl->logOperation("Redid annotation");
+        RECORDIFY_LOG_INFO("ScreenWriter", "Redid annotation");
     } else {
-        m_impl->logOperation("Nothing to redo");
+        RECORDIFY_LOG_INFO("ScreenWriter", "Nothing to redo");
     }
 }
 
 // Configuration
+void ScreenWriter::setAntiAliasing(bool enabled) {
+    m_currentContext.antiAliasing = enabled;
+    RECORDIFY_LOG_DEBUG("ScreenWriter", "Anti-aliasing ", enabled ? "enabled" : "disabled");
+}
+
 void ScreenWriter::setDefaultTextProperties(const TextProperties& properties) {
     m_defaultTextProps = properties;
-    m_impl->logOperation("Updated default text properties");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Updated default text properties");
 }
 
 void ScreenWriter::setDefaultShapeProperties(const ShapeProperties& properties) {
     m_defaultShapeProps = properties;
-    m_impl->logOperation("Updated default shape properties");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Updated default shape properties");
 }
 
 // Statistics
 ScreenWriter::RenderStats ScreenWriter::getRenderStats() const {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
     return m_impl->renderStats;
 }
 
 void ScreenWriter::resetRenderStats() {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
     m_impl->renderStats = RenderStats();
     m_impl->lastStatsReset = std::chrono::steady_clock::now();
-    m_impl->logOperation("Reset render statistics");
+    RECORDIFY_LOG_INFO("ScreenWriter", "Reset render statistics");
 }
 
 // Private methods
@@ -681,8 +1677,50 @@ bool ScreenWriter::validateContext() const {
     return m_initialized && m_impl->hasCanvas;
 }
 
+Utils::Rectangle ScreenWriter::renderPath(RasterPath& path, const ShapeProperties& properties,
+                                          bool fillable, bool roundCaps) {
+    const auto& transform = m_currentContext.transform;
+    path.transform([&transform](const PointF& point) { return applyTransform(transform, point); });
+
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    Impl::Layer* layer = m_impl->findLayer(m_impl->activeLayerId);
+    if (!layer) {
+        return Utils::Rectangle();
+    }
+    m_impl->canvasStale = true;
+    
+    Rasterizer& rasterizer = m_impl->rasterizer;
+    rasterizer.setTarget(layer->surface);
+    rasterizer.setClip(m_currentContext.clipRect);
+    rasterizer.setAntiAliasing(m_currentContext.antiAliasing);
+    return paintPath(rasterizer, path, properties, fillable, roundCaps, transform.scaleX, transform.scaleY,
+                     properties.opacity * m_currentContext.globalOpacity);
+}
+
+Utils::Rectangle ScreenWriter::renderText(RasterPath& path, const TextProperties& properties,
+                                          const Utils::Rectangle& clip) {
+    const auto& transform = m_currentContext.transform;
+    path.transform([&transform](const PointF& point) { return applyTransform(transform, point); });
+
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
+    Impl::Layer* layer = m_impl->findLayer(m_impl->activeLayerId);
+    if (!layer) {
+        return Utils::Rectangle();
+    }
+    m_impl->canvasStale = true;
+    
+    Rasterizer& rasterizer = m_impl->rasterizer;
+    rasterizer.setTarget(layer->surface);
+    rasterizer.setClip(clip);
+    rasterizer.setAntiAliasing(m_currentContext.antiAliasing && properties.font.antiAliasing);
+    return paintText(rasterizer, path, properties, transform.scaleX, transform.scaleY,
+                     m_currentContext.globalOpacity);
+}
+
 void ScreenWriter::updateRenderStats() {
+    std::lock_guard<std::mutex> lock(m_impl->renderMutex);
     m_impl->renderStats.objectsRendered++;
+    m_impl->updateMemoryUsage();
     
     auto now = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_impl->lastStatsReset);
@@ -0,0 +1,455 @@
+#include "screen_handler/synthetic_source.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace Recordify {
+namespace ScreenHandler {
+
+namespace {
+
+constexpr int CELL_WIDTH = 8;
+constexpr int LINE_HEIGHT = 16;
+constexpr int TITLE_HEIGHT = 24;
+constexpr int TASKBAR_HEIGHT = 40;
+
+// SplitMix64 finalizer: same values on every platform, unlike std distributions
+uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint64_t hash(uint64_t seed, uint64_t a, uint64_t b = 0) {
+    return mix(seed ^ mix(a ^ mix(b)));
+}
+
+inline void putPixel(uint8_t* pixel, uint8_t b, uint8_t g, uint8_t r) {
+    pixel[0] = b;
+    pixel[1] = g;
+    pixel[2] = r;
+    pixel[3] = 255;
+}
+
+float typicalFraction(SyntheticWorkload workload) {
+    switch (workload) {
+        case SyntheticWorkload::STATIC_DESKTOP: return 0.0005f;
+        case SyntheticWorkload::SCROLLING_TERMINAL: return 0.5f;
+        case SyntheticWorkload::VIDEO_REGION: return 0.25f;
+        case SyntheticWorkload::MOVING_WINDOW: return 0.2f;
+        case SyntheticWorkload::BLINKING_CURSOR: return 0.0001f;
+    }
+    return 0.0f;
+}
+
+// Rectangle of `pixels` area with the given width:height ratio, at least 1x1
+Utils::Size sizeForArea(double pixels, double aspect, int maxWidth, int maxHeight) {
+    if (pixels < 1.0) {
+        return Utils::Size(0, 0);
+    }
+    int height = std::clamp(static_cast<int>(std::lround(std::sqrt(pixels / aspect))), 1, maxHeight);
+    int width = std::clamp(static_cast<int>(std::lround(pixels / height)), 1, maxWidth);
+    return Utils::Size(width, height);
+}
+
+} // namespace
+
+struct SyntheticSource::Impl {
+    SyntheticConfig config;
+    bool opened = false;
+    size_t stride = 0;
+    std::vector<uint8_t> desktop; // wallpaper behind every workload
+    std::vector<uint8_t> canvas;  // frame being shown
+
+    int64_t frame = 0;    // frame the canvas holds
+    bool grabbed = false; // frame 0 is shown by the first grab, not rendered over
+    Utils::Rectangle changed;
+    uint64_t changedPixels = 0;
+
+    // Layout derived from the changed fraction
+    Utils::Rectangle terminal;
+    Utils::Rectangle region; // video, window, clock or cursor
+    int64_t scroll = 0;      // first text line the terminal shows
+    int speed = 0;           // window pixels per frame
+    int direction = 1;
+    std::vector<uint8_t> texture; // video noise, one byte per pixel
+    Utils::Point pointer;
+
+    uint8_t* at(int x, int y) { return canvas.data() + stride * y + static_cast<size_t>(x) * 4; }
+    int width() const { return config.width; }
+    int height() const { return config.height; }
+
+    void buildDesktop() {
+        desktop.assign(stride * height(), 0);
+        const uint64_t tint = hash(config.seed, 0xD35C);
+        for (int y = 0; y < height(); ++y) {
+            uint8_t* row = desktop.data() + stride * y;
+            const bool taskbar = y >= height() - TASKBAR_HEIGHT;
+            for (int x = 0; x < width(); ++x) {
+                if (taskbar) {
+                    putPixel(row + x * 4, 32, 32, 32);
+                } else {
+                    putPixel(row + x * 4, static_cast<uint8_t>(90 + 60 * y / height()),
+                             static_cast<uint8_t>(60 + 40 * x / width()), static_cast<uint8_t>(30 + (tint & 31)));
+                }
+            }
+        }
+
+        // Column of icons; green stays below the window palette
+        for (int icon = 0; 24 + icon * 80 + 48 <= height() - TASKBAR_HEIGHT && 72 <= width(); ++icon) {
+            const uint64_t color = hash(config.seed, 0x1C0, icon);
+            for (int y = 0; y < 48; ++y) {
+                uint8_t* row = desktop.data() + stride * (24 + icon * 80 + y) + 24 * 4;
+                for (int x = 0; x < 48; ++x) {
+                    putPixel(row + x * 4, static_cast<uint8_t>(color), static_cast<uint8_t>(64 + ((color >> 8) & 127)),
+                             static_cast<uint8_t>(color >> 16));
+                }
+            }
+        }
+    }
+
+    void paintDesktop(const Utils::Rectangle& rect) {
+        for (int y = rect.y; y < rect.y + rect.height; ++y) {
+            const size_t offset = stride * y + static_cast<size_t>(rect.x) * 4;
+            std::memcpy(canvas.data() + offset, desktop.data() + offset, static_cast<size_t>(rect.width) * 4);
+        }
+    }
+
+    // Ragged lines of 8x16 glyph cells. Adjacent lines use disjoint grey
+    // levels, so scrolling by a line changes every terminal pixel.
+    void paintTerminal(const Utils::Rectangle& rect) {
+        for (int y = rect.y; y < rect.y + rect.height; ++y) {
+            const int64_t line = scroll + (y - terminal.y) / LINE_HEIGHT;
+            const int glyphRow = (y - terminal.y) % LINE_HEIGHT;
+            const uint8_t background = (line & 1) ? 24 : 40;
+            const uint8_t foreground = (line & 1) ? 200 : 230;
+            const int length = static_cast<int>(hash(config.seed, 0x7E7, line) % (terminal.width / CELL_WIDTH + 1));
+
+            uint8_t* row = at(rect.x, y);
+            int cell = -1;
+            uint8_t bits = 0;
+            for (int x = rect.x; x < rect.x + rect.width; ++x, row += 4) {
+                const int column = (x - terminal.x) / CELL_WIDTH;
+                if (column != cell) {
+                    cell = column;
+                    const bool blankRow = glyphRow < 2 || glyphRow >= LINE_HEIGHT - 2;
+                    bits = column < length && !blankRow
+                               ? static_cast<uint8_t>(hash(config.seed, line, 2 * column + glyphRow / 8) >>
+                                                      (8 * (glyphRow % 8)))
+                               : 0;
+                }
+                const uint8_t level = (bits >> ((x - terminal.x) % CELL_WIDTH)) & 1 ? foreground : background;
+                putPixel(row, level, level, level);
+            }
+        }
+    }
+
+    // The blue channel advances by 7 per frame, so every pixel changes
+    void paintVideo() {
+        const uint8_t shift = static_cast<uint8_t>(frame * 7);
+        for (int y = 0; y < region.height; ++y) {
+            uint8_t* row = at(region.x, region.y + y);
+            const uint8_t* noise = texture.data() + static_cast<size_t>(y) * region.width;
+            for (int x = 0; x < region.width; ++x) {
+                putPixel(row + x * 4, static_cast<uint8_t>(noise[x] + shift),
+                         static_cast<uint8_t>(2 * y + frame * 3), static_cast<uint8_t>(x + y + frame * 5));
+            }
+        }
+    }
+
+    // Blue follows the window-local x with a step of 3, so a move by any
+    // distance other than a multiple of 256 changes every window pixel
+    void paintWindow() {
+        const uint8_t tone = static_cast<uint8_t>(hash(config.seed, 0x3100));
+        for (int y = 0; y < region.height; ++y) {
+            uint8_t* row = at(region.x, region.y + y);
+            for (int x = 0; x < region.width; ++x) {
+                if (y < TITLE_HEIGHT) {
+                    putPixel(row + x * 4, static_cast<uint8_t>(3 * x + tone), 240, 60);
+                } else {
+                    putPixel(row + x * 4, static_cast<uint8_t>(3 * x + 5 * y + tone),
+                             static_cast<uint8_t>(224 + (y & 15)), static_cast<uint8_t>(x ^ y));
+                }
+            }
+        }
+    }
+
+    void paintClock(int64_t tick) {
+        for (int y = 0; y < region.height; ++y) {
+            uint8_t* row = at(region.x, region.y + y);
+            for (int x = 0; x < region.width; ++x) {
+                putPixel(row + x * 4, static_cast<uint8_t>(5 * x + 3 * y + 11 * tick), 200, 200);
+            }
+        }
+    }
+
+    void paintCursor(bool visible) {
+        if (!visible) {
+            paintTerminal(region);
+            return;
+        }
+        for (int y = 0; y < region.height; ++y) {
+            uint8_t* row = at(region.x, region.y + y);
+            for (int x = 0; x < region.width; ++x) {
+                putPixel(row + x * 4, 0, 255, 255);
+            }
+        }
+    }
+
+    void layout() {
+        const double target = std::clamp(config.changedFraction < 0.0f ? typicalFraction(config.workload)
+                                                                         : config.changedFraction,
+                                         0.0f, 1.0f) *
+                              static_cast<double>(width()) * height();
+        const uint64_t spot = hash(config.seed, 0x9017);
+        pointer = Utils::Point(static_cast<int>(spot % width()), static_cast<int>((spot >> 32) % height()));
+        terminal = Utils::Rectangle();
+        region = Utils::Rectangle();
+        scroll = 0;
+        direction = 1;
+
+        switch (config.workload) {
+            case SyntheticWorkload::STATIC_DESKTOP: {
+                Utils::Size clock = sizeForArea(target, 3.0, width(), height());
+                region = Utils::Rectangle(std::max(0, width() - clock.width - 8),
+                                          std::max(0, height() - clock.height - 8), clock.width, clock.height);
+                break;
+            }
+            case SyntheticWorkload::SCROLLING_TERMINAL: {
+                const int lines = std::min(height() / LINE_HEIGHT,
+                                           static_cast<int>(std::lround(target / width() / LINE_HEIGHT)));
+                terminal = Utils::Rectangle(0, 0, width(), lines * LINE_HEIGHT);
+                break;
+            }
+            case SyntheticWorkload::VIDEO_REGION: {
+                Utils::Size video = sizeForArea(target, 16.0 / 9.0, width(), height());
+                region = Utils::Rectangle((width() - video.width) / 2, (height() - video.height) / 2,
+                                          video.width, video.height);
+                texture.resize(static_cast<size_t>(video.width) * video.height);
+                for (size_t i = 0; i < texture.size(); i += 8) {
+                    const uint64_t noise = hash(config.seed, 0x71DE0, i);
+                    std::memcpy(texture.data() + i, &noise, std::min<size_t>(8, texture.size() - i));
+                }
+                break;
+            }
+            case SyntheticWorkload::MOVING_WINDOW: {
+                // Each frame changes the union of the old and new position:
+                // (w + w/8) * h with w = 1.6h
+                Utils::Size window = sizeForArea(target / 1.125, 1.6, width() - 1, height());
+                if (window.width == 0) {
+                    break;
+                }
+                speed = std::max(1, window.width / 8);
+                if (window.width + speed > width()) {
+                    speed = width() - window.width;
+                }
+                region = Utils::Rectangle(0, (height() - window.height) / 2, window.width, window.height);
+                pointer = Utils::Point(region.x + region.width / 2, region.y + TITLE_HEIGHT / 2);
+                break;
+            }
+            case SyntheticWorkload::BLINKING_CURSOR: {
+                terminal = Utils::Rectangle(0, 0, width(), height());
+                Utils::Size cursor = sizeForArea(target, 0.5, width(), height());
+                const int line = height() / LINE_HEIGHT / 2;
+                region = Utils::Rectangle(std::min(4 * CELL_WIDTH, width() - cursor.width),
+                                          std::min(line * LINE_HEIGHT, height() - cursor.height),
+                                          cursor.width, cursor.height);
+                break;
+            }
+        }
+    }
+
+    void paintFirstFrame() {
+        paintDesktop(Utils::Rectangle(0, 0, width(), height()));
+        if (!terminal.isEmpty()) {
+            paintTerminal(terminal);
+        }
+        if (region.isEmpty()) {
+            return;
+        }
+        switch (config.workload) {
+            case SyntheticWorkload::STATIC_DESKTOP: paintClock(0); break;
+            case SyntheticWorkload::VIDEO_REGION: paintVideo(); break;
+            case SyntheticWorkload::MOVING_WINDOW: paintWindow(); break;
+            case SyntheticWorkload::BLINKING_CURSOR: paintCursor(true); break;
+            case SyntheticWorkload::SCROLLING_TERMINAL: break;
+        }
+    }
+
+    // Renders frame + 1 over the current one
+    void advance() {
+        ++frame;
+        changed = Utils::Rectangle();
+        changedPixels = 0;
+        const bool tick = config.period <= 1 || frame % config.period == 0;
+
+        switch (config.workload) {
+            case SyntheticWorkload::STATIC_DESKTOP:
+                if (tick && !region.isEmpty()) {
+                    paintClock(config.period <= 1 ? frame : frame / config.period);
+                    changed = region;
+                }
+                break;
+            case SyntheticWorkload::SCROLLING_TERMINAL:
+                if (!terminal.isEmpty()) {
+                    // Terminal spans full rows, so its lines are one contiguous block
+                    std::memmove(at(0, terminal.y), at(0, terminal.y + LINE_HEIGHT),
+                                 stride * (terminal.height - LINE_HEIGHT));
+                    ++scroll;
+                    paintTerminal(Utils::Rectangle(0, terminal.y + terminal.height - LINE_HEIGHT, width(),
+                                                   LINE_HEIGHT));
+                    changed = terminal;
+                }
+                break;
+            case SyntheticWorkload::VIDEO_REGION:
+                if (!region.isEmpty()) {
+                    paintVideo();
+                    changed = region;
+                }
+                break;
+            case SyntheticWorkload::MOVING_WINDOW:
+                if (!region.isEmpty() && speed > 0) {
+                    moveWindow();
+                }
+                break;
+            case SyntheticWorkload::BLINKING_CURSOR:
+                if (tick && !region.isEmpty()) {
+                    paintCursor((frame / std::max(1, config.period)) % 2 == 0);
+                    changed = region;
+                }
+                break;
+        }
+        if (config.workload != SyntheticWorkload::MOVING_WINDOW) {
+            changedPixels = static_cast<uint64_t>(changed.width) * changed.height;
+        }
+    }
+
+    // Bounces between the screen edges
+    void moveWindow() {
+        int next = region.x + direction * speed;
+        if (next < 0 || next + region.width > width()) {
+            direction = -direction;
+            next = std::clamp(region.x + direction * speed, 0, width() - region.width);
+        }
+        int distance = std::abs(next - region.x);
+        if (distance % 256 == 0 && distance > 0) {
+            next -= direction; // would line the texture up with itself
+            distance -= 1;
+        }
+
+        Utils::Rectangle previous = region;
+        region.x = next;
+        paintDesktop(previous);
+        paintWindow();
+        pointer.x += next - previous.x;
+
+        changed = previous.united(region);
+        changedPixels = static_cast<uint64_t>(std::min(region.width, distance) + region.width) * region.height;
+    }
+};
+
+SyntheticSource::SyntheticSource(const SyntheticConfig& config) : m_impl(std::make_unique<Impl>()) {
+    m_impl->config = config;
+}
+
+SyntheticSource::~SyntheticSource() = default;
+
+const char* SyntheticSource::name() const {
+    return "synthetic";
+}
+
+bool SyntheticSource::open() {
+    if (m_impl->opened) {
+        return true;
+    }
+    if (m_impl->config.width < 64 || m_impl->config.height < 64) {
+        RECORDIFY_LOG_WARN("SyntheticSource", "Invalid screen size ", m_impl->config.width, "x",
+                           m_impl->config.height);
+        return false;
+    }
+
+    m_impl->stride = static_cast<size_t>(m_impl->config.width) * 4;
+    m_impl->canvas.assign(m_impl->stride * m_impl->config.height, 0);
+    m_impl->buildDesktop();
+    m_impl->frame = 0;
+    m_impl->grabbed = false;
+    m_impl->layout();
+    m_impl->paintFirstFrame();
+    m_impl->opened = true;
+
+    RECORDIFY_LOG_INFO("SyntheticSource", workloadName(m_impl->config.workload), " at ", m_impl->config.width,
+                       "x", m_impl->config.height, ", seed ", m_impl->config.seed);
+    return true;
+}
+
+void SyntheticSource::close() {
+    m_impl->opened = false;
+    m_impl->desktop = std::vector<uint8_t>();
+    m_impl->canvas = std::vector<uint8_t>();
+    m_impl->texture = std::vector<uint8_t>();
+}
+
+Utils::Rectangle SyntheticSource::bounds() const {
+    return Utils::Rectangle(0, 0, m_impl->config.width, m_impl->config.height);
+}
+
+bool SyntheticSource::grab(const Utils::Rectangle& area, uint8_t* pixels, size_t stride) {
+    if (!m_impl->opened || area.isEmpty() || !bounds().contains(area)) {
+        return false;
+    }
+
+    if (!m_impl->grabbed) {
+        m_impl->grabbed = true;
+        m_impl->changed = bounds();
+        m_impl->changedPixels = static_cast<uint64_t>(m_impl->config.width) * m_impl->config.height;
+    } else {
+        m_impl->advance();
+    }
+
+    const size_t rowBytes = static_cast<size_t>(area.width) * 4;
+    for (int y = 0; y < area.height; ++y) {
+        std::memcpy(pixels + stride * y, m_impl->at(area.x, area.y + y), rowBytes);
+    }
+    return true;
+}
+
+bool SyntheticSource::pointer(Utils::Point& position) {
+    if (!m_impl->opened) {
+        return false;
+    }
+    position = m_impl->pointer;
+    return true;
+}
+
+int64_t SyntheticSource::getFrameIndex() const {
+    return m_impl->grabbed ? m_impl->frame : -1;
+}
+
+Utils::Rectangle SyntheticSource::getChangedArea() const {
+    return m_impl->changed;
+}
+
+float SyntheticSource::getChangedFraction() const {
+    const double pixels = static_cast<double>(m_impl->config.width) * m_impl->config.height;
+    return pixels > 0.0 ? static_cast<float>(m_impl->changedPixels / pixels) : 0.0f;
+}
+
+const SyntheticConfig& SyntheticSource::getConfig() const {
+    return m_impl->config;
+}
+
+const char* SyntheticSource::workloadName(SyntheticWorkload workload) {
+    switch (workload) {
+        case SyntheticWorkload::STATIC_DESKTOP: return "static desktop";
+        case SyntheticWorkload::SCROLLING_TERMINAL: return "scrolling terminal";
+        case SyntheticWorkload::VIDEO_REGION: return "video region";
+        case SyntheticWorkload::MOVING_WINDOW: return "moving window";
+        case SyntheticWorkload::BLINKING_CURSOR: return "blinking cursor";
+    }
+    return "unknown";
+}
+
+}} // namespace Recordify::ScreenHandler
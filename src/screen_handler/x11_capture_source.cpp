@@ -0,0 +1,348 @@
+#include "screen_handler/capture_source.h"
+#include "utils/logger.h"
+
+#ifdef RECORDIFY_HAVE_X11
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+#endif
+
+namespace Recordify {
+namespace ScreenHandler {
+
+#ifdef RECORDIFY_HAVE_X11
+
+namespace {
+
+// Xlib reports protocol errors through a process-wide handler whose default
+// exits the process; ours only records them around the requests that can fail
+std::atomic<bool> g_xError{false};
+
+int recordXError(Display*, XErrorEvent*) {
+    g_xError.store(true);
+    return 0;
+}
+
+class ErrorTrap {
+public:
+    explicit ErrorTrap(Display* display) : m_display(display) {
+        g_xError.store(false);
+        m_previous = XSetErrorHandler(recordXError);
+    }
+    ~ErrorTrap() { XSetErrorHandler(m_previous); }
+
+    // Waits for the server to process everything sent so far
+    bool failed() {
+        XSync(m_display, False);
+        return g_xError.load();
+    }
+
+private:
+    Display* m_display;
+    XErrorHandler m_previous;
+};
+
+// Image headers point at memory we own; keep XDestroyImage from freeing it
+void destroyImage(XImage* image) {
+    if (image) {
+        image->data = nullptr;
+        XDestroyImage(image);
+    }
+}
+
+class X11CaptureSource : public CaptureSource {
+public:
+    X11CaptureSource(const std::string& displayName, bool useShm) : m_displayName(displayName), m_useShm(useShm) {}
+    ~X11CaptureSource() override { close(); }
+
+    const char* name() const override { return m_shm ? "x11-shm" : "x11"; }
+
+    bool open() override {
+        if (m_display) {
+            return true;
+        }
+        m_display = XOpenDisplay(m_displayName.empty() ? nullptr : m_displayName.c_str());
+        if (!m_display) {
+            RECORDIFY_LOG_WARN("CaptureSource", "Cannot open X display ",
+                               m_displayName.empty() ? "$DISPLAY" : m_displayName);
+            return false;
+        }
+
+        const int screen = DefaultScreen(m_display);
+        m_root = RootWindow(m_display, screen);
+        m_visual = DefaultVisual(m_display, screen);
+        m_depth = DefaultDepth(m_display, screen);
+        m_bounds = Utils::Rectangle(0, 0, DisplayWidth(m_display, screen), DisplayHeight(m_display, screen));
+        if (m_depth != 24 && m_depth != 32) {
+            RECORDIFY_LOG_WARN("CaptureSource", "Unsupported X display depth ", m_depth);
+            close();
+            return false;
+        }
+
+        m_shm = m_useShm && XShmQueryExtension(m_display) && attachSegment();
+        RECORDIFY_LOG_INFO("CaptureSource", "Capturing X display ", DisplayString(m_display), " (",
+                           m_bounds.width, "x", m_bounds.height, ") through ",
+                           m_shm ? "MIT-SHM" : "XGetImage");
+        return true;
+    }
+
+    void close() override {
+        if (!m_display) {
+            return;
+        }
+        destroyImage(m_image);
+        m_image = nullptr;
+        destroyImage(m_poolImage);
+        m_poolImage = nullptr;
+        // Pool memory stays mapped on our side until the pool lets go of it
+        for (auto& segment : m_poolSegments) {
+            XShmDetach(m_display, &segment->info);
+        }
+        m_poolSegments.clear();
+        if (m_shm) {
+            XShmDetach(m_display, &m_segment);
+            XSync(m_display, False);
+            shmdt(m_segment.shmaddr);
+            m_shm = false;
+        }
+        XCloseDisplay(m_display);
+        m_display = nullptr;
+    }
+
+    Utils::Rectangle bounds() const override { return m_bounds; }
+    int bitsPerPixel() const override { return 32; }
+
+    bool grab(const Utils::Rectangle& area, uint8_t* pixels, size_t stride) override {
+        if (!m_display || area.isEmpty() || !m_bounds.contains(area)) {
+            return false;
+        }
+
+        // Without shared memory the reply is unpacked straight into `pixels`
+        if (!m_shm) {
+            if (!prepareImage(area.width, area.height, stride)) {
+                return false;
+            }
+            m_image->data = reinterpret_cast<char*>(pixels);
+            ErrorTrap trap(m_display);
+            const bool ok = XGetSubImage(m_display, m_root, area.x, area.y, area.width, area.height, AllPlanes,
+                                         ZPixmap, m_image, 0, 0) != nullptr &&
+                            !trap.failed();
+            m_image->data = nullptr;
+            return ok;
+        }
+
+        // Pool slabs from slabAllocator() are shared with the server, which
+        // writes the frame in place
+        const size_t rowBytes = static_cast<size_t>(area.width) * 4;
+        PoolSegment* segment = stride == rowBytes ? segmentHolding(pixels, rowBytes * area.height) : nullptr;
+        if (segment && preparePoolImage(area.width, area.height)) {
+            m_poolImage->data = reinterpret_cast<char*>(pixels);
+            m_poolImage->obdata = reinterpret_cast<char*>(&segment->info);
+            return XShmGetImage(m_display, m_root, m_poolImage, area.x, area.y, AllPlanes) != 0;
+        }
+
+        // Any other memory: grab into our own segment and copy out
+        if (!prepareImage(area.width, area.height, rowBytes) ||
+            !XShmGetImage(m_display, m_root, m_image, area.x, area.y, AllPlanes)) {
+            return false;
+        }
+        for (int y = 0; y < area.height; ++y) {
+            std::memcpy(pixels + stride * y, m_image->data + static_cast<size_t>(m_image->bytes_per_line) * y,
+                        rowBytes);
+        }
+        return true;
+    }
+
+    // Slabs in segments the server has attached, so grabs into them skip the copy
+    FramePool::SlabAllocator slabAllocator() override {
+        if (!m_shm) {
+            return FramePool::SlabAllocator();
+        }
+        return [this](size_t bytes) { return allocatePoolSegment(bytes); };
+    }
+
+    bool pointer(Utils::Point& position) override {
+        if (!m_display) {
+            return false;
+        }
+        Window root, child;
+        int rootX, rootY, windowX, windowY;
+        unsigned int buttons;
+        if (!XQueryPointer(m_display, m_root, &root, &child, &rootX, &rootY, &windowX, &windowY, &buttons)) {
+            return false; // pointer is on another screen
+        }
+        position = Utils::Point(rootX, rootY);
+        return true;
+    }
+
+private:
+    struct PoolSegment {
+        XShmSegmentInfo info{};
+        size_t bytes = 0;
+        std::weak_ptr<void> mapping; // expires once the pool has unmapped it
+    };
+
+    // New segment of `bytes`, mapped here and attached by the server
+    bool createSegment(XShmSegmentInfo& segment, size_t bytes) {
+        segment.shmid = shmget(IPC_PRIVATE, bytes, IPC_CREAT | 0600);
+        if (segment.shmid < 0) {
+            return false;
+        }
+        segment.shmaddr = static_cast<char*>(shmat(segment.shmid, nullptr, 0));
+        segment.readOnly = False;
+        if (segment.shmaddr == reinterpret_cast<char*>(-1)) {
+            shmctl(segment.shmid, IPC_RMID, nullptr);
+            return false;
+        }
+
+        // Fails when the server can't map our segment (remote display, separate IPC namespace)
+        bool attached;
+        {
+            ErrorTrap trap(m_display);
+            attached = XShmAttach(m_display, &segment) && !trap.failed();
+        }
+        // Marked for removal now, so it goes away with the last detach even after a crash
+        shmctl(segment.shmid, IPC_RMID, nullptr);
+        if (!attached) {
+            shmdt(segment.shmaddr);
+            return false;
+        }
+        return true;
+    }
+
+    // One screen-sized segment, shared with the server for the source's lifetime
+    bool attachSegment() {
+        XImage* image = XShmCreateImage(m_display, m_visual, m_depth, ZPixmap, nullptr, &m_segment,
+                                        m_bounds.width, m_bounds.height);
+        if (!image) {
+            return false;
+        }
+        m_segmentBytes = static_cast<size_t>(image->bytes_per_line) * image->height;
+        if (!createSegment(m_segment, m_segmentBytes)) {
+            RECORDIFY_LOG_INFO("CaptureSource", "MIT-SHM attach failed, falling back to XGetImage");
+            destroyImage(image);
+            return false;
+        }
+        image->data = m_segment.shmaddr;
+        m_image = image;
+        return true;
+    }
+
+    FramePool::SlabMemory allocatePoolSegment(size_t bytes) {
+        // Segments of pools that were reconfigured since
+        for (auto it = m_poolSegments.begin(); it != m_poolSegments.end();) {
+            if ((*it)->mapping.expired()) {
+                XShmDetach(m_display, &(*it)->info);
+                it = m_poolSegments.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        auto segment = std::make_unique<PoolSegment>();
+        if (!m_display || !createSegment(segment->info, bytes)) {
+            RECORDIFY_LOG_WARN("CaptureSource", "Cannot share ", bytes, " bytes of frame memory with the X server");
+            return FramePool::SlabMemory();
+        }
+        segment->bytes = bytes;
+        FramePool::SlabMemory memory;
+        memory.data = reinterpret_cast<uint8_t*>(segment->info.shmaddr);
+        memory.owner = std::shared_ptr<void>(segment->info.shmaddr, [](void* address) { shmdt(address); });
+        segment->mapping = memory.owner;
+        m_poolSegments.push_back(std::move(segment));
+        return memory;
+    }
+
+    PoolSegment* segmentHolding(const uint8_t* pixels, size_t bytes) {
+        for (auto& segment : m_poolSegments) {
+            const uint8_t* start = reinterpret_cast<const uint8_t*>(segment->info.shmaddr);
+            if (!segment->mapping.expired() && pixels >= start && pixels + bytes <= start + segment->bytes) {
+                return segment.get();
+            }
+        }
+        return nullptr;
+    }
+
+    // Image header for grabs into pool segments; data and segment are set per grab
+    bool preparePoolImage(int width, int height) {
+        if (m_poolImage && m_poolImage->width == width && m_poolImage->height == height) {
+            return true;
+        }
+        destroyImage(m_poolImage);
+        m_poolImage = XShmCreateImage(m_display, m_visual, m_depth, ZPixmap, nullptr, &m_segment, width, height);
+        if (m_poolImage && (m_poolImage->bits_per_pixel != 32 || m_poolImage->bytes_per_line != width * 4)) {
+            destroyImage(m_poolImage);
+            m_poolImage = nullptr;
+        }
+        return m_poolImage != nullptr;
+    }
+
+    // Image header for the requested size: over our segment with MIT-SHM,
+    // otherwise over the caller's pixels, rows `stride` apart
+    bool prepareImage(int width, int height, size_t stride) {
+        if (m_image && m_image->width == width && m_image->height == height &&
+            (m_shm || static_cast<size_t>(m_image->bytes_per_line) == stride)) {
+            return true;
+        }
+        destroyImage(m_image);
+        m_image = m_shm ? XShmCreateImage(m_display, m_visual, m_depth, ZPixmap, nullptr, &m_segment, width, height)
+                        : XCreateImage(m_display, m_visual, m_depth, ZPixmap, 0, nullptr, width, height, 32,
+                                       static_cast<int>(stride));
+        if (!m_image) {
+            return false;
+        }
+
+        const size_t bytes = static_cast<size_t>(m_image->bytes_per_line) * height;
+        if (m_image->bits_per_pixel != 32 || (m_shm && bytes > m_segmentBytes)) {
+            RECORDIFY_LOG_WARN("CaptureSource", "Cannot grab ", width, "x", height, " at ",
+                               m_image->bits_per_pixel, " bits per pixel");
+            destroyImage(m_image);
+            m_image = nullptr;
+            return false;
+        }
+        if (m_shm) {
+            m_image->data = m_segment.shmaddr;
+        }
+        return true;
+    }
+
+    std::string m_displayName;
+    bool m_useShm;
+    Display* m_display = nullptr;
+    Window m_root = 0;
+    Visual* m_visual = nullptr;
+    int m_depth = 0;
+    Utils::Rectangle m_bounds;
+
+    XImage* m_image = nullptr;
+    bool m_shm = false;
+    XShmSegmentInfo m_segment{};
+    size_t m_segmentBytes = 0;
+
+    // Frame pool memory handed out by slabAllocator()
+    std::vector<std::unique_ptr<PoolSegment>> m_poolSegments;
+    XImage* m_poolImage = nullptr;
+};
+
+} // namespace
+
+std::unique_ptr<CaptureSource> createX11CaptureSource(const std::string& displayName, bool useShm) {
+    return std::make_unique<X11CaptureSource>(displayName, useShm);
+}
+
+#else
+
+std::unique_ptr<CaptureSource> createX11CaptureSource(const std::string&, bool) {
+    RECORDIFY_LOG_DEBUG("CaptureSource", "Built without X11 support");
+    return nullptr;
+}
+
+#endif
+
+}} // namespace Recordify::ScreenHandler
@@ -0,0 +1,386 @@
+#include "utils/color_convert.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RECORDIFY_CONVERT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Recordify {
+namespace Utils {
+namespace ColorConvert {
+
+namespace {
+
+// Q15 weights indexed by byte position within a pixel, so RGBA only swaps them
+struct Coefficients {
+    int32_t y[3], u[3], v[3];
+    int32_t lumaBias;   // offset and rounding, before >> 15
+    int32_t chromaBias; // 128 and rounding, before >> 17
+};
+
+Coefficients makeCoefficients(const ConvertOptions& options, PixelFormat format) {
+    const double kr = options.matrix == Matrix::BT709 ? 0.2126 : 0.299;
+    const double kb = options.matrix == Matrix::BT709 ? 0.0722 : 0.114;
+    const bool full = options.range == Range::FULL;
+    const double lumaScale = (full ? 1.0 : 219.0 / 255.0) * 32768.0;
+    const double chromaScale = (full ? 1.0 : 224.0 / 255.0) * 32768.0;
+
+    // Green takes the rounding slack, so grey maps to exactly grey
+    const int32_t yR = static_cast<int32_t>(std::lround(kr * lumaScale));
+    const int32_t yB = static_cast<int32_t>(std::lround(kb * lumaScale));
+    const int32_t yG = static_cast<int32_t>(std::lround(lumaScale)) - yR - yB;
+    const int32_t half = static_cast<int32_t>(std::lround(0.5 * chromaScale));
+    const int32_t uR = static_cast<int32_t>(std::lround(-kr / (2.0 * (1.0 - kb)) * chromaScale));
+    const int32_t vB = static_cast<int32_t>(std::lround(-kb / (2.0 * (1.0 - kr)) * chromaScale));
+
+    Coefficients c;
+    const bool rgb = format == PixelFormat::RGBA32;
+    const int r = rgb ? 0 : 2, b = rgb ? 2 : 0;
+    c.y[r] = yR; c.y[1] = yG; c.y[b] = yB;
+    c.u[r] = uR; c.u[1] = -half - uR; c.u[b] = half;
+    c.v[r] = half; c.v[1] = -half - vB; c.v[b] = vB;
+    c.lumaBias = ((full ? 0 : 16) << 15) + (1 << 14);
+    c.chromaBias = (128 << 17) + (1 << 16);
+    return c;
+}
+
+// Two source rows and the outputs they produce. On an odd final row both
+// halves point at the same row.
+struct RowPair {
+    const uint8_t* top;
+    const uint8_t* bottom;
+    uint8_t* yTop;
+    uint8_t* yBottom;
+    uint8_t* u;
+    uint8_t* v;
+    int chromaStep; // 1 for I420, 2 for NV12 (v == u + 1)
+};
+
+using RowKernel = void (*)(const RowPair&, int, const Coefficients&);
+
+inline uint8_t clampByte(int32_t value) {
+    return static_cast<uint8_t>(std::min(255, std::max(0, value)));
+}
+
+inline uint8_t luma(const uint8_t* p, const Coefficients& c) {
+    return clampByte((c.y[0] * p[0] + c.y[1] * p[1] + c.y[2] * p[2] + c.lumaBias) >> 15);
+}
+
+// Reference kernel; the SIMD kernels also use it for their row tails
+template <int BPP>
+void convertRowsScalar(const RowPair& rows, int begin, int width, const Coefficients& c) {
+    for (int x = begin; x < width; x += 2) {
+        const int next = std::min(x + 1, width - 1);
+        const uint8_t* a = rows.top + x * BPP;
+        const uint8_t* b = rows.top + next * BPP;
+        const uint8_t* d = rows.bottom + x * BPP;
+        const uint8_t* e = rows.bottom + next * BPP;
+
+        rows.yTop[x] = luma(a, c);
+        rows.yBottom[x] = luma(d, c);
+        if (x + 1 < width) {
+            rows.yTop[x + 1] = luma(b, c);
+            rows.yBottom[x + 1] = luma(e, c);
+        }
+
+        int32_t sum[3];
+        for (int i = 0; i < 3; ++i) {
+            sum[i] = a[i] + b[i] + d[i] + e[i];
+        }
+        const size_t chroma = static_cast<size_t>(x / 2) * rows.chromaStep;
+        rows.u[chroma] = clampByte((c.u[0] * sum[0] + c.u[1] * sum[1] + c.u[2] * sum[2] + c.chromaBias) >> 17);
+        rows.v[chroma] = clampByte((c.v[0] * sum[0] + c.v[1] * sum[1] + c.v[2] * sum[2] + c.chromaBias) >> 17);
+    }
+}
+
+template <int BPP>
+void rowsScalar(const RowPair& rows, int width, const Coefficients& c) {
+    convertRowsScalar<BPP>(rows, 0, width, c);
+}
+
+#ifdef RECORDIFY_CONVERT_X86
+
+// The SIMD kernels keep one pixel per 32-bit lane. Masking the even and odd
+// bytes gives 16-bit pairs (byte0, byte2) and (byte1, alpha) that pmaddwd
+// weighs in one step, with no channel deinterleaving.
+inline int32_t pairWeights(int32_t low, int32_t high) {
+    return static_cast<int32_t>((static_cast<uint32_t>(high) << 16) | (static_cast<uint32_t>(low) & 0xFFFF));
+}
+
+__attribute__((target("ssse3")))
+inline __m128i loadPixelsSsse3(const uint8_t* p, int bpp) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    if (bpp == 3) {
+        // 4 pixels in the low 12 bytes, spread to one per lane
+        pixels = _mm_shuffle_epi8(pixels, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+    }
+    return pixels;
+}
+
+template <int BPP>
+__attribute__((target("ssse3")))
+void rowsSsse3(const RowPair& rows, int width, const Coefficients& c) {
+    const __m128i lowBytes = _mm_set1_epi32(0x00FF00FF);
+    const __m128i evenLanes = _mm_setr_epi32(-1, 0, -1, 0);
+    const __m128i yEven = _mm_set1_epi32(pairWeights(c.y[0], c.y[2]));
+    const __m128i yOdd = _mm_set1_epi32(pairWeights(c.y[1], 0));
+    const __m128i uEven = _mm_set1_epi32(pairWeights(c.u[0], c.u[2]));
+    const __m128i uOdd = _mm_set1_epi32(pairWeights(c.u[1], 0));
+    const __m128i vEven = _mm_set1_epi32(pairWeights(c.v[0], c.v[2]));
+    const __m128i vOdd = _mm_set1_epi32(pairWeights(c.v[1], 0));
+    const __m128i lumaBias = _mm_set1_epi32(c.lumaBias);
+    const __m128i chromaBias = _mm_set1_epi32(c.chromaBias);
+
+    const size_t rowBytes = static_cast<size_t>(width) * BPP;
+    int x = 0;
+    // 8 pixels per step; the second load of each row reads 16 bytes
+    for (; static_cast<size_t>(x + 4) * BPP + 16 <= rowBytes; x += 8) {
+        __m128i even[4], odd[4], lumaWords[2];
+        const uint8_t* sources[4] = {rows.top + x * BPP, rows.top + (x + 4) * BPP,
+                                     rows.bottom + x * BPP, rows.bottom + (x + 4) * BPP};
+        for (int i = 0; i < 4; ++i) {
+            __m128i pixels = loadPixelsSsse3(sources[i], BPP);
+            even[i] = _mm_and_si128(pixels, lowBytes);
+            odd[i] = _mm_srli_epi16(pixels, 8);
+        }
+        for (int row = 0; row < 2; ++row) {
+            __m128i first = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(even[2 * row], yEven),
+                                                        _mm_madd_epi16(odd[2 * row], yOdd)), lumaBias);
+            __m128i second = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(even[2 * row + 1], yEven),
+                                                         _mm_madd_epi16(odd[2 * row + 1], yOdd)), lumaBias);
+            lumaWords[row] = _mm_packs_epi32(_mm_srai_epi32(first, 15), _mm_srai_epi32(second, 15));
+        }
+        __m128i lumaBytes = _mm_packus_epi16(lumaWords[0], lumaWords[1]);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.yTop + x), lumaBytes);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.yBottom + x), _mm_srli_si128(lumaBytes, 8));
+
+        // Column sums, then neighbouring pixels paired into quads:
+        // pixels 0-3 land in even lanes, 4-7 in odd ones -> quads 0,2,1,3
+        __m128i evenLeft = _mm_add_epi16(even[0], even[2]), evenRight = _mm_add_epi16(even[1], even[3]);
+        __m128i oddLeft = _mm_add_epi16(odd[0], odd[2]), oddRight = _mm_add_epi16(odd[1], odd[3]);
+        __m128i evenQuads = _mm_or_si128(
+            _mm_and_si128(evenLanes, _mm_add_epi16(evenLeft, _mm_srli_epi64(evenLeft, 32))),
+            _mm_andnot_si128(evenLanes, _mm_add_epi16(evenRight, _mm_slli_epi64(evenRight, 32))));
+        __m128i oddQuads = _mm_or_si128(
+            _mm_and_si128(evenLanes, _mm_add_epi16(oddLeft, _mm_srli_epi64(oddLeft, 32))),
+            _mm_andnot_si128(evenLanes, _mm_add_epi16(oddRight, _mm_slli_epi64(oddRight, 32))));
+
+        __m128i u = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(evenQuads, uEven), _mm_madd_epi16(oddQuads, uOdd)),
+                                  chromaBias);
+        __m128i v = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(evenQuads, vEven), _mm_madd_epi16(oddQuads, vOdd)),
+                                  chromaBias);
+        u = _mm_shuffle_epi32(_mm_srai_epi32(u, 17), _MM_SHUFFLE(3, 1, 2, 0));
+        v = _mm_shuffle_epi32(_mm_srai_epi32(v, 17), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i chroma = _mm_packus_epi16(_mm_packs_epi32(u, v), _mm_setzero_si128()); // u0-3 v0-3
+
+        const size_t offset = static_cast<size_t>(x / 2) * rows.chromaStep;
+        if (rows.chromaStep == 1) {
+            int32_t uBytes = _mm_cvtsi128_si32(chroma), vBytes = _mm_cvtsi128_si32(_mm_srli_si128(chroma, 4));
+            std::memcpy(rows.u + offset, &uBytes, 4);
+            std::memcpy(rows.v + offset, &vBytes, 4);
+        } else {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.u + offset),
+                             _mm_unpacklo_epi8(chroma, _mm_srli_si128(chroma, 4)));
+        }
+    }
+    convertRowsScalar<BPP>(rows, x, width, c);
+}
+
+__attribute__((target("avx2")))
+inline __m256i loadPixelsAvx2(const uint8_t* p, int bpp) {
+    __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    if (bpp == 3) {
+        // 8 pixels in the low 24 bytes: 4 to each 128-bit lane, then one per 32-bit lane
+        pixels = _mm256_permutevar8x32_epi32(pixels, _mm256_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5));
+        pixels = _mm256_shuffle_epi8(pixels, _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                                              0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+    }
+    return pixels;
+}
+
+template <int BPP>
+__attribute__((target("avx2")))
+void rowsAvx2(const RowPair& rows, int width, const Coefficients& c) {
+    const __m256i lowBytes = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i yEven = _mm256_set1_epi32(pairWeights(c.y[0], c.y[2]));
+    const __m256i yOdd = _mm256_set1_epi32(pairWeights(c.y[1], 0));
+    const __m256i uEven = _mm256_set1_epi32(pairWeights(c.u[0], c.u[2]));
+    const __m256i uOdd = _mm256_set1_epi32(pairWeights(c.u[1], 0));
+    const __m256i vEven = _mm256_set1_epi32(pairWeights(c.v[0], c.v[2]));
+    const __m256i vOdd = _mm256_set1_epi32(pairWeights(c.v[1], 0));
+    const __m256i lumaBias = _mm256_set1_epi32(c.lumaBias);
+    const __m256i chromaBias = _mm256_set1_epi32(c.chromaBias);
+    // Undo the per-lane interleaving of packs
+    const __m256i packOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256i quadOrder = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+    const size_t rowBytes = static_cast<size_t>(width) * BPP;
+    int x = 0;
+    // 16 pixels per step; the second load of each row reads 32 bytes
+    for (; static_cast<size_t>(x + 8) * BPP + 32 <= rowBytes; x += 16) {
+        __m256i even[4], odd[4], lumaWords[2];
+        const uint8_t* sources[4] = {rows.top + x * BPP, rows.top + (x + 8) * BPP,
+                                     rows.bottom + x * BPP, rows.bottom + (x + 8) * BPP};
+        for (int i = 0; i < 4; ++i) {
+            __m256i pixels = loadPixelsAvx2(sources[i], BPP);
+            even[i] = _mm256_and_si256(pixels, lowBytes);
+            odd[i] = _mm256_srli_epi16(pixels, 8);
+        }
+        for (int row = 0; row < 2; ++row) {
+            __m256i first = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(even[2 * row], yEven),
+                                                              _mm256_madd_epi16(odd[2 * row], yOdd)), lumaBias);
+            __m256i second = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(even[2 * row + 1], yEven),
+                                                               _mm256_madd_epi16(odd[2 * row + 1], yOdd)), lumaBias);
+            lumaWords[row] = _mm256_packs_epi32(_mm256_srai_epi32(first, 15), _mm256_srai_epi32(second, 15));
+        }
+        __m256i lumaBytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lumaWords[0], lumaWords[1]), packOrder);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rows.yTop + x), _mm256_castsi256_si128(lumaBytes));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rows.yBottom + x), _mm256_extracti128_si256(lumaBytes, 1));
+
+        // Pixels 0-7 pair up in even lanes, 8-15 in odd ones -> quads 0,4,1,5,2,6,3,7
+        __m256i evenLeft = _mm256_add_epi16(even[0], even[2]), evenRight = _mm256_add_epi16(even[1], even[3]);
+        __m256i oddLeft = _mm256_add_epi16(odd[0], odd[2]), oddRight = _mm256_add_epi16(odd[1], odd[3]);
+        __m256i evenQuads = _mm256_blend_epi32(_mm256_add_epi16(evenLeft, _mm256_srli_epi64(evenLeft, 32)),
+                                               _mm256_add_epi16(evenRight, _mm256_slli_epi64(evenRight, 32)), 0xAA);
+        __m256i oddQuads = _mm256_blend_epi32(_mm256_add_epi16(oddLeft, _mm256_srli_epi64(oddLeft, 32)),
+                                              _mm256_add_epi16(oddRight, _mm256_slli_epi64(oddRight, 32)), 0xAA);
+
+        __m256i u = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(evenQuads, uEven),
+                                                      _mm256_madd_epi16(oddQuads, uOdd)), chromaBias);
+        __m256i v = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(evenQuads, vEven),
+                                                      _mm256_madd_epi16(oddQuads, vOdd)), chromaBias);
+        u = _mm256_permutevar8x32_epi32(_mm256_srai_epi32(u, 17), quadOrder);
+        v = _mm256_permutevar8x32_epi32(_mm256_srai_epi32(v, 17), quadOrder);
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(u, v), _mm256_setzero_si256());
+        __m128i chroma = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(packed, packOrder)); // u0-7 v0-7
+
+        const size_t offset = static_cast<size_t>(x / 2) * rows.chromaStep;
+        if (rows.chromaStep == 1) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.u + offset), chroma);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.v + offset), _mm_srli_si128(chroma, 8));
+        } else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rows.u + offset),
+                             _mm_unpacklo_epi8(chroma, _mm_srli_si128(chroma, 8)));
+        }
+    }
+    convertRowsScalar<BPP>(rows, x, width, c);
+}
+
+#endif // RECORDIFY_CONVERT_X86
+
+RowKernel kernelFor(Isa isa, int bpp) {
+#ifdef RECORDIFY_CONVERT_X86
+    switch (isa) {
+        case Isa::AVX2: return bpp == 3 ? &rowsAvx2<3> : &rowsAvx2<4>;
+        case Isa::SSSE3: return bpp == 3 ? &rowsSsse3<3> : &rowsSsse3<4>;
+        case Isa::SCALAR: break;
+    }
+#else
+    (void)isa;
+#endif
+    return bpp == 3 ? &rowsScalar<3> : &rowsScalar<4>;
+}
+
+std::atomic<Isa>& activeIsaSlot() {
+    static std::atomic<Isa> isa{detectIsa()};
+    return isa;
+}
+
+bool convert(const uint8_t* pixels, int width, int height, size_t stride, PixelFormat format,
+             uint8_t* y, size_t yStride, uint8_t* u, size_t uStride, uint8_t* v, size_t vStride,
+             int chromaStep, const ConvertOptions& options) {
+    const int bpp = bytesPerPixel(format);
+    const size_t chromaBytes = static_cast<size_t>(chromaWidth(width)) * chromaStep;
+    if (!pixels || !y || !u || !v || width <= 0 || height <= 0 ||
+        stride < static_cast<size_t>(width) * bpp || yStride < static_cast<size_t>(width) ||
+        uStride < chromaBytes || vStride < chromaBytes) {
+        return false;
+    }
+
+    const Coefficients coefficients = makeCoefficients(options, format);
+    const RowKernel kernel = kernelFor(activeIsa(), bpp);
+    const int chromaRows = chromaHeight(height);
+
+    auto convertBand = [&](int first, int last) {
+        for (int row = first; row < last; ++row) {
+            const int top = 2 * row, bottom = std::min(top + 1, height - 1);
+            RowPair rows;
+            rows.top = pixels + stride * top;
+            rows.bottom = pixels + stride * bottom;
+            rows.yTop = y + yStride * top;
+            rows.yBottom = y + yStride * bottom;
+            rows.u = u + uStride * row;
+            rows.v = v + vStride * row;
+            rows.chromaStep = chromaStep;
+            kernel(rows, width, coefficients);
+        }
+    };
+
+    int threadCount = options.threadCount;
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    // Bands under ~32 row pairs cost more to hand out than to convert
+    threadCount = std::max(1, std::min(threadCount, chromaRows / 32));
+
+    // Band 0 runs on the calling thread
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<size_t>(threadCount - 1));
+    for (int band = 1; band < threadCount; ++band) {
+        workers.emplace_back(convertBand, chromaRows * band / threadCount, chromaRows * (band + 1) / threadCount);
+    }
+    convertBand(0, chromaRows / threadCount);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return true;
+}
+
+} // namespace
+
+Isa detectIsa() {
+#ifdef RECORDIFY_CONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+    if (__builtin_cpu_supports("ssse3")) return Isa::SSSE3;
+#endif
+    return Isa::SCALAR;
+}
+
+Isa activeIsa() {
+    return activeIsaSlot().load(std::memory_order_relaxed);
+}
+
+void setActiveIsa(Isa isa) {
+    activeIsaSlot().store(std::min(isa, detectIsa()), std::memory_order_relaxed);
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2: return "avx2";
+        case Isa::SSSE3: return "ssse3";
+        case Isa::SCALAR: return "scalar";
+    }
+    return "unknown";
+}
+
+bool convertToI420(const uint8_t* pixels, int width, int height, size_t stride, PixelFormat format,
+                   uint8_t* y, size_t yStride, uint8_t* u, size_t uStride, uint8_t* v, size_t vStride,
+                   const ConvertOptions& options) {
+    return convert(pixels, width, height, stride, format, y, yStride, u, uStride, v, vStride, 1, options);
+}
+
+bool convertToNV12(const uint8_t* pixels, int width, int height, size_t stride, PixelFormat format,
+                   uint8_t* y, size_t yStride, uint8_t* uv, size_t uvStride, const ConvertOptions& options) {
+    return convert(pixels, width, height, stride, format, y, yStride, uv, uvStride, uv ? uv + 1 : nullptr,
+                   uvStride, 2, options);
+}
+
+} // namespace ColorConvert
+}} // namespace Recordify::Utils
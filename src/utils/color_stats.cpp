@@ -0,0 +1,657 @@
+#include "utils/color_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RECORDIFY_STATS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Recordify {
+namespace Utils {
+
+namespace {
+
+constexpr int BUCKET_COUNT = 1 << (COLOR_BUCKET_BITS * 3);
+constexpr int BUCKET_SHIFT = 8 - COLOR_BUCKET_BITS;
+
+// 16.16 reciprocals so HSV saturation needs no per-pixel division. The
+// result equals floor(spread * 255 / max), which the SIMD kernels compute
+// exactly in single precision.
+struct SaturationTable {
+    uint32_t reciprocal[256];
+    
+    SaturationTable() {
+        reciprocal[0] = 0;
+        for (int value = 1; value < 256; ++value) {
+            reciprocal[value] = ((255u << 16) + value - 1) / value;
+        }
+    }
+};
+
+const SaturationTable& saturationTable() {
+    static const SaturationTable table;
+    return table;
+}
+
+struct Bucket {
+    uint64_t count = 0;
+    uint64_t r = 0, g = 0, b = 0;
+};
+
+struct Accumulator {
+    uint64_t count = 0;
+    uint64_t sumR = 0, sumG = 0, sumB = 0;
+    uint64_t sumLuma = 0, sumLumaSquared = 0;
+    uint64_t sumSaturation = 0; // scaled 0-255
+    std::array<uint32_t, 256> histogram{};
+    std::vector<Bucket> buckets = std::vector<Bucket>(BUCKET_COUNT);
+    
+    void reset() {
+        count = sumR = sumG = sumB = 0;
+        sumLuma = sumLumaSquared = sumSaturation = 0;
+        histogram.fill(0);
+        std::fill(buckets.begin(), buckets.end(), Bucket());
+    }
+    
+    void merge(const Accumulator& other) {
+        count += other.count;
+        sumR += other.sumR;
+        sumG += other.sumG;
+        sumB += other.sumB;
+        sumLuma += other.sumLuma;
+        sumLumaSquared += other.sumLumaSquared;
+        sumSaturation += other.sumSaturation;
+        for (int i = 0; i < 256; ++i) {
+            histogram[i] += other.histogram[i];
+        }
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            buckets[i].count += other.buckets[i].count;
+            buckets[i].r += other.buckets[i].r;
+            buckets[i].g += other.buckets[i].g;
+            buckets[i].b += other.buckets[i].b;
+        }
+    }
+};
+
+// Rows are analysed in chunks of packed 32-bit pixels; the SIMD kernels keep
+// 32-bit lane sums, which cannot overflow within one chunk
+constexpr size_t CHUNK_PIXELS = 256;
+
+// Adds the channel, luma and saturation sums of `count` (<= CHUNK_PIXELS)
+// packed BGRX pixels to acc, and stores each pixel's luma
+using SumKernel = void (*)(const uint8_t* pixels, size_t count, uint8_t* luma, Accumulator& acc);
+
+#ifdef RECORDIFY_STATS_X86
+
+// Tail of the SIMD kernels, one pixel at a time
+void sumPixelsScalar(const uint8_t* pixels, size_t count, uint8_t* luma, Accumulator& acc) {
+    const uint32_t* reciprocal = saturationTable().reciprocal;
+    uint64_t sumR = 0, sumG = 0, sumB = 0, sumLuma = 0, sumLumaSquared = 0, sumSaturation = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* pixel = pixels + i * 4;
+        const uint32_t b = pixel[0];
+        const uint32_t g = pixel[1];
+        const uint32_t r = pixel[2];
+        const uint32_t y = (77 * r + 150 * g + 29 * b + 128) >> 8;
+        const uint32_t maxChannel = std::max(r, std::max(g, b));
+        const uint32_t minChannel = std::min(r, std::min(g, b));
+        luma[i] = static_cast<uint8_t>(y);
+        sumR += r;
+        sumG += g;
+        sumB += b;
+        sumLuma += y;
+        sumLumaSquared += y * y;
+        sumSaturation += ((maxChannel - minChannel) * reciprocal[maxChannel]) >> 16;
+    }
+    acc.sumR += sumR;
+    acc.sumG += sumG;
+    acc.sumB += sumB;
+    acc.sumLuma += sumLuma;
+    acc.sumLumaSquared += sumLumaSquared;
+    acc.sumSaturation += sumSaturation;
+}
+
+// Eight pixels per step in 16-bit lanes: channels unpacked from two loads,
+// luma with 16-bit multiplies (at most 65408), sums widened by madd against
+// ones, and saturation as a truncated float division by max(channel, 1)
+__attribute__((target("sse2")))
+void sumPixelsSse2(const uint8_t* pixels, size_t count, uint8_t* luma, Accumulator& acc) {
+    const __m128i byteMask = _mm_set1_epi32(0xff);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weightR = _mm_set1_epi16(77);
+    const __m128i weightG = _mm_set1_epi16(150);
+    const __m128i weightB = _mm_set1_epi16(29);
+    const __m128i rounding = _mm_set1_epi16(128);
+    const __m128i fullScale = _mm_set1_epi16(255);
+    __m128i sumR = zero, sumG = zero, sumB = zero, sumLuma = zero, sumSquares = zero, sumSaturation = zero;
+    
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4 + 16));
+        const __m128i b = _mm_packs_epi32(_mm_and_si128(lo, byteMask), _mm_and_si128(hi, byteMask));
+        const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), byteMask),
+                                          _mm_and_si128(_mm_srli_epi32(hi, 8), byteMask));
+        const __m128i r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), byteMask),
+                                          _mm_and_si128(_mm_srli_epi32(hi, 16), byteMask));
+        
+        const __m128i y = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, weightR),
+                                                                     _mm_mullo_epi16(g, weightG)),
+                                                       _mm_add_epi16(_mm_mullo_epi16(b, weightB), rounding)), 8);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(luma + i), _mm_packus_epi16(y, y));
+        
+        const __m128i maxChannel = _mm_max_epi16(r, _mm_max_epi16(g, b));
+        const __m128i minChannel = _mm_min_epi16(r, _mm_min_epi16(g, b));
+        const __m128i spread = _mm_mullo_epi16(_mm_sub_epi16(maxChannel, minChannel), fullScale);
+        const __m128i divisor = _mm_max_epi16(maxChannel, ones);
+        const __m128i saturationLo = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(spread, zero)),
+                                                                 _mm_cvtepi32_ps(_mm_unpacklo_epi16(divisor, zero))));
+        const __m128i saturationHi = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(spread, zero)),
+                                                                 _mm_cvtepi32_ps(_mm_unpackhi_epi16(divisor, zero))));
+        
+        sumR = _mm_add_epi32(sumR, _mm_madd_epi16(r, ones));
+        sumG = _mm_add_epi32(sumG, _mm_madd_epi16(g, ones));
+        sumB = _mm_add_epi32(sumB, _mm_madd_epi16(b, ones));
+        sumLuma = _mm_add_epi32(sumLuma, _mm_madd_epi16(y, ones));
+        sumSquares = _mm_add_epi32(sumSquares, _mm_madd_epi16(y, y));
+        sumSaturation = _mm_add_epi32(sumSaturation, _mm_add_epi32(saturationLo, saturationHi));
+    }
+    
+    alignas(16) uint32_t lanes[6][4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), sumR);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), sumG);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), sumB);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[3]), sumLuma);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[4]), sumSquares);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[5]), sumSaturation);
+    uint64_t totals[6] = {};
+    for (int sum = 0; sum < 6; ++sum) {
+        totals[sum] = static_cast<uint64_t>(lanes[sum][0]) + lanes[sum][1] + lanes[sum][2] + lanes[sum][3];
+    }
+    acc.sumR += totals[0];
+    acc.sumG += totals[1];
+    acc.sumB += totals[2];
+    acc.sumLuma += totals[3];
+    acc.sumLumaSquared += totals[4];
+    acc.sumSaturation += totals[5];
+    
+    sumPixelsScalar(pixels + i * 4, count - i, luma + i, acc);
+}
+
+// Same as SSE2 with sixteen pixels per step. packs works within 128-bit
+// lanes, which the sums don't mind; luma is put back in order before storing.
+__attribute__((target("avx2")))
+void sumPixelsAvx2(const uint8_t* pixels, size_t count, uint8_t* luma, Accumulator& acc) {
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i weightR = _mm256_set1_epi16(77);
+    const __m256i weightG = _mm256_set1_epi16(150);
+    const __m256i weightB = _mm256_set1_epi16(29);
+    const __m256i rounding = _mm256_set1_epi16(128);
+    const __m256i fullScale = _mm256_set1_epi16(255);
+    __m256i sumR = zero, sumG = zero, sumB = zero, sumLuma = zero, sumSquares = zero, sumSaturation = zero;
+    
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4));
+        const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4 + 32));
+        const __m256i b = _mm256_packs_epi32(_mm256_and_si256(lo, byteMask), _mm256_and_si256(hi, byteMask));
+        const __m256i g = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, 8), byteMask),
+                                             _mm256_and_si256(_mm256_srli_epi32(hi, 8), byteMask));
+        const __m256i r = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, 16), byteMask),
+                                             _mm256_and_si256(_mm256_srli_epi32(hi, 16), byteMask));
+        
+        const __m256i y = _mm256_srli_epi16(
+            _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(r, weightR), _mm256_mullo_epi16(g, weightG)),
+                             _mm256_add_epi16(_mm256_mullo_epi16(b, weightB), rounding)), 8);
+        const __m256i ordered = _mm256_permute4x64_epi64(y, 0xD8);
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(ordered, ordered), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(luma + i), _mm256_castsi256_si128(packed));
+        
+        const __m256i maxChannel = _mm256_max_epi16(r, _mm256_max_epi16(g, b));
+        const __m256i minChannel = _mm256_min_epi16(r, _mm256_min_epi16(g, b));
+        const __m256i spread = _mm256_mullo_epi16(_mm256_sub_epi16(maxChannel, minChannel), fullScale);
+        const __m256i divisor = _mm256_max_epi16(maxChannel, ones);
+        const __m256i saturationLo = _mm256_cvttps_epi32(
+            _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_unpacklo_epi16(spread, zero)),
+                          _mm256_cvtepi32_ps(_mm256_unpacklo_epi16(divisor, zero))));
+        const __m256i saturationHi = _mm256_cvttps_epi32(
+            _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_unpackhi_epi16(spread, zero)),
+                          _mm256_cvtepi32_ps(_mm256_unpackhi_epi16(divisor, zero))));
+        
+        sumR = _mm256_add_epi32(sumR, _mm256_madd_epi16(r, ones));
+        sumG = _mm256_add_epi32(sumG, _mm256_madd_epi16(g, ones));
+        sumB = _mm256_add_epi32(sumB, _mm256_madd_epi16(b, ones));
+        sumLuma = _mm256_add_epi32(sumLuma, _mm256_madd_epi16(y, ones));
+        sumSquares = _mm256_add_epi32(sumSquares, _mm256_madd_epi16(y, y));
+        sumSaturation = _mm256_add_epi32(sumSaturation, _mm256_add_epi32(saturationLo, saturationHi));
+    }
+    
+    alignas(32) uint32_t lanes[6][8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), sumR);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), sumG);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[2]), sumB);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[3]), sumLuma);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[4]), sumSquares);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[5]), sumSaturation);
+    uint64_t totals[6] = {};
+    for (int sum = 0; sum < 6; ++sum) {
+        for (int lane = 0; lane < 8; ++lane) {
+            totals[sum] += lanes[sum][lane];
+        }
+    }
+    acc.sumR += totals[0];
+    acc.sumG += totals[1];
+    acc.sumB += totals[2];
+    acc.sumLuma += totals[3];
+    acc.sumLumaSquared += totals[4];
+    acc.sumSaturation += totals[5];
+    
+    sumPixelsScalar(pixels + i * 4, count - i, luma + i, acc);
+}
+
+#endif // RECORDIFY_STATS_X86
+
+// Null for scalar, which folds every run instead
+SumKernel kernelFor(ColorStatsKernels::Isa isa) {
+#ifdef RECORDIFY_STATS_X86
+    switch (isa) {
+        case ColorStatsKernels::Isa::AVX2: return &sumPixelsAvx2;
+        case ColorStatsKernels::Isa::SSE2: return &sumPixelsSse2;
+        case ColorStatsKernels::Isa::SCALAR: break;
+    }
+#else
+    (void)isa;
+#endif
+    return nullptr;
+}
+
+std::atomic<ColorStatsKernels::Isa>& activeIsaSlot() {
+    static std::atomic<ColorStatsKernels::Isa> isa{ColorStatsKernels::detectIsa()};
+    return isa;
+}
+
+// Histogram and palette share of a run of identical pixels
+inline void scatterRun(uint32_t r, uint32_t g, uint32_t b, uint32_t luma, uint32_t length, Accumulator& acc) {
+    acc.histogram[luma] += length;
+    Bucket& bucket = acc.buckets[((r >> BUCKET_SHIFT) << (2 * COLOR_BUCKET_BITS)) |
+                                 ((g >> BUCKET_SHIFT) << COLOR_BUCKET_BITS) |
+                                 (b >> BUCKET_SHIFT)];
+    bucket.count += length;
+    bucket.r += r * length;
+    bucket.g += g * length;
+    bucket.b += b * length;
+}
+
+// Folds a whole run into the sums as well, for runs long enough that this
+// beats summing their pixels one by one
+inline void addRun(const uint8_t* pixel, uint32_t length, const uint32_t* reciprocal, Accumulator& acc) {
+    const uint32_t b = pixel[0];
+    const uint32_t g = pixel[1];
+    const uint32_t r = pixel[2];
+    
+    const uint32_t luma = (77 * r + 150 * g + 29 * b + 128) >> 8;
+    const uint32_t maxChannel = std::max(r, std::max(g, b));
+    const uint32_t minChannel = std::min(r, std::min(g, b));
+    const uint32_t saturation = ((maxChannel - minChannel) * reciprocal[maxChannel]) >> 16;
+    
+    acc.count += length;
+    acc.sumR += r * length;
+    acc.sumG += g * length;
+    acc.sumB += b * length;
+    acc.sumLuma += luma * length;
+    acc.sumLumaSquared += static_cast<uint64_t>(luma * luma) * length;
+    acc.sumSaturation += saturation * length;
+    scatterRun(r, g, b, luma, length, acc);
+}
+
+// Chunks averaging shorter runs than this go to the SIMD kernel
+constexpr size_t SIMD_RUN_LENGTH = 16;
+
+// Run of identical pixels within a chunk, in sampled pixels
+struct Run {
+    uint16_t start;
+    uint16_t length;
+};
+
+// Selects the three color bytes of a pixel loaded as a 32-bit word
+uint32_t colorMask() {
+    static const uint32_t mask = []() {
+        const uint8_t bytes[4] = {0xff, 0xff, 0xff, 0};
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }();
+    return mask;
+}
+
+// Splits `count` pixels `step` bytes apart into runs; returns how many.
+// Wide pixels (4+ bytes) are compared as masked 32-bit words.
+template <bool Wide>
+size_t findRuns(const uint8_t* pixels, size_t count, size_t step, Run* runs) {
+    auto key = [pixels, step](size_t index) {
+        const uint8_t* pixel = pixels + index * step;
+        if (Wide) {
+            uint32_t word;
+            std::memcpy(&word, pixel, sizeof(word));
+            return word & colorMask();
+        }
+        return static_cast<uint32_t>(pixel[0] | (pixel[1] << 8) | (pixel[2] << 16));
+    };
+    
+    size_t runCount = 0;
+    uint32_t runKey = key(0);
+    size_t runStart = 0;
+    for (size_t i = 1; i < count; ++i) {
+        const uint32_t next = key(i);
+        if (next != runKey) {
+            runs[runCount++] = Run{static_cast<uint16_t>(runStart), static_cast<uint16_t>(i - runStart)};
+            runKey = next;
+            runStart = i;
+        }
+    }
+    runs[runCount++] = Run{static_cast<uint16_t>(runStart), static_cast<uint16_t>(count - runStart)};
+    return runCount;
+}
+
+// Scalar path: every run of identical pixels is folded once as it ends
+void accumulateRowRuns(const uint8_t* row, int width, int bytesPerPixel, int columnStep,
+                       const uint32_t* reciprocal, Accumulator& acc) {
+    const size_t step = static_cast<size_t>(columnStep) * bytesPerPixel;
+    const uint8_t* end = row + static_cast<size_t>(width) * bytesPerPixel;
+    
+    const uint8_t* runStart = row;
+    uint32_t runKey = row[0] | (row[1] << 8) | (row[2] << 16);
+    uint32_t runLength = 0;
+    for (const uint8_t* pixel = row; pixel < end; pixel += step) {
+        const uint32_t key = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+        if (key != runKey) {
+            addRun(runStart, runLength, reciprocal, acc);
+            runStart = pixel;
+            runKey = key;
+            runLength = 0;
+        }
+        ++runLength;
+    }
+    addRun(runStart, runLength, reciprocal, acc);
+}
+
+// Screen content mostly comes in long runs, which are folded into every sum
+// once. Chunks of short runs (photos, video, gradients) have their sums
+// added up per pixel by the SIMD kernel, and only the histogram and palette
+// go per run.
+void accumulateRowChunks(const uint8_t* row, int width, int bytesPerPixel, int columnStep, SumKernel sumPixels,
+                         const uint32_t* reciprocal, Accumulator& acc) {
+    alignas(32) uint8_t packed[CHUNK_PIXELS * 4];
+    alignas(32) uint8_t luma[CHUNK_PIXELS];
+    Run runs[CHUNK_PIXELS];
+    const size_t samples = (static_cast<size_t>(width) + columnStep - 1) / columnStep;
+    const size_t step = static_cast<size_t>(columnStep) * bytesPerPixel;
+    
+    for (size_t first = 0; first < samples; first += CHUNK_PIXELS) {
+        const size_t count = std::min(CHUNK_PIXELS, samples - first);
+        const uint8_t* pixels = row + first * step;
+        const size_t runCount = bytesPerPixel >= 4 ? findRuns<true>(pixels, count, step, runs)
+                                                   : findRuns<false>(pixels, count, step, runs);
+        
+        if (runCount * SIMD_RUN_LENGTH <= count) {
+            for (size_t i = 0; i < runCount; ++i) {
+                addRun(pixels + runs[i].start * step, runs[i].length, reciprocal, acc);
+            }
+            continue;
+        }
+        
+        // The kernels take packed 32-bit pixels
+        if (bytesPerPixel != 4 || columnStep != 1) {
+            if (bytesPerPixel >= 4) {
+                for (size_t i = 0; i < count; ++i) {
+                    std::memcpy(&packed[i * 4], pixels + i * step, 4);
+                }
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    std::memcpy(&packed[i * 4], pixels + i * step, 3);
+                }
+            }
+            pixels = packed;
+        }
+        sumPixels(pixels, count, luma, acc);
+        acc.count += count;
+        for (size_t i = 0; i < runCount; ++i) {
+            const uint8_t* pixel = pixels + runs[i].start * 4;
+            scatterRun(pixel[2], pixel[1], pixel[0], luma[runs[i].start], runs[i].length, acc);
+        }
+    }
+}
+
+void accumulateBand(const uint8_t* pixels, int width, size_t stride, int bytesPerPixel,
+                    int rowStep, int columnStep, int firstRow, int lastRow, Accumulator& acc) {
+    const SumKernel sumPixels = kernelFor(activeIsaSlot().load(std::memory_order_relaxed));
+    const uint32_t* reciprocal = saturationTable().reciprocal;
+    for (int sampledRow = firstRow; sampledRow < lastRow; ++sampledRow) {
+        const uint8_t* row = pixels + stride * static_cast<size_t>(sampledRow) * rowStep;
+        if (sumPixels) {
+            accumulateRowChunks(row, width, bytesPerPixel, columnStep, sumPixels, reciprocal, acc);
+        } else {
+            accumulateRowRuns(row, width, bytesPerPixel, columnStep, reciprocal, acc);
+        }
+    }
+}
+
+struct BandJob {
+    const uint8_t* pixels;
+    int width;
+    size_t stride;
+    int bytesPerPixel, rowStep, columnStep;
+    int sampledRows, bands;
+    
+    void run(int band, Accumulator& acc) const {
+        acc.reset();
+        accumulateBand(pixels, width, stride, bytesPerPixel, rowStep, columnStep,
+                       sampledRows * band / bands, sampledRows * (band + 1) / bands, acc);
+    }
+};
+
+// Workers and their accumulators kept for the life of the process. Worker i
+// takes band i + 1 and the caller band 0. One call uses them at a time; a
+// call that finds them busy analyses on its own thread instead of waiting.
+class BandPool {
+public:
+    static BandPool& instance() {
+        static BandPool pool;
+        return pool;
+    }
+    
+    ~BandPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+    }
+    
+    std::mutex& callMutex() { return m_callMutex; }
+    
+    // callMutex held; merges every band into `total`
+    void run(const BandJob& job, Accumulator& total) {
+        while (m_workers.size() + 1 < static_cast<size_t>(job.bands)) {
+            const size_t index = m_workers.size();
+            m_accumulators.push_back(std::make_unique<Accumulator>());
+            m_workers.emplace_back([this, index]() { workerLoop(index); });
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_job = &job;
+            m_pending = job.bands - 1;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+        
+        job.run(0, total);
+        
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_pending == 0; });
+        m_job = nullptr;
+        for (int band = 1; band < job.bands; ++band) {
+            total.merge(*m_accumulators[static_cast<size_t>(band - 1)]);
+        }
+    }
+    
+private:
+    BandPool() = default;
+    
+    void workerLoop(size_t index) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&]() { return m_stopping || m_generation != seen; });
+            if (m_stopping) {
+                return;
+            }
+            seen = m_generation;
+            // A worker with no band in a call can wake after it has finished
+            const BandJob* job = m_job;
+            const int band = static_cast<int>(index) + 1;
+            if (!job || band >= job->bands) {
+                continue;
+            }
+            Accumulator& acc = *m_accumulators[index];
+            lock.unlock();
+            job->run(band, acc);
+            lock.lock();
+            if (--m_pending == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+    
+    std::mutex m_callMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_done;
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<Accumulator>> m_accumulators;
+    const BandJob* m_job = nullptr;
+    uint64_t m_generation = 0;
+    int m_pending = 0;
+    bool m_stopping = false;
+};
+
+} // namespace
+
+namespace ColorStatsKernels {
+
+Isa detectIsa() {
+#ifdef RECORDIFY_STATS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+    if (__builtin_cpu_supports("sse2")) return Isa::SSE2;
+#endif
+    return Isa::SCALAR;
+}
+
+Isa activeIsa() {
+    return activeIsaSlot().load(std::memory_order_relaxed);
+}
+
+void setActiveIsa(Isa isa) {
+    activeIsaSlot().store(std::min(isa, detectIsa()), std::memory_order_relaxed);
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2: return "avx2";
+        case Isa::SSE2: return "sse2";
+        case Isa::SCALAR: return "scalar";
+    }
+    return "unknown";
+}
+
+} // namespace ColorStatsKernels
+
+ColorStatsResult computeColorStats(const uint8_t* pixels, int width, int height, size_t stride,
+                                   int bytesPerPixel, const ColorStatsOptions& options) {
+    ColorStatsResult result;
+    if (!pixels || width <= 0 || height <= 0 || bytesPerPixel < 3) {
+        return result;
+    }
+    
+    const int rowStep = std::max(1, options.rowStep);
+    const int columnStep = std::max(1, options.columnStep);
+    const int sampledRows = (height + rowStep - 1) / rowStep;
+    
+    int threadCount = options.threadCount;
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threadCount = std::min(threadCount, sampledRows);
+    
+    // Accumulators are reused from call to call; band 0 runs on the calling thread
+    static thread_local Accumulator total;
+    BandJob job = {pixels, width, stride, bytesPerPixel, rowStep, columnStep, sampledRows, threadCount};
+    if (threadCount > 1) {
+        BandPool& pool = BandPool::instance();
+        std::unique_lock<std::mutex> call(pool.callMutex(), std::try_to_lock);
+        if (call.owns_lock()) {
+            pool.run(job, total);
+        } else {
+            job.bands = 1;
+            job.run(0, total);
+        }
+    } else {
+        job.run(0, total);
+    }
+    if (total.count == 0) {
+        return result;
+    }
+    
+    const double count = static_cast<double>(total.count);
+    const double meanLuma = total.sumLuma / count;
+    const double variance = std::max(0.0, total.sumLumaSquared / count - meanLuma * meanLuma);
+    
+    result.sampleCount = total.count;
+    result.meanRed = static_cast<float>(total.sumR / count);
+    result.meanGreen = static_cast<float>(total.sumG / count);
+    result.meanBlue = static_cast<float>(total.sumB / count);
+    result.meanLuminance = static_cast<float>(meanLuma);
+    result.luminanceStdDev = static_cast<float>(std::sqrt(variance));
+    result.meanSaturation = static_cast<float>(total.sumSaturation / (count * 255.0));
+    result.luminanceHistogram = total.histogram;
+    
+    // Most populated buckets, each reported as the mean of its pixels
+    std::array<int, BUCKET_COUNT> order;
+    std::iota(order.begin(), order.end(), 0);
+    const size_t paletteSize = std::min<size_t>(static_cast<size_t>(std::max(0, options.paletteSize)), order.size());
+    std::partial_sort(order.begin(), order.begin() + paletteSize, order.end(), [&](int a, int b) {
+        return total.buckets[a].count > total.buckets[b].count;
+    });
+    
+    result.palette.reserve(paletteSize);
+    for (size_t i = 0; i < paletteSize; ++i) {
+        const Bucket& bucket = total.buckets[order[i]];
+        if (bucket.count == 0) {
+            break;
+        }
+        ColorStatsResult::PaletteEntry entry;
+        entry.r = static_cast<uint8_t>(bucket.r / bucket.count);
+        entry.g = static_cast<uint8_t>(bucket.g / bucket.count);
+        entry.b = static_cast<uint8_t>(bucket.b / bucket.count);
+        entry.share = static_cast<float>(bucket.count / count);
+        result.palette.push_back(entry);
+    }
+    
+    return result;
+}
+
+}} // namespace Recordify::Utils
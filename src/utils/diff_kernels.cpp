@@ -0,0 +1,251 @@
+#include "utils/diff_kernels.h"
+#include <algorithm>
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RECORDIFY_DIFF_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Recordify {
+namespace Utils {
+namespace DiffKernels {
+
+namespace {
+
+using RowKernel = void (*)(const uint8_t*, const uint8_t*, size_t, uint8_t, DiffResult&);
+
+void diffRowScalar(const uint8_t* a, const uint8_t* b, size_t length, uint8_t threshold,
+                   DiffResult& result) {
+    uint64_t changed = 0;
+    uint64_t changedPixels = 0;
+    uint64_t sad = 0;
+    uint8_t maxDelta = result.maxDelta;
+    // Returns whether the byte changed
+    auto diffByte = [&](size_t i) {
+        uint8_t delta = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        changed += delta > threshold;
+        sad += delta;
+        maxDelta = std::max(maxDelta, delta);
+        return delta > threshold;
+    };
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        const bool pixelChanged = diffByte(i) | diffByte(i + 1) | diffByte(i + 2) | diffByte(i + 3);
+        changedPixels += pixelChanged;
+    }
+    bool partialChanged = false; // a partial pixel at the end of the run
+    for (; i < length; ++i) {
+        partialChanged |= diffByte(i);
+    }
+    changedPixels += partialChanged;
+    result.changedBytes += changed;
+    result.changedPixels += changedPixels;
+    result.sad += sad;
+    result.maxDelta = maxDelta;
+}
+
+#ifdef RECORDIFY_DIFF_X86
+
+__attribute__((target("sse2")))
+void diffRowSse2(const uint8_t* a, const uint8_t* b, size_t length, uint8_t threshold,
+                 DiffResult& result) {
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sad = _mm_setzero_si128();
+    __m128i maxDelta = _mm_setzero_si128();
+    const __m128i allSet = _mm_cmpeq_epi32(zero, zero);
+    __m128i unchangedPixels = _mm_setzero_si128(); // per 32-bit lane
+    uint64_t changed = 0;
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i delta = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+
+        sad = _mm_add_epi64(sad, _mm_sad_epu8(va, vb));
+        maxDelta = _mm_max_epu8(maxDelta, delta);
+
+        // Bytes at or below the threshold saturate to zero
+        __m128i unchanged = _mm_cmpeq_epi8(_mm_subs_epu8(delta, limit), zero);
+        changed += 16 - __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(unchanged)));
+        // A pixel is unchanged when all four of its bytes are; the compare gives -1
+        unchangedPixels = _mm_sub_epi32(unchangedPixels, _mm_cmpeq_epi32(unchanged, allSet));
+    }
+
+    alignas(16) uint64_t sadLanes[2];
+    alignas(16) uint8_t maxLanes[16];
+    alignas(16) uint32_t unchangedLanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(sadLanes), sad);
+    _mm_store_si128(reinterpret_cast<__m128i*>(maxLanes), maxDelta);
+    _mm_store_si128(reinterpret_cast<__m128i*>(unchangedLanes), unchangedPixels);
+
+    result.changedBytes += changed;
+    result.changedPixels += i / 4 - (static_cast<uint64_t>(unchangedLanes[0]) + unchangedLanes[1] +
+                                     unchangedLanes[2] + unchangedLanes[3]);
+    result.sad += sadLanes[0] + sadLanes[1];
+    result.maxDelta = std::max(result.maxDelta, *std::max_element(maxLanes, maxLanes + 16));
+
+    if (i < length) {
+        diffRowScalar(a + i, b + i, length - i, threshold, result);
+    }
+}
+
+__attribute__((target("avx2")))
+void diffRowAvx2(const uint8_t* a, const uint8_t* b, size_t length, uint8_t threshold,
+                 DiffResult& result) {
+    const __m256i limit = _mm256_set1_epi8(static_cast<char>(threshold));
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sad = _mm256_setzero_si256();
+    __m256i maxDelta = _mm256_setzero_si256();
+    const __m256i allSet = _mm256_cmpeq_epi32(zero, zero);
+    __m256i unchangedPixels = _mm256_setzero_si256(); // per 32-bit lane
+    uint64_t changed = 0;
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i delta = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+
+        sad = _mm256_add_epi64(sad, _mm256_sad_epu8(va, vb));
+        maxDelta = _mm256_max_epu8(maxDelta, delta);
+
+        __m256i unchanged = _mm256_cmpeq_epi8(_mm256_subs_epu8(delta, limit), zero);
+        changed += 32 - __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(unchanged)));
+        unchangedPixels = _mm256_sub_epi32(unchangedPixels, _mm256_cmpeq_epi32(unchanged, allSet));
+    }
+
+    alignas(32) uint64_t sadLanes[4];
+    alignas(32) uint8_t maxLanes[32];
+    alignas(32) uint32_t unchangedLanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sadLanes), sad);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(maxLanes), maxDelta);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(unchangedLanes), unchangedPixels);
+
+    uint64_t unchangedTotal = 0;
+    for (uint32_t lane : unchangedLanes) {
+        unchangedTotal += lane;
+    }
+    result.changedBytes += changed;
+    result.changedPixels += i / 4 - unchangedTotal;
+    result.sad += sadLanes[0] + sadLanes[1] + sadLanes[2] + sadLanes[3];
+    result.maxDelta = std::max(result.maxDelta, *std::max_element(maxLanes, maxLanes + 32));
+
+    if (i < length) {
+        diffRowSse2(a + i, b + i, length - i, threshold, result);
+    }
+}
+
+#endif // RECORDIFY_DIFF_X86
+
+RowKernel kernelFor(Isa isa) {
+#ifdef RECORDIFY_DIFF_X86
+    switch (isa) {
+        case Isa::AVX2: return &diffRowAvx2;
+        case Isa::SSE2: return &diffRowSse2;
+        case Isa::SCALAR: break;
+    }
+#else
+    (void)isa;
+#endif
+    return &diffRowScalar;
+}
+
+std::atomic<Isa>& activeIsaSlot() {
+    static std::atomic<Isa> isa{detectIsa()};
+    return isa;
+}
+
+} // namespace
+
+Isa detectIsa() {
+#ifdef RECORDIFY_DIFF_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+    if (__builtin_cpu_supports("sse2")) return Isa::SSE2;
+#endif
+    return Isa::SCALAR;
+}
+
+Isa activeIsa() {
+    return activeIsaSlot().load(std::memory_order_relaxed);
+}
+
+void setActiveIsa(Isa isa) {
+    activeIsaSlot().store(std::min(isa, detectIsa()), std::memory_order_relaxed);
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2: return "avx2";
+        case Isa::SSE2: return "sse2";
+        case Isa::SCALAR: return "scalar";
+    }
+    return "unknown";
+}
+
+DiffResult diffBuffers(const uint8_t* current, const uint8_t* previous, size_t length,
+                       uint8_t threshold) {
+    DiffResult result;
+    kernelFor(activeIsa())(current, previous, length, threshold, result);
+    return result;
+}
+
+DiffResult diffRows(const uint8_t* current, size_t currentStride, const uint8_t* previous,
+                    size_t previousStride, size_t rowBytes, int rows, uint8_t threshold) {
+    if (rows <= 0) {
+        return DiffResult{};
+    }
+    // Packed images are one contiguous run
+    if (currentStride == rowBytes && previousStride == rowBytes) {
+        return diffBuffers(current, previous, rowBytes * rows, threshold);
+    }
+
+    RowKernel kernel = kernelFor(activeIsa());
+    DiffResult result;
+    for (int y = 0; y < rows; ++y) {
+        kernel(current + currentStride * y, previous + previousStride * y, rowBytes, threshold, result);
+    }
+    return result;
+}
+
+void diffFrames(const uint8_t* current, const uint8_t* previous, int width, int height,
+                size_t stride, int bytesPerPixel, int tileSize, uint8_t threshold,
+                FrameDiff& result) {
+    diffFrames(current, stride, previous, stride, width, height, bytesPerPixel, tileSize, threshold, result);
+}
+
+void diffFrames(const uint8_t* current, size_t currentStride, const uint8_t* previous, size_t previousStride,
+                int width, int height, int bytesPerPixel, int tileSize, uint8_t threshold,
+                FrameDiff& result) {
+    RowKernel kernel = kernelFor(activeIsa());
+
+    result.tileSize = tileSize;
+    result.tileColumns = (width + tileSize - 1) / tileSize;
+    result.tileRows = (height + tileSize - 1) / tileSize;
+    result.total = DiffResult{};
+    result.tiles.assign(static_cast<size_t>(result.tileColumns) * result.tileRows, DiffResult{});
+
+    // Walk row by row so both frames stream through the cache once
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* rowA = current + currentStride * y;
+        const uint8_t* rowB = previous + previousStride * y;
+        DiffResult* rowTiles = result.tiles.data() + static_cast<size_t>(y / tileSize) * result.tileColumns;
+
+        for (int column = 0; column < result.tileColumns; ++column) {
+            int x = column * tileSize;
+            size_t offset = static_cast<size_t>(x) * bytesPerPixel;
+            size_t length = static_cast<size_t>(std::min(tileSize, width - x)) * bytesPerPixel;
+            kernel(rowA + offset, rowB + offset, length, threshold, rowTiles[column]);
+        }
+    }
+
+    for (const auto& tile : result.tiles) {
+        result.total.merge(tile);
+    }
+}
+
+} // namespace DiffKernels
+}} // namespace Recordify::Utils
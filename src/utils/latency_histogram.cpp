@@ -0,0 +1,160 @@
+#include "utils/latency_histogram.h"
+
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace Recordify {
+namespace Utils {
+
+namespace {
+
+const uint64_t SUB_BUCKETS = 1ull << LatencyHistogram::SUB_BUCKET_BITS;
+
+int highestBit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+
+void clearPhaseCounts(std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT>& counts) {
+    for (auto& count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    value = std::min(value, MAX_VALUE);
+    if (value < 2 * SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    const int shift = highestBit(value) - SUB_BUCKET_BITS;
+    return static_cast<size_t>((static_cast<uint64_t>(shift) << SUB_BUCKET_BITS) + (value >> shift));
+}
+
+uint64_t LatencyHistogram::bucketLowest(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    const int shift = static_cast<int>(index >> SUB_BUCKET_BITS) - 1;
+    return (SUB_BUCKETS + (index & (SUB_BUCKETS - 1))) << shift;
+}
+
+uint64_t LatencyHistogram::bucketHighest(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    const int shift = static_cast<int>(index >> SUB_BUCKET_BITS) - 1;
+    return bucketLowest(index) + (1ull << shift) - 1;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double percent) const {
+    if (count == 0) return 0;
+    if (percent <= 0.0) return min;
+
+    const double wanted = std::ceil(std::min(percent, 100.0) / 100.0 * static_cast<double>(count));
+    const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(wanted));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return std::max(min, std::min(bucketHighest(i), max));
+        }
+    }
+    return max;
+}
+
+uint64_t LatencyHistogram::Snapshot::countAtOrBelow(uint64_t value) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < counts.size() && bucketHighest(i) <= value; ++i) {
+        total += counts[i];
+    }
+    return total;
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+    if (other.count == 0) return;
+    if (counts.size() < other.counts.size()) {
+        counts.resize(other.counts.size(), 0);
+    }
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+    min = count == 0 ? other.min : std::min(min, other.min);
+    max = count == 0 ? other.max : std::max(max, other.max);
+    count += other.count;
+    sum += other.sum;
+}
+
+LatencyHistogram::LatencyHistogram() {
+    for (Phase& phase : m_phases) {
+        clearPhaseCounts(phase.counts);
+    }
+    m_total.counts.assign(BUCKET_COUNT, 0);
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    const uint64_t value = std::min(nanoseconds, MAX_VALUE);
+    const int64_t epoch = m_startEpoch.fetch_add(1, std::memory_order_acq_rel);
+    Phase& phase = m_phases[epoch < 0 ? 1 : 0];
+
+    phase.counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    phase.count.fetch_add(1, std::memory_order_relaxed);
+    phase.sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t current = phase.min.load(std::memory_order_relaxed);
+    while (value < current && !phase.min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = phase.max.load(std::memory_order_relaxed);
+    while (value > current && !phase.max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+
+    phase.endEpoch.fetch_add(1, std::memory_order_release);
+}
+
+void LatencyHistogram::collect() const {
+    // Writer/reader phaser: new records go to the other phase from the
+    // exchange on, and the old phase is complete once its end count catches
+    // up with the start count at the flip.
+    const bool nextIsEven = m_startEpoch.load(std::memory_order_acquire) < 0;
+    const int64_t initial = nextIsEven ? 0 : std::numeric_limits<int64_t>::min();
+    Phase& next = m_phases[nextIsEven ? 0 : 1];
+    Phase& drained = m_phases[nextIsEven ? 1 : 0];
+    next.endEpoch.store(initial, std::memory_order_relaxed);
+
+    const int64_t startAtFlip = m_startEpoch.exchange(initial, std::memory_order_acq_rel);
+    while (drained.endEpoch.load(std::memory_order_acquire) != startAtFlip) {
+        std::this_thread::yield();
+    }
+
+    Snapshot interval;
+    interval.count = drained.count.exchange(0, std::memory_order_relaxed);
+    interval.sum = drained.sum.exchange(0, std::memory_order_relaxed);
+    interval.min = drained.min.exchange(UINT64_MAX, std::memory_order_relaxed);
+    interval.max = drained.max.exchange(0, std::memory_order_relaxed);
+    if (interval.count > 0) {
+        interval.counts.resize(BUCKET_COUNT);
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            interval.counts[i] = drained.counts[i].exchange(0, std::memory_order_relaxed);
+        }
+        m_total.merge(interval);
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    std::lock_guard<std::mutex> lock(m_readerMutex);
+    collect();
+    return m_total;
+}
+
+void LatencyHistogram::reset() {
+    std::lock_guard<std::mutex> lock(m_readerMutex);
+    collect();
+    m_total = Snapshot();
+    m_total.counts.assign(BUCKET_COUNT, 0);
+}
+
+}} // namespace Recordify::Utils
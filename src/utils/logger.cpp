@@ -0,0 +1,249 @@
+#include "utils/logger.h"
+#include "utils/lockfree_queue.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+namespace Recordify {
+namespace Utils {
+
+// LogRecord implementation
+LogRecord::Arg* LogRecord::push(Arg::Type type) {
+    if (argCount >= MAX_ARGS) {
+        truncated = true;
+        return nullptr;
+    }
+    Arg& arg = args[argCount++];
+    arg.type = type;
+    arg.textOffset = 0;
+    arg.textLength = 0;
+    return &arg;
+}
+
+void LogRecord::addText(const char* data, size_t length) {
+    size_t available = TEXT_BYTES - textUsed;
+    if (length > available) {
+        length = available;
+        truncated = true;
+    }
+    Arg* arg = push(Arg::TEXT);
+    if (!arg) {
+        return;
+    }
+    arg->textOffset = textUsed;
+    arg->textLength = static_cast<uint16_t>(length);
+    std::memcpy(text + textUsed, data, length);
+    textUsed = static_cast<uint16_t>(textUsed + length);
+}
+
+void LogRecord::format(std::string& out) const {
+    char scratch[64];
+
+    // HH:MM:SS.mmm LEVEL [Component] message
+    std::time_t seconds = std::chrono::system_clock::to_time_t(timestamp);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        timestamp.time_since_epoch()).count() % 1000;
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    int length = std::snprintf(scratch, sizeof(scratch), "%02d:%02d:%02d.%03d %-5s [%s] ",
+                               local.tm_hour, local.tm_min, local.tm_sec, static_cast<int>(millis),
+                               Logger::levelName(level), component ? component : "");
+    out.append(scratch, static_cast<size_t>(length));
+
+    for (int i = 0; i < argCount; ++i) {
+        const Arg& arg = args[i];
+        switch (arg.type) {
+            case Arg::SIGNED:
+                length = std::snprintf(scratch, sizeof(scratch), "%" PRId64, arg.i);
+                break;
+            case Arg::UNSIGNED:
+                length = std::snprintf(scratch, sizeof(scratch), "%" PRIu64, arg.u);
+                break;
+            case Arg::FLOATING:
+                length = std::snprintf(scratch, sizeof(scratch), "%g", arg.d);
+                break;
+            case Arg::BOOLEAN:
+                length = std::snprintf(scratch, sizeof(scratch), "%s", arg.u ? "true" : "false");
+                break;
+            case Arg::CHARACTER:
+                scratch[0] = static_cast<char>(arg.u);
+                length = 1;
+                break;
+            case Arg::TEXT:
+                out.append(text + arg.textOffset, arg.textLength);
+                length = 0;
+                break;
+        }
+        out.append(scratch, static_cast<size_t>(length));
+    }
+
+    if (truncated) {
+        out.append("...");
+    }
+    out.push_back('\n');
+}
+
+// Logger implementation
+struct Logger::Impl {
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+
+    MpscQueue<LogRecord> queue{QUEUE_CAPACITY};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    uint64_t droppedReported = 0; // logger thread only
+
+    std::mutex outputMutex; // guards output against setOutput* and inline writes
+    FILE* output = stderr;
+    bool ownsOutput = false;
+
+    std::atomic<bool> running{true};
+    std::thread thread;
+    std::string buffer;
+
+    void writeBuffer() {
+        if (!buffer.empty()) {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::fwrite(buffer.data(), 1, buffer.size(), output);
+            std::fflush(output);
+            buffer.clear();
+        }
+    }
+
+    // Formats everything currently queued; returns false if the queue was empty
+    bool drain() {
+        LogRecord record;
+        uint64_t count = 0;
+        while (queue.tryPop(record)) {
+            record.format(buffer);
+            ++count;
+            if (buffer.size() > 64 * 1024) {
+                writeBuffer();
+            }
+        }
+
+        uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+        if (droppedNow != droppedReported) {
+            buffer += "[Logger] " + std::to_string(droppedNow - droppedReported) +
+                      " record(s) dropped, queue full\n";
+            droppedReported = droppedNow;
+        }
+
+        writeBuffer();
+        written.fetch_add(count, std::memory_order_release);
+        return count > 0;
+    }
+
+    void run() {
+        while (running.load(std::memory_order_acquire)) {
+            if (!drain()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+        drain();
+    }
+
+    void closeOutput() {
+        if (ownsOutput) {
+            std::fclose(output);
+        }
+        output = stderr;
+        ownsOutput = false;
+    }
+};
+
+Logger::Logger()
+    : m_impl(std::make_unique<Impl>()) {
+    m_impl->buffer.reserve(64 * 1024);
+    m_impl->thread = std::thread(&Impl::run, m_impl.get());
+}
+
+Logger& Logger::instance() {
+    // Never destroyed so objects logging from static destructors stay safe;
+    // the queue is drained at exit
+    static Logger* logger = [] {
+        auto* created = new Logger();
+        std::atexit([] { Logger::instance().shutdown(); });
+        return created;
+    }();
+    return *logger;
+}
+
+bool Logger::setOutputFile(const std::string& filePath) {
+    FILE* file = std::fopen(filePath.c_str(), "a");
+    if (!file) {
+        return false;
+    }
+    flush();
+    std::lock_guard<std::mutex> lock(m_impl->outputMutex);
+    m_impl->closeOutput();
+    m_impl->output = file;
+    m_impl->ownsOutput = true;
+    return true;
+}
+
+void Logger::setOutputStderr() {
+    flush();
+    std::lock_guard<std::mutex> lock(m_impl->outputMutex);
+    m_impl->closeOutput();
+}
+
+void Logger::submit(const LogRecord& record) {
+    if (!m_impl->running.load(std::memory_order_acquire)) {
+        std::string line;
+        record.format(line);
+        std::lock_guard<std::mutex> lock(m_impl->outputMutex);
+        std::fwrite(line.data(), 1, line.size(), m_impl->output);
+        return;
+    }
+
+    if (m_impl->queue.tryPush(record)) {
+        m_impl->submitted.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_impl->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::flush() {
+    uint64_t target = m_impl->submitted.load(std::memory_order_relaxed);
+    while (m_impl->running.load(std::memory_order_acquire) &&
+           m_impl->written.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Logger::shutdown() {
+    if (!m_impl->running.exchange(false)) {
+        return;
+    }
+    if (m_impl->thread.joinable()) {
+        m_impl->thread.join();
+    }
+    std::lock_guard<std::mutex> lock(m_impl->outputMutex);
+    std::fflush(m_impl->output);
+}
+
+uint64_t Logger::getDroppedRecords() const {
+    return m_impl->dropped.load(std::memory_order_relaxed);
+}
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::LEVEL_TRACE: return "TRACE";
+        case LogLevel::LEVEL_DEBUG: return "DEBUG";
+        case LogLevel::LEVEL_INFO: return "INFO";
+        case LogLevel::LEVEL_WARNING: return "WARN";
+        case LogLevel::LEVEL_ERROR: return "ERROR";
+        case LogLevel::LEVEL_OFF: return "OFF";
+    }
+    return "?";
+}
+
+}} // namespace Recordify::Utils
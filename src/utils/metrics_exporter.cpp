@@ -0,0 +1,232 @@
+#include "utils/metrics_exporter.h"
+#include "utils/logger.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Recordify {
+namespace Utils {
+
+namespace {
+
+std::string formatValue(double value) {
+    if (std::isnan(value)) return "NaN";
+    if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+
+    char text[32];
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        std::snprintf(text, sizeof(text), "%.0f", value);
+    } else {
+        std::snprintf(text, sizeof(text), "%.9g", value);
+    }
+    return text;
+}
+
+std::string withLabel(const std::string& labels, const std::string& extra) {
+    return labels.empty() ? extra : labels + "," + extra;
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+} // namespace
+
+void PrometheusText::family(const std::string& name, const char* type, const std::string& help) {
+    m_text += "# HELP " + name + " " + help + "\n";
+    m_text += "# TYPE " + name + " " + type + "\n";
+}
+
+void PrometheusText::sample(const std::string& name, const std::string& labels, double value) {
+    m_text += name;
+    if (!labels.empty()) {
+        m_text += "{" + labels + "}";
+    }
+    m_text += " " + formatValue(value) + "\n";
+}
+
+void PrometheusText::histogram(const std::string& name, const std::string& labels,
+                               const LatencyHistogram::Snapshot& snapshot, const std::vector<double>& boundsSeconds) {
+    // Bounds rarely fall on bucket edges; a bucket straddling one is counted
+    // in the next bound up, so counts err low by at most one bucket width.
+    for (double bound : boundsSeconds) {
+        char le[32];
+        std::snprintf(le, sizeof(le), "%g", bound);
+        const uint64_t limit = static_cast<uint64_t>(bound * 1e9);
+        sample(name + "_bucket", withLabel(labels, std::string("le=\"") + le + "\""),
+               static_cast<double>(snapshot.countAtOrBelow(limit)));
+    }
+    sample(name + "_bucket", withLabel(labels, "le=\"+Inf\""), static_cast<double>(snapshot.count));
+    sample(name + "_sum", labels, static_cast<double>(snapshot.sum) / 1e9);
+    sample(name + "_count", labels, static_cast<double>(snapshot.count));
+}
+
+struct MetricsExporter::Impl {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::string socketPath; // removed again on stop
+#ifndef _WIN32
+    int listenFd = -1;
+#endif
+
+    void fileLoop(const std::string& path, std::chrono::milliseconds interval, const Provider& provider) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            lock.unlock();
+            writeFile(path, provider());
+            lock.lock();
+            wake.wait_for(lock, interval, [this]() { return stopping; });
+        }
+    }
+
+#ifndef _WIN32
+    bool isStopping() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stopping;
+    }
+
+    void socketLoop(const Provider& provider) {
+        while (!isStopping()) {
+            pollfd listener = {listenFd, POLLIN, 0};
+            if (::poll(&listener, 1, 100) <= 0) continue;
+
+            const int client = ::accept(listenFd, nullptr, nullptr);
+            if (client < 0) continue;
+            const std::string text = provider();
+            size_t sent = 0;
+            while (sent < text.size()) {
+                const ssize_t written = ::send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+                if (written <= 0) break;
+                sent += static_cast<size_t>(written);
+            }
+            ::close(client);
+        }
+    }
+#endif
+};
+
+MetricsExporter::MetricsExporter() : m_impl(std::make_unique<Impl>()) {}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::writeFile(const std::string& path, const std::string& text) {
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        RECORDIFY_LOG_ERROR("MetricsExporter", "Cannot write ", temporary, ": ", std::strerror(errno));
+        return false;
+    }
+    const bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (std::fclose(file) != 0 || !written || !replaceFile(temporary, path)) {
+        RECORDIFY_LOG_ERROR("MetricsExporter", "Failed writing metrics to ", path);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MetricsExporter::startFile(const std::string& path, std::chrono::milliseconds interval, Provider provider) {
+    if (path.empty() || !provider) return false;
+    stop();
+    if (!writeFile(path, provider())) return false;
+
+    m_impl->stopping = false;
+    interval = std::max(interval, std::chrono::milliseconds(10));
+    m_impl->thread = std::thread([this, path, interval, provider]() { m_impl->fileLoop(path, interval, provider); });
+    RECORDIFY_LOG_INFO("MetricsExporter", "Writing metrics to ", path, " every ", interval.count(), " ms");
+    return true;
+}
+
+bool MetricsExporter::startSocket(const std::string& path, Provider provider) {
+#ifdef _WIN32
+    (void)path;
+    (void)provider;
+    RECORDIFY_LOG_ERROR("MetricsExporter", "Unix socket export is not supported on this platform");
+    return false;
+#else
+    if (path.empty() || !provider) return false;
+    stop();
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        RECORDIFY_LOG_ERROR("MetricsExporter", "Socket path too long: ", path);
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+    // Replace a socket left behind by an earlier run, but nothing else
+    struct stat existing;
+    if (::lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            RECORDIFY_LOG_ERROR("MetricsExporter", path, " exists and is not a socket");
+            return false;
+        }
+        ::unlink(path.c_str());
+    }
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 8) != 0) {
+        RECORDIFY_LOG_ERROR("MetricsExporter", "Cannot listen on ", path, ": ", std::strerror(errno));
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+
+    m_impl->listenFd = fd;
+    m_impl->socketPath = path;
+    m_impl->stopping = false;
+    m_impl->thread = std::thread([this, provider]() { m_impl->socketLoop(provider); });
+    RECORDIFY_LOG_INFO("MetricsExporter", "Serving metrics on ", path);
+    return true;
+#endif
+}
+
+void MetricsExporter::stop() {
+    if (!m_impl->thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->stopping = true;
+    }
+    m_impl->wake.notify_all();
+    m_impl->thread.join();
+
+#ifndef _WIN32
+    if (m_impl->listenFd >= 0) {
+        ::close(m_impl->listenFd);
+        m_impl->listenFd = -1;
+        ::unlink(m_impl->socketPath.c_str());
+        m_impl->socketPath.clear();
+    }
+#endif
+}
+
+bool MetricsExporter::isRunning() const {
+    return m_impl->thread.joinable();
+}
+
+}} // namespace Recordify::Utils
@@ -0,0 +1,436 @@
+#include "video_handler/avi_muxer.h"
+#include "video_handler/encoder_backend.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Recordify {
+namespace VideoHandler {
+
+namespace {
+
+// Fixed header layout, so close() can patch fields in place
+constexpr uint64_t MAX_BYTES_PER_SEC_OFFSET = 36;
+constexpr uint64_t TOTAL_FRAMES_OFFSET = 48;
+constexpr uint64_t AVIH_BUFFER_OFFSET = 60;
+constexpr uint64_t WIDTH_OFFSET = 64;
+constexpr uint64_t HEIGHT_OFFSET = 68;
+constexpr uint64_t FOURCC_OFFSET = 112;
+constexpr uint64_t SCALE_OFFSET = 128;
+constexpr uint64_t RATE_OFFSET = 132;
+constexpr uint64_t STREAM_LENGTH_OFFSET = 140;
+constexpr uint64_t STRH_BUFFER_OFFSET = 144;
+constexpr uint64_t INDX_OFFSET = 212;
+constexpr uint64_t INDX_IN_USE_OFFSET = 224;
+constexpr uint64_t INDX_ENTRIES_OFFSET = 244;
+constexpr uint32_t INDX_BYTES = 24 + 16 * AviMuxer::MAX_RIFF_LISTS;
+constexpr uint32_t DMLH_BYTES = 248;
+constexpr uint64_t DMLH_FRAMES_OFFSET = INDX_OFFSET + 8 + INDX_BYTES + 20;
+constexpr uint32_t MOVI_TAG_OFFSET = static_cast<uint32_t>(DMLH_FRAMES_OFFSET + DMLH_BYTES + 8);
+constexpr uint32_t HEADER_BYTES = MOVI_TAG_OFFSET + 4;
+
+constexpr uint32_t AVIF_HASINDEX = 0x10;
+constexpr uint32_t AVIIF_KEYFRAME = 0x10;
+constexpr uint32_t FRAME_CHUNK = makeFourcc('0', '0', 'd', 'c');
+constexpr uint8_t AVI_INDEX_OF_INDEXES = 0;
+constexpr uint8_t AVI_INDEX_OF_CHUNKS = 1;
+constexpr uint32_t STD_INDEX_DELTA_FRAME = 0x80000000u; // in ix00 sizes
+constexpr uint32_t STD_INDEX_HEADER_BYTES = 32;
+
+void put16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+void put64(std::vector<uint8_t>& out, uint64_t value) {
+    put32(out, static_cast<uint32_t>(value));
+    put32(out, static_cast<uint32_t>(value >> 32));
+}
+
+void putTag(std::vector<uint8_t>& out, const char* tag) {
+    out.insert(out.end(), tag, tag + 4);
+}
+
+void store32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t load32(const uint8_t* in) {
+    return in[0] | in[1] << 8 | in[2] << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+uint64_t load64(const uint8_t* in) {
+    return load32(in) | static_cast<uint64_t>(load32(in + 4)) << 32;
+}
+
+bool seekTo(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+} // namespace
+
+AviMuxer::~AviMuxer() {
+    close();
+}
+
+bool AviMuxer::open(const std::string& path, int width, int height, float fps, uint32_t fourcc,
+                    const FileManager::WriterOptions& output) {
+    if (m_writer.isOpen()) {
+        RECORDIFY_LOG_WARN("AviMuxer", "Already writing ", m_path);
+        return false;
+    }
+    if (width <= 0 || height <= 0 || fps <= 0.0f) {
+        RECORDIFY_LOG_WARN("AviMuxer", "Invalid stream format ", width, "x", height, " @ ", fps, " fps");
+        return false;
+    }
+
+    if (!m_writer.open(path, output)) {
+        RECORDIFY_LOG_WARN("AviMuxer", "Cannot create ", path);
+        return false;
+    }
+
+    // Frame rate as rate/scale, exact for integer and NTSC-style rates
+    const uint32_t scale = 1000;
+    const uint32_t rate = static_cast<uint32_t>(std::lround(fps * scale));
+    const uint32_t imageBytes = static_cast<uint32_t>(width) * height * 3;
+
+    std::vector<uint8_t> header;
+    header.reserve(HEADER_BYTES);
+    putTag(header, "RIFF");
+    put32(header, 0); // patched
+    putTag(header, "AVI ");
+
+    putTag(header, "LIST");
+    put32(header, static_cast<uint32_t>(MOVI_TAG_OFFSET - 8 - 20));
+    putTag(header, "hdrl");
+    putTag(header, "avih");
+    put32(header, 56);
+    put32(header, static_cast<uint32_t>(std::lround(1000000.0 / fps)));
+    put32(header, 0); // max bytes/sec, patched
+    put32(header, 0);
+    put32(header, AVIF_HASINDEX);
+    put32(header, 0); // total frames, patched
+    put32(header, 0);
+    put32(header, 1); // streams
+    put32(header, 0); // suggested buffer, patched
+    put32(header, static_cast<uint32_t>(width));
+    put32(header, static_cast<uint32_t>(height));
+    for (int i = 0; i < 4; ++i) {
+        put32(header, 0);
+    }
+
+    putTag(header, "LIST");
+    put32(header, static_cast<uint32_t>(INDX_OFFSET + 8 + INDX_BYTES - 96));
+    putTag(header, "strl");
+    putTag(header, "strh");
+    put32(header, 56);
+    putTag(header, "vids");
+    put32(header, fourcc);
+    put32(header, 0); // flags
+    put16(header, 0); // priority
+    put16(header, 0); // language
+    put32(header, 0); // initial frames
+    put32(header, scale);
+    put32(header, rate);
+    put32(header, 0); // start
+    put32(header, 0); // length, patched
+    put32(header, 0); // suggested buffer, patched
+    put32(header, 0xFFFFFFFFu); // default quality
+    put32(header, 0); // sample size: variable
+    put16(header, 0);
+    put16(header, 0);
+    put16(header, static_cast<uint16_t>(width));
+    put16(header, static_cast<uint16_t>(height));
+
+    putTag(header, "strf");
+    put32(header, 40); // BITMAPINFOHEADER
+    put32(header, 40);
+    put32(header, static_cast<uint32_t>(width));
+    put32(header, static_cast<uint32_t>(height));
+    put16(header, 1);  // planes
+    put16(header, 24); // bit count
+    put32(header, fourcc);
+    put32(header, imageBytes);
+    for (int i = 0; i < 4; ++i) {
+        put32(header, 0);
+    }
+
+    // Super index, one entry per RIFF list, filled in as each one finishes
+    putTag(header, "indx");
+    put32(header, INDX_BYTES);
+    put16(header, 4); // longs per entry
+    header.push_back(0);
+    header.push_back(AVI_INDEX_OF_INDEXES);
+    put32(header, 0); // entries in use, patched
+    put32(header, FRAME_CHUNK);
+    header.resize(header.size() + 12 + 16 * AviMuxer::MAX_RIFF_LISTS, 0);
+
+    putTag(header, "LIST");
+    put32(header, 4 + 8 + DMLH_BYTES);
+    putTag(header, "odml");
+    putTag(header, "dmlh");
+    put32(header, DMLH_BYTES);
+    header.resize(header.size() + DMLH_BYTES, 0); // total frames, patched
+
+    putTag(header, "LIST");
+    put32(header, 0); // movi size, patched
+    putTag(header, "movi");
+
+    if (!m_writer.write(header.data(), header.size())) {
+        RECORDIFY_LOG_WARN("AviMuxer", "Failed writing header to ", path);
+        m_writer.close();
+        return false;
+    }
+
+    m_path = path;
+    m_fps = fps;
+    m_fileSize = header.size();
+    m_riffStart = 0;
+    m_moviStart = MOVI_TAG_OFFSET;
+    m_riffLists = 0;
+    m_frameCount = 0;
+    m_largestFrame = 0;
+    m_failed = false;
+    m_index.clear();
+    m_chunks.clear();
+    return true;
+}
+
+bool AviMuxer::writeFrame(const uint8_t* data, size_t size, bool keyFrame) {
+    if (!m_writer.isOpen() || m_failed) {
+        return false;
+    }
+    if (size > 0x7FFFFFFFu) {
+        RECORDIFY_LOG_WARN("AviMuxer", "Packet of ", size, " bytes too large for ", m_path, ", frame discarded");
+        return false;
+    }
+
+    // Continue in a new RIFF list when this one would pass the limit once its indexes are written
+    const uint64_t padded = size + (size & 1);
+    const uint64_t entries = m_chunks.size() + 1;
+    const uint64_t indexBytes = STD_INDEX_HEADER_BYTES + entries * 8 + (m_riffStart == 0 ? 8 + entries * 16 : 0);
+    if (!m_chunks.empty() && m_fileSize - m_riffStart + 8 + padded + indexBytes > m_riffLimit) {
+        if (m_riffLists + 1 >= MAX_RIFF_LISTS) {
+            return fail("super index full");
+        }
+        if (!finishRiff() || !startRiff()) {
+            return fail("cannot start a new RIFF list");
+        }
+    }
+
+    uint8_t chunkHeader[8];
+    store32(chunkHeader, FRAME_CHUNK);
+    store32(chunkHeader + 4, static_cast<uint32_t>(size));
+    static const uint8_t padding = 0;
+    if (!m_writer.write(chunkHeader, 8) || !m_writer.write(data, size) ||
+        ((size & 1) && !m_writer.write(&padding, 1))) {
+        return fail("write failed");
+    }
+
+    if (m_riffStart == 0) {
+        m_index.push_back({keyFrame ? AVIIF_KEYFRAME : 0u, static_cast<uint32_t>(m_fileSize - MOVI_TAG_OFFSET),
+                           static_cast<uint32_t>(size)});
+    }
+    m_chunks.push_back({m_fileSize + 8, static_cast<uint32_t>(size), keyFrame});
+    m_fileSize += 8 + padded;
+    m_frameCount++;
+    m_largestFrame = std::max(m_largestFrame, static_cast<uint32_t>(size));
+    return true;
+}
+
+bool AviMuxer::fail(const char* reason) {
+    RECORDIFY_LOG_ERROR("AviMuxer", "Recording to ", m_path, " stopped after ", m_frameCount, " frames: ", reason);
+    m_failed = true;
+    return false;
+}
+
+bool AviMuxer::finishRiff() {
+    const bool first = m_riffStart == 0;
+    bool ok = true;
+
+    // ix00 closes the movi list; offsets are relative to the RIFF list
+    if (!m_chunks.empty()) {
+        std::vector<uint8_t> index;
+        index.reserve(STD_INDEX_HEADER_BYTES + m_chunks.size() * 8);
+        putTag(index, "ix00");
+        put32(index, static_cast<uint32_t>(STD_INDEX_HEADER_BYTES - 8 + m_chunks.size() * 8));
+        put16(index, 2); // longs per entry
+        index.push_back(0);
+        index.push_back(AVI_INDEX_OF_CHUNKS);
+        put32(index, static_cast<uint32_t>(m_chunks.size()));
+        put32(index, FRAME_CHUNK);
+        put64(index, m_riffStart);
+        put32(index, 0);
+        for (const auto& chunk : m_chunks) {
+            put32(index, static_cast<uint32_t>(chunk.offset - m_riffStart));
+            put32(index, chunk.size | (chunk.keyFrame ? 0u : STD_INDEX_DELTA_FRAME));
+        }
+
+        std::vector<uint8_t> entry;
+        put64(entry, m_fileSize);
+        put32(entry, static_cast<uint32_t>(index.size()));
+        put32(entry, static_cast<uint32_t>(m_chunks.size()));
+        ok = m_writer.write(index.data(), index.size());
+        m_fileSize += index.size();
+        ok = patch(INDX_ENTRIES_OFFSET + 16 * m_riffLists, entry) && ok;
+        ok = patch(INDX_IN_USE_OFFSET, ++m_riffLists) && ok;
+        m_chunks.clear();
+    }
+    ok = patch(m_moviStart - 4, static_cast<uint32_t>(m_fileSize - m_moviStart)) && ok;
+
+    if (first) {
+        std::vector<uint8_t> index;
+        index.reserve(8 + m_index.size() * 16);
+        putTag(index, "idx1");
+        put32(index, static_cast<uint32_t>(m_index.size() * 16));
+        for (const auto& entry : m_index) {
+            put32(index, FRAME_CHUNK);
+            put32(index, entry.flags);
+            put32(index, entry.offset);
+            put32(index, entry.size);
+        }
+        ok = m_writer.write(index.data(), index.size()) && ok;
+        m_fileSize += index.size();
+    }
+    return patch(m_riffStart + 4, static_cast<uint32_t>(m_fileSize - m_riffStart - 8)) && ok;
+}
+
+bool AviMuxer::startRiff() {
+    std::vector<uint8_t> header;
+    putTag(header, "RIFF");
+    put32(header, 0); // patched
+    putTag(header, "AVIX");
+    putTag(header, "LIST");
+    put32(header, 0); // patched
+    putTag(header, "movi");
+    if (!m_writer.write(header.data(), header.size())) {
+        return false;
+    }
+    m_riffStart = m_fileSize;
+    m_moviStart = m_fileSize + 20;
+    m_fileSize += header.size();
+    return true;
+}
+
+bool AviMuxer::patch(uint64_t offset, const std::vector<uint8_t>& bytes) {
+    return m_writer.writeAt(offset, bytes.data(), bytes.size());
+}
+
+bool AviMuxer::patch(uint64_t offset, uint32_t value) {
+    uint8_t bytes[4];
+    store32(bytes, value);
+    return m_writer.writeAt(offset, bytes, 4);
+}
+
+bool AviMuxer::close() {
+    if (!m_writer.isOpen()) {
+        return false;
+    }
+
+    bool ok = finishRiff();
+
+    // Average data rate, what players use to size their read-ahead
+    const double seconds = m_frameCount / m_fps;
+    const double rate = seconds > 0.0 ? (m_fileSize - HEADER_BYTES) / seconds : 0.0;
+    const uint32_t bytesPerSecond = static_cast<uint32_t>(std::min(rate, 4294967295.0));
+    ok = patch(MAX_BYTES_PER_SEC_OFFSET, bytesPerSecond) && ok;
+    ok = patch(TOTAL_FRAMES_OFFSET, static_cast<uint32_t>(m_index.size())) && ok; // first RIFF list
+    ok = patch(AVIH_BUFFER_OFFSET, m_largestFrame + 8) && ok;
+    ok = patch(STREAM_LENGTH_OFFSET, m_frameCount) && ok;
+    ok = patch(STRH_BUFFER_OFFSET, m_largestFrame + 8) && ok;
+    ok = patch(DMLH_FRAMES_OFFSET, m_frameCount) && ok;
+    ok = m_writer.close() && ok;
+
+    if (!ok) {
+        RECORDIFY_LOG_WARN("AviMuxer", "Failed finalizing ", m_path);
+    }
+    return ok && !m_failed;
+}
+
+// AviReader
+AviReader::~AviReader() {
+    close();
+}
+
+bool AviReader::open(const std::string& path) {
+    close();
+    m_file = std::fopen(path.c_str(), "rb");
+    uint8_t header[HEADER_BYTES];
+    if (!m_file || std::fread(header, 1, HEADER_BYTES, m_file) != HEADER_BYTES ||
+        std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "AVI ", 4) != 0 ||
+        std::memcmp(header + INDX_OFFSET, "indx", 4) != 0 || std::memcmp(header + MOVI_TAG_OFFSET, "movi", 4) != 0) {
+        RECORDIFY_LOG_WARN("AviReader", path, " is not an AVI written by AviMuxer");
+        close();
+        return false;
+    }
+    m_width = static_cast<int>(load32(header + WIDTH_OFFSET));
+    m_height = static_cast<int>(load32(header + HEIGHT_OFFSET));
+    m_fourcc = load32(header + FOURCC_OFFSET);
+    const uint32_t scale = load32(header + SCALE_OFFSET);
+    m_fps = scale ? static_cast<float>(load32(header + RATE_OFFSET)) / scale : 0.0f;
+
+    // The movi size is patched when the first RIFF list finishes; before
+    // that the file has no index at all
+    const uint32_t riffLists = std::min(load32(header + INDX_IN_USE_OFFSET), AviMuxer::MAX_RIFF_LISTS);
+    if (load32(header + MOVI_TAG_OFFSET - 4) == 0) {
+        RECORDIFY_LOG_WARN("AviReader", path, " has no index, it was not closed");
+        close();
+        return false;
+    }
+
+    // Lists past the last one in the super index were still being written
+    std::vector<uint8_t> index;
+    for (uint32_t list = 0; list < riffLists; ++list) {
+        const uint8_t* entry = header + INDX_ENTRIES_OFFSET + 16 * list;
+        index.resize(load32(entry + 8));
+        if (index.size() < STD_INDEX_HEADER_BYTES || !seekTo(m_file, load64(entry)) ||
+            std::fread(index.data(), 1, index.size(), m_file) != index.size() ||
+            std::memcmp(index.data(), "ix00", 4) != 0) {
+            RECORDIFY_LOG_WARN("AviReader", path, " has a damaged index");
+            close();
+            return false;
+        }
+        const uint64_t base = load64(&index[20]);
+        const size_t count = std::min<size_t>(load32(&index[12]), (index.size() - STD_INDEX_HEADER_BYTES) / 8);
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* chunk = &index[STD_INDEX_HEADER_BYTES + i * 8];
+            const uint32_t size = load32(chunk + 4);
+            m_index.push_back({base + load32(chunk), size & ~STD_INDEX_DELTA_FRAME,
+                               (size & STD_INDEX_DELTA_FRAME) == 0});
+        }
+    }
+    return true;
+}
+
+void AviReader::close() {
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    m_index.clear();
+}
+
+bool AviReader::readFrame(uint32_t frame, std::vector<uint8_t>& packet, bool& keyFrame) {
+    if (!m_file || frame >= m_index.size()) {
+        return false;
+    }
+    const IndexEntry& entry = m_index[frame];
+    packet.resize(entry.size);
+    keyFrame = entry.keyFrame;
+    return seekTo(m_file, entry.offset) &&
+           (entry.size == 0 || std::fread(packet.data(), 1, entry.size, m_file) == entry.size);
+}
+
+}} // namespace Recordify::VideoHandler
@@ -0,0 +1,73 @@
+#include "video_handler/encoder_backend.h"
+#include "video_handler/mjpeg_backend.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <mutex>
+
+namespace Recordify {
+namespace VideoHandler {
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, BackendFactory> factories;
+
+    Registry() {
+        factories["mjpeg"] = []() { return std::unique_ptr<EncoderBackend>(new MjpegBackend()); };
+    }
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+std::string normalize(std::string codec) {
+    std::transform(codec.begin(), codec.end(), codec.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return codec;
+}
+
+} // namespace
+
+bool registerBackend(const std::string& codec, BackendFactory factory) {
+    if (codec.empty() || !factory) {
+        return false;
+    }
+    Registry& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    instance.factories[normalize(codec)] = std::move(factory);
+    return true;
+}
+
+std::unique_ptr<EncoderBackend> createBackend(const std::string& codec) {
+    Registry& instance = registry();
+    BackendFactory factory;
+    {
+        std::lock_guard<std::mutex> lock(instance.mutex);
+        auto it = instance.factories.find(normalize(codec));
+        if (it != instance.factories.end()) {
+            factory = it->second;
+        }
+    }
+    if (!factory) {
+        RECORDIFY_LOG_WARN("VideoEncoder", "No encoder backend registered for codec '", codec, "'");
+        return nullptr;
+    }
+    return factory();
+}
+
+std::vector<std::string> availableBackends() {
+    Registry& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    std::vector<std::string> names;
+    for (const auto& entry : instance.factories) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+}} // namespace Recordify::VideoHandler
@@ -0,0 +1,385 @@
+#include "video_handler/mjpeg_backend.h"
+#include "utils/color_convert.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Recordify {
+namespace VideoHandler {
+
+namespace {
+
+// Natural (row-major) index -> position in the zigzag scan
+const uint8_t ZIGZAG[64] = {
+    0,  1,  5,  6,  14, 15, 27, 28, 2,  4,  7,  13, 16, 26, 29, 42,
+    3,  8,  12, 17, 25, 30, 41, 43, 9,  11, 18, 24, 31, 40, 44, 53,
+    10, 19, 23, 32, 39, 45, 52, 54, 20, 22, 33, 38, 46, 51, 55, 60,
+    21, 34, 37, 47, 50, 56, 59, 61, 35, 36, 48, 49, 57, 58, 62, 63};
+
+// ITU T.81 Annex K quantization tables, natural order
+const uint8_t LUMA_QUANT[64] = {
+    16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+    14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+    18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99};
+
+const uint8_t CHROMA_QUANT[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99};
+
+// Annex K Huffman tables: code counts per length 1-16, then symbols
+const uint8_t DC_LUMA_BITS[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+const uint8_t DC_CHROMA_BITS[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+const uint8_t DC_VALUES[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+const uint8_t AC_LUMA_BITS[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+const uint8_t AC_LUMA_VALUES[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa};
+
+const uint8_t AC_CHROMA_BITS[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+const uint8_t AC_CHROMA_VALUES[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa};
+
+// AAN DCT output scale per row/column, times sqrt(8)
+const float AAN_SCALE[8] = {
+    1.0f * 2.828427125f, 1.387039845f * 2.828427125f, 1.306562965f * 2.828427125f, 1.175875602f * 2.828427125f,
+    1.0f * 2.828427125f, 0.785694958f * 2.828427125f, 0.541196100f * 2.828427125f, 0.275899379f * 2.828427125f};
+
+struct HuffmanCode {
+    uint16_t code;
+    uint8_t length;
+};
+
+struct HuffmanTables {
+    HuffmanCode dcLuma[256], dcChroma[256], acLuma[256], acChroma[256];
+};
+
+void buildCodes(const uint8_t* bits, const uint8_t* values, HuffmanCode* codes) {
+    uint16_t code = 0;
+    int symbol = 0;
+    for (int length = 1; length <= 16; ++length) {
+        for (int i = 0; i < bits[length - 1]; ++i) {
+            codes[values[symbol++]] = {code++, static_cast<uint8_t>(length)};
+        }
+        code <<= 1;
+    }
+}
+
+const HuffmanTables& huffmanTables() {
+    static const HuffmanTables tables = []() {
+        HuffmanTables built{};
+        buildCodes(DC_LUMA_BITS, DC_VALUES, built.dcLuma);
+        buildCodes(DC_CHROMA_BITS, DC_VALUES, built.dcChroma);
+        buildCodes(AC_LUMA_BITS, AC_LUMA_VALUES, built.acLuma);
+        buildCodes(AC_CHROMA_BITS, AC_CHROMA_VALUES, built.acChroma);
+        return built;
+    }();
+    return tables;
+}
+
+// Entropy-coded segment writer with 0xFF byte stuffing
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void put(uint32_t bits, int length) {
+        m_buffer = (m_buffer << length) | bits;
+        m_count += length;
+        while (m_count >= 8) {
+            m_count -= 8;
+            uint8_t byte = static_cast<uint8_t>(m_buffer >> m_count);
+            m_out.push_back(byte);
+            if (byte == 0xFF) {
+                m_out.push_back(0);
+            }
+        }
+        m_buffer &= (1u << m_count) - 1;
+    }
+
+    void put(const HuffmanCode& code) { put(code.code, code.length); }
+
+    // Pads the last byte with 1 bits
+    void flush() {
+        int pad = (8 - m_count) & 7;
+        if (pad) {
+            put((1u << pad) - 1, pad);
+        }
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint32_t m_buffer = 0;
+    int m_count = 0;
+};
+
+// JFIF YCbCr, 4:2:0, padded to whole MCUs by repeating the last column/row
+struct Planes {
+    std::vector<uint8_t> luma, cb, cr;
+    int lumaWidth = 0, lumaHeight = 0;
+    int chromaWidth = 0, chromaHeight = 0;
+};
+
+void padPlane(uint8_t* plane, int stride, int usedWidth, int usedHeight, int height) {
+    for (int y = 0; y < usedHeight; ++y) {
+        uint8_t* row = plane + static_cast<size_t>(y) * stride;
+        std::memset(row + usedWidth, row[usedWidth - 1], stride - usedWidth);
+    }
+    for (int y = usedHeight; y < height; ++y) {
+        std::memcpy(plane + static_cast<size_t>(y) * stride, plane + static_cast<size_t>(usedHeight - 1) * stride,
+                    stride);
+    }
+}
+
+void convertToPlanes(const VideoFrame& frame, Planes& planes) {
+    const int width = frame.width, height = frame.height, bpp = frame.bytesPerPixel;
+    planes.lumaWidth = (width + 15) & ~15;
+    planes.lumaHeight = (height + 15) & ~15;
+    planes.chromaWidth = planes.lumaWidth / 2;
+    planes.chromaHeight = planes.lumaHeight / 2;
+    planes.luma.resize(static_cast<size_t>(planes.lumaWidth) * planes.lumaHeight);
+    planes.cb.resize(static_cast<size_t>(planes.chromaWidth) * planes.chromaHeight);
+    planes.cr.resize(planes.cb.size());
+
+    // BT.601 full range, as JFIF expects
+    Utils::ColorConvert::ConvertOptions options;
+    options.range = Utils::ColorConvert::Range::FULL;
+    Utils::ColorConvert::convertToI420(frame.pixels, width, height, frame.stride,
+                                       bpp == 3 ? Utils::ColorConvert::PixelFormat::BGR24
+                                                : Utils::ColorConvert::PixelFormat::BGRA32,
+                                       planes.luma.data(), planes.lumaWidth, planes.cb.data(), planes.chromaWidth,
+                                       planes.cr.data(), planes.chromaWidth, options);
+    padPlane(planes.luma.data(), planes.lumaWidth, width, height, planes.lumaHeight);
+
+    const int usedWidth = (width + 1) / 2, usedHeight = (height + 1) / 2;
+    padPlane(planes.cb.data(), planes.chromaWidth, usedWidth, usedHeight, planes.chromaHeight);
+    padPlane(planes.cr.data(), planes.chromaWidth, usedWidth, usedHeight, planes.chromaHeight);
+}
+
+// One pass of the AAN forward DCT over 8 values `step` apart
+inline void dct8(float* d, int step) {
+    float tmp0 = d[0] + d[7 * step], tmp7 = d[0] - d[7 * step];
+    float tmp1 = d[step] + d[6 * step], tmp6 = d[step] - d[6 * step];
+    float tmp2 = d[2 * step] + d[5 * step], tmp5 = d[2 * step] - d[5 * step];
+    float tmp3 = d[3 * step] + d[4 * step], tmp4 = d[3 * step] - d[4 * step];
+
+    // Even part
+    float tmp10 = tmp0 + tmp3, tmp13 = tmp0 - tmp3;
+    float tmp11 = tmp1 + tmp2, tmp12 = tmp1 - tmp2;
+    d[0] = tmp10 + tmp11;
+    d[4 * step] = tmp10 - tmp11;
+    float z1 = (tmp12 + tmp13) * 0.707106781f;
+    d[2 * step] = tmp13 + z1;
+    d[6 * step] = tmp13 - z1;
+
+    // Odd part
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+    float z5 = (tmp10 - tmp12) * 0.382683433f;
+    float z2 = tmp10 * 0.541196100f + z5;
+    float z4 = tmp12 * 1.306562965f + z5;
+    float z3 = tmp11 * 0.707106781f;
+    float z11 = tmp7 + z3, z13 = tmp7 - z3;
+    d[5 * step] = z13 + z2;
+    d[3 * step] = z13 - z2;
+    d[step] = z11 + z4;
+    d[7 * step] = z11 - z4;
+}
+
+inline int magnitudeBits(int value) {
+    unsigned magnitude = static_cast<unsigned>(value < 0 ? -value : value);
+    int bits = 0;
+    while (magnitude) {
+        ++bits;
+        magnitude >>= 1;
+    }
+    return bits;
+}
+
+inline void putValue(BitWriter& writer, int value, int bits) {
+    if (bits) {
+        writer.put(static_cast<uint32_t>(value < 0 ? value - 1 : value) & ((1u << bits) - 1), bits);
+    }
+}
+
+void encodeBlock(BitWriter& writer, const uint8_t* plane, int stride, const float* scale, int& previousDc,
+                 const HuffmanCode* dcCodes, const HuffmanCode* acCodes) {
+    float block[64];
+    for (int y = 0; y < 8; ++y) {
+        const uint8_t* row = plane + static_cast<size_t>(y) * stride;
+        for (int x = 0; x < 8; ++x) {
+            block[y * 8 + x] = static_cast<float>(row[x]) - 128.0f;
+        }
+    }
+    for (int i = 0; i < 8; ++i) {
+        dct8(block + i * 8, 1);
+    }
+    for (int i = 0; i < 8; ++i) {
+        dct8(block + i, 8);
+    }
+
+    int coefficients[64];
+    for (int i = 0; i < 64; ++i) {
+        float value = block[i] * scale[i];
+        coefficients[ZIGZAG[i]] = static_cast<int>(value < 0.0f ? value - 0.5f : value + 0.5f);
+    }
+
+    const int difference = coefficients[0] - previousDc;
+    previousDc = coefficients[0];
+    const int dcBits = magnitudeBits(difference);
+    writer.put(dcCodes[dcBits]);
+    putValue(writer, difference, dcBits);
+
+    int last = 63;
+    while (last > 0 && coefficients[last] == 0) {
+        --last;
+    }
+    int run = 0;
+    for (int i = 1; i <= last; ++i) {
+        if (coefficients[i] == 0) {
+            ++run;
+            continue;
+        }
+        for (; run >= 16; run -= 16) {
+            writer.put(acCodes[0xF0]); // 16 zeros
+        }
+        const int bits = magnitudeBits(coefficients[i]);
+        writer.put(acCodes[(run << 4) | bits]);
+        putValue(writer, coefficients[i], bits);
+        run = 0;
+    }
+    if (last < 63) {
+        writer.put(acCodes[0x00]); // end of block
+    }
+}
+
+void putMarker(std::vector<uint8_t>& out, uint8_t marker, uint16_t length) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    if (length) {
+        out.push_back(static_cast<uint8_t>(length >> 8));
+        out.push_back(static_cast<uint8_t>(length & 0xFF));
+    }
+}
+
+void putHuffmanTable(std::vector<uint8_t>& out, uint8_t id, const uint8_t* bits, const uint8_t* values) {
+    out.push_back(id);
+    int count = 0;
+    for (int i = 0; i < 16; ++i) {
+        out.push_back(bits[i]);
+        count += bits[i];
+    }
+    out.insert(out.end(), values, values + count);
+}
+
+} // namespace
+
+bool MjpegBackend::open(const EncoderSettings& settings) {
+    int quality = std::max(1, std::min(100, settings.quality));
+    // IJG quality scaling
+    int factor = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    for (int i = 0; i < 64; ++i) {
+        int luma = std::max(1, std::min(255, (LUMA_QUANT[i] * factor + 50) / 100));
+        int chroma = std::max(1, std::min(255, (CHROMA_QUANT[i] * factor + 50) / 100));
+        m_lumaTable[ZIGZAG[i]] = static_cast<uint8_t>(luma);
+        m_chromaTable[ZIGZAG[i]] = static_cast<uint8_t>(chroma);
+
+        const float aan = AAN_SCALE[i / 8] * AAN_SCALE[i % 8];
+        m_lumaScale[i] = 1.0f / (luma * aan);
+        m_chromaScale[i] = 1.0f / (chroma * aan);
+    }
+    m_quality = quality;
+    huffmanTables(); // build once up front rather than on the first worker
+    return true;
+}
+
+void MjpegBackend::writeHeaders(std::vector<uint8_t>& out, int width, int height) const {
+    putMarker(out, 0xD8, 0); // SOI
+
+    static const uint8_t JFIF[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    putMarker(out, 0xE0, 2 + sizeof(JFIF));
+    out.insert(out.end(), JFIF, JFIF + sizeof(JFIF));
+
+    putMarker(out, 0xDB, 2 + 2 * 65);
+    out.push_back(0);
+    out.insert(out.end(), m_lumaTable, m_lumaTable + 64);
+    out.push_back(1);
+    out.insert(out.end(), m_chromaTable, m_chromaTable + 64);
+
+    // Baseline frame: Y sampled 2x2, Cb/Cr 1x1
+    const uint8_t frameHeader[] = {8,
+                                   static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height & 0xFF),
+                                   static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width & 0xFF),
+                                   3, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1};
+    putMarker(out, 0xC0, 2 + sizeof(frameHeader));
+    out.insert(out.end(), frameHeader, frameHeader + sizeof(frameHeader));
+
+    putMarker(out, 0xC4, 2 + 4 * 17 + 2 * 12 + 2 * 162);
+    putHuffmanTable(out, 0x00, DC_LUMA_BITS, DC_VALUES);
+    putHuffmanTable(out, 0x10, AC_LUMA_BITS, AC_LUMA_VALUES);
+    putHuffmanTable(out, 0x01, DC_CHROMA_BITS, DC_VALUES);
+    putHuffmanTable(out, 0x11, AC_CHROMA_BITS, AC_CHROMA_VALUES);
+
+    const uint8_t scanHeader[] = {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+    putMarker(out, 0xDA, 2 + sizeof(scanHeader));
+    out.insert(out.end(), scanHeader, scanHeader + sizeof(scanHeader));
+}
+
+bool MjpegBackend::encode(const VideoFrame& frame, std::vector<uint8_t>& packet, bool& keyFrame) {
+    if (m_quality == 0 || !frame.isValid() || frame.width > 65535 || frame.height > 65535) {
+        return false;
+    }
+
+    // Per worker, reused across frames
+    thread_local Planes planes;
+    convertToPlanes(frame, planes);
+
+    packet.reserve(packet.size() + static_cast<size_t>(frame.width) * frame.height / 4 + 1024);
+    writeHeaders(packet, frame.width, frame.height);
+
+    const HuffmanTables& tables = huffmanTables();
+    BitWriter writer(packet);
+    int dcY = 0, dcCb = 0, dcCr = 0;
+    for (int my = 0; my < planes.lumaHeight; my += 16) {
+        for (int mx = 0; mx < planes.lumaWidth; mx += 16) {
+            const uint8_t* luma = planes.luma.data() + static_cast<size_t>(my) * planes.lumaWidth + mx;
+            for (int block = 0; block < 4; ++block) {
+                const uint8_t* origin = luma + (block >> 1) * 8 * planes.lumaWidth + (block & 1) * 8;
+                encodeBlock(writer, origin, planes.lumaWidth, m_lumaScale, dcY, tables.dcLuma, tables.acLuma);
+            }
+            const size_t chroma = static_cast<size_t>(my / 2) * planes.chromaWidth + mx / 2;
+            encodeBlock(writer, planes.cb.data() + chroma, planes.chromaWidth, m_chromaScale, dcCb,
+                        tables.dcChroma, tables.acChroma);
+            encodeBlock(writer, planes.cr.data() + chroma, planes.chromaWidth, m_chromaScale, dcCr,
+                        tables.dcChroma, tables.acChroma);
+        }
+    }
+    writer.flush();
+    putMarker(packet, 0xD9, 0); // EOI
+
+    keyFrame = true;
+    return true;
+}
+
+}} // namespace Recordify::VideoHandler
@@ -0,0 +1,163 @@
+#include "video_handler/segmented_muxer.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace Recordify {
+namespace VideoHandler {
+
+namespace {
+
+std::string fourccText(uint32_t fourcc) {
+    std::string text(4, ' ');
+    for (int i = 0; i < 4; ++i) {
+        text[i] = static_cast<char>(fourcc >> (8 * i));
+    }
+    return text;
+}
+
+} // namespace
+
+SegmentedMuxer::~SegmentedMuxer() {
+    close();
+}
+
+bool SegmentedMuxer::open(const std::string& path, int width, int height, float fps, uint32_t fourcc,
+                          const FileManager::WriterOptions& output, double segmentSeconds) {
+    if (m_open) {
+        RECORDIFY_LOG_WARN("SegmentedMuxer", "Already writing ", m_path);
+        return false;
+    }
+    m_path = path;
+    m_width = width;
+    m_height = height;
+    m_fps = fps;
+    m_fourcc = fourcc;
+    m_output = output;
+    m_finishedFrames = 0;
+    m_segmentFrames = segmentSeconds > 0.0 && fps > 0.0f
+                          ? static_cast<uint32_t>(std::max(1L, std::lround(segmentSeconds * fps)))
+                          : 0;
+
+    if (!isSegmented()) {
+        m_open = m_muxer.open(path, width, height, fps, fourcc, output);
+        return m_open;
+    }
+
+    // A segment only goes into the manifest once it is on disk
+    if (m_output.sync == FileManager::SyncPolicy::NEVER) {
+        m_output.sync = FileManager::SyncPolicy::ON_CLOSE;
+    }
+    m_manifest = FileManager::SegmentManifest(path);
+    m_manifest.setStream({fourccText(fourcc), width, height, fps});
+    m_open = m_manifest.save() && openSegment();
+    if (m_open) {
+        RECORDIFY_LOG_INFO("SegmentedMuxer", "Recording ", m_segmentFrames, "-frame segments, manifest ",
+                           m_manifest.getPath());
+    }
+    return m_open;
+}
+
+bool SegmentedMuxer::openSegment() {
+    FileManager::SegmentInfo segment;
+    segment.file = m_manifest.segmentName(m_manifest.getSegments().size());
+    return m_muxer.open(m_manifest.resolve(segment), m_width, m_height, m_fps, m_fourcc, m_output);
+}
+
+bool SegmentedMuxer::closeSegment() {
+    FileManager::SegmentInfo segment;
+    segment.file = m_manifest.segmentName(m_manifest.getSegments().size());
+    segment.frames = m_muxer.getFrameCount();
+    segment.duration = segment.frames / static_cast<double>(m_fps);
+    bool ok = m_muxer.close();
+    segment.bytes = m_muxer.getFileSize();
+
+    if (segment.frames == 0) {
+        std::remove(m_manifest.resolve(segment).c_str());
+        return ok;
+    }
+    if (!ok) {
+        return false;
+    }
+    m_finishedFrames += segment.frames;
+    return m_manifest.add(segment);
+}
+
+bool SegmentedMuxer::writeFrame(const uint8_t* data, size_t size, bool keyFrame) {
+    if (!m_open) {
+        return false;
+    }
+    if (isSegmented() && keyFrame && m_muxer.getFrameCount() >= m_segmentFrames) {
+        if (!closeSegment() || !openSegment()) {
+            RECORDIFY_LOG_ERROR("SegmentedMuxer", "Cannot start segment ", m_manifest.getSegments().size(),
+                                " of ", m_path);
+            m_open = false;
+            return false;
+        }
+    }
+    return m_muxer.writeFrame(data, size, keyFrame);
+}
+
+bool SegmentedMuxer::close() {
+    if (!m_open) {
+        return false;
+    }
+    m_open = false;
+    if (!isSegmented()) {
+        m_finishedFrames = m_muxer.getFrameCount();
+        return m_muxer.close();
+    }
+    bool ok = closeSegment();
+    return m_manifest.finish() && ok;
+}
+
+bool concatenateSegments(const std::string& manifestPath, const std::string& outputPath,
+                         const FileManager::WriterOptions& output) {
+    FileManager::SegmentManifest manifest;
+    if (!manifest.load(manifestPath) || manifest.getSegments().empty()) {
+        RECORDIFY_LOG_WARN("SegmentedMuxer", "No segments to join in ", manifestPath);
+        return false;
+    }
+    if (!manifest.isComplete()) {
+        RECORDIFY_LOG_INFO("SegmentedMuxer", manifestPath, " is from an interrupted recording, joining the ",
+                           manifest.getSegments().size(), " finished segments");
+    }
+
+    AviMuxer muxer;
+    AviReader reader;
+    std::vector<uint8_t> packet;
+    bool ok = true;
+    for (const auto& segment : manifest.getSegments()) {
+        ok = reader.open(manifest.resolve(segment));
+        if (ok && (reader.getWidth() != manifest.getStream().width ||
+                   reader.getHeight() != manifest.getStream().height ||
+                   fourccText(reader.getFourcc()) != manifest.getStream().codec)) {
+            RECORDIFY_LOG_WARN("SegmentedMuxer", segment.file, " does not match the stream format");
+            ok = false;
+        }
+        if (ok && !muxer.isOpen()) {
+            ok = muxer.open(outputPath, reader.getWidth(), reader.getHeight(), reader.getFps(), reader.getFourcc(),
+                            output);
+        }
+
+        for (uint32_t frame = 0; ok && frame < reader.getFrameCount(); ++frame) {
+            bool keyFrame = true;
+            ok = reader.readFrame(frame, packet, keyFrame) && muxer.writeFrame(packet.data(), packet.size(), keyFrame);
+            if (!ok) {
+                RECORDIFY_LOG_WARN("SegmentedMuxer", "Failed copying frame ", frame, " of ", segment.file);
+            }
+        }
+        if (!ok) {
+            break;
+        }
+    }
+
+    ok = muxer.close() && ok;
+    if (!ok) {
+        std::remove(outputPath.c_str());
+    }
+    return ok;
+}
+
+}} // namespace Recordify::VideoHandler
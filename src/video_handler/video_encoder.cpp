@@ -0,0 +1,491 @@
+#include "video_handler/video_encoder.h"
+#include "video_handler/segmented_muxer.h"
+#include "screen_handler/screen_handler.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Recordify {
+namespace VideoHandler {
+
+namespace {
+
+VideoFrame viewOf(const ScreenHandler::ScreenCapture& capture) {
+    VideoFrame frame;
+    frame.pixels = capture.hasPixels() ? capture.pixels() : nullptr;
+    frame.width = capture.width;
+    frame.height = capture.height;
+    frame.bytesPerPixel = capture.bytesPerPixel();
+    // Rows may be padded (DWORD-aligned on Windows) or belong to a wider frame (crops)
+    frame.stride = capture.bytesPerRow();
+    return frame;
+}
+
+} // namespace
+
+struct VideoEncoder::Impl {
+    struct Job {
+        uint64_t sequence = 0;
+        ScreenHandler::FrameBuffer pooled; // keeps a captured frame alive
+        std::vector<uint8_t> copy;
+        std::shared_ptr<const void> owner; // keeps borrowed pixels alive
+        VideoFrame frame;
+    };
+
+    struct Packet {
+        std::vector<uint8_t> data;
+        bool keyFrame = true;
+        bool encoded = false;
+    };
+
+    std::string path;
+    EncoderSettings settings;
+    std::unique_ptr<EncoderBackend> backend;
+    SegmentedMuxer muxer;
+    std::atomic<bool> opened{false};
+
+    // Output format, fixed by the settings or by the first frame
+    std::mutex formatMutex;
+    std::atomic<bool> started{false};
+    bool startFailed = false;
+    int width = 0, height = 0;
+
+    // Backends that aren't intra-only see frames in order from one thread:
+    // a single worker for submit(), the writer stage for attach()
+    std::mutex encodeMutex;
+
+    // Frames waiting for a worker
+    std::mutex queueMutex;
+    std::condition_variable queueReady, queueSpace;
+    std::deque<Job> jobs;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+    uint64_t nextSequence = 0;
+
+    // Encoded packets waiting for their turn in the file
+    std::mutex muxMutex;
+    std::map<uint64_t, Packet> finished;
+    uint64_t nextWrite = 0;
+
+    // DIRTY_TILES pipelines send changed tiles only; the writer stage keeps
+    // the full frame they apply to. Owned by the writer thread.
+    std::vector<uint8_t> reference;
+    int referenceWidth = 0, referenceHeight = 0, referenceBpp = 0;
+    std::vector<uint8_t> lastPacket;
+    bool lastKeyFrame = true;
+    std::vector<uint8_t> orderedPacket; // writer stage, backends with inter frames
+
+    std::atomic<uint64_t> framesSubmitted{0}, framesEncoded{0}, framesWritten{0}, framesDropped{0};
+    std::atomic<uint64_t> bytesWritten{0}, encodeNanos{0};
+
+    bool ensureStarted(int frameWidth, int frameHeight);
+    bool encode(const VideoFrame& frame, std::vector<uint8_t>& packet, bool& keyFrame);
+    bool mux(const uint8_t* data, size_t size, bool keyFrame); // muxMutex held
+    bool enqueue(Job&& job);
+    void workerLoop();
+    void stopWorkers();
+    bool writeChanges(const ScreenHandler::SparseCapture& changes);
+    void dropFrame() { framesDropped.fetch_add(1, std::memory_order_relaxed); }
+};
+
+bool VideoEncoder::Impl::ensureStarted(int frameWidth, int frameHeight) {
+    if (!started.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(formatMutex);
+        if (!started.load(std::memory_order_relaxed)) {
+            width = frameWidth;
+            height = frameHeight;
+            EncoderSettings format = settings;
+            format.width = width;
+            format.height = height;
+            startFailed = !backend->open(format) ||
+                          !muxer.open(path, width, height, settings.fps, backend->fourcc(), settings.output,
+                                     settings.segmentSeconds);
+            if (startFailed) {
+                RECORDIFY_LOG_WARN("VideoEncoder", "Cannot start ", backend->name(), " stream ", width, "x", height,
+                                   " in ", path);
+            } else {
+                RECORDIFY_LOG_INFO("VideoEncoder", "Encoding ", width, "x", height, " @ ", settings.fps,
+                                   " fps with ", backend->name(), " to ", path);
+            }
+            started.store(true, std::memory_order_release);
+        }
+    }
+    return !startFailed && frameWidth == width && frameHeight == height;
+}
+
+bool VideoEncoder::Impl::encode(const VideoFrame& frame, std::vector<uint8_t>& packet, bool& keyFrame) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok;
+    if (backend->isIntraOnly()) {
+        ok = backend->encode(frame, packet, keyFrame);
+    } else {
+        std::lock_guard<std::mutex> lock(encodeMutex);
+        ok = backend->encode(frame, packet, keyFrame);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    encodeNanos.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    if (ok) {
+        framesEncoded.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ok;
+}
+
+bool VideoEncoder::Impl::mux(const uint8_t* data, size_t size, bool keyFrame) {
+    if (!muxer.writeFrame(data, size, keyFrame)) {
+        dropFrame();
+        return false;
+    }
+    framesWritten.fetch_add(1, std::memory_order_relaxed);
+    bytesWritten.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
+
+bool VideoEncoder::Impl::enqueue(Job&& job) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (settings.blockWhenFull) {
+        queueSpace.wait(lock, [this]() { return stopping || jobs.size() < settings.queueDepth; });
+    }
+    if (stopping || jobs.size() >= settings.queueDepth) {
+        dropFrame();
+        return false;
+    }
+
+    if (workers.empty()) {
+        int count = settings.threads > 0 ? settings.threads
+                                         : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        if (!backend->isIntraOnly()) {
+            count = 1;
+        }
+        for (int i = 0; i < count; ++i) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    job.sequence = nextSequence++;
+    jobs.push_back(std::move(job));
+    lock.unlock();
+    queueReady.notify_one();
+    return true;
+}
+
+void VideoEncoder::Impl::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return; // stopping and drained
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        queueSpace.notify_one();
+
+        Packet packet;
+        packet.encoded = encode(job.frame, packet.data, packet.keyFrame);
+        job.pooled.reset(); // hand the slab back to the capture pool early
+        job.copy = std::vector<uint8_t>();
+        job.owner.reset();
+
+        // Whoever completes the next packet in line writes every packet now ready
+        std::lock_guard<std::mutex> lock(muxMutex);
+        finished.emplace(job.sequence, std::move(packet));
+        for (auto it = finished.begin(); it != finished.end() && it->first == nextWrite; it = finished.erase(it)) {
+            if (it->second.encoded) {
+                mux(it->second.data.data(), it->second.data.size(), it->second.keyFrame);
+            } else {
+                dropFrame();
+            }
+            nextWrite++;
+        }
+    }
+}
+
+void VideoEncoder::Impl::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_all();
+    queueSpace.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+bool VideoEncoder::Impl::writeChanges(const ScreenHandler::SparseCapture& changes) {
+    const int bpp = changes.bytesPerPixel();
+    const bool sameFormat = changes.width == referenceWidth && changes.height == referenceHeight && bpp == referenceBpp;
+    if (changes.keyFrame && !sameFormat) {
+        referenceWidth = changes.width;
+        referenceHeight = changes.height;
+        referenceBpp = bpp;
+        reference.assign(static_cast<size_t>(changes.width) * changes.height * bpp, 0);
+        lastPacket.clear();
+    } else if (!sameFormat || reference.empty()) {
+        dropFrame(); // nothing to apply the tiles to until the next key frame
+        return false;
+    }
+
+    if (changes.empty()) {
+        // Unchanged screen: repeat the previous picture
+        if (lastPacket.empty()) {
+            dropFrame();
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(muxMutex);
+        return mux(lastPacket.data(), lastPacket.size(), lastKeyFrame);
+    }
+
+    const size_t stride = static_cast<size_t>(referenceWidth) * bpp;
+    for (size_t i = 0; i < changes.tiles.size(); ++i) {
+        Utils::Rectangle tile = changes.tiles[i].intersection(Utils::Rectangle(0, 0, referenceWidth, referenceHeight));
+        if (tile != changes.tiles[i]) {
+            continue; // malformed tile
+        }
+        const size_t rowBytes = static_cast<size_t>(tile.width) * bpp;
+        const uint8_t* src = changes.tilePixels(i);
+        for (int y = 0; y < tile.height; ++y, src += rowBytes) {
+            std::memcpy(reference.data() + (tile.y + y) * stride + static_cast<size_t>(tile.x) * bpp, src, rowBytes);
+        }
+    }
+
+    VideoFrame frame;
+    frame.pixels = reference.data();
+    frame.width = referenceWidth;
+    frame.height = referenceHeight;
+    frame.stride = stride;
+    frame.bytesPerPixel = bpp;
+    lastPacket.clear();
+    if (!ensureStarted(frame.width, frame.height) || !encode(frame, lastPacket, lastKeyFrame)) {
+        lastPacket.clear();
+        dropFrame();
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(muxMutex);
+    return mux(lastPacket.data(), lastPacket.size(), lastKeyFrame);
+}
+
+VideoEncoder::VideoEncoder() : m_impl(std::make_unique<Impl>()) {}
+
+VideoEncoder::~VideoEncoder() {
+    if (isOpen()) {
+        close();
+    }
+}
+
+bool VideoEncoder::open(const std::string& path, const EncoderSettings& settings) {
+    return open(path, settings, createBackend(settings.codec));
+}
+
+bool VideoEncoder::open(const std::string& path, const EncoderSettings& settings,
+                        std::unique_ptr<EncoderBackend> backend) {
+    if (isOpen()) {
+        RECORDIFY_LOG_WARN("VideoEncoder", "Already encoding to ", m_impl->path);
+        return false;
+    }
+    if (!backend || path.empty() || settings.fps <= 0.0f) {
+        RECORDIFY_LOG_WARN("VideoEncoder", "Cannot open '", path, "': invalid settings or codec");
+        return false;
+    }
+
+    Impl& impl = *m_impl;
+    impl.path = path;
+    impl.settings = settings;
+    impl.settings.queueDepth = std::max<size_t>(1, settings.queueDepth);
+    impl.backend = std::move(backend);
+    impl.started = false;
+    impl.startFailed = false;
+    impl.stopping = false;
+    impl.nextSequence = 0;
+    impl.nextWrite = 0;
+    impl.reference.clear();
+    impl.referenceWidth = impl.referenceHeight = impl.referenceBpp = 0;
+    impl.lastPacket.clear();
+    impl.framesSubmitted = impl.framesEncoded = impl.framesWritten = impl.framesDropped = 0;
+    impl.bytesWritten = impl.encodeNanos = 0;
+
+    // Known size: create the file now rather than on the first frame
+    if (settings.width > 0 && settings.height > 0 && !impl.ensureStarted(settings.width, settings.height)) {
+        impl.backend.reset();
+        return false;
+    }
+    impl.opened = true;
+    return true;
+}
+
+bool VideoEncoder::close() {
+    if (!isOpen()) {
+        return false;
+    }
+    Impl& impl = *m_impl;
+    impl.stopWorkers();
+    impl.opened = false;
+
+    bool ok = true;
+    if (impl.muxer.isOpen()) {
+        ok = impl.muxer.close();
+    } else if (!impl.started) {
+        RECORDIFY_LOG_WARN("VideoEncoder", "No frames received, ", impl.path, " not written");
+    }
+    impl.backend->close();
+
+    Stats stats = getStats();
+    RECORDIFY_LOG_INFO("VideoEncoder", "Closed ", impl.path, ": ", stats.framesWritten, " frames, ",
+                       stats.bytesWritten, " bytes, ", stats.framesDropped, " dropped");
+    impl.finished.clear();
+    impl.reference = std::vector<uint8_t>();
+    impl.lastPacket = std::vector<uint8_t>();
+    impl.orderedPacket = std::vector<uint8_t>();
+    return ok && !impl.startFailed;
+}
+
+bool VideoEncoder::isOpen() const {
+    return m_impl->opened.load(std::memory_order_acquire);
+}
+
+bool VideoEncoder::submit(const ScreenHandler::ScreenCapture& capture) {
+    if (!isOpen()) {
+        return false;
+    }
+    m_impl->framesSubmitted.fetch_add(1, std::memory_order_relaxed);
+
+    Impl::Job job;
+    job.frame = viewOf(capture);
+    if (!job.frame.isValid() || !m_impl->ensureStarted(job.frame.width, job.frame.height)) {
+        m_impl->dropFrame();
+        return false;
+    }
+    job.pooled = capture.pixelData;
+    return m_impl->enqueue(std::move(job));
+}
+
+bool VideoEncoder::submit(const VideoFrame& frame) {
+    if (!isOpen()) {
+        return false;
+    }
+    m_impl->framesSubmitted.fetch_add(1, std::memory_order_relaxed);
+    if (!frame.isValid() || !m_impl->ensureStarted(frame.width, frame.height)) {
+        m_impl->dropFrame();
+        return false;
+    }
+
+    Impl::Job job;
+    const size_t rowBytes = static_cast<size_t>(frame.width) * frame.bytesPerPixel;
+    job.copy.resize(rowBytes * frame.height);
+    for (int y = 0; y < frame.height; ++y) {
+        std::memcpy(job.copy.data() + y * rowBytes, frame.pixels + y * frame.stride, rowBytes);
+    }
+    job.frame = frame;
+    job.frame.pixels = job.copy.data();
+    job.frame.stride = rowBytes;
+    return m_impl->enqueue(std::move(job));
+}
+
+bool VideoEncoder::submit(const VideoFrame& frame, std::shared_ptr<const void> owner) {
+    if (!isOpen()) {
+        return false;
+    }
+    m_impl->framesSubmitted.fetch_add(1, std::memory_order_relaxed);
+    if (!frame.isValid() || !m_impl->ensureStarted(frame.width, frame.height)) {
+        m_impl->dropFrame();
+        return false;
+    }
+
+    Impl::Job job;
+    job.owner = std::move(owner);
+    job.frame = frame;
+    return m_impl->enqueue(std::move(job));
+}
+
+void VideoEncoder::attach(ScreenHandler::ScreenHandler& handler) {
+    handler.setFrameEncoder([this](ScreenHandler::PipelineFrame& frame) { return encodeFrame(frame); });
+    handler.setFrameWriter([this](const ScreenHandler::PipelineFrame& frame) { return writeFrame(frame); },
+                           [this](std::function<void()> done) { whenWritten(std::move(done)); });
+}
+
+void VideoEncoder::detach(ScreenHandler::ScreenHandler& handler) {
+    handler.setFrameEncoder(ScreenHandler::ScreenHandler::FrameEncoder());
+    handler.setFrameWriter(ScreenHandler::ScreenHandler::FrameWriter());
+}
+
+bool VideoEncoder::encodeFrame(ScreenHandler::PipelineFrame& frame) {
+    if (!isOpen()) {
+        return false;
+    }
+    m_impl->framesSubmitted.fetch_add(1, std::memory_order_relaxed);
+    if (frame.incremental || !m_impl->backend->isIntraOnly()) {
+        return true; // encoded by writeFrame(), which sees frames in order
+    }
+
+    VideoFrame view = viewOf(frame.capture);
+    frame.encodedData.clear();
+    if (!view.isValid() || !m_impl->ensureStarted(view.width, view.height) ||
+        !m_impl->encode(view, frame.encodedData, frame.keyFrame)) {
+        m_impl->dropFrame();
+        return false;
+    }
+    return true;
+}
+
+bool VideoEncoder::whenWritten(std::function<void()> done) {
+    std::lock_guard<std::mutex> lock(m_impl->muxMutex);
+    return m_impl->muxer.whenWritten(std::move(done));
+}
+
+bool VideoEncoder::writeFrame(const ScreenHandler::PipelineFrame& frame) {
+    if (!isOpen()) {
+        return false;
+    }
+    if (frame.incremental) {
+        return m_impl->writeChanges(frame.changes);
+    }
+    if (!m_impl->backend->isIntraOnly()) {
+        VideoFrame view = viewOf(frame.capture);
+        bool keyFrame = true;
+        m_impl->orderedPacket.clear();
+        if (!view.isValid() || !m_impl->ensureStarted(view.width, view.height) ||
+            !m_impl->encode(view, m_impl->orderedPacket, keyFrame)) {
+            m_impl->dropFrame();
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_impl->muxMutex);
+        return m_impl->mux(m_impl->orderedPacket.data(), m_impl->orderedPacket.size(), keyFrame);
+    }
+    if (frame.encodedData.empty()) {
+        m_impl->dropFrame();
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_impl->muxMutex);
+    return m_impl->mux(frame.encodedData.data(), frame.encodedData.size(), frame.keyFrame);
+}
+
+VideoEncoder::Stats VideoEncoder::getStats() const {
+    Stats stats;
+    stats.framesSubmitted = m_impl->framesSubmitted.load(std::memory_order_relaxed);
+    stats.framesEncoded = m_impl->framesEncoded.load(std::memory_order_relaxed);
+    stats.framesWritten = m_impl->framesWritten.load(std::memory_order_relaxed);
+    stats.framesDropped = m_impl->framesDropped.load(std::memory_order_relaxed);
+    stats.bytesWritten = m_impl->bytesWritten.load(std::memory_order_relaxed);
+    if (stats.framesEncoded > 0) {
+        stats.encodeTime = static_cast<float>(m_impl->encodeNanos.load(std::memory_order_relaxed) /
+                                              1e6 / stats.framesEncoded);
+    }
+    return stats;
+}
+
+const std::string& VideoEncoder::getPath() const {
+    return m_impl->path;
+}
+
+}} // namespace Recordify::VideoHandler
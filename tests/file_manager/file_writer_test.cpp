@@ -0,0 +1,171 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "file_manager/file_writer.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Recordify::FileManager;
+
+namespace {
+
+const char* const OUTPUT_PATH = "file_writer_test.bin";
+
+std::vector<uint8_t> readFile(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+std::vector<uint8_t> randomBytes(size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& byte : bytes) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return bytes;
+}
+
+// Small batches and a shallow queue so a few KB cross many batch boundaries
+WriterOptions smallBatches(IoBackend backend) {
+    WriterOptions options;
+    options.batchSize = 4096;
+    options.queueDepth = 2;
+    options.backend = backend;
+    return options;
+}
+
+// Writes `data` in uneven pieces
+void writeInPieces(FileWriter& writer, const std::vector<uint8_t>& data) {
+    size_t offset = 0, piece = 1;
+    while (offset < data.size()) {
+        const size_t size = std::min(piece, data.size() - offset);
+        CPPUNIT_ASSERT(writer.write(data.data() + offset, size));
+        offset += size;
+        piece = piece * 3 + 7;
+    }
+}
+
+} // namespace
+
+class FileWriterTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(FileWriterTest);
+    CPPUNIT_TEST(testBackendsWriteSameBytes);
+    CPPUNIT_TEST(testFlushCarriesPartialBatch);
+    CPPUNIT_TEST(testWriteAtPatchesQueuedAndPendingBytes);
+    CPPUNIT_TEST(testDirectIoTrimsPaddedTail);
+    CPPUNIT_TEST(testWhenWrittenWaitsForTheBytes);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override { std::remove(OUTPUT_PATH); }
+
+    void testBackendsWriteSameBytes() {
+        const std::vector<uint8_t> data = randomBytes(50000, 1);
+        for (IoBackend backend : {IoBackend::PWRITE, IoBackend::AUTO}) {
+            FileWriter writer;
+            CPPUNIT_ASSERT(writer.open(OUTPUT_PATH, smallBatches(backend)));
+            writeInPieces(writer, data);
+            CPPUNIT_ASSERT(writer.close());
+            CPPUNIT_ASSERT(readFile(OUTPUT_PATH) == data);
+
+            FileWriter::Stats stats = writer.getStats();
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(data.size()), stats.bytesQueued);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(data.size()), stats.bytesWritten);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(13), stats.batchesWritten); // 12 full + tail
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), stats.syncs);           // ON_CLOSE
+        }
+    }
+
+    void testFlushCarriesPartialBatch() {
+        FileWriter writer;
+        CPPUNIT_ASSERT(writer.open(OUTPUT_PATH, smallBatches(IoBackend::AUTO)));
+        const std::vector<uint8_t> data = randomBytes(10000, 2);
+        CPPUNIT_ASSERT(writer.write(data.data(), 5000));
+        CPPUNIT_ASSERT(writer.flush());
+        CPPUNIT_ASSERT(readFile(OUTPUT_PATH) == std::vector<uint8_t>(data.begin(), data.begin() + 5000));
+
+        // The rest lands after the flushed bytes, not after a padded block
+        CPPUNIT_ASSERT(writer.write(data.data() + 5000, 5000));
+        CPPUNIT_ASSERT(writer.sync());
+        CPPUNIT_ASSERT(writer.close());
+        CPPUNIT_ASSERT(readFile(OUTPUT_PATH) == data);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(2), writer.getStats().syncs);
+    }
+
+    void testWriteAtPatchesQueuedAndPendingBytes() {
+        FileWriter writer;
+        CPPUNIT_ASSERT(writer.open(OUTPUT_PATH, smallBatches(IoBackend::AUTO)));
+        std::vector<uint8_t> data = randomBytes(20000, 3);
+        writeInPieces(writer, data);
+
+        // One header already handed to the I/O thread, one spanning into
+        // the batch still being filled
+        const uint8_t header[8] = {'R', 'I', 'F', 'F', 1, 2, 3, 4};
+        CPPUNIT_ASSERT(writer.writeAt(0, header, sizeof(header)));
+        CPPUNIT_ASSERT(writer.writeAt(16380, header, sizeof(header)));
+        CPPUNIT_ASSERT(!writer.writeAt(19996, header, sizeof(header))); // past the end
+        CPPUNIT_ASSERT(writer.close());
+
+        std::copy(header, header + 8, data.begin());
+        std::copy(header, header + 8, data.begin() + 16380);
+        CPPUNIT_ASSERT(readFile(OUTPUT_PATH) == data);
+    }
+
+    void testDirectIoTrimsPaddedTail() {
+        WriterOptions options = smallBatches(IoBackend::AUTO);
+        options.directIo = true;
+        options.batchSize = 6000; // rounded up to whole blocks
+        options.sync = SyncPolicy::ALWAYS;
+        FileWriter writer;
+        CPPUNIT_ASSERT(writer.open(OUTPUT_PATH, options));
+
+        const std::vector<uint8_t> data = randomBytes(30001, 4);
+        writeInPieces(writer, data);
+        const uint8_t patch[3] = {9, 9, 9};
+        CPPUNIT_ASSERT(writer.writeAt(100, patch, sizeof(patch)));
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(data.size()), writer.getPosition());
+        CPPUNIT_ASSERT(writer.close());
+
+        std::vector<uint8_t> expected = data;
+        std::copy(patch, patch + 3, expected.begin() + 100);
+        CPPUNIT_ASSERT(readFile(OUTPUT_PATH) == expected);
+        // Direct or not, every batch was followed by a sync
+        FileWriter::Stats stats = writer.getStats();
+        CPPUNIT_ASSERT(stats.syncs >= stats.batchesWritten);
+    }
+
+    void testWhenWrittenWaitsForTheBytes() {
+        FileWriter writer;
+        CPPUNIT_ASSERT(writer.open(OUTPUT_PATH, smallBatches(IoBackend::AUTO)));
+        const std::vector<uint8_t> data = randomBytes(5000, 5);
+        std::atomic<int> done{0};
+        std::thread::id ioThread;
+        auto count = [&done, &ioThread]() {
+            ioThread = std::this_thread::get_id();
+            done.fetch_add(1);
+        };
+
+        // Still in the batch being filled, so nothing has been written
+        CPPUNIT_ASSERT(writer.write(data.data(), 3000));
+        CPPUNIT_ASSERT(writer.whenWritten(count));
+        CPPUNIT_ASSERT_EQUAL(0, done.load());
+        CPPUNIT_ASSERT(writer.write(data.data() + 3000, 2000)); // fills and queues the first batch
+        CPPUNIT_ASSERT(writer.whenWritten(count));
+        CPPUNIT_ASSERT(writer.flush());
+        CPPUNIT_ASSERT_EQUAL(2, done.load());
+        CPPUNIT_ASSERT(ioThread != std::this_thread::get_id());
+
+        // Nothing outstanding: runs right away
+        CPPUNIT_ASSERT(writer.whenWritten([&done]() { done.fetch_add(1); }));
+        CPPUNIT_ASSERT_EQUAL(3, done.load());
+        CPPUNIT_ASSERT(writer.close());
+        CPPUNIT_ASSERT(!writer.whenWritten(count));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FileWriterTest);
@@ -0,0 +1,170 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "file_manager/frame_spool.h"
+#include "screen_handler/screen_handler.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace Recordify::FileManager;
+using Recordify::ScreenHandler::FrameBuffer;
+using Recordify::ScreenHandler::PipelineFrame;
+using Recordify::ScreenHandler::ScreenCapture;
+
+namespace {
+
+const char* const SPOOL_PATH = "frame_spool_test.spool";
+
+ScreenCapture makeCapture(int width, int height, int frame) {
+    ScreenCapture capture;
+    capture.area = Recordify::Utils::Rectangle(10, 20, width, height);
+    capture.width = width;
+    capture.height = height;
+    capture.bitsPerPixel = 32;
+    capture.timestamp = std::chrono::steady_clock::time_point(std::chrono::milliseconds(1000 + frame * 33));
+    capture.pixelData = FrameBuffer::allocate(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < capture.pixelData.size(); ++i) {
+        capture.pixelData[i] = static_cast<uint8_t>(i * 7 + frame);
+    }
+    return capture;
+}
+
+bool samePixels(const ScreenCapture& capture, const uint8_t* pixels) {
+    return std::memcmp(capture.pixelData.data(), pixels, capture.pixelData.size()) == 0;
+}
+
+} // namespace
+
+class FrameSpoolTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(FrameSpoolTest);
+    CPPUNIT_TEST(testRoundTrip);
+    CPPUNIT_TEST(testCropIsStoredPacked);
+    CPPUNIT_TEST(testFullSpoolRejectsFrames);
+    CPPUNIT_TEST(testUnclosedSpoolIsReadable);
+    CPPUNIT_TEST(testIncrementalFramesAreRebuilt);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override {
+        std::remove(SPOOL_PATH);
+    }
+
+    void testRoundTrip() {
+        FrameSpool writer;
+        CPPUNIT_ASSERT(writer.create(SPOOL_PATH, 8, 1 << 20));
+        for (int frame = 0; frame < 3; ++frame) {
+            CPPUNIT_ASSERT(writer.append(makeCapture(33, 17, frame)));
+        }
+        CPPUNIT_ASSERT(writer.close());
+
+        FrameSpool reader;
+        CPPUNIT_ASSERT(reader.open(SPOOL_PATH));
+        CPPUNIT_ASSERT(reader.isComplete());
+        CPPUNIT_ASSERT_EQUAL(3u, reader.getFrameCount());
+        for (int frame = 0; frame < 3; ++frame) {
+            SpoolFrameInfo info;
+            const uint8_t* pixels = nullptr;
+            CPPUNIT_ASSERT(reader.getFrame(frame, info, pixels));
+            ScreenCapture expected = makeCapture(33, 17, frame);
+            CPPUNIT_ASSERT_EQUAL(33, info.width);
+            CPPUNIT_ASSERT_EQUAL(17, info.height);
+            CPPUNIT_ASSERT_EQUAL(10, info.area.x);
+            CPPUNIT_ASSERT_EQUAL(32, info.bitsPerPixel);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(33 * 4), info.stride);
+            CPPUNIT_ASSERT(info.timestamp == expected.timestamp);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uintptr_t>(0), reinterpret_cast<uintptr_t>(pixels) % 64);
+            CPPUNIT_ASSERT(samePixels(expected, pixels));
+        }
+        SpoolFrameInfo info;
+        const uint8_t* pixels = nullptr;
+        CPPUNIT_ASSERT(!reader.getFrame(3, info, pixels));
+    }
+
+    void testCropIsStoredPacked() {
+        ScreenCapture capture = makeCapture(32, 16, 0);
+        ScreenCapture region = capture.share();
+        CPPUNIT_ASSERT(region.crop(Recordify::Utils::Rectangle(5, 3, 7, 4)));
+
+        FrameSpool writer;
+        CPPUNIT_ASSERT(writer.create(SPOOL_PATH, 2, 1 << 16));
+        CPPUNIT_ASSERT(writer.append(region));
+        CPPUNIT_ASSERT(writer.close());
+
+        FrameSpool reader;
+        CPPUNIT_ASSERT(reader.open(SPOOL_PATH));
+        SpoolFrameInfo info;
+        const uint8_t* pixels = nullptr;
+        CPPUNIT_ASSERT(reader.getFrame(0, info, pixels));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(7 * 4), info.stride);
+        CPPUNIT_ASSERT_EQUAL(15, info.area.x);
+        for (int y = 0; y < 4; ++y) {
+            CPPUNIT_ASSERT_EQUAL(0, std::memcmp(pixels + info.stride * y, region.view().row(y), info.stride));
+        }
+    }
+
+    void testFullSpoolRejectsFrames() {
+        // Room for two 64x64 frames of data but index slots for four
+        FrameSpool writer;
+        CPPUNIT_ASSERT(writer.create(SPOOL_PATH, 4, 2 * 64 * 64 * 4));
+        CPPUNIT_ASSERT(writer.append(makeCapture(64, 64, 0)));
+        CPPUNIT_ASSERT(writer.append(makeCapture(64, 64, 1)));
+        CPPUNIT_ASSERT(!writer.append(makeCapture(64, 64, 2)));
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), writer.getDroppedFrames());
+        CPPUNIT_ASSERT_EQUAL(2u, writer.getFrameCount());
+        CPPUNIT_ASSERT(writer.close());
+    }
+
+    void testUnclosedSpoolIsReadable() {
+        FrameSpool writer;
+        CPPUNIT_ASSERT(writer.create(SPOOL_PATH, 16, 1 << 20));
+        CPPUNIT_ASSERT(writer.append(makeCapture(40, 30, 0)));
+        CPPUNIT_ASSERT(writer.append(makeCapture(40, 30, 1)));
+
+        // What a crash right now would leave
+        FrameSpool reader;
+        CPPUNIT_ASSERT(reader.open(SPOOL_PATH));
+        CPPUNIT_ASSERT(!reader.isComplete());
+        CPPUNIT_ASSERT_EQUAL(2u, reader.getFrameCount());
+        SpoolFrameInfo info;
+        const uint8_t* pixels = nullptr;
+        CPPUNIT_ASSERT(reader.getFrame(1, info, pixels));
+        CPPUNIT_ASSERT(samePixels(makeCapture(40, 30, 1), pixels));
+        reader.close();
+        CPPUNIT_ASSERT(writer.close());
+    }
+
+    void testIncrementalFramesAreRebuilt() {
+        FrameSpool writer;
+        CPPUNIT_ASSERT(writer.create(SPOOL_PATH, 4, 1 << 20));
+
+        // Key frame covering the whole capture, then one changed tile
+        ScreenCapture first = makeCapture(128, 64, 0);
+        PipelineFrame frame;
+        frame.incremental = true;
+        frame.changes.width = 128;
+        frame.changes.height = 64;
+        frame.changes.bitsPerPixel = 32;
+        frame.changes.keyFrame = true;
+        frame.changes.tiles = {Recordify::Utils::Rectangle(0, 0, 128, 64)};
+        frame.changes.tileOffsets = {0};
+        frame.changes.pixelData.assign(first.pixelData.begin(), first.pixelData.end());
+        CPPUNIT_ASSERT(writer.writeFrame(frame));
+
+        frame.changes.keyFrame = false;
+        frame.changes.tiles = {Recordify::Utils::Rectangle(64, 0, 64, 64)};
+        frame.changes.pixelData.assign(64 * 64 * 4, 0xAB);
+        CPPUNIT_ASSERT(writer.writeFrame(frame));
+        CPPUNIT_ASSERT(writer.close());
+
+        FrameSpool reader;
+        CPPUNIT_ASSERT(reader.open(SPOOL_PATH));
+        SpoolFrameInfo info;
+        const uint8_t* pixels = nullptr;
+        CPPUNIT_ASSERT(reader.getFrame(1, info, pixels));
+        CPPUNIT_ASSERT_EQUAL(0, std::memcmp(pixels, first.pixelData.data(), 64 * 4));
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(0xAB), pixels[64 * 4]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(0xAB), pixels[info.stride * 63 + 127 * 4]);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FrameSpoolTest);
@@ -0,0 +1,163 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/animation_batch.h"
+#include "screen_handler/screen_writer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Point;
+using Recordify::Utils::Size;
+
+namespace {
+
+AnimationKeyframe keyframe(float time, int x, int y, float opacity, Easing easing = Easing::LINEAR) {
+    AnimationKeyframe key;
+    key.time = time;
+    key.position = Point(x, y);
+    key.opacity = opacity;
+    key.scale = 1.0f;
+    key.rotation = 0.0f;
+    key.easing = easing;
+    return key;
+}
+
+} // namespace
+
+class AnimationTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(AnimationTest);
+    CPPUNIT_TEST(testKeyframesStaySorted);
+    CPPUNIT_TEST(testEasingEndpoints);
+    CPPUNIT_TEST(testConcurrentInterpolate);
+    CPPUNIT_TEST(testBatchMatchesInterpolate);
+    CPPUNIT_TEST(testAnnotationFollowsAnimation);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testKeyframesStaySorted() {
+        Animation animation(1.0f);
+        animation.addKeyframe(keyframe(1.0f, 100, 0, 1.0f));
+        animation.addKeyframe(keyframe(0.0f, 0, 0, 1.0f));
+        animation.addKeyframe(keyframe(0.5f, 20, 0, 1.0f));
+
+        CPPUNIT_ASSERT_EQUAL(0.5f, animation.getKeyframes()[1].time);
+        CPPUNIT_ASSERT_EQUAL(10, animation.interpolate(0.25f).position.x);
+        CPPUNIT_ASSERT_EQUAL(60, animation.interpolate(0.75f).position.x);
+        // Going backwards past the cached segment still finds the right one
+        CPPUNIT_ASSERT_EQUAL(4, animation.interpolate(0.1f).position.x);
+    }
+
+    void testEasingEndpoints() {
+        for (Easing easing : {Easing::LINEAR, Easing::EASE_IN, Easing::EASE_OUT, Easing::EASE_IN_OUT}) {
+            CPPUNIT_ASSERT_EQUAL(0.0f, applyEasing(easing, 0.0f));
+            CPPUNIT_ASSERT_EQUAL(1.0f, applyEasing(easing, 1.0f));
+            CPPUNIT_ASSERT(applyEasing(easing, 0.25f) <= applyEasing(easing, 0.75f));
+        }
+        CPPUNIT_ASSERT(applyEasing(Easing::EASE_IN, 0.5f) < 0.5f);
+        CPPUNIT_ASSERT(applyEasing(Easing::EASE_OUT, 0.5f) > 0.5f);
+        CPPUNIT_ASSERT_EQUAL(0.0f, applyEasing(Easing::STEP, 0.99f));
+    }
+
+    // Threads sharing one animation only race on the segment hint
+    void testConcurrentInterpolate() {
+        Animation animation(1.0f);
+        for (int k = 0; k <= 10; ++k) {
+            animation.addKeyframe(keyframe(k / 10.0f, k * 100, 0, 1.0f));
+        }
+        std::vector<std::thread> threads;
+        std::vector<int> mismatches(4, 0);
+        for (size_t thread = 0; thread < mismatches.size(); ++thread) {
+            threads.emplace_back([&animation, &mismatches, thread]() {
+                for (int i = 0; i < 20000; ++i) {
+                    // Each thread walks its own direction and stride through the segments
+                    int step = (i * static_cast<int>(thread * 2 + 1)) % 1000;
+                    float time = (thread % 2 ? 999 - step : step) / 1000.0f;
+                    int expected = static_cast<int>(time * 1000.0f);
+                    if (std::abs(animation.interpolate(time).position.x - expected) > 1) {
+                        ++mismatches[thread];
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (int count : mismatches) {
+            CPPUNIT_ASSERT_EQUAL(0, count);
+        }
+
+        // Copies carry the keyframes and work on their own
+        Animation copy = animation;
+        CPPUNIT_ASSERT_EQUAL(250, copy.interpolate(0.25f).position.x);
+    }
+
+    void testBatchMatchesInterpolate() {
+        std::mt19937 rng(3);
+        std::vector<Animation> reference;
+        AnimationBatch batch;
+        for (int id = 0; id < 40; ++id) {
+            Animation animation(0.5f + (rng() % 100) / 50.0f);
+            int keys = 1 + rng() % 6;
+            for (int k = 0; k < keys; ++k) {
+                animation.addKeyframe(keyframe((rng() % 101) / 100.0f, rng() % 500, rng() % 500,
+                                               (rng() % 101) / 100.0f, static_cast<Easing>(rng() % 5)));
+            }
+            reference.push_back(animation);
+            batch.add(id, animation);
+        }
+        // Dropping one in the middle compacts the keyframe arrays
+        CPPUNIT_ASSERT(batch.remove(7));
+
+        std::vector<float> elapsed(reference.size(), 0.0f);
+        std::vector<int> finished;
+        for (int step = 0; step < 200 && !batch.empty(); ++step) {
+            batch.advance(1.0f / 60.0f, finished);
+            const auto& ids = batch.getObjectIds();
+            for (size_t i = 0; i < ids.size(); ++i) {
+                const Animation& animation = reference[ids[i]];
+                elapsed[ids[i]] += 1.0f / 60.0f;
+                float time = std::min(1.0f, elapsed[ids[i]] / animation.getDuration());
+                AnimationKeyframe expected = animation.interpolate(time);
+                AnimationKeyframe actual = batch.getStateAt(i);
+                CPPUNIT_ASSERT_EQUAL(expected.position.x, actual.position.x);
+                CPPUNIT_ASSERT_EQUAL(expected.position.y, actual.position.y);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.opacity, actual.opacity, 1e-5);
+            }
+        }
+        CPPUNIT_ASSERT(batch.empty());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(39), finished.size());
+    }
+
+    void testAnnotationFollowsAnimation() {
+        ScreenWriter writer;
+        CPPUNIT_ASSERT(writer.initialize());
+        CPPUNIT_ASSERT(writer.createCanvas(Size(256, 128)));
+
+        ScreenWriter::Annotation click;
+        click.type = "click";
+        click.points = {Point(20, 20)};
+        click.shapeProps.strokeWidth = 0.0f;
+        int id = writer.addAnnotation(click);
+
+        Animation slide(1.0f);
+        slide.addKeyframe(keyframe(0.0f, 0, 0, 1.0f));
+        slide.addKeyframe(keyframe(1.0f, 200, 0, 1.0f));
+        writer.startAnimation(id, slide);
+
+        writer.updateAnimations(0.5f);
+        CPPUNIT_ASSERT_EQUAL(0, writer.getAnnotationAt(Point(20, 20)));
+        CPPUNIT_ASSERT_EQUAL(id, writer.getAnnotationAt(Point(120, 20)));
+
+        // Finished animations keep the last pose until stopped
+        writer.updateAnimations(1.0f);
+        CPPUNIT_ASSERT_EQUAL(id, writer.getAnnotationAt(Point(220, 20)));
+        writer.stopAnimation(id);
+        CPPUNIT_ASSERT_EQUAL(id, writer.getAnnotationAt(Point(20, 20)));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AnimationTest);
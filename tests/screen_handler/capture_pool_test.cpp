@@ -0,0 +1,167 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/screen_handler.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Rectangle;
+
+namespace {
+
+// 320x200 BGRA screen with nothing on it
+class BlankSource : public CaptureSource {
+public:
+    const char* name() const override { return "blank"; }
+    bool open() override { return true; }
+    Rectangle bounds() const override { return Rectangle(0, 0, 320, 200); }
+    int bitsPerPixel() const override { return 32; }
+    bool grab(const Rectangle&, uint8_t*, size_t) override { return true; }
+};
+
+// Where an ArenaSource's slabs are and where its grabs landed; outlives the
+// source, which the reader destroys
+struct Arena {
+    std::mutex mutex;
+    uint8_t* start = nullptr;
+    size_t bytes = 0;
+    int inPlaceGrabs = 0;
+    int copiedGrabs = 0;
+};
+
+// Hands out slab memory of its own, the way the X11 source hands out
+// MIT-SHM segments, and checks where each grab lands
+class ArenaSource : public BlankSource {
+public:
+    explicit ArenaSource(std::shared_ptr<Arena> arena) : m_arena(std::move(arena)) {}
+
+    const char* name() const override { return "arena"; }
+
+    bool grab(const Rectangle& area, uint8_t* target, size_t stride) override {
+        const size_t bytes = stride * area.height;
+        std::lock_guard<std::mutex> lock(m_arena->mutex);
+        const bool inArena = target >= m_arena->start && target + bytes <= m_arena->start + m_arena->bytes;
+        (inArena && stride == static_cast<size_t>(area.width) * 4 ? m_arena->inPlaceGrabs : m_arena->copiedGrabs)++;
+        return true;
+    }
+
+    FramePool::SlabAllocator slabAllocator() override {
+        std::shared_ptr<Arena> arena = m_arena;
+        return [arena](size_t bytes) {
+            void* memory = nullptr;
+            if (posix_memalign(&memory, 4096, bytes) != 0) {
+                return FramePool::SlabMemory();
+            }
+            std::lock_guard<std::mutex> lock(arena->mutex);
+            arena->start = static_cast<uint8_t*>(memory);
+            arena->bytes = bytes;
+            FramePool::SlabMemory slabs;
+            slabs.data = arena->start;
+            slabs.owner = std::shared_ptr<void>(memory, std::free);
+            return slabs;
+        };
+    }
+
+private:
+    std::shared_ptr<Arena> m_arena;
+};
+
+RecordingConfig makeConfig(RecordingMode mode, const Rectangle& area) {
+    RecordingConfig config;
+    config.mode = mode;
+    config.captureArea = area;
+    config.fps = 120.0f;
+    config.adaptiveQuality = false;
+    config.autoSave = false;
+    config.dropPolicy = DropPolicy::BLOCK;
+    return config;
+}
+
+// Records for a moment from `source` (the default one if null) and returns
+// the reader's pool stats
+FramePool::Stats record(const RecordingConfig& config, std::unique_ptr<CaptureSource> source = nullptr) {
+    ScreenHandler handler;
+    CPPUNIT_ASSERT(handler.initialize());
+    CPPUNIT_ASSERT(handler.getReader()->setCaptureSource(source ? std::move(source)
+                                                                : std::make_unique<BlankSource>()));
+    handler.setFrameEncoder([](PipelineFrame&) { return true; });
+    handler.setFrameWriter([](const PipelineFrame&) { return true; });
+
+    CPPUNIT_ASSERT(handler.startCapture(config));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CPPUNIT_ASSERT(handler.stopCapture());
+    return handler.getReader()->getFramePoolStats();
+}
+
+} // namespace
+
+class CapturePoolTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(CapturePoolTest);
+    CPPUNIT_TEST(testFrameBytesFollowSource);
+    CPPUNIT_TEST(testFullScreenCaptureUsesPool);
+    CPPUNIT_TEST(testRegionCaptureUsesPool);
+    CPPUNIT_TEST(testRecordingGrabsIntoSourceSlabs);
+    CPPUNIT_TEST(testX11RecordingUsesPool);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testFrameBytesFollowSource() {
+        ScreenReader reader;
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::make_unique<BlankSource>()));
+        CPPUNIT_ASSERT(reader.initialize());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(320 * 200 * 4), reader.getFrameBytes());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(64 * 48 * 4), reader.getFrameBytes(Rectangle(10, 10, 64, 48)));
+        // Clipped to the screen, like the grab itself
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(20 * 10 * 4), reader.getFrameBytes(Rectangle(300, 190, 64, 48)));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), reader.getFrameBytes(Rectangle(400, 0, 64, 48)));
+    }
+
+    // An empty capture area still sizes the pool from the display
+    void testFullScreenCaptureUsesPool() {
+        FramePool::Stats stats = record(makeConfig(RecordingMode::FULLSCREEN, Rectangle()));
+        CPPUNIT_ASSERT(stats.slabBytes >= static_cast<size_t>(320 * 200 * 4)); // rounded up to pages
+        CPPUNIT_ASSERT(stats.hits > 0);
+    }
+
+    void testRegionCaptureUsesPool() {
+        FramePool::Stats stats = record(makeConfig(RecordingMode::REGION, Rectangle(16, 16, 64, 64)));
+        CPPUNIT_ASSERT(stats.slabBytes >= static_cast<size_t>(64 * 64 * 4));
+        CPPUNIT_ASSERT(stats.hits > 0);
+    }
+
+    // Recording must reach the source's zero-copy path: packed grabs straight
+    // into the memory its allocator handed out
+    void testRecordingGrabsIntoSourceSlabs() {
+        auto arena = std::make_shared<Arena>();
+        FramePool::Stats stats = record(makeConfig(RecordingMode::REGION, Rectangle(16, 16, 64, 64)),
+                                        std::make_unique<ArenaSource>(arena));
+        CPPUNIT_ASSERT(stats.hits > 0);
+        CPPUNIT_ASSERT(arena->start != nullptr);
+        CPPUNIT_ASSERT(arena->bytes >= static_cast<size_t>(stats.slabCount) * stats.slabBytes);
+        CPPUNIT_ASSERT(arena->inPlaceGrabs > 0);
+        CPPUNIT_ASSERT_EQUAL(0, arena->copiedGrabs);
+    }
+
+    // Needs X11 support and a display to talk to, like CaptureSourceTest
+    void testX11RecordingUsesPool() {
+        const char* display = std::getenv("DISPLAY");
+        std::unique_ptr<CaptureSource> source = createX11CaptureSource();
+        if (!source || !display || !*display || !source->open()) {
+            std::cout << "\n[CapturePoolTest] SKIPPED testX11RecordingUsesPool: "
+                      << (source ? "no X display" : "built without X11") << std::endl;
+            return;
+        }
+        source->close();
+
+        FramePool::Stats stats = record(makeConfig(RecordingMode::REGION, Rectangle(0, 0, 64, 64)), std::move(source));
+        CPPUNIT_ASSERT(stats.slabBytes >= static_cast<size_t>(64 * 64 * 4));
+        CPPUNIT_ASSERT(stats.hits > 0);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CapturePoolTest);
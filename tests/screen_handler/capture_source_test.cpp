@@ -0,0 +1,125 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/screen_reader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Rectangle;
+
+namespace {
+
+// 640x480 BGRA screen whose blue byte is x and green byte is y
+class GradientSource : public CaptureSource {
+public:
+    explicit GradientSource(bool openable = true) : m_openable(openable) {}
+
+    const char* name() const override { return "gradient"; }
+    bool open() override { return m_openable; }
+    Rectangle bounds() const override { return Rectangle(0, 0, 640, 480); }
+    int bitsPerPixel() const override { return 32; }
+
+    bool grab(const Rectangle& area, uint8_t* pixels, size_t stride) override {
+        lastArea = area;
+        for (int y = 0; y < area.height; ++y) {
+            for (int x = 0; x < area.width; ++x) {
+                uint8_t* pixel = pixels + stride * y + x * 4;
+                pixel[0] = static_cast<uint8_t>(area.x + x);
+                pixel[1] = static_cast<uint8_t>(area.y + y);
+                pixel[2] = 0;
+                pixel[3] = 255;
+            }
+        }
+        return true;
+    }
+
+    Rectangle lastArea;
+
+private:
+    bool m_openable;
+};
+
+} // namespace
+
+class CaptureSourceTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(CaptureSourceTest);
+    CPPUNIT_TEST(testReaderCapturesFromSource);
+    CPPUNIT_TEST(testUnopenableSourceIsRejected);
+    CPPUNIT_TEST(testX11SourceGrabs);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testReaderCapturesFromSource() {
+        ScreenReader reader;
+        auto owned = std::make_unique<GradientSource>();
+        GradientSource* source = owned.get();
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::move(owned)));
+        CPPUNIT_ASSERT(reader.initialize());
+        CPPUNIT_ASSERT_EQUAL(std::string("gradient"), std::string(reader.getCaptureSourceName()));
+        CPPUNIT_ASSERT(reader.getPrimaryDisplay().bounds == Rectangle(0, 0, 640, 480));
+
+        // Areas are clipped to what the source can grab
+        ScreenCapture capture;
+        CPPUNIT_ASSERT(reader.captureScreen(capture, Rectangle(600, 400, 100, 100)));
+        CPPUNIT_ASSERT(capture.area == Rectangle(600, 400, 40, 80));
+        CPPUNIT_ASSERT_EQUAL(32, capture.bitsPerPixel);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(639 & 0xFF), capture.view().row(79)[39 * 4]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(479 & 0xFF), capture.view().row(79)[39 * 4 + 1]);
+
+        ScreenCapture region;
+        CPPUNIT_ASSERT(reader.captureRegion(region, Rectangle(10, 20, 30, 40)));
+        CPPUNIT_ASSERT(source->lastArea == Rectangle(10, 20, 30, 40)); // not the whole display
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(30 * 4), region.stride);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(10), region.pixels()[0]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(20 + 39), region.view().row(39)[1]);
+    }
+
+    void testUnopenableSourceIsRejected() {
+        ScreenReader reader;
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::make_unique<GradientSource>()));
+        CPPUNIT_ASSERT(!reader.setCaptureSource(std::make_unique<GradientSource>(false)));
+        CPPUNIT_ASSERT(!reader.setCaptureSource(nullptr));
+        CPPUNIT_ASSERT_EQUAL(std::string("gradient"), std::string(reader.getCaptureSourceName()));
+    }
+
+    // Needs X11 support and a display to talk to; `make test-run` provides
+    // one through xvfb-run when it is installed
+    void testX11SourceGrabs() {
+        const char* display = std::getenv("DISPLAY");
+        std::unique_ptr<CaptureSource> source = createX11CaptureSource();
+        if (!source || !display || !*display || !source->open()) {
+            std::cout << "\n[CaptureSourceTest] SKIPPED testX11SourceGrabs: "
+                      << (source ? "no X display" : "built without X11") << std::endl;
+            return;
+        }
+
+        const Rectangle area(0, 0, std::min(64, source->bounds().width), std::min(48, source->bounds().height));
+        const size_t stride = static_cast<size_t>(area.width) * 4 + 16;
+        std::vector<uint8_t> pixels(stride * area.height, 0xCD);
+        CPPUNIT_ASSERT_EQUAL(32, source->bitsPerPixel());
+        CPPUNIT_ASSERT(source->grab(area, pixels.data(), stride));
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(0xCD), pixels[stride - 1]); // padding untouched
+        CPPUNIT_ASSERT(!source->grab(Rectangle(source->bounds().width, 0, 8, 8), pixels.data(), stride));
+
+        // Into memory from the source's own allocator, with or without MIT-SHM
+        const size_t rowBytes = static_cast<size_t>(area.width) * 4;
+        FramePool pool;
+        CPPUNIT_ASSERT(pool.configure(2, rowBytes * area.height, source->slabAllocator()));
+        FrameBuffer slab = pool.acquire(rowBytes * area.height);
+        CPPUNIT_ASSERT(slab.isPooled());
+        CPPUNIT_ASSERT(source->grab(area, slab.data(), rowBytes));
+        for (int y = 0; y < area.height; ++y) {
+            CPPUNIT_ASSERT(std::equal(pixels.begin() + stride * y, pixels.begin() + stride * y + rowBytes,
+                                      slab.begin() + rowBytes * y));
+        }
+
+        // Pool memory outlives the source
+        source->close();
+        slab[0] = 1;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CaptureSourceTest);
@@ -0,0 +1,258 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/screen_handler.h"
+#include "screen_handler/screen_reader.h"
+#include "screen_handler/screen_writer.h"
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Rectangle;
+
+namespace {
+
+// 200x130 BGRA screen (4x3 tiles, partial at the right and bottom) that tests paint on
+class CanvasSource : public CaptureSource {
+public:
+    static constexpr int WIDTH = 200;
+    static constexpr int HEIGHT = 130;
+
+    CanvasSource() : pixels(static_cast<size_t>(WIDTH) * HEIGHT * 4) {
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            pixels[i] = static_cast<uint8_t>(i * 7);
+        }
+    }
+
+    const char* name() const override { return "canvas"; }
+    bool open() override { return true; }
+    Rectangle bounds() const override { return Rectangle(0, 0, WIDTH, HEIGHT); }
+    int bitsPerPixel() const override { return 32; }
+
+    bool grab(const Rectangle& area, uint8_t* target, size_t stride) override {
+        for (int y = 0; y < area.height; ++y) {
+            std::memcpy(target + stride * y, &pixels[(static_cast<size_t>(area.y + y) * WIDTH + area.x) * 4],
+                        static_cast<size_t>(area.width) * 4);
+        }
+        return true;
+    }
+
+    void fill(const Rectangle& rect, uint8_t value) {
+        for (int y = rect.y; y < rect.y + rect.height; ++y) {
+            std::memset(&pixels[(static_cast<size_t>(y) * WIDTH + rect.x) * 4], value,
+                        static_cast<size_t>(rect.width) * 4);
+        }
+    }
+
+    std::vector<uint8_t> pixels;
+};
+
+// Packed 32-bit frame, every byte set to `value`
+ScreenCapture makeCapture(int width, int height, uint8_t value) {
+    ScreenCapture capture;
+    capture.area = Rectangle(0, 0, width, height);
+    capture.width = width;
+    capture.height = height;
+    capture.bitsPerPixel = 32;
+    capture.pixelData = FrameBuffer::allocate(static_cast<size_t>(width) * height * 4);
+    std::memset(capture.pixels(), value, static_cast<size_t>(width) * height * 4);
+    return capture;
+}
+
+bool samePixels(const ScreenCapture& a, const ScreenCapture& b) {
+    for (int y = 0; y < a.height; ++y) {
+        if (std::memcmp(a.view().row(y), b.view().row(y), a.view().rowBytes()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+class DirtyTilesTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(DirtyTilesTest);
+    CPPUNIT_TEST(testTileHashesFollowContent);
+    CPPUNIT_TEST(testChangedRegionsMergeRuns);
+    CPPUNIT_TEST(testCaptureChangesSendsOnlyChangedTiles);
+    CPPUNIT_TEST(testApplyToRebuildsFrame);
+    CPPUNIT_TEST(testCaptureChangesResendsRequestedTiles);
+    CPPUNIT_TEST(testIncrementalFramesCarryAnnotations);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testTileHashesFollowContent() {
+        ScreenCapture previous = makeCapture(150, 100, 0x20);
+        ScreenCapture current = previous.clone();
+        CPPUNIT_ASSERT_EQUAL(3, current.tileColumns());
+        CPPUNIT_ASSERT_EQUAL(2, current.tileRows());
+        CPPUNIT_ASSERT(current.tileRect(5) == Rectangle(128, 64, 22, 36));
+
+        previous.hashTiles();
+        current.hashTiles();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(6), current.tileHashes.size());
+        CPPUNIT_ASSERT(previous.tileHashes == current.tileHashes);
+
+        // One byte in the partial corner tile
+        current.pixels()[(static_cast<size_t>(99) * 150 + 149) * 4 + 2] ^= 1;
+        current.hashTiles();
+        std::vector<int> changed;
+        current.findChangedTiles(previous, changed);
+        CPPUNIT_ASSERT(changed == std::vector<int>({5}));
+
+        // Stale cached hashes are ignored once the size no longer matches
+        current.tileHashes.clear();
+        current.findChangedTiles(previous, changed);
+        CPPUNIT_ASSERT(changed == std::vector<int>({5}));
+
+        // A different geometry marks every tile
+        ScreenCapture smaller = makeCapture(100, 100, 0x20);
+        smaller.findChangedTiles(previous, changed);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), changed.size());
+    }
+
+    void testChangedRegionsMergeRuns() {
+        ScreenCapture previous = makeCapture(150, 100, 0x20);
+        ScreenCapture current = previous.clone();
+        current.pixels()[0] = 1;                                        // tile 0
+        current.pixels()[static_cast<size_t>(70) * 4] = 1;              // tile 1
+        current.pixels()[(static_cast<size_t>(70) * 150 + 10) * 4] = 1; // tile 3
+
+        std::vector<Rectangle> regions = current.findChangedRegions(previous);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), regions.size());
+        CPPUNIT_ASSERT(regions[0] == Rectangle(0, 0, 128, 64));
+        CPPUNIT_ASSERT(regions[1] == Rectangle(0, 64, 64, 36));
+        CPPUNIT_ASSERT(previous.findChangedRegions(previous.clone()).empty());
+    }
+
+    void testCaptureChangesSendsOnlyChangedTiles() {
+        ScreenReader reader;
+        auto owned = std::make_unique<CanvasSource>();
+        CanvasSource* source = owned.get();
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::move(owned)));
+        CPPUNIT_ASSERT(reader.initialize());
+
+        // Nothing to compare against: every tile, packed back to back
+        SparseCapture changes;
+        CPPUNIT_ASSERT(reader.captureChanges(changes));
+        CPPUNIT_ASSERT(changes.keyFrame);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(12), changes.tiles.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(CanvasSource::WIDTH) * CanvasSource::HEIGHT * 4,
+                             changes.pixelData.size());
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, changes.changeRatio(), 1e-6);
+
+        CPPUNIT_ASSERT(reader.captureChanges(changes));
+        CPPUNIT_ASSERT(!changes.keyFrame);
+        CPPUNIT_ASSERT(changes.empty());
+        CPPUNIT_ASSERT(!changes.hasMotion(0.0f));
+
+        // A block inside the middle tile of the second row
+        source->fill(Rectangle(70, 70, 10, 10), 0xEE);
+        CPPUNIT_ASSERT(reader.captureChanges(changes));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), changes.tiles.size());
+        CPPUNIT_ASSERT(changes.tiles[0] == Rectangle(64, 64, 64, 64));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(64 * 64 * 4), changes.pixelData.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(0xEE), changes.tilePixels(0)[(6 * 64 + 6) * 4]);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(64.0 * 64 / (200 * 130), changes.changeRatio(), 1e-6);
+    }
+
+    // A consumer holding the previous frame stays in step with the screen
+    void testApplyToRebuildsFrame() {
+        ScreenReader reader;
+        auto owned = std::make_unique<CanvasSource>();
+        CanvasSource* source = owned.get();
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::move(owned)));
+        CPPUNIT_ASSERT(reader.initialize());
+
+        ScreenCapture reference = makeCapture(CanvasSource::WIDTH, CanvasSource::HEIGHT, 0);
+        SparseCapture changes;
+        const Rectangle edits[] = {Rectangle(0, 0, 5, 5), Rectangle(190, 120, 10, 10), Rectangle(60, 10, 80, 60)};
+        for (int step = 0; step <= 3; ++step) {
+            if (step > 0) {
+                source->fill(edits[step - 1], static_cast<uint8_t>(step * 40));
+            }
+            CPPUNIT_ASSERT(reader.captureChanges(changes));
+            CPPUNIT_ASSERT(changes.applyTo(reference));
+
+            ScreenCapture screen;
+            CPPUNIT_ASSERT(reader.captureScreen(screen));
+            CPPUNIT_ASSERT(samePixels(screen, reference));
+        }
+
+        // The frame must have the capture's geometry
+        ScreenCapture wrongSize = makeCapture(64, 64, 0);
+        CPPUNIT_ASSERT(!changes.applyTo(wrongSize));
+    }
+
+    void testCaptureChangesResendsRequestedTiles() {
+        ScreenReader reader;
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::make_unique<CanvasSource>()));
+        CPPUNIT_ASSERT(reader.initialize());
+
+        SparseCapture changes;
+        CPPUNIT_ASSERT(reader.captureChanges(changes));
+
+        // Unchanged screen, but tiles 1, 2 and 9 requested; off-screen is ignored
+        const std::vector<Rectangle> resend = {Rectangle(130, 10, 10, 10), Rectangle(100, 40, 40, 10),
+                                               Rectangle(70, 128, 4, 4), Rectangle(300, 0, 10, 10)};
+        CPPUNIT_ASSERT(reader.captureChanges(changes, Rectangle(), resend));
+        CPPUNIT_ASSERT(!changes.keyFrame);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), changes.tiles.size());
+        CPPUNIT_ASSERT(changes.tiles[0] == Rectangle(64, 0, 64, 64));
+        CPPUNIT_ASSERT(changes.tiles[1] == Rectangle(128, 0, 64, 64));
+        CPPUNIT_ASSERT(changes.tiles[2] == Rectangle(64, 128, 64, 2));
+
+        CPPUNIT_ASSERT(reader.captureChanges(changes));
+        CPPUNIT_ASSERT(changes.empty());
+    }
+
+    // Annotations drawn during a DIRTY_TILES recording reach the frames the
+    // writer rebuilds, and leave them again once erased
+    void testIncrementalFramesCarryAnnotations() {
+        ScreenHandler handler;
+        CPPUNIT_ASSERT(handler.initialize());
+        auto owned = std::make_unique<CanvasSource>();
+        const CanvasSource* source = owned.get();
+        CPPUNIT_ASSERT(handler.getReader()->setCaptureSource(std::move(owned)));
+
+        std::mutex mutex;
+        ScreenCapture reference = makeCapture(CanvasSource::WIDTH, CanvasSource::HEIGHT, 0);
+        handler.setFrameEncoder([](PipelineFrame&) { return true; });
+        handler.setFrameWriter([&](const PipelineFrame& frame) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return frame.incremental && frame.changes.applyTo(reference);
+        });
+        auto pixelAt = [&](int x, int y) {
+            std::lock_guard<std::mutex> lock(mutex);
+            const uint8_t* pixel = reference.view().row(y) + static_cast<size_t>(x) * 4;
+            return std::vector<uint8_t>(pixel, pixel + 3);
+        };
+
+        RecordingConfig config;
+        config.captureMode = CaptureMode::DIRTY_TILES;
+        config.fps = 60.0f;
+        config.adaptiveQuality = false;
+        config.autoSave = false;
+        config.dropPolicy = DropPolicy::BLOCK;
+        CPPUNIT_ASSERT(handler.startCapture(config));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // past the key frame
+
+        ShapeProperties box;
+        box.fillColor = Color(255, 0, 0);
+        box.strokeColor = Color(255, 0, 0);
+        CPPUNIT_ASSERT(handler.getWriter()->drawRectangle(Rectangle(70, 70, 20, 20), box));
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        CPPUNIT_ASSERT(pixelAt(80, 80) == std::vector<uint8_t>({0, 0, 255}));
+
+        handler.getWriter()->clearCanvas();
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        const uint8_t* screen = &source->pixels[(static_cast<size_t>(80) * CanvasSource::WIDTH + 80) * 4];
+        CPPUNIT_ASSERT(pixelAt(80, 80) == std::vector<uint8_t>(screen, screen + 3));
+        CPPUNIT_ASSERT(handler.stopCapture());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DirtyTilesTest);
@@ -0,0 +1,100 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/frame_pool.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using Recordify::ScreenHandler::FrameBuffer;
+using Recordify::ScreenHandler::FramePool;
+
+class FramePoolTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(FramePoolTest);
+    CPPUNIT_TEST(testSlabsArePageAligned);
+    CPPUNIT_TEST(testHitsAndMisses);
+    CPPUNIT_TEST(testReleaseReturnsSlab);
+    CPPUNIT_TEST(testReconfigureKeepsBorrowedBuffers);
+    CPPUNIT_TEST(testReconfigureWhileAcquiring);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testSlabsArePageAligned() {
+        FramePool pool(2, 1000);
+        FrameBuffer buffer = pool.acquire(1000);
+        CPPUNIT_ASSERT(buffer.isPooled());
+        CPPUNIT_ASSERT(reinterpret_cast<uintptr_t>(buffer.data()) % FramePool::pageSize() == 0);
+        CPPUNIT_ASSERT(buffer.capacity() >= 1000);
+    }
+
+    void testHitsAndMisses() {
+        FramePool pool(1, 1000);
+        FrameBuffer first = pool.acquire(800);
+        FrameBuffer exhausted = pool.acquire(800);
+        FrameBuffer oversized = pool.acquire(pool.getStats().slabBytes + 1);
+
+        FramePool::Stats stats = pool.getStats();
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), stats.hits);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(2), stats.misses);
+        CPPUNIT_ASSERT(!exhausted.isPooled());
+        CPPUNIT_ASSERT(!oversized.isPooled());
+    }
+
+    void testReleaseReturnsSlab() {
+        FramePool pool(1, 1000);
+        FrameBuffer buffer = pool.acquire(1000);
+        {
+            FrameBuffer copy = buffer;
+            CPPUNIT_ASSERT_EQUAL(2, buffer.useCount());
+        }
+        CPPUNIT_ASSERT(buffer.unique());
+        CPPUNIT_ASSERT_EQUAL(1, pool.getStats().slabsInUse);
+
+        buffer.reset();
+        CPPUNIT_ASSERT_EQUAL(0, pool.getStats().slabsInUse);
+        CPPUNIT_ASSERT(pool.acquire(1000).isPooled());
+    }
+
+    void testReconfigureKeepsBorrowedBuffers() {
+        FramePool pool(1, 64);
+        FrameBuffer buffer = pool.acquire(64);
+        buffer[63] = 42;
+
+        CPPUNIT_ASSERT(pool.configure(2, 128));
+        CPPUNIT_ASSERT_EQUAL(42, static_cast<int>(buffer[63]));
+        CPPUNIT_ASSERT_EQUAL(0, pool.getStats().slabsInUse);
+    }
+
+    // Capture threads keep acquiring while the slab set is swapped under them
+    void testReconfigureWhileAcquiring() {
+        FramePool pool(4, 4096);
+        std::atomic<bool> running{true};
+        std::atomic<int> badBuffers{0};
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < 3; ++thread) {
+            threads.emplace_back([&pool, &running, &badBuffers, thread]() {
+                while (running.load()) {
+                    FrameBuffer buffer = pool.acquire(4096);
+                    buffer[0] = static_cast<uint8_t>(thread);
+                    buffer[4095] = static_cast<uint8_t>(thread);
+                    if (buffer.size() != 4096 || buffer[0] != buffer[4095]) {
+                        badBuffers.fetch_add(1);
+                    }
+                }
+            });
+        }
+        for (int round = 0; round < 200; ++round) {
+            CPPUNIT_ASSERT(pool.configure(2 + round % 3, 4096 * (1 + round % 2)));
+            pool.getStats();
+        }
+        running = false;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        CPPUNIT_ASSERT_EQUAL(0, badBuffers.load());
+        CPPUNIT_ASSERT_EQUAL(0, pool.getStats().slabsInUse);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FramePoolTest);
@@ -0,0 +1,98 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/screen_reader.h"
+#include <type_traits>
+
+using Recordify::ScreenHandler::FrameBuffer;
+using Recordify::ScreenHandler::FrameView;
+using Recordify::ScreenHandler::ScreenCapture;
+using Recordify::Utils::Rectangle;
+
+namespace {
+
+// 32-bit frame whose first byte per pixel encodes (x, y)
+ScreenCapture makeCapture(int width, int height) {
+    ScreenCapture capture;
+    capture.area = Rectangle(100, 200, width, height);
+    capture.width = width;
+    capture.height = height;
+    capture.bitsPerPixel = 32;
+    capture.pixelData = FrameBuffer::allocate(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            capture.pixels()[(static_cast<size_t>(y) * width + x) * 4] = static_cast<uint8_t>(y * 16 + x);
+        }
+    }
+    return capture;
+}
+
+} // namespace
+
+class FrameViewTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(FrameViewTest);
+    CPPUNIT_TEST(testCaptureIsMoveOnly);
+    CPPUNIT_TEST(testCropSharesPixels);
+    CPPUNIT_TEST(testSubViewClipsToFrame);
+    CPPUNIT_TEST(testCloneOfCropIsPacked);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testCaptureIsMoveOnly() {
+        CPPUNIT_ASSERT(!std::is_copy_constructible<ScreenCapture>::value);
+        CPPUNIT_ASSERT(std::is_nothrow_move_constructible<ScreenCapture>::value);
+
+        ScreenCapture capture = makeCapture(8, 8);
+        const uint8_t* pixels = capture.pixels();
+        ScreenCapture moved = std::move(capture);
+        CPPUNIT_ASSERT(moved.pixels() == pixels);
+        CPPUNIT_ASSERT(moved.pixelData.unique());
+    }
+
+    void testCropSharesPixels() {
+        ScreenCapture capture = makeCapture(16, 8);
+        const uint8_t* base = capture.pixels();
+        ScreenCapture region = capture.share();
+        CPPUNIT_ASSERT_EQUAL(2, capture.pixelData.useCount());
+
+        CPPUNIT_ASSERT(region.crop(Rectangle(4, 2, 6, 3)));
+        CPPUNIT_ASSERT(region.pixels() == base + 2 * 16 * 4 + 4 * 4);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(16 * 4), region.bytesPerRow());
+        CPPUNIT_ASSERT_EQUAL(6, region.width);
+        CPPUNIT_ASSERT(region.area == Rectangle(104, 202, 6, 3));
+        CPPUNIT_ASSERT(region.hasPixels());
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(4 * 16 + 9), region.view().row(2)[5 * 4]);
+
+        // Cropping again is relative to the crop
+        CPPUNIT_ASSERT(region.crop(Rectangle(1, 1, 2, 2)));
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(3 * 16 + 5), region.pixels()[0]);
+        CPPUNIT_ASSERT(!region.crop(Rectangle(10, 10, 4, 4)));
+    }
+
+    void testSubViewClipsToFrame() {
+        ScreenCapture capture = makeCapture(16, 8);
+        FrameView view = capture.view(Rectangle(12, 6, 10, 10));
+        CPPUNIT_ASSERT(view.isValid());
+        CPPUNIT_ASSERT_EQUAL(4, view.width);
+        CPPUNIT_ASSERT_EQUAL(2, view.height);
+        CPPUNIT_ASSERT(view.area == Rectangle(112, 206, 4, 2));
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(7 * 16 + 15), view.row(1)[3 * 4]);
+        CPPUNIT_ASSERT(!capture.view(Rectangle(20, 0, 4, 4)).isValid());
+    }
+
+    void testCloneOfCropIsPacked() {
+        ScreenCapture capture = makeCapture(16, 8);
+        CPPUNIT_ASSERT(capture.crop(Rectangle(2, 3, 5, 4)));
+        ScreenCapture copy = capture.clone();
+        CPPUNIT_ASSERT(copy.pixelData.data() != capture.pixelData.data());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5 * 4), copy.bytesPerRow());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5 * 4 * 4), copy.pixelData.size());
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 5; ++x) {
+                CPPUNIT_ASSERT_EQUAL(capture.view().row(y)[x * 4], copy.view().row(y)[x * 4]);
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FrameViewTest);
@@ -0,0 +1,138 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/screen_reader.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Point;
+using Recordify::Utils::Rectangle;
+using Recordify::Utils::Span;
+
+namespace {
+
+// Static screen whose pointer moves one pixel right per sample
+class MovingPointerSource : public CaptureSource {
+public:
+    const char* name() const override { return "moving pointer"; }
+    bool open() override { return true; }
+    Rectangle bounds() const override { return Rectangle(0, 0, 64, 64); }
+    int bitsPerPixel() const override { return 32; }
+    bool grab(const Rectangle&, uint8_t*, size_t) override { return true; }
+
+    bool pointer(Point& position) override {
+        samplerThread = std::this_thread::get_id();
+        position = Point(++samples, 10);
+        return true;
+    }
+
+    std::atomic<int> samples{0};
+    std::thread::id samplerThread;
+};
+
+} // namespace
+
+class InputSamplingTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(InputSamplingTest);
+    CPPUNIT_TEST(testCallbacksRunOnDispatcher);
+    CPPUNIT_TEST(testSlowCallbackDoesNotStallSampler);
+    CPPUNIT_TEST(testMouseTrailViewReportsOverwrite);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testCallbacksRunOnDispatcher() {
+        ScreenReader reader;
+        auto owned = std::make_unique<MovingPointerSource>();
+        MovingPointerSource* source = owned.get();
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::move(owned)));
+        CPPUNIT_ASSERT(reader.initialize());
+        reader.setUpdateRate(500.0f);
+
+        std::mutex mutex;
+        std::vector<int> positions;
+        std::vector<std::chrono::steady_clock::time_point> stamps;
+        std::vector<std::thread::id> threads;
+        reader.setMouseCallback([&](const MouseState& mouse) {
+            std::lock_guard<std::mutex> lock(mutex);
+            positions.push_back(mouse.position.x);
+            stamps.push_back(mouse.timestamp);
+            threads.push_back(std::this_thread::get_id());
+        });
+
+        CPPUNIT_ASSERT(reader.startSampling());
+        CPPUNIT_ASSERT(reader.isSampling());
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        reader.stopSampling();
+        CPPUNIT_ASSERT(!reader.isSampling());
+
+        // Stopping drains the queue: every sample reached the callback, in order
+        std::lock_guard<std::mutex> lock(mutex);
+        CPPUNIT_ASSERT(positions.size() > 5);
+        CPPUNIT_ASSERT_EQUAL(source->samples.load(), static_cast<int>(positions.size()));
+        for (size_t i = 0; i < positions.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(static_cast<int>(i) + 1, positions[i]);
+            CPPUNIT_ASSERT(i == 0 || stamps[i - 1] < stamps[i]);
+            CPPUNIT_ASSERT(threads[i] == threads[0]);
+        }
+        CPPUNIT_ASSERT(threads[0] != std::this_thread::get_id());
+        CPPUNIT_ASSERT(threads[0] != source->samplerThread);
+        CPPUNIT_ASSERT_EQUAL(0, reader.getReaderStats().droppedEvents);
+    }
+
+    // The sampler keeps its schedule and only the queue backs up
+    void testSlowCallbackDoesNotStallSampler() {
+        ScreenReader reader;
+        auto owned = std::make_unique<MovingPointerSource>();
+        MovingPointerSource* source = owned.get();
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::move(owned)));
+        CPPUNIT_ASSERT(reader.initialize());
+        reader.setUpdateRate(500.0f);
+
+        std::atomic<int> delivered{0};
+        reader.setMouseCallback([&delivered](const MouseState&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            delivered.fetch_add(1);
+        });
+
+        CPPUNIT_ASSERT(reader.startSampling());
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const int sampledWhileRunning = source->samples.load();
+        const int deliveredWhileRunning = delivered.load();
+        reader.stopSampling();
+
+        CPPUNIT_ASSERT(sampledWhileRunning > 3 * deliveredWhileRunning);
+        ScreenReader::ReaderStats stats = reader.getReaderStats();
+        CPPUNIT_ASSERT_EQUAL(stats.mouseEvents - stats.droppedEvents, delivered.load());
+    }
+
+    void testMouseTrailViewReportsOverwrite() {
+        ScreenReader reader;
+        CPPUNIT_ASSERT(reader.setCaptureSource(std::make_unique<MovingPointerSource>()));
+        CPPUNIT_ASSERT(reader.initialize());
+        reader.setUpdateRate(500.0f);
+
+        CPPUNIT_ASSERT(reader.startSampling());
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        reader.stopSampling();
+
+        uint64_t sequence = 0;
+        Span<Point> trail = reader.getMouseTrailView(sequence, 10);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(10), trail.size());
+        for (size_t i = 1; i < trail.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(trail[i - 1].x + 1, trail[i].x);
+        }
+        CPPUNIT_ASSERT(reader.isMouseTrailIntact(sequence, trail.size()));
+
+        // Another 128+ samples wrap the trail past the view
+        CPPUNIT_ASSERT(reader.startSampling());
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        reader.stopSampling();
+        CPPUNIT_ASSERT(!reader.isMouseTrailIntact(sequence, trail.size()));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(InputSamplingTest);
@@ -0,0 +1,100 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/screen_reader.h"
+#include <type_traits>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+
+class KeyTableTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(KeyTableTest);
+    CPPUNIT_TEST(testBitsetOperations);
+    CPPUNIT_TEST(testPressReleaseAcrossTicks);
+    CPPUNIT_TEST(testSnapshotIsIndependent);
+    CPPUNIT_TEST(testModifiersMatchEitherSide);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testBitsetOperations() {
+        KeyBitset bits;
+        CPPUNIT_ASSERT(!bits.any());
+        for (int keyCode : {0, 63, 64, 130, 255}) {
+            bits.set(keyCode);
+        }
+        CPPUNIT_ASSERT_EQUAL(5, bits.count());
+        CPPUNIT_ASSERT(bits.test(63) && bits.test(64) && !bits.test(65));
+
+        std::vector<int> visited;
+        bits.forEach([&visited](int keyCode) { visited.push_back(keyCode); });
+        CPPUNIT_ASSERT(visited == std::vector<int>({0, 63, 64, 130, 255}));
+
+        KeyBitset other;
+        other.set(64);
+        other.set(200);
+        CPPUNIT_ASSERT_EQUAL(1, (bits & other).count());
+        CPPUNIT_ASSERT_EQUAL(6, (bits | other).count());
+        CPPUNIT_ASSERT_EQUAL(5, (bits ^ other).count());
+
+        bits.set(255, false);
+        CPPUNIT_ASSERT(!bits.test(255));
+        CPPUNIT_ASSERT(bits != other);
+    }
+
+    void testPressReleaseAcrossTicks() {
+        // Copies are plain memory, so the input thread can hand them around freely
+        CPPUNIT_ASSERT(std::is_trivially_copyable<KeyTable>::value);
+
+        KeyTable keys;
+        auto now = std::chrono::steady_clock::now();
+        keys.press(0x41, now);
+        keys.press(0x41, now + std::chrono::milliseconds(5)); // repeat keeps the first press time
+        keys.press(KeyTable::KEY_COUNT, now);                 // out of range, ignored
+        CPPUNIT_ASSERT(keys[0x41].isJustPressed());
+        CPPUNIT_ASSERT(keys[0x41].pressTime == now);
+        CPPUNIT_ASSERT_EQUAL(1, keys.changed().count());
+
+        keys.advance();
+        CPPUNIT_ASSERT(keys[0x41].pressed && !keys[0x41].isJustPressed());
+        CPPUNIT_ASSERT(!keys.changed().any());
+
+        keys.release(0x41, now + std::chrono::milliseconds(20));
+        CPPUNIT_ASSERT(keys[0x41].isJustReleased());
+        CPPUNIT_ASSERT(keys.changed().test(0x41));
+        keys.advance();
+        CPPUNIT_ASSERT(!keys[0x41].isJustReleased());
+        CPPUNIT_ASSERT(!keys.pressed().any());
+    }
+
+    void testSnapshotIsIndependent() {
+        KeyboardState state;
+        auto now = std::chrono::steady_clock::now();
+        state.keys.press(0x20, now);
+        state.timestamp = now;
+        KeySnapshot before = state.snapshot();
+
+        state.keys.advance();
+        state.keys.press(0x21, now);
+        state.keys.release(0x20, now);
+        KeySnapshot after = state.snapshot();
+
+        CPPUNIT_ASSERT(before.pressed.test(0x20) && !before.pressed.test(0x21));
+        KeyBitset changed = after.changedSince(before);
+        CPPUNIT_ASSERT_EQUAL(2, changed.count());
+        CPPUNIT_ASSERT(changed.test(0x20) && changed.test(0x21));
+        CPPUNIT_ASSERT(state.getPressedKeys() == std::vector<int>({0x21}));
+    }
+
+    void testModifiersMatchEitherSide() {
+        KeyboardState state;
+        auto now = std::chrono::steady_clock::now();
+        state.keys.press(0xA3, now); // right control
+        CPPUNIT_ASSERT(state.isModifierPressed(0x11));
+        CPPUNIT_ASSERT(state.isModifierPressed(0xA3));
+        CPPUNIT_ASSERT(!state.isModifierPressed(0xA2));
+        CPPUNIT_ASSERT(!state.isModifierPressed(0x10));
+        CPPUNIT_ASSERT(state.isKeyPressed(0xA3) && !state.isKeyPressed(-1));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(KeyTableTest);
@@ -0,0 +1,131 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/layer_compositor.h"
+#include "screen_handler/screen_writer.h"
+#include <algorithm>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Point;
+using Recordify::Utils::Rectangle;
+using Recordify::Utils::Size;
+
+class LayerCompositorTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(LayerCompositorTest);
+    CPPUNIT_TEST(testOnlyDirtyTilesRebuild);
+    CPPUNIT_TEST(testCompositeTouchesOccupiedTiles);
+    CPPUNIT_TEST(testOpacityAndVisibility);
+    CPPUNIT_TEST(testAnnotationSpritesFollowUpdates);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testOnlyDirtyTilesRebuild() {
+        TiledSurface layer(256, 128);
+        LayerCompositor compositor;
+        compositor.resize(256, 128);
+        compositor.update({{&layer, 1.0f, true}});
+        const uint64_t initial = compositor.getStats().tilesRebuilt;
+
+        Rasterizer rasterizer(layer);
+        RasterPath path;
+        path.addRect(10.0f, 10.0f, 20.0f, 20.0f);
+        rasterizer.fill(path, PremultipliedColor::fromStraight(255, 0, 0, 255));
+        CPPUNIT_ASSERT_EQUAL(1, layer.occupiedTiles());
+
+        compositor.update({{&layer, 1.0f, true}});
+        CPPUNIT_ASSERT_EQUAL(initial + 1, compositor.getStats().tilesRebuilt);
+        CPPUNIT_ASSERT(!layer.hasDirtyTiles());
+
+        // Nothing changed, nothing rebuilt
+        compositor.update({{&layer, 1.0f, true}});
+        CPPUNIT_ASSERT_EQUAL(initial + 1, compositor.getStats().tilesRebuilt);
+    }
+
+    void testCompositeTouchesOccupiedTiles() {
+        const int width = 200, height = 150;
+        TiledSurface layer(width, height);
+        Rasterizer rasterizer(layer);
+        RasterPath path;
+        path.addRect(130.0f, 70.0f, 8.0f, 8.0f);
+        rasterizer.fill(path, PremultipliedColor::fromStraight(0, 0, 255, 255));
+
+        LayerCompositor compositor;
+        compositor.resize(width, height);
+        compositor.update({{&layer, 1.0f, true}});
+
+        std::vector<uint8_t> frame(width * height * 3, 10);
+        CPPUNIT_ASSERT_EQUAL(1, compositor.compositeOnto(frame.data(), width, height, width * 3, 3));
+
+        // BGR order: blue lands in byte 0
+        const uint8_t* inside = &frame[(72 * width + 132) * 3];
+        CPPUNIT_ASSERT_EQUAL(255, static_cast<int>(inside[0]));
+        CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(inside[2]));
+        CPPUNIT_ASSERT_EQUAL(10, static_cast<int>(frame[(72 * width + 120) * 3]));
+    }
+
+    void testOpacityAndVisibility() {
+        ScreenWriter writer;
+        CPPUNIT_ASSERT(writer.initialize());
+        CPPUNIT_ASSERT(writer.createCanvas(Size(64, 64)));
+
+        int layerId = writer.createLayer("marks");
+        CPPUNIT_ASSERT(writer.setActiveLayer(layerId));
+        ShapeProperties box;
+        box.fillColor = Color(255, 255, 255);
+        box.strokeWidth = 0.0f;
+        CPPUNIT_ASSERT(writer.drawRectangle(Rectangle(0, 0, 16, 16), box));
+
+        std::vector<uint8_t> frame(64 * 64 * 4, 0);
+        CPPUNIT_ASSERT(writer.setLayerOpacity(layerId, 0.5f));
+        CPPUNIT_ASSERT(writer.compositeLayers(frame.data(), 64, 64, 64 * 4, 4));
+        CPPUNIT_ASSERT_EQUAL(128, static_cast<int>(frame[(4 * 64 + 4) * 4]));
+
+        std::fill(frame.begin(), frame.end(), 0);
+        CPPUNIT_ASSERT(writer.setLayerVisible(layerId, false));
+        CPPUNIT_ASSERT(writer.compositeLayers(frame.data(), 64, 64, 64 * 4, 4));
+        CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(frame[(4 * 64 + 4) * 4]));
+        CPPUNIT_ASSERT_EQUAL(1ull, static_cast<unsigned long long>(writer.getRenderStats().compositedTiles));
+    }
+
+    void testAnnotationSpritesFollowUpdates() {
+        ScreenWriter writer;
+        CPPUNIT_ASSERT(writer.initialize());
+        CPPUNIT_ASSERT(writer.createCanvas(Size(256, 256)));
+
+        ScreenWriter::Annotation click;
+        click.type = "click";
+        click.points = {Point(20, 20)};
+        click.shapeProps.fillColor = Color::RED;
+        click.shapeProps.strokeWidth = 0.0f;
+        int id = writer.addAnnotation(click);
+
+        // BGRA: red lands in byte 2
+        auto redAt = [](const std::vector<uint8_t>& frame, int x, int y) {
+            return static_cast<int>(frame[(y * 256 + x) * 4 + 2]);
+        };
+        std::vector<uint8_t> frame(256 * 256 * 4, 0);
+        CPPUNIT_ASSERT(writer.compositeLayers(frame.data(), 256, 256, 256 * 4, 4));
+        CPPUNIT_ASSERT_EQUAL(255, redAt(frame, 20, 20));
+        CPPUNIT_ASSERT_EQUAL(id, writer.getAnnotationAt(Point(20, 20)));
+        CPPUNIT_ASSERT_EQUAL(0, writer.getAnnotationAt(Point(100, 100)));
+
+        click.points = {Point(200, 200)};
+        CPPUNIT_ASSERT(writer.updateAnnotation(id, click));
+        std::fill(frame.begin(), frame.end(), 0);
+        CPPUNIT_ASSERT(writer.compositeLayers(frame.data(), 256, 256, 256 * 4, 4));
+        CPPUNIT_ASSERT_EQUAL(0, redAt(frame, 20, 20));
+        CPPUNIT_ASSERT_EQUAL(255, redAt(frame, 200, 200));
+        CPPUNIT_ASSERT(writer.getAnnotationsIn(Rectangle(0, 0, 64, 64)).empty());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), writer.getAnnotationsIn(Rectangle(190, 190, 4, 4)).size());
+
+        CPPUNIT_ASSERT(writer.removeAnnotation(id));
+        std::fill(frame.begin(), frame.end(), 0);
+        const uint64_t before = writer.getRenderStats().compositedTiles;
+        CPPUNIT_ASSERT(writer.compositeLayers(frame.data(), 256, 256, 256 * 4, 4));
+        CPPUNIT_ASSERT_EQUAL(before, writer.getRenderStats().compositedTiles);
+        CPPUNIT_ASSERT_EQUAL(0, redAt(frame, 200, 200));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LayerCompositorTest);
@@ -0,0 +1,149 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/screen_handler.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Rectangle;
+
+namespace {
+
+// Blank screen whose grabs fail in bursts
+class FlakySource : public CaptureSource {
+public:
+    const char* name() const override { return "flaky"; }
+    bool open() override { return true; }
+    Rectangle bounds() const override { return Rectangle(0, 0, 64, 48); }
+    int bitsPerPixel() const override { return 32; }
+    bool grab(const Rectangle&, uint8_t*, size_t) override { return ++m_grabs % 8 >= 3; }
+
+private:
+    int m_grabs = 0;
+};
+
+RecordingConfig makeConfig() {
+    RecordingConfig config;
+    config.mode = RecordingMode::REGION;
+    config.captureArea = Rectangle(0, 0, 64, 48);
+    config.fps = 120.0f;
+    config.adaptiveQuality = false;
+    config.autoSave = false;
+    config.dropPolicy = DropPolicy::BLOCK;
+    return config;
+}
+
+} // namespace
+
+class PipelineOrderTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(PipelineOrderTest);
+    CPPUNIT_TEST(testWriterSeesCaptureOrder);
+    CPPUNIT_TEST(testFailedCapturesAreDropped);
+    CPPUNIT_TEST(testLatencyRunsToWriteCompletion);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    // Encode workers finish out of order; the writer must still get frames in sequence
+    void testWriterSeesCaptureOrder() {
+        ScreenHandler handler;
+        CPPUNIT_ASSERT(handler.initialize());
+        handler.setThreadCount(4);
+
+        std::atomic<int> encoded{0};
+        handler.setFrameEncoder([&encoded](PipelineFrame& frame) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(frame.sequence % 4 == 0 ? 15 : 1));
+            encoded.fetch_add(1);
+            return true;
+        });
+        std::vector<uint64_t> written;
+        handler.setFrameWriter([&written](const PipelineFrame& frame) {
+            written.push_back(frame.sequence);
+            return true;
+        });
+
+        CPPUNIT_ASSERT(handler.startCapture(makeConfig()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        CPPUNIT_ASSERT(handler.stopCapture());
+
+        CPPUNIT_ASSERT(written.size() > 8);
+        for (size_t i = 1; i < written.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(written[i - 1] + 1, written[i]);
+        }
+    }
+
+    // A failed grab never reaches the encoder, doesn't leave a hole in the
+    // sequence and doesn't leak its slot
+    void testFailedCapturesAreDropped() {
+        ScreenHandler handler;
+        CPPUNIT_ASSERT(handler.initialize());
+        CPPUNIT_ASSERT(handler.getReader()->setCaptureSource(std::make_unique<FlakySource>()));
+        handler.setThreadCount(2);
+
+        std::atomic<int> encoded{0};
+        handler.setFrameEncoder([&encoded](PipelineFrame&) {
+            encoded.fetch_add(1);
+            return true;
+        });
+        std::vector<uint64_t> written;
+        handler.setFrameWriter([&written](const PipelineFrame& frame) {
+            written.push_back(frame.sequence);
+            return true;
+        });
+
+        RecordingConfig config = makeConfig();
+        config.bufferSize = 2;
+        CPPUNIT_ASSERT(handler.startCapture(config));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        CPPUNIT_ASSERT(handler.stopCapture());
+
+        CaptureStats stats = handler.getCaptureStats();
+        const int failed = stats.dropsByReason[static_cast<int>(DropReason::CAPTURE_FAILED)];
+        CPPUNIT_ASSERT(failed > 0);
+        CPPUNIT_ASSERT(written.size() > 8);
+        CPPUNIT_ASSERT_EQUAL(static_cast<int>(written.size()), encoded.load());
+        CPPUNIT_ASSERT(stats.droppedFrames >= failed);
+        for (size_t i = 0; i < written.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(i), written[i]);
+        }
+        CPPUNIT_ASSERT(handler.getMetricsText().find("reason=\"capture_failed\"") != std::string::npos);
+    }
+
+    // With a write completion, end-to-end latency runs until the writer
+    // reports the frame's bytes written, not until it returns
+    void testLatencyRunsToWriteCompletion() {
+        ScreenHandler handler;
+        CPPUNIT_ASSERT(handler.initialize());
+        std::mutex mutex;
+        std::vector<std::function<void()>> pending;
+        handler.setFrameWriter([](const PipelineFrame&) { return true; },
+                               [&mutex, &pending](std::function<void()> done) {
+                                   std::lock_guard<std::mutex> lock(mutex);
+                                   pending.push_back(std::move(done));
+                               });
+
+        CPPUNIT_ASSERT(handler.startCapture(makeConfig()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        CPPUNIT_ASSERT(handler.stopCapture());
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(0), handler.getCaptureStats().endToEndLatency.count);
+
+        // Completions may come after the pipeline stopped
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::lock_guard<std::mutex> lock(mutex);
+        CPPUNIT_ASSERT(pending.size() > 8);
+        for (auto& done : pending) {
+            done();
+        }
+        LatencySummary latency = handler.getCaptureStats().endToEndLatency;
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(pending.size()), latency.count);
+        CPPUNIT_ASSERT(latency.p50 >= 50.0f); // ms
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PipelineOrderTest);
@@ -0,0 +1,175 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/quality_controller.h"
+
+using namespace Recordify::ScreenHandler;
+
+namespace {
+
+PipelineLoad makeLoad(float captureMs, float encodeMs, int newDrops = 0) {
+    PipelineLoad load;
+    load.captureMs = captureMs;
+    load.encodeMs = encodeMs;
+    load.newDrops = newDrops;
+    return load;
+}
+
+EncoderKnobs allKnobs() {
+    EncoderKnobs knobs;
+    knobs.resolution = knobs.chroma = knobs.preset = true;
+    return knobs;
+}
+
+// Encode time of content costing `fullMs` at full size, at the controller's current scale
+float scaledEncode(const QualityController& controller, float fullMs) {
+    const float scale = controller.getLevel().resolutionScale;
+    return fullMs * scale * scale;
+}
+
+} // namespace
+
+class QualityControllerTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(QualityControllerTest);
+    CPPUNIT_TEST(testStepsDownInOrder);
+    CPPUNIT_TEST(testStepsUpWithHysteresis);
+    CPPUNIT_TEST(testStepsUpOnMeasuredCost);
+    CPPUNIT_TEST(testOnlyEnabledKnobsStep);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testStepsDownInOrder() {
+        QualityController controller;
+        controller.setEncoderKnobs(allKnobs());
+        controller.reset(30.0f);
+        CPPUNIT_ASSERT_EQUAL(8, controller.getStepCount());
+
+        // Evaluate every 250 ms with capture + encode at twice the 33 ms budget
+        auto now = std::chrono::steady_clock::now();
+        std::vector<QualityLevel> visited;
+        for (int evaluation = 0; evaluation < 60; ++evaluation) {
+            now += std::chrono::milliseconds(250);
+            if (controller.evaluate(makeLoad(6.0f, 60.0f), now) == QualityController::Decision::STEP_DOWN) {
+                visited.push_back(controller.getLevel());
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(7), visited.size());
+        CPPUNIT_ASSERT_EQUAL(0.75f, visited[0].resolutionScale);
+        CPPUNIT_ASSERT_EQUAL(0.5f, visited[1].resolutionScale);
+        CPPUNIT_ASSERT(visited[1].chroma == ChromaSubsampling::YUV444);
+        CPPUNIT_ASSERT(visited[2].chroma == ChromaSubsampling::YUV420);
+        CPPUNIT_ASSERT(visited[2].preset == EncoderPreset::QUALITY);
+        CPPUNIT_ASSERT(visited[3].preset == EncoderPreset::BALANCED);
+        CPPUNIT_ASSERT(visited[4].preset == EncoderPreset::FAST);
+        CPPUNIT_ASSERT_EQUAL(1.0f, visited[4].fpsScale);
+        CPPUNIT_ASSERT_EQUAL(0.75f, visited[5].fpsScale);
+        CPPUNIT_ASSERT_EQUAL(0.5f, visited[6].fpsScale);
+        CPPUNIT_ASSERT_EQUAL(7, controller.getLevel().step);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(66.67, controller.getFrameBudget(7), 0.01);
+    }
+
+    void testStepsUpWithHysteresis() {
+        QualityController controller;
+        controller.setEncoderKnobs(allKnobs());
+        controller.reset(30.0f);
+        auto now = std::chrono::steady_clock::now();
+        while (controller.getLevel().step < 2) {
+            now += std::chrono::milliseconds(250);
+            controller.evaluate(makeLoad(2.0f, scaledEncode(controller, 60.0f)), now);
+        }
+
+        // Fits at scale 0.5 but would not at 0.75: 2 + 15 * 0.5625 / 0.25 = 35.75 ms
+        for (int evaluation = 0; evaluation < 40; ++evaluation) {
+            now += std::chrono::milliseconds(250);
+            CPPUNIT_ASSERT(controller.evaluate(makeLoad(2.0f, scaledEncode(controller, 60.0f)), now) ==
+                           QualityController::Decision::HOLD);
+        }
+
+        // Predicted 20 ms at 0.75 fits; it takes a full streak, and a drop restarts it
+        int evaluations = 0;
+        for (int evaluation = 0; evaluation < 7; ++evaluation) {
+            now += std::chrono::milliseconds(250);
+            CPPUNIT_ASSERT(controller.evaluate(makeLoad(2.0f, 8.0f), now) == QualityController::Decision::HOLD);
+        }
+        now += std::chrono::milliseconds(250);
+        CPPUNIT_ASSERT(controller.evaluate(makeLoad(2.0f, 8.0f, 1), now) == QualityController::Decision::HOLD);
+        QualityController::Decision decision = QualityController::Decision::HOLD;
+        while (decision == QualityController::Decision::HOLD) {
+            now += std::chrono::milliseconds(250);
+            decision = controller.evaluate(makeLoad(2.0f, 8.0f), now);
+            ++evaluations;
+        }
+        CPPUNIT_ASSERT(decision == QualityController::Decision::STEP_UP);
+        CPPUNIT_ASSERT_EQUAL(8, evaluations);
+        CPPUNIT_ASSERT_EQUAL(0.75f, controller.getLevel().resolutionScale);
+
+        // Settling: no change right after the step even though load is low
+        now += std::chrono::milliseconds(250);
+        CPPUNIT_ASSERT(controller.evaluate(makeLoad(0.0f, 0.0f), now) == QualityController::Decision::HOLD);
+    }
+
+    // Presets have no modelled cost; the ratio measured on the way down decides
+    void testStepsUpOnMeasuredCost() {
+        EncoderKnobs knobs;
+        knobs.preset = true;
+        QualityController controller;
+        controller.setEncoderKnobs(knobs);
+        controller.reset(30.0f);
+        CPPUNIT_ASSERT_EQUAL(5, controller.getStepCount());
+
+        // The balanced preset halves the encode time
+        auto now = std::chrono::steady_clock::now();
+        while (controller.getLevel().step < 1) {
+            now += std::chrono::milliseconds(250);
+            controller.evaluate(makeLoad(2.0f, 60.0f), now);
+        }
+        CPPUNIT_ASSERT(controller.getLevel().preset == EncoderPreset::BALANCED);
+        now += std::chrono::milliseconds(1000);
+        CPPUNIT_ASSERT(controller.evaluate(makeLoad(2.0f, 30.0f), now) == QualityController::Decision::HOLD);
+
+        // Would fit at equal cost, not at the measured double: 2 + 2 * 14 = 30 ms
+        for (int evaluation = 0; evaluation < 20; ++evaluation) {
+            now += std::chrono::milliseconds(250);
+            CPPUNIT_ASSERT(controller.evaluate(makeLoad(2.0f, 14.0f), now) == QualityController::Decision::HOLD);
+        }
+
+        // 2 + 2 * 10 = 22 ms fits
+        int evaluations = 0;
+        QualityController::Decision decision = QualityController::Decision::HOLD;
+        while (decision == QualityController::Decision::HOLD && evaluations < 20) {
+            now += std::chrono::milliseconds(250);
+            decision = controller.evaluate(makeLoad(2.0f, 10.0f), now);
+            ++evaluations;
+        }
+        CPPUNIT_ASSERT(decision == QualityController::Decision::STEP_UP);
+        CPPUNIT_ASSERT_EQUAL(8, evaluations);
+    }
+
+    void testOnlyEnabledKnobsStep() {
+        // Without encoder knobs only the frame rate steps
+        QualityController unsupported;
+        unsupported.reset(30.0f);
+        CPPUNIT_ASSERT_EQUAL(3, unsupported.getStepCount());
+
+        AdaptiveQualityOptions options;
+        options.scaleResolution = false;
+        options.subsampleChroma = false;
+        options.lowerPreset = false;
+        QualityController controller(options);
+        controller.setEncoderKnobs(allKnobs());
+        controller.reset(60.0f);
+        CPPUNIT_ASSERT_EQUAL(3, controller.getStepCount());
+
+        // Drops count as overload even when the timings fit
+        auto now = std::chrono::steady_clock::now();
+        controller.evaluate(makeLoad(1.0f, 1.0f, 3), now);
+        CPPUNIT_ASSERT(controller.evaluate(makeLoad(1.0f, 1.0f, 3), now + std::chrono::milliseconds(250)) ==
+                       QualityController::Decision::STEP_DOWN);
+        CPPUNIT_ASSERT_EQUAL(0.75f, controller.getLevel().fpsScale);
+        CPPUNIT_ASSERT_EQUAL(1.0f, controller.getLevel().resolutionScale);
+        CPPUNIT_ASSERT_EQUAL(std::string("scale 1, 4:4:4, quality preset, 45 fps"),
+                             controller.getLevel().describe(60.0f));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(QualityControllerTest);
@@ -0,0 +1,137 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/rasterizer.h"
+#include "screen_handler/screen_writer.h"
+#include <random>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Point;
+using Recordify::Utils::Rectangle;
+using Recordify::Utils::Size;
+
+class RasterizerTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(RasterizerTest);
+    CPPUNIT_TEST(testSimdBlendMatchesScalar);
+    CPPUNIT_TEST(testFillCoverageIsExact);
+    CPPUNIT_TEST(testDashedStrokeLeavesGaps);
+    CPPUNIT_TEST(testClipLimitsFill);
+    CPPUNIT_TEST(testGoldenScene);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testSimdBlendMatchesScalar() {
+        std::mt19937 rng(7);
+        std::vector<uint8_t> coverage(67);
+        std::vector<uint8_t> simd(67 * 4);
+        for (int round = 0; round < 50; ++round) {
+            for (auto& value : coverage) value = static_cast<uint8_t>(rng() % 4 == 0 ? 255 : rng());
+            for (int i = 0; i < 67; ++i) {
+                PremultipliedColor dst = PremultipliedColor::fromStraight(rng(), rng(), rng(), rng());
+                simd[i * 4] = dst.r; simd[i * 4 + 1] = dst.g; simd[i * 4 + 2] = dst.b; simd[i * 4 + 3] = dst.a;
+            }
+            std::vector<uint8_t> scalar(simd);
+            PremultipliedColor color = PremultipliedColor::fromStraight(rng(), rng(), rng(),
+                                                                        round % 2 ? 255 : rng());
+
+            Rasterizer::blendSpan(simd.data(), coverage.data(), 67, color, true);
+            Rasterizer::blendSpan(scalar.data(), coverage.data(), 67, color, false);
+            CPPUNIT_ASSERT(simd == scalar);
+        }
+    }
+
+    void testFillCoverageIsExact() {
+        RasterSurface surface(10, 10);
+        Rasterizer rasterizer(surface);
+        RasterPath path;
+        path.addRect(2.5f, 2.0f, 4.0f, 3.0f);
+        Rectangle touched = rasterizer.fill(path, PremultipliedColor::fromStraight(255, 255, 255, 255));
+
+        CPPUNIT_ASSERT(touched == Rectangle(2, 2, 5, 3));
+        CPPUNIT_ASSERT_EQUAL(128, static_cast<int>(surface.pixel(2, 2).a));
+        CPPUNIT_ASSERT_EQUAL(255, static_cast<int>(surface.pixel(3, 3).a));
+        CPPUNIT_ASSERT_EQUAL(128, static_cast<int>(surface.pixel(6, 4).a));
+        CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(surface.pixel(7, 2).a));
+        CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(surface.pixel(3, 5).a));
+    }
+
+    void testDashedStrokeLeavesGaps() {
+        RasterSurface surface(32, 8);
+        Rasterizer rasterizer(surface);
+        RasterPath path;
+        path.moveTo(0.0f, 4.0f);
+        path.lineTo(32.0f, 4.0f);
+
+        StrokeStyle style;
+        style.width = 2.0f;
+        style.dashPattern = {4.0f, 4.0f};
+        rasterizer.stroke(path, style, PremultipliedColor::fromStraight(255, 0, 0, 255));
+
+        for (int x = 0; x < 32; ++x) {
+            bool on = (x / 4) % 2 == 0;
+            CPPUNIT_ASSERT_EQUAL(on ? 255 : 0, static_cast<int>(surface.pixel(x, 3).a));
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(surface.pixel(x, 5).a));
+        }
+    }
+
+    void testClipLimitsFill() {
+        RasterSurface surface(16, 16);
+        Rasterizer rasterizer(surface);
+        rasterizer.setClip(Rectangle(4, 4, 4, 4));
+        RasterPath path;
+        path.addEllipse(8.0f, 8.0f, 20.0f, 20.0f);
+        Rectangle touched = rasterizer.fill(path, PremultipliedColor::fromStraight(0, 0, 255, 255));
+
+        CPPUNIT_ASSERT(touched == Rectangle(4, 4, 4, 4));
+        CPPUNIT_ASSERT_EQUAL(255, static_cast<int>(surface.pixel(4, 4).a));
+        CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(surface.pixel(3, 4).a));
+        CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(surface.pixel(8, 8).a));
+    }
+
+    // Renders a fixed scene through ScreenWriter and compares the result with
+    // a known-good hash. Update GOLDEN_HASH only after checking the output by eye.
+    void testGoldenScene() {
+        const uint64_t GOLDEN_HASH = 0x5737e548f2dd0b23ull;
+
+        ScreenWriter writer;
+        CPPUNIT_ASSERT(writer.initialize());
+        CPPUNIT_ASSERT(writer.createCanvas(Size(96, 64)));
+        writer.clearCanvas(Color(30, 30, 30));
+
+        ShapeProperties box;
+        box.fillColor = Color(40, 120, 220);
+        box.strokeColor = Color::WHITE;
+        box.strokeWidth = 2.0f;
+        box.cornerRadius = 6.0f;
+        CPPUNIT_ASSERT(writer.drawRectangle(Rectangle(4, 4, 40, 24), box));
+
+        ShapeProperties ring;
+        ring.filled = false;
+        ring.strokeColor = Color(255, 200, 0);
+        ring.strokeWidth = 3.0f;
+        ring.dashPattern = {6.0f, 3.0f};
+        CPPUNIT_ASSERT(writer.drawCircle(Point(70, 18), 13.0f, ring));
+
+        ShapeProperties pen;
+        pen.strokeColor = Color(255, 60, 60, 200);
+        pen.strokeWidth = 2.5f;
+        CPPUNIT_ASSERT(writer.drawArrow(Point(6, 58), Point(50, 36), 8.0f, pen));
+        CPPUNIT_ASSERT(writer.drawPolygon({Point(60, 60), Point(90, 40), Point(92, 62)}, box));
+
+        TextProperties text;
+        text.color = Color::WHITE;
+        text.font.size = 8.0f;
+        CPPUNIT_ASSERT(writer.drawText("Rec 1", Point(8, 12), text));
+
+        RasterSurface canvas = writer.getCanvas();
+        CPPUNIT_ASSERT_EQUAL(GOLDEN_HASH, canvas.hash());
+
+        // The canvas is a copy, so later drawing leaves it alone
+        CPPUNIT_ASSERT(writer.drawCircle(Point(20, 40), 10.0f, box));
+        CPPUNIT_ASSERT_EQUAL(GOLDEN_HASH, canvas.hash());
+        CPPUNIT_ASSERT(writer.getCanvas().hash() != GOLDEN_HASH);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RasterizerTest);
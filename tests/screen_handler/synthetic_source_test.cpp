@@ -0,0 +1,116 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/synthetic_source.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace Recordify::ScreenHandler;
+using Recordify::Utils::Point;
+using Recordify::Utils::Rectangle;
+
+namespace {
+
+const int WIDTH = 320;
+const int HEIGHT = 240;
+
+SyntheticConfig makeConfig(SyntheticWorkload workload, float changedFraction, uint32_t seed = 7) {
+    SyntheticConfig config;
+    config.workload = workload;
+    config.width = WIDTH;
+    config.height = HEIGHT;
+    config.seed = seed;
+    config.changedFraction = changedFraction;
+    config.period = 1;
+    return config;
+}
+
+std::vector<uint8_t> grabFrame(SyntheticSource& source) {
+    std::vector<uint8_t> frame(static_cast<size_t>(WIDTH) * HEIGHT * 4);
+    CPPUNIT_ASSERT(source.grab(source.bounds(), frame.data(), static_cast<size_t>(WIDTH) * 4));
+    return frame;
+}
+
+} // namespace
+
+class SyntheticSourceTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(SyntheticSourceTest);
+    CPPUNIT_TEST(testSameSeedSameFrames);
+    CPPUNIT_TEST(testChangedPixelsMatchFraction);
+    CPPUNIT_TEST(testPointerDragsWindow);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testSameSeedSameFrames() {
+        SyntheticSource first(makeConfig(SyntheticWorkload::SCROLLING_TERMINAL, 0.5f));
+        SyntheticSource second(makeConfig(SyntheticWorkload::SCROLLING_TERMINAL, 0.5f));
+        SyntheticSource other(makeConfig(SyntheticWorkload::SCROLLING_TERMINAL, 0.5f, 8));
+        CPPUNIT_ASSERT(first.open() && second.open() && other.open());
+        for (int frame = 0; frame < 5; ++frame) {
+            std::vector<uint8_t> pixels = grabFrame(first);
+            CPPUNIT_ASSERT(pixels == grabFrame(second));
+            CPPUNIT_ASSERT(pixels != grabFrame(other));
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(4), first.getFrameIndex());
+
+        // Reopening restarts the script
+        std::vector<uint8_t> start = grabFrame(second);
+        first.close();
+        CPPUNIT_ASSERT(first.open());
+        second.close();
+        CPPUNIT_ASSERT(second.open());
+        CPPUNIT_ASSERT(grabFrame(first) == grabFrame(second));
+        CPPUNIT_ASSERT(grabFrame(first) != start);
+    }
+
+    // The reported change is exact and close to the requested fraction
+    void testChangedPixelsMatchFraction() {
+        for (SyntheticWorkload workload : {SyntheticWorkload::STATIC_DESKTOP, SyntheticWorkload::SCROLLING_TERMINAL,
+                                           SyntheticWorkload::VIDEO_REGION, SyntheticWorkload::MOVING_WINDOW,
+                                           SyntheticWorkload::BLINKING_CURSOR}) {
+            SyntheticSource source(makeConfig(workload, 0.2f));
+            CPPUNIT_ASSERT(source.open());
+            std::vector<uint8_t> previous = grabFrame(source);
+            CPPUNIT_ASSERT_EQUAL(1.0f, source.getChangedFraction());
+
+            // Long enough for the window to bounce off both edges
+            for (int frame = 1; frame < 40; ++frame) {
+                std::vector<uint8_t> current = grabFrame(source);
+                const Rectangle area = source.getChangedArea();
+                int changed = 0;
+                for (int y = 0; y < HEIGHT; ++y) {
+                    for (int x = 0; x < WIDTH; ++x) {
+                        const size_t offset = (static_cast<size_t>(y) * WIDTH + x) * 4;
+                        if (std::memcmp(&current[offset], &previous[offset], 4) != 0) {
+                            CPPUNIT_ASSERT(area.contains(Point(x, y)));
+                            ++changed;
+                        }
+                    }
+                }
+                const float fraction = static_cast<float>(changed) / (WIDTH * HEIGHT);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(fraction, source.getChangedFraction(), 1e-6);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(0.2, fraction, 0.01);
+                previous.swap(current);
+            }
+        }
+    }
+
+    void testPointerDragsWindow() {
+        SyntheticSource source(makeConfig(SyntheticWorkload::MOVING_WINDOW, 0.2f));
+        Point position;
+        CPPUNIT_ASSERT(!source.pointer(position));
+        CPPUNIT_ASSERT(source.open());
+
+        grabFrame(source);
+        CPPUNIT_ASSERT(source.pointer(position));
+        Point before = position;
+        grabFrame(source);
+        CPPUNIT_ASSERT(source.pointer(position));
+        CPPUNIT_ASSERT(position.x > before.x);
+        CPPUNIT_ASSERT_EQUAL(before.y, position.y);
+        CPPUNIT_ASSERT(source.getChangedArea().contains(position));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SyntheticSourceTest);
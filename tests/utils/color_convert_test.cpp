@@ -0,0 +1,127 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/color_convert.h"
+#include <random>
+#include <vector>
+
+using namespace Recordify::Utils::ColorConvert;
+
+namespace {
+
+struct Planes {
+    std::vector<uint8_t> y, u, v;
+};
+
+// Padded strides so a kernel reading or writing past a row shows up as a mismatch
+Planes convert(const std::vector<uint8_t>& pixels, int width, int height, size_t stride, PixelFormat format,
+               bool nv12, const ConvertOptions& options) {
+    const size_t yStride = width + 5, chromaStride = chromaWidth(width) * 2 + 3;
+    Planes planes;
+    planes.y.assign(yStride * height, 0xAB);
+    planes.u.assign(chromaStride * chromaHeight(height), 0xCD);
+    if (nv12) {
+        CPPUNIT_ASSERT(convertToNV12(pixels.data(), width, height, stride, format,
+                                     planes.y.data(), yStride, planes.u.data(), chromaStride, options));
+    } else {
+        planes.v.assign(planes.u.size(), 0xEF);
+        CPPUNIT_ASSERT(convertToI420(pixels.data(), width, height, stride, format, planes.y.data(), yStride,
+                                     planes.u.data(), chromaStride, planes.v.data(), chromaStride, options));
+    }
+    return planes;
+}
+
+} // namespace
+
+class ColorConvertTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ColorConvertTest);
+    CPPUNIT_TEST(testKnownColors);
+    CPPUNIT_TEST(testSimdMatchesScalar);
+    CPPUNIT_TEST(testThreadedMatchesSingle);
+    CPPUNIT_TEST(testRejectsBadArguments);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override {
+        setActiveIsa(detectIsa());
+    }
+
+    void testKnownColors() {
+        // White then black, BGRA, 2x2 each
+        std::vector<uint8_t> pixels = {255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255, 0, 0, 0, 255,
+                                       255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255, 0, 0, 0, 255};
+        ConvertOptions options;
+        Planes limited = convert(pixels, 4, 2, 16, PixelFormat::BGRA32, false, options);
+        CPPUNIT_ASSERT_EQUAL(235, static_cast<int>(limited.y[0]));
+        CPPUNIT_ASSERT_EQUAL(16, static_cast<int>(limited.y[3]));
+        CPPUNIT_ASSERT_EQUAL(128, static_cast<int>(limited.u[0]));
+        CPPUNIT_ASSERT_EQUAL(128, static_cast<int>(limited.v[1]));
+
+        // Pure red, full-range BT.601 matches JPEG: 76, 85, 255
+        std::vector<uint8_t> red = {255, 0, 0, 255, 255, 0, 0, 255, 255, 0, 0, 255, 255, 0, 0, 255};
+        options.range = Range::FULL;
+        Planes full = convert(red, 2, 2, 8, PixelFormat::RGBA32, false, options);
+        CPPUNIT_ASSERT_EQUAL(76, static_cast<int>(full.y[0]));
+        CPPUNIT_ASSERT_EQUAL(85, static_cast<int>(full.u[0]));
+        CPPUNIT_ASSERT_EQUAL(255, static_cast<int>(full.v[0]));
+    }
+
+    void testSimdMatchesScalar() {
+        // Odd sizes leave a scalar tail and a repeated last row/column
+        std::mt19937 rng(11);
+        const int width = 77, height = 9;
+        for (PixelFormat format : {PixelFormat::BGR24, PixelFormat::BGRA32, PixelFormat::RGBA32}) {
+            const size_t stride = width * bytesPerPixel(format) + 7;
+            std::vector<uint8_t> pixels(stride * height);
+            for (uint8_t& value : pixels) {
+                value = static_cast<uint8_t>(rng());
+            }
+            for (Matrix matrix : {Matrix::BT601, Matrix::BT709}) {
+                for (Range range : {Range::LIMITED, Range::FULL}) {
+                    for (bool nv12 : {false, true}) {
+                        ConvertOptions options;
+                        options.matrix = matrix;
+                        options.range = range;
+                        setActiveIsa(Isa::SCALAR);
+                        Planes expected = convert(pixels, width, height, stride, format, nv12, options);
+                        for (Isa isa : {Isa::SSSE3, Isa::AVX2}) {
+                            setActiveIsa(isa);
+                            Planes actual = convert(pixels, width, height, stride, format, nv12, options);
+                            CPPUNIT_ASSERT(expected.y == actual.y);
+                            CPPUNIT_ASSERT(expected.u == actual.u);
+                            CPPUNIT_ASSERT(expected.v == actual.v);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void testThreadedMatchesSingle() {
+        const int width = 130, height = 301;
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            pixels[i] = static_cast<uint8_t>(i * 13 + i / 7);
+        }
+        ConvertOptions options;
+        options.matrix = Matrix::BT709;
+        Planes expected = convert(pixels, width, height, width * 3, PixelFormat::BGR24, false, options);
+        options.threadCount = 4;
+        Planes actual = convert(pixels, width, height, width * 3, PixelFormat::BGR24, false, options);
+        CPPUNIT_ASSERT(expected.y == actual.y);
+        CPPUNIT_ASSERT(expected.u == actual.u);
+        CPPUNIT_ASSERT(expected.v == actual.v);
+    }
+
+    void testRejectsBadArguments() {
+        std::vector<uint8_t> pixels(64 * 4), y(64), uv(64);
+        // Stride shorter than a row
+        CPPUNIT_ASSERT(!convertToNV12(pixels.data(), 8, 8, 16, PixelFormat::BGRA32, y.data(), 8, uv.data(), 8));
+        // NV12 needs two bytes per chroma sample
+        CPPUNIT_ASSERT(!convertToNV12(pixels.data(), 8, 2, 32, PixelFormat::BGRA32, y.data(), 8, uv.data(), 4));
+        CPPUNIT_ASSERT(!convertToI420(nullptr, 8, 2, 32, PixelFormat::BGRA32, y.data(), 8, uv.data(), 4,
+                                      uv.data() + 32, 4));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ColorConvertTest);
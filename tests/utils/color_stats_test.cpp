@@ -0,0 +1,158 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/color_stats.h"
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Recordify::Utils;
+
+namespace {
+
+// BGRA frame: left half pure red, right half gray 100
+std::vector<uint8_t> makeFrame(int width, int height) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            const bool red = x < width / 2;
+            pixel[0] = red ? 0 : 100;
+            pixel[1] = red ? 0 : 100;
+            pixel[2] = red ? 255 : 100;
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+} // namespace
+
+class ColorStatsTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ColorStatsTest);
+    CPPUNIT_TEST(testKnownHistogramAndMeans);
+    CPPUNIT_TEST(testBandsMatchSingleThread);
+    CPPUNIT_TEST(testConcurrentCallers);
+    CPPUNIT_TEST(testSimdMatchesScalar);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override {
+        ColorStatsKernels::setActiveIsa(ColorStatsKernels::detectIsa());
+    }
+
+    void testKnownHistogramAndMeans() {
+        std::vector<uint8_t> frame = makeFrame(8, 4);
+        ColorStatsResult stats = computeColorStats(frame.data(), 8, 4, 32, 4);
+
+        // BT.601 luma: red (77 * 255 + 128) >> 8 = 77, gray 100
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(32), stats.sampleCount);
+        CPPUNIT_ASSERT_EQUAL(16u, stats.luminanceHistogram[77]);
+        CPPUNIT_ASSERT_EQUAL(16u, stats.luminanceHistogram[100]);
+        uint32_t histogramTotal = 0;
+        for (uint32_t count : stats.luminanceHistogram) {
+            histogramTotal += count;
+        }
+        CPPUNIT_ASSERT_EQUAL(32u, histogramTotal);
+
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(177.5, stats.meanRed, 1e-4);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(50.0, stats.meanGreen, 1e-4);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(50.0, stats.meanBlue, 1e-4);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(88.5, stats.meanLuminance, 1e-4);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(11.5, stats.luminanceStdDev, 1e-4);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, stats.meanSaturation, 1e-4);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), stats.palette.size());
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, stats.palette[0].share, 1e-6);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, stats.palette[1].share, 1e-6);
+
+        // Every other row and column
+        ColorStatsOptions options;
+        options.rowStep = 2;
+        options.columnStep = 2;
+        stats = computeColorStats(frame.data(), 8, 4, 32, 4, options);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(8), stats.sampleCount);
+        CPPUNIT_ASSERT_EQUAL(4u, stats.luminanceHistogram[77]);
+    }
+
+    // Workers are reused from call to call and must start each one clean
+    void testBandsMatchSingleThread() {
+        std::vector<uint8_t> frame = makeFrame(64, 48);
+        ColorStatsResult single = computeColorStats(frame.data(), 64, 48, 256, 4);
+        ColorStatsOptions options;
+        options.threadCount = 4;
+        for (int call = 0; call < 3; ++call) {
+            ColorStatsResult banded = computeColorStats(frame.data(), 64, 48, 256, 4, options);
+            CPPUNIT_ASSERT_EQUAL(single.sampleCount, banded.sampleCount);
+            CPPUNIT_ASSERT(single.luminanceHistogram == banded.luminanceHistogram);
+            CPPUNIT_ASSERT_EQUAL(single.meanRed, banded.meanRed);
+            CPPUNIT_ASSERT_EQUAL(single.palette.size(), banded.palette.size());
+        }
+    }
+
+    void testConcurrentCallers() {
+        std::vector<uint8_t> frame = makeFrame(64, 48);
+        ColorStatsOptions options;
+        options.threadCount = 3;
+        std::vector<std::thread> callers;
+        std::vector<uint64_t> samples(4, 0);
+        for (size_t caller = 0; caller < samples.size(); ++caller) {
+            callers.emplace_back([&, caller]() {
+                for (int call = 0; call < 50; ++call) {
+                    ColorStatsResult stats = computeColorStats(frame.data(), 64, 48, 256, 4, options);
+                    samples[caller] += stats.luminanceHistogram[77];
+                }
+            });
+        }
+        for (auto& caller : callers) {
+            caller.join();
+        }
+        for (uint64_t count : samples) {
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(50 * 32 * 48), count);
+        }
+    }
+
+    // Sums are exact integers, so every kernel must give identical results
+    void testSimdMatchesScalar() {
+        using ColorStatsKernels::Isa;
+        // Odd width so the kernels exercise their tail path. Noise with short
+        // runs of repeats goes to the kernels, the flat right edge is folded.
+        const int width = 301;
+        const int height = 7;
+        std::mt19937 rng(11);
+        std::vector<uint8_t> frame(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < frame.size(); ++i) {
+            const bool flat = (i / 4) % width >= 200;
+            frame[i] = !flat && rng() % 3 == 0 ? static_cast<uint8_t>(rng()) : (i >= 4 ? frame[i - 4] : 0);
+        }
+
+        for (int bytesPerPixel : {3, 4}) {
+            for (int step : {1, 2}) {
+                ColorStatsOptions options;
+                options.rowStep = step;
+                options.columnStep = step;
+                const size_t stride = static_cast<size_t>(width) * 4;
+                ColorStatsKernels::setActiveIsa(Isa::SCALAR);
+                ColorStatsResult expected = computeColorStats(frame.data(), width * 4 / bytesPerPixel, height,
+                                                              stride, bytesPerPixel, options);
+
+                for (Isa isa : {Isa::SSE2, Isa::AVX2}) {
+                    ColorStatsKernels::setActiveIsa(isa);
+                    ColorStatsResult actual = computeColorStats(frame.data(), width * 4 / bytesPerPixel, height,
+                                                                stride, bytesPerPixel, options);
+                    CPPUNIT_ASSERT_EQUAL(expected.sampleCount, actual.sampleCount);
+                    CPPUNIT_ASSERT_EQUAL(expected.meanRed, actual.meanRed);
+                    CPPUNIT_ASSERT_EQUAL(expected.meanGreen, actual.meanGreen);
+                    CPPUNIT_ASSERT_EQUAL(expected.meanBlue, actual.meanBlue);
+                    CPPUNIT_ASSERT_EQUAL(expected.meanLuminance, actual.meanLuminance);
+                    CPPUNIT_ASSERT_EQUAL(expected.luminanceStdDev, actual.luminanceStdDev);
+                    CPPUNIT_ASSERT_EQUAL(expected.meanSaturation, actual.meanSaturation);
+                    CPPUNIT_ASSERT(expected.luminanceHistogram == actual.luminanceHistogram);
+                    CPPUNIT_ASSERT_EQUAL(expected.palette.size(), actual.palette.size());
+                }
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ColorStatsTest);
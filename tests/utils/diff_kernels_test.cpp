@@ -0,0 +1,121 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/diff_kernels.h"
+#include <random>
+#include <vector>
+
+using namespace Recordify::Utils::DiffKernels;
+
+class DiffKernelsTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(DiffKernelsTest);
+    CPPUNIT_TEST(testIdenticalBuffers);
+    CPPUNIT_TEST(testThresholdIsExclusive);
+    CPPUNIT_TEST(testChangedPixelsAreWhole);
+    CPPUNIT_TEST(testSimdMatchesScalar);
+    CPPUNIT_TEST(testTilesCoverPartialEdges);
+    CPPUNIT_TEST(testRowsWithDifferentStrides);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override {
+        setActiveIsa(detectIsa());
+    }
+
+    void testIdenticalBuffers() {
+        std::vector<uint8_t> frame(1000, 77);
+        DiffResult result = diffBuffers(frame.data(), frame.data(), frame.size(), 0);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(0), result.changedBytes);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(0), result.sad);
+        CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(result.maxDelta));
+    }
+
+    void testThresholdIsExclusive() {
+        std::vector<uint8_t> previous(100, 100);
+        std::vector<uint8_t> current(100, 100);
+        current[3] = 110;  // delta 10: not above threshold
+        current[50] = 89;  // delta 11
+        current[99] = 255; // delta 155, scalar tail
+
+        DiffResult result = diffBuffers(current.data(), previous.data(), current.size(), 10);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(2), result.changedBytes);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(176), result.sad);
+        CPPUNIT_ASSERT_EQUAL(155, static_cast<int>(result.maxDelta));
+    }
+
+    // A pixel with all its channels changed is one changed pixel, not four
+    void testChangedPixelsAreWhole() {
+        std::vector<uint8_t> previous(64 * 4, 0);
+        std::vector<uint8_t> current = previous;
+        current[0] = current[1] = current[2] = 200; // pixel 0, three channels
+        current[4 * 9 + 3] = 200;                   // pixel 9, alpha only
+        current[4 * 63 + 1] = 200;                  // last pixel, in the SIMD body
+
+        for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2}) {
+            setActiveIsa(isa);
+            DiffResult result = diffBuffers(current.data(), previous.data(), current.size(), 10);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(5), result.changedBytes);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(3), result.changedPixels);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0 / 64, result.changeRatio(64, 4), 1e-6);
+        }
+        DiffResult packed;
+        packed.changedBytes = 6;
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0 / (64 * 3), packed.changeRatio(64, 3), 1e-6);
+    }
+
+    void testSimdMatchesScalar() {
+        // Odd length so every kernel exercises its tail path
+        std::mt19937 rng(7);
+        std::vector<uint8_t> previous(4099);
+        std::vector<uint8_t> current(previous.size());
+        for (size_t i = 0; i < previous.size(); ++i) {
+            previous[i] = static_cast<uint8_t>(rng());
+            current[i] = (rng() % 4 == 0) ? static_cast<uint8_t>(rng()) : previous[i];
+        }
+
+        setActiveIsa(Isa::SCALAR);
+        DiffResult expected = diffBuffers(current.data(), previous.data(), current.size(), 10);
+
+        for (Isa isa : {Isa::SSE2, Isa::AVX2}) {
+            setActiveIsa(isa);
+            DiffResult actual = diffBuffers(current.data(), previous.data(), current.size(), 10);
+            CPPUNIT_ASSERT_EQUAL(expected.changedBytes, actual.changedBytes);
+            CPPUNIT_ASSERT_EQUAL(expected.changedPixels, actual.changedPixels);
+            CPPUNIT_ASSERT_EQUAL(expected.sad, actual.sad);
+            CPPUNIT_ASSERT_EQUAL(expected.maxDelta, actual.maxDelta);
+        }
+    }
+
+    void testTilesCoverPartialEdges() {
+        const int width = 100, height = 70, bytesPerPixel = 4;
+        std::vector<uint8_t> previous(static_cast<size_t>(width) * height * bytesPerPixel, 0);
+        std::vector<uint8_t> current = previous;
+        current[((69 * width) + 99) * bytesPerPixel] = 200; // bottom-right pixel
+
+        FrameDiff diff;
+        diffFrames(current.data(), previous.data(), width, height,
+                   static_cast<size_t>(width) * bytesPerPixel, bytesPerPixel, 64, 10, diff);
+
+        CPPUNIT_ASSERT_EQUAL(2, diff.tileColumns);
+        CPPUNIT_ASSERT_EQUAL(2, diff.tileRows);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), diff.tile(1, 1).changedBytes);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(0), diff.tile(0, 0).changedBytes);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), diff.total.changedBytes);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), diff.total.changedPixels);
+    }
+
+    void testRowsWithDifferentStrides() {
+        // A 10x4 crop out of a 32-byte-wide frame against a packed copy of it
+        std::vector<uint8_t> frame(32 * 6, 50);
+        std::vector<uint8_t> packed(10 * 4, 50);
+        frame[32 * 3 + 5 + 9] = 90;   // last byte of the crop's bottom row
+        frame[32 * 3 + 5 + 10] = 255; // just outside the crop
+        frame[32 * 4 + 5] = 255;      // row below the crop
+
+        DiffResult result = diffRows(frame.data() + 5, 32, packed.data(), 10, 10, 4, 10);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), result.changedBytes);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(40), result.sad);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DiffKernelsTest);
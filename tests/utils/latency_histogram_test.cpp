@@ -0,0 +1,149 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/latency_histogram.h"
+#include "utils/metrics_exporter.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using Recordify::Utils::LatencyHistogram;
+using Recordify::Utils::MetricsExporter;
+using Recordify::Utils::PrometheusText;
+
+class LatencyHistogramTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(LatencyHistogramTest);
+    CPPUNIT_TEST(testPercentilesWithinBucketPrecision);
+    CPPUNIT_TEST(testSnapshotsWhileRecording);
+    CPPUNIT_TEST(testPrometheusHistogram);
+    CPPUNIT_TEST(testExportTargets);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testPercentilesWithinBucketPrecision() {
+        LatencyHistogram histogram;
+        for (uint64_t microseconds = 1; microseconds <= 10000; ++microseconds) {
+            histogram.record(microseconds * 1000);
+        }
+
+        LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(10000), snapshot.count);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1000), snapshot.min);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(10000000), snapshot.max);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(5000500.0, snapshot.mean(), 1e-6);
+        for (double percent : {50.0, 90.0, 99.0, 99.9}) {
+            const double exact = percent * 100000.0;
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(exact, static_cast<double>(snapshot.percentile(percent)), exact / 32);
+        }
+        CPPUNIT_ASSERT_EQUAL(snapshot.max, snapshot.percentile(100.0));
+
+        // Every value maps into a bucket whose range covers it
+        const std::vector<uint64_t> values = {0, 63, 64, 65, 1000, 123456789, LatencyHistogram::MAX_VALUE};
+        for (uint64_t value : values) {
+            const size_t index = LatencyHistogram::bucketIndex(value);
+            CPPUNIT_ASSERT(index < LatencyHistogram::BUCKET_COUNT);
+            CPPUNIT_ASSERT(LatencyHistogram::bucketLowest(index) <= value);
+            CPPUNIT_ASSERT(LatencyHistogram::bucketHighest(index) >= value);
+        }
+
+        histogram.reset();
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(0), histogram.snapshot().count);
+    }
+
+    // Snapshots taken mid-flight never see half a record
+    void testSnapshotsWhileRecording() {
+        LatencyHistogram histogram;
+        std::atomic<bool> done{false};
+        std::vector<std::thread> writers;
+        for (int thread = 0; thread < 3; ++thread) {
+            writers.emplace_back([&histogram]() {
+                for (int i = 0; i < 20000; ++i) {
+                    histogram.record(static_cast<uint64_t>(1000));
+                }
+            });
+        }
+        std::thread reader([&]() {
+            while (!done.load()) {
+                LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+                uint64_t buckets = 0;
+                for (uint64_t count : snapshot.counts) {
+                    buckets += count;
+                }
+                CPPUNIT_ASSERT_EQUAL(snapshot.count, buckets);
+                CPPUNIT_ASSERT_EQUAL(snapshot.count * 1000, snapshot.sum);
+            }
+        });
+
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        done = true;
+        reader.join();
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(60000), histogram.snapshot().count);
+    }
+
+    void testPrometheusHistogram() {
+        LatencyHistogram histogram;
+        histogram.record(static_cast<uint64_t>(500000));   // 0.5 ms
+        histogram.record(static_cast<uint64_t>(3000000));  // 3 ms
+        histogram.record(static_cast<uint64_t>(40000000)); // 40 ms
+
+        PrometheusText text;
+        text.family("test_latency_seconds", "histogram", "Test latencies");
+        text.histogram("test_latency_seconds", "stage=\"encode\"", histogram.snapshot(), {0.001, 0.01});
+        const std::string expected = "# HELP test_latency_seconds Test latencies\n"
+                                     "# TYPE test_latency_seconds histogram\n"
+                                     "test_latency_seconds_bucket{stage=\"encode\",le=\"0.001\"} 1\n"
+                                     "test_latency_seconds_bucket{stage=\"encode\",le=\"0.01\"} 2\n"
+                                     "test_latency_seconds_bucket{stage=\"encode\",le=\"+Inf\"} 3\n"
+                                     "test_latency_seconds_sum{stage=\"encode\"} 0.0435\n"
+                                     "test_latency_seconds_count{stage=\"encode\"} 3\n";
+        CPPUNIT_ASSERT_EQUAL(expected, text.str());
+    }
+
+    void testExportTargets() {
+        const std::string path = "latency_histogram_test.prom";
+        MetricsExporter exporter;
+        CPPUNIT_ASSERT(exporter.startFile(path, std::chrono::milliseconds(10), []() { return std::string("up 1\n"); }));
+        std::ifstream file(path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        CPPUNIT_ASSERT_EQUAL(std::string("up 1\n"), contents.str());
+        exporter.stop();
+        CPPUNIT_ASSERT(!exporter.isRunning());
+        std::remove(path.c_str());
+
+#ifndef _WIN32
+        const std::string socketPath = "latency_histogram_test.sock";
+        CPPUNIT_ASSERT(exporter.startSocket(socketPath, []() { return std::string("up 2\n"); }));
+        for (int scrape = 0; scrape < 2; ++scrape) {
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", socketPath.c_str());
+            CPPUNIT_ASSERT(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+            std::string received;
+            char buffer[64];
+            ssize_t length;
+            while ((length = ::read(fd, buffer, sizeof(buffer))) > 0) {
+                received.append(buffer, static_cast<size_t>(length));
+            }
+            ::close(fd);
+            CPPUNIT_ASSERT_EQUAL(std::string("up 2\n"), received);
+        }
+        exporter.stop();
+        CPPUNIT_ASSERT(::access(socketPath.c_str(), F_OK) != 0);
+#endif
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LatencyHistogramTest);
@@ -0,0 +1,140 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/lockfree_queue.h"
+#include <thread>
+#include <vector>
+
+using namespace Recordify::Utils;
+
+class LockfreeQueueTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(LockfreeQueueTest);
+    CPPUNIT_TEST(testCapacityRoundsUp);
+    CPPUNIT_TEST(testSpscFifoFullAndEmpty);
+    CPPUNIT_TEST(testSpscAcrossThreads);
+    CPPUNIT_TEST(testMpscFifoFullAndEmpty);
+    CPPUNIT_TEST(testMpscKeepsPerProducerOrder);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testCapacityRoundsUp() {
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), SpscQueue<int>(0).capacity());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), SpscQueue<int>(1).capacity());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(8), SpscQueue<int>(5).capacity());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(16), MpscQueue<int>(16).capacity());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(32), MpscQueue<int>(17).capacity());
+    }
+
+    void testSpscFifoFullAndEmpty() {
+        SpscQueue<int> queue(4);
+        int value = -1;
+        CPPUNIT_ASSERT(queue.empty());
+        CPPUNIT_ASSERT(!queue.tryPop(value));
+
+        // Wrap the indices around the ring a few times
+        int next = 0;
+        int expected = 0;
+        for (int round = 0; round < 3; ++round) {
+            while (queue.tryPush(next)) {
+                ++next;
+            }
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), queue.size());
+            for (int i = 0; i < 3; ++i) {
+                CPPUNIT_ASSERT(queue.tryPop(value));
+                CPPUNIT_ASSERT_EQUAL(expected++, value);
+            }
+        }
+        while (queue.tryPop(value)) {
+            CPPUNIT_ASSERT_EQUAL(expected++, value);
+        }
+        CPPUNIT_ASSERT_EQUAL(next, expected);
+        CPPUNIT_ASSERT(queue.empty());
+    }
+
+    void testSpscAcrossThreads() {
+        const int count = 200000;
+        SpscQueue<int> queue(64);
+        std::thread producer([&queue, count]() {
+            for (int i = 0; i < count; ++i) {
+                while (!queue.tryPush(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        int expected = 0;
+        while (expected < count) {
+            int value;
+            if (!queue.tryPop(value)) {
+                std::this_thread::yield();
+                continue;
+            }
+            CPPUNIT_ASSERT_EQUAL(expected, value);
+            ++expected;
+        }
+        producer.join();
+        CPPUNIT_ASSERT(queue.empty());
+    }
+
+    void testMpscFifoFullAndEmpty() {
+        MpscQueue<int> queue(4);
+        int value = -1;
+        CPPUNIT_ASSERT(!queue.tryPop(value));
+        for (int i = 0; i < 4; ++i) {
+            CPPUNIT_ASSERT(queue.tryPush(i));
+        }
+        CPPUNIT_ASSERT(!queue.tryPush(4));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), queue.size());
+
+        CPPUNIT_ASSERT(queue.tryPop(value));
+        CPPUNIT_ASSERT_EQUAL(0, value);
+        CPPUNIT_ASSERT(queue.tryPush(4));
+        for (int i = 1; i <= 4; ++i) {
+            CPPUNIT_ASSERT(queue.tryPop(value));
+            CPPUNIT_ASSERT_EQUAL(i, value);
+        }
+        CPPUNIT_ASSERT(queue.empty());
+    }
+
+    // Producers interleave freely, but each one's items must arrive in order
+    void testMpscKeepsPerProducerOrder() {
+        const int producers = 4;
+        const int perProducer = 50000;
+        MpscQueue<int> queue(128);
+        std::vector<std::thread> threads;
+        for (int producer = 0; producer < producers; ++producer) {
+            threads.emplace_back([&queue, producer, perProducer]() {
+                for (int i = 0; i < perProducer; ++i) {
+                    while (!queue.tryPush(producer * perProducer + i)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        std::vector<int> nextIndex(producers, 0);
+        int received = 0;
+        while (received < producers * perProducer) {
+            int value;
+            if (!queue.tryPop(value)) {
+                std::this_thread::yield();
+                continue;
+            }
+            const int producer = value / perProducer;
+            CPPUNIT_ASSERT(producer >= 0 && producer < producers);
+            CPPUNIT_ASSERT_EQUAL(nextIndex[producer], value % perProducer);
+            ++nextIndex[producer];
+            ++received;
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        int value;
+        CPPUNIT_ASSERT(!queue.tryPop(value));
+        for (int count : nextIndex) {
+            CPPUNIT_ASSERT_EQUAL(perProducer, count);
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LockfreeQueueTest);
@@ -0,0 +1,127 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/logger.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Recordify::Utils;
+
+namespace {
+
+const char* const LOG_PATH = "logger_test.log";
+
+std::vector<std::string> readLines(const char* path) {
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Drops the "HH:MM:SS.mmm " timestamp
+std::string withoutTime(const std::string& line) {
+    return line.size() > 13 ? line.substr(13) : std::string();
+}
+
+} // namespace
+
+class LoggerTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(LoggerTest);
+    CPPUNIT_TEST(testRecordFormatting);
+    CPPUNIT_TEST(testFlushWritesInOrder);
+    CPPUNIT_TEST(testConcurrentProducersKeepTheirOrder);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override {
+        std::remove(LOG_PATH);
+        CPPUNIT_ASSERT(Logger::instance().setOutputFile(LOG_PATH));
+    }
+
+    void tearDown() override {
+        Logger::instance().setOutputStderr();
+        std::remove(LOG_PATH);
+    }
+
+    void testRecordFormatting() {
+        LogRecord record;
+        record.level = LogLevel::LEVEL_WARNING;
+        record.component = "Test";
+        record.add("frame ");
+        record.add(-3);
+        record.add(' ');
+        record.add(7u);
+        record.add(std::string(" at "));
+        record.add(2.5);
+        record.add(false);
+        std::string line;
+        record.format(line);
+        CPPUNIT_ASSERT_EQUAL(std::string("WARN  [Test] frame -3 7 at 2.5false\n"), withoutTime(line));
+
+        // Arguments past the limit are cut off and marked
+        LogRecord full;
+        full.component = "Test";
+        for (int i = 0; i < LogRecord::MAX_ARGS + 4; ++i) {
+            full.add(i % 10);
+        }
+        line.clear();
+        full.format(line);
+        CPPUNIT_ASSERT_EQUAL(std::string("INFO  [Test] 0123456789012345...\n"), withoutTime(line));
+    }
+
+    void testFlushWritesInOrder() {
+        Logger& logger = Logger::instance();
+        const uint64_t droppedBefore = logger.getDroppedRecords();
+        for (int i = 0; i < 500; ++i) {
+            logger.log(LogLevel::LEVEL_INFO, "LoggerTest", "record ", i);
+        }
+        logger.flush(); // everything submitted so far is on disk now
+
+        std::vector<std::string> lines = readLines(LOG_PATH);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(500), lines.size());
+        for (int i = 0; i < 500; ++i) {
+            CPPUNIT_ASSERT_EQUAL("INFO  [LoggerTest] record " + std::to_string(i), withoutTime(lines[i]));
+        }
+        CPPUNIT_ASSERT_EQUAL(droppedBefore, logger.getDroppedRecords());
+    }
+
+    // Records from different threads interleave, but each thread's stay in order
+    void testConcurrentProducersKeepTheirOrder() {
+        Logger& logger = Logger::instance();
+        const int producers = 4;
+        const int perProducer = 1000; // all of them fit in the queue, so none are dropped
+        std::vector<std::thread> threads;
+        for (int producer = 0; producer < producers; ++producer) {
+            threads.emplace_back([&logger, producer, perProducer]() {
+                for (int i = 0; i < perProducer; ++i) {
+                    logger.log(LogLevel::LEVEL_INFO, "LoggerTest", producer, ' ', i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        logger.flush();
+
+        std::vector<int> next(producers, 0);
+        for (const std::string& line : readLines(LOG_PATH)) {
+            int producer = -1;
+            int index = -1;
+            CPPUNIT_ASSERT_EQUAL(2, std::sscanf(withoutTime(line).c_str(), "INFO  [LoggerTest] %d %d",
+                                                &producer, &index));
+            CPPUNIT_ASSERT(producer >= 0 && producer < producers);
+            CPPUNIT_ASSERT_EQUAL(next[producer]++, index);
+        }
+        for (int count : next) {
+            CPPUNIT_ASSERT_EQUAL(perProducer, count);
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LoggerTest);
@@ -0,0 +1,75 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/ring_buffer.h"
+
+using Recordify::Utils::RingBuffer;
+using Recordify::Utils::Span;
+
+class RingBufferTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(RingBufferTest);
+    CPPUNIT_TEST(testViewIsContiguousAcrossWrap);
+    CPPUNIT_TEST(testOverwritesOldest);
+    CPPUNIT_TEST(testClearHidesOlderEntries);
+    CPPUNIT_TEST(testIntactDetectsOverwrite);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testViewIsContiguousAcrossWrap() {
+        RingBuffer<int, 8> ring;
+        for (int i = 0; i < 13; ++i) {
+            ring.push(i);
+        }
+
+        Span<int> latest = ring.view(6);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(6), latest.size());
+        for (size_t i = 0; i < latest.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(static_cast<int>(7 + i), latest[i]);
+        }
+    }
+
+    void testOverwritesOldest() {
+        RingBuffer<int, 4> ring;
+        for (int i = 0; i < 10; ++i) {
+            ring.push(i);
+        }
+
+        // One slot is always reserved for the producer
+        std::vector<int> all = ring.snapshot(100);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), all.size());
+        CPPUNIT_ASSERT_EQUAL(7, all.front());
+        CPPUNIT_ASSERT_EQUAL(9, all.back());
+    }
+
+    void testClearHidesOlderEntries() {
+        RingBuffer<int, 8> ring;
+        ring.push(1);
+        ring.push(2);
+        ring.clear();
+        CPPUNIT_ASSERT(ring.empty());
+
+        ring.push(3);
+        std::vector<int> all = ring.snapshot(8);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), all.size());
+        CPPUNIT_ASSERT_EQUAL(3, all[0]);
+    }
+
+    void testIntactDetectsOverwrite() {
+        RingBuffer<int, 8> ring;
+        for (int i = 0; i < 8; ++i) {
+            ring.push(i);
+        }
+
+        uint64_t sequence = 0;
+        Span<int> latest = ring.view(4, &sequence);
+        for (int i = 0; i < 3; ++i) {
+            ring.push(100 + i);
+        }
+        CPPUNIT_ASSERT(ring.isIntact(sequence, latest.size()));
+
+        ring.push(200);
+        CPPUNIT_ASSERT(!ring.isIntact(sequence, latest.size()));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RingBufferTest);
@@ -0,0 +1,75 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/spatial_index.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using Recordify::Utils::Point;
+using Recordify::Utils::Rectangle;
+using Recordify::Utils::SpatialGrid;
+
+class SpatialIndexTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(SpatialIndexTest);
+    CPPUNIT_TEST(testQueriesMatchLinearScan);
+    CPPUNIT_TEST(testRemoveAndMove);
+    CPPUNIT_TEST(testOversizedAndNegative);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testQueriesMatchLinearScan() {
+        std::mt19937 rng(11);
+        std::vector<std::pair<int, Rectangle>> items;
+        for (int i = 0; i < 500; ++i) {
+            items.push_back({i, Rectangle(rng() % 2000, rng() % 1200, 1 + rng() % 300, 1 + rng() % 200)});
+        }
+        SpatialGrid<int> grid(100);
+        grid.build(items);
+
+        for (int round = 0; round < 200; ++round) {
+            Point point(rng() % 2200, rng() % 1400);
+            Rectangle area(rng() % 2200, rng() % 1400, 1 + rng() % 600, 1 + rng() % 600);
+            std::vector<int> expectedPoint, expectedRect;
+            for (const auto& item : items) {
+                if (item.second.contains(point)) expectedPoint.push_back(item.first);
+                if (item.second.intersects(area)) expectedRect.push_back(item.first);
+            }
+
+            std::vector<int> atPoint = grid.queryPoint(point);
+            std::vector<int> inRect = grid.queryRect(area);
+            std::sort(atPoint.begin(), atPoint.end());
+            std::sort(inRect.begin(), inRect.end());
+            CPPUNIT_ASSERT(atPoint == expectedPoint);
+            CPPUNIT_ASSERT(inRect == expectedRect);
+        }
+    }
+
+    void testRemoveAndMove() {
+        SpatialGrid<int> grid(64);
+        grid.insert(1, Rectangle(0, 0, 100, 100));
+        grid.insert(2, Rectangle(50, 50, 10, 10));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), grid.queryPoint(Point(55, 55)).size());
+
+        CPPUNIT_ASSERT(grid.remove(1));
+        CPPUNIT_ASSERT(!grid.remove(1));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), grid.queryPoint(Point(55, 55)).size());
+
+        grid.insert(2, Rectangle(500, 500, 10, 10));
+        CPPUNIT_ASSERT(grid.queryPoint(Point(55, 55)).empty());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), grid.queryRect(Rectangle(490, 490, 20, 20)).size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), grid.size());
+    }
+
+    void testOversizedAndNegative() {
+        SpatialGrid<int> grid(32);
+        grid.insert(1, Rectangle(-5000, -5000, 10000, 10000)); // overflow list
+        grid.insert(2, Rectangle(-40, -40, 20, 20));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), grid.queryPoint(Point(-30, -30)).size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), grid.queryPoint(Point(-10, -10)).size());
+        // Query large enough to walk occupied cells instead
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), grid.queryRect(Rectangle(-4000, -4000, 8000, 8000)).size());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SpatialIndexTest);
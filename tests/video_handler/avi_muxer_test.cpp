@@ -0,0 +1,79 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "video_handler/avi_muxer.h"
+#include "video_handler/encoder_backend.h"
+#include <cstdio>
+#include <vector>
+
+using namespace Recordify::VideoHandler;
+
+namespace {
+
+const char* const OUTPUT_PATH = "avi_muxer_test.avi";
+
+std::vector<uint8_t> makePacket(int frame) {
+    return std::vector<uint8_t>(static_cast<size_t>(1001 + frame), static_cast<uint8_t>(frame));
+}
+
+} // namespace
+
+class AviMuxerTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(AviMuxerTest);
+    CPPUNIT_TEST(testContinuesInAvixLists);
+    CPPUNIT_TEST(testFailsOnceSuperIndexIsFull);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override {
+        std::remove(OUTPUT_PATH);
+    }
+
+    void testContinuesInAvixLists() {
+        // About 8 packets per RIFF list
+        AviMuxer muxer;
+        CPPUNIT_ASSERT(muxer.open(OUTPUT_PATH, 64, 48, 10.0f, makeFourcc('M', 'J', 'P', 'G')));
+        muxer.setRiffLimit(16 * 1024);
+        for (int frame = 0; frame < 40; ++frame) {
+            std::vector<uint8_t> packet = makePacket(frame);
+            CPPUNIT_ASSERT(muxer.writeFrame(packet.data(), packet.size(), frame % 5 == 0));
+        }
+        CPPUNIT_ASSERT(muxer.getFileSize() > 2 * 16 * 1024);
+        CPPUNIT_ASSERT(muxer.close());
+
+        AviReader reader;
+        CPPUNIT_ASSERT(reader.open(OUTPUT_PATH));
+        CPPUNIT_ASSERT_EQUAL(40u, reader.getFrameCount());
+        CPPUNIT_ASSERT_EQUAL(64, reader.getWidth());
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(10.0, reader.getFps(), 1e-6);
+        std::vector<uint8_t> packet;
+        for (uint32_t frame = 0; frame < 40; ++frame) {
+            bool keyFrame = false;
+            CPPUNIT_ASSERT(reader.readFrame(frame, packet, keyFrame));
+            CPPUNIT_ASSERT(packet == makePacket(static_cast<int>(frame)));
+            CPPUNIT_ASSERT_EQUAL(frame % 5 == 0, keyFrame);
+        }
+    }
+
+    void testFailsOnceSuperIndexIsFull() {
+        // One packet per RIFF list
+        AviMuxer muxer;
+        CPPUNIT_ASSERT(muxer.open(OUTPUT_PATH, 64, 48, 10.0f, makeFourcc('M', 'J', 'P', 'G')));
+        muxer.setRiffLimit(1);
+        std::vector<uint8_t> packet = makePacket(0);
+        for (uint32_t frame = 0; frame < AviMuxer::MAX_RIFF_LISTS; ++frame) {
+            CPPUNIT_ASSERT(muxer.writeFrame(packet.data(), packet.size(), true));
+        }
+        CPPUNIT_ASSERT(!muxer.writeFrame(packet.data(), packet.size(), true));
+        CPPUNIT_ASSERT(!muxer.writeFrame(packet.data(), packet.size(), true));
+        CPPUNIT_ASSERT_EQUAL(AviMuxer::MAX_RIFF_LISTS, muxer.getFrameCount());
+
+        // Still finalized, with everything written before the failure
+        CPPUNIT_ASSERT(!muxer.close());
+        AviReader reader;
+        CPPUNIT_ASSERT(reader.open(OUTPUT_PATH));
+        CPPUNIT_ASSERT_EQUAL(AviMuxer::MAX_RIFF_LISTS, reader.getFrameCount());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AviMuxerTest);
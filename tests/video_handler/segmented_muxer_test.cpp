@@ -0,0 +1,110 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "video_handler/segmented_muxer.h"
+#include "video_handler/encoder_backend.h"
+#include <cstdio>
+#include <vector>
+
+using namespace Recordify::VideoHandler;
+using Recordify::FileManager::SegmentManifest;
+
+namespace {
+
+const char* const OUTPUT_PATH = "segmented_test.avi";
+const char* const MANIFEST_PATH = "segmented_test.manifest";
+const char* const JOINED_PATH = "segmented_test_joined.avi";
+
+std::vector<uint8_t> makePacket(int frame) {
+    return std::vector<uint8_t>(static_cast<size_t>(100 + frame), static_cast<uint8_t>(frame));
+}
+
+// Every packet of an AVI, in order
+std::vector<std::vector<uint8_t>> readPackets(const std::string& path) {
+    AviReader reader;
+    CPPUNIT_ASSERT(reader.open(path));
+    std::vector<std::vector<uint8_t>> packets(reader.getFrameCount());
+    for (uint32_t i = 0; i < reader.getFrameCount(); ++i) {
+        bool keyFrame = false;
+        CPPUNIT_ASSERT(reader.readFrame(i, packets[i], keyFrame));
+    }
+    return packets;
+}
+
+} // namespace
+
+class SegmentedMuxerTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(SegmentedMuxerTest);
+    CPPUNIT_TEST(testRollsOverAtKeyFrames);
+    CPPUNIT_TEST(testInterruptedRecordingKeepsFinishedSegments);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override {
+        for (int i = 0; i < 4; ++i) {
+            char name[64];
+            std::snprintf(name, sizeof(name), "segmented_test_%05d.avi", i);
+            std::remove(name);
+        }
+        std::remove(MANIFEST_PATH);
+        std::remove(JOINED_PATH);
+    }
+
+    void testRollsOverAtKeyFrames() {
+        // 10 frames per segment; frame 10 isn't a key frame so the first segment runs long
+        SegmentedMuxer muxer;
+        CPPUNIT_ASSERT(muxer.open(OUTPUT_PATH, 64, 48, 10.0f, makeFourcc('M', 'J', 'P', 'G'),
+                                  Recordify::FileManager::WriterOptions(), 1.0));
+        for (int frame = 0; frame < 25; ++frame) {
+            std::vector<uint8_t> packet = makePacket(frame);
+            CPPUNIT_ASSERT(muxer.writeFrame(packet.data(), packet.size(), frame != 10));
+        }
+        CPPUNIT_ASSERT(muxer.close());
+
+        SegmentManifest manifest;
+        CPPUNIT_ASSERT(manifest.load(MANIFEST_PATH));
+        CPPUNIT_ASSERT(manifest.isComplete());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), manifest.getSegments().size());
+        CPPUNIT_ASSERT_EQUAL(11u, manifest.getSegments()[0].frames);
+        CPPUNIT_ASSERT_EQUAL(10u, manifest.getSegments()[1].frames);
+        CPPUNIT_ASSERT_EQUAL(4u, manifest.getSegments()[2].frames);
+        CPPUNIT_ASSERT_EQUAL(std::string("MJPG"), manifest.getStream().codec);
+        CPPUNIT_ASSERT_EQUAL(64, manifest.getStream().width);
+
+        // Each segment stands alone, and they join back into the original stream
+        std::vector<std::vector<uint8_t>> second = readPackets(manifest.resolve(manifest.getSegments()[1]));
+        CPPUNIT_ASSERT(second.front() == makePacket(11));
+        CPPUNIT_ASSERT(concatenateSegments(MANIFEST_PATH, JOINED_PATH));
+        std::vector<std::vector<uint8_t>> joined = readPackets(JOINED_PATH);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(25), joined.size());
+        for (int frame = 0; frame < 25; ++frame) {
+            CPPUNIT_ASSERT(joined[frame] == makePacket(frame));
+        }
+    }
+
+    void testInterruptedRecordingKeepsFinishedSegments() {
+        SegmentedMuxer muxer;
+        CPPUNIT_ASSERT(muxer.open(OUTPUT_PATH, 64, 48, 10.0f, makeFourcc('M', 'J', 'P', 'G'),
+                                  Recordify::FileManager::WriterOptions(), 1.0));
+        for (int frame = 0; frame < 15; ++frame) {
+            std::vector<uint8_t> packet = makePacket(frame);
+            CPPUNIT_ASSERT(muxer.writeFrame(packet.data(), packet.size(), true));
+        }
+
+        // What a crash right now would leave: one finished segment, no end marker,
+        // and an in-progress segment without an index
+        SegmentManifest manifest;
+        CPPUNIT_ASSERT(manifest.load(MANIFEST_PATH));
+        CPPUNIT_ASSERT(!manifest.isComplete());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), manifest.getSegments().size());
+        AviReader unfinished;
+        CPPUNIT_ASSERT(!unfinished.open("segmented_test_00001.avi"));
+
+        CPPUNIT_ASSERT(concatenateSegments(MANIFEST_PATH, JOINED_PATH));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(10), readPackets(JOINED_PATH).size());
+        CPPUNIT_ASSERT(muxer.close());
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(15), muxer.getFrameCount());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SegmentedMuxerTest);
@@ -0,0 +1,225 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "screen_handler/screen_handler.h"
+#include "video_handler/mjpeg_backend.h"
+#include "video_handler/video_encoder.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace Recordify::VideoHandler;
+using Recordify::ScreenHandler::FrameBuffer;
+using Recordify::ScreenHandler::PipelineFrame;
+using Recordify::Utils::Rectangle;
+
+namespace {
+
+const char* const OUTPUT_PATH = "video_encoder_test.avi";
+
+std::vector<uint8_t> makePixels(int width, int height, int bpp, int seed) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * bpp);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = static_cast<uint8_t>((i * 7 + seed * 31 + (i / (width * bpp)) * 3) & 0xFF);
+    }
+    return pixels;
+}
+
+std::vector<uint8_t> encodeDirect(const std::vector<uint8_t>& pixels, int width, int height, int bpp) {
+    MjpegBackend backend;
+    backend.open(EncoderSettings());
+    VideoFrame frame{pixels.data(), width, height, static_cast<size_t>(width) * bpp, bpp};
+    std::vector<uint8_t> packet;
+    bool keyFrame = false;
+    backend.encode(frame, packet, keyFrame);
+    return packet;
+}
+
+uint32_t read32(const std::vector<uint8_t>& data, size_t offset) {
+    return data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 | static_cast<uint32_t>(data[offset + 3]) << 24;
+}
+
+// Frame payloads in index order, after checking the RIFF structure around them
+std::vector<std::vector<uint8_t>> readAviFrames(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<std::vector<uint8_t>> frames;
+    CPPUNIT_ASSERT(file.size() > 224);
+    CPPUNIT_ASSERT(std::memcmp(file.data(), "RIFF", 4) == 0 && std::memcmp(file.data() + 8, "AVI ", 4) == 0);
+    CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(file.size() - 8), read32(file, 4));
+
+    // movi follows the header list, whose size grows with the OpenDML index
+    const size_t movi = 20 + read32(file, 16) + 8;
+    CPPUNIT_ASSERT(std::memcmp(file.data() + movi, "movi", 4) == 0);
+    const size_t index = movi + read32(file, movi - 4);
+    CPPUNIT_ASSERT(std::memcmp(file.data() + index, "idx1", 4) == 0);
+    const uint32_t count = read32(file, index + 4) / 16;
+    CPPUNIT_ASSERT_EQUAL(count, read32(file, 48)); // avih total frames
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const size_t entry = index + 8 + i * 16;
+        const size_t chunk = movi + read32(file, entry + 8);
+        const uint32_t size = read32(file, entry + 12);
+        CPPUNIT_ASSERT(std::memcmp(file.data() + chunk, "00dc", 4) == 0);
+        CPPUNIT_ASSERT_EQUAL(size, read32(file, chunk + 4));
+        frames.emplace_back(file.begin() + chunk + 8, file.begin() + chunk + 8 + size);
+    }
+    return frames;
+}
+
+class NullBackend : public EncoderBackend {
+public:
+    const char* name() const override { return "null"; }
+    uint32_t fourcc() const override { return makeFourcc('N', 'U', 'L', 'L'); }
+    bool open(const EncoderSettings&) override { return true; }
+    bool encode(const VideoFrame& frame, std::vector<uint8_t>& packet, bool& keyFrame) override {
+        packet.push_back(frame.pixels[0]);
+        keyFrame = true;
+        return true;
+    }
+};
+
+} // namespace
+
+class VideoEncoderTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(VideoEncoderTest);
+    CPPUNIT_TEST(testMjpegFrameLayout);
+    CPPUNIT_TEST(testWorkersKeepSubmissionOrder);
+    CPPUNIT_TEST(testPipelineRebuildsIncrementalFrames);
+    CPPUNIT_TEST(testRegisteredBackend);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override { std::remove(OUTPUT_PATH); }
+
+    void testMjpegFrameLayout() {
+        // Odd size exercises the MCU edge padding
+        std::vector<uint8_t> packet = encodeDirect(makePixels(37, 21, 4, 1), 37, 21, 4);
+        CPPUNIT_ASSERT(packet.size() > 600);
+        CPPUNIT_ASSERT_EQUAL(0xFF, static_cast<int>(packet[0]));
+        CPPUNIT_ASSERT_EQUAL(0xD8, static_cast<int>(packet[1]));
+        CPPUNIT_ASSERT_EQUAL(0xD9, static_cast<int>(packet.back()));
+
+        // Walk the marker segments up to the scan and read the frame size
+        size_t offset = 2;
+        int width = 0, height = 0;
+        while (offset + 4 < packet.size() && packet[offset + 1] != 0xDA) {
+            CPPUNIT_ASSERT_EQUAL(0xFF, static_cast<int>(packet[offset]));
+            if (packet[offset + 1] == 0xC0) {
+                height = packet[offset + 5] << 8 | packet[offset + 6];
+                width = packet[offset + 7] << 8 | packet[offset + 8];
+            }
+            offset += 2 + (packet[offset + 2] << 8 | packet[offset + 3]);
+        }
+        CPPUNIT_ASSERT_EQUAL(37, width);
+        CPPUNIT_ASSERT_EQUAL(21, height);
+    }
+
+    void testWorkersKeepSubmissionOrder() {
+        EncoderSettings settings;
+        settings.threads = 3;
+        settings.queueDepth = 2;
+        settings.blockWhenFull = true;
+        VideoEncoder encoder;
+        CPPUNIT_ASSERT(encoder.open(OUTPUT_PATH, settings));
+
+        std::vector<std::vector<uint8_t>> expected;
+        for (int i = 0; i < 12; ++i) {
+            std::vector<uint8_t> pixels = makePixels(64, 48, 3, i);
+            expected.push_back(encodeDirect(pixels, 64, 48, 3));
+            CPPUNIT_ASSERT(encoder.submit(VideoFrame{pixels.data(), 64, 48, 64 * 3, 3}));
+        }
+        // The first frame fixed the size
+        std::vector<uint8_t> other = makePixels(32, 32, 3, 0);
+        CPPUNIT_ASSERT(!encoder.submit(VideoFrame{other.data(), 32, 32, 32 * 3, 3}));
+        CPPUNIT_ASSERT(encoder.close());
+
+        CPPUNIT_ASSERT(readAviFrames(OUTPUT_PATH) == expected);
+        VideoEncoder::Stats stats = encoder.getStats();
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(12), stats.framesWritten);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), stats.framesDropped);
+    }
+
+    void testPipelineRebuildsIncrementalFrames() {
+        VideoEncoder encoder;
+        CPPUNIT_ASSERT(encoder.open(OUTPUT_PATH));
+
+        std::vector<uint8_t> screen = makePixels(128, 64, 4, 5);
+        PipelineFrame frame;
+        frame.incremental = true;
+        frame.changes.width = 128;
+        frame.changes.height = 64;
+        frame.changes.bitsPerPixel = 32;
+        frame.changes.keyFrame = true;
+        frame.changes.tiles = {Rectangle(0, 0, 128, 64)};
+        frame.changes.tileOffsets = {0};
+        frame.changes.pixelData = screen;
+        CPPUNIT_ASSERT(encoder.encodeFrame(frame));
+        CPPUNIT_ASSERT(encoder.writeFrame(frame));
+
+        // Nothing changed: the previous picture repeats
+        frame.changes.keyFrame = false;
+        frame.changes.tiles.clear();
+        frame.changes.tileOffsets.clear();
+        frame.changes.pixelData.clear();
+        CPPUNIT_ASSERT(encoder.writeFrame(frame));
+
+        // One tile changed
+        std::vector<uint8_t> tile = makePixels(16, 8, 4, 9);
+        frame.changes.tiles = {Rectangle(32, 16, 16, 8)};
+        frame.changes.tileOffsets = {0};
+        frame.changes.pixelData = tile;
+        CPPUNIT_ASSERT(encoder.writeFrame(frame));
+        for (int y = 0; y < 8; ++y) {
+            std::memcpy(&screen[((16 + y) * 128 + 32) * 4], &tile[y * 16 * 4], 16 * 4);
+        }
+
+        // Full frames are compressed by the encode stage
+        PipelineFrame full;
+        std::vector<uint8_t> pixels = makePixels(128, 64, 4, 6);
+        full.capture.pixelData = FrameBuffer::allocate(pixels.size());
+        std::memcpy(full.capture.pixelData.data(), pixels.data(), pixels.size());
+        full.capture.width = 128;
+        full.capture.height = 64;
+        full.capture.bitsPerPixel = 32;
+        CPPUNIT_ASSERT(encoder.encodeFrame(full));
+        CPPUNIT_ASSERT(!full.encodedData.empty());
+        CPPUNIT_ASSERT(encoder.writeFrame(full));
+        // Reported once the packets are in the file, at the latest on close
+        std::atomic<bool> written{false};
+        CPPUNIT_ASSERT(encoder.whenWritten([&written]() { written = true; }));
+        CPPUNIT_ASSERT(encoder.close());
+        CPPUNIT_ASSERT(written.load());
+
+        std::vector<std::vector<uint8_t>> frames = readAviFrames(OUTPUT_PATH);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), frames.size());
+        CPPUNIT_ASSERT(frames[0] == encodeDirect(makePixels(128, 64, 4, 5), 128, 64, 4));
+        CPPUNIT_ASSERT(frames[1] == frames[0]);
+        CPPUNIT_ASSERT(frames[2] == encodeDirect(screen, 128, 64, 4));
+        CPPUNIT_ASSERT(frames[3] == full.encodedData);
+    }
+
+    void testRegisteredBackend() {
+        CPPUNIT_ASSERT(registerBackend("Null", []() { return std::unique_ptr<EncoderBackend>(new NullBackend()); }));
+        EncoderSettings settings;
+        settings.codec = "null";
+        settings.width = 8;
+        settings.height = 8;
+        VideoEncoder encoder;
+        CPPUNIT_ASSERT(encoder.open(OUTPUT_PATH, settings));
+
+        std::vector<uint8_t> pixels(8 * 8 * 3, 42);
+        CPPUNIT_ASSERT(encoder.submit(VideoFrame{pixels.data(), 8, 8, 8 * 3, 3}));
+        CPPUNIT_ASSERT(encoder.close());
+
+        std::vector<std::vector<uint8_t>> frames = readAviFrames(OUTPUT_PATH);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), frames.size());
+        CPPUNIT_ASSERT(frames[0] == std::vector<uint8_t>(1, 42));
+        CPPUNIT_ASSERT(createBackend("no-such-codec") == nullptr);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(VideoEncoderTest);